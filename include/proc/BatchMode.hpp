@@ -0,0 +1,18 @@
+#pragma once
+
+#include <CliOptions.hpp>
+
+// Non-interactive mode, `top -b` alike : the collector is run N times with a fixed delay and every
+// snapshot is streamed in the chosen format. Diagnostics are moved to stderr so stdout stays parsable.
+// With -g the snapshots are the cgroup v2 aggregates instead of the processes.
+// With --rules every process snapshot goes through the rule engine, the alerts landing in the alert log.
+// With --where only the processes matching the filter are streamed, the rule engine still sees all of them.
+// With --budget the delay widens, then fewer processes are read per snapshot, while the collector is over budget.
+namespace proc
+{
+namespace batch
+{
+// returns the process exit code
+int run(const cli::Options& options);
+}
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <CounterDelta.hpp>
+#include <ProcessInfo.hpp>
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Container level usage straight from cgroup v2, per cgroup directory :
+// | File           | Used as                                                        |
+// | -------------- | -------------------------------------------------------------- |
+// | cpu.stat       | usage_usec, cumulative (exited children included) -> CPU% delta |
+// | memory.current | bytes charged to the cgroup                                     |
+// | pids.current   | tasks in the cgroup and its' descendants                        |
+// | cgroup.procs   | members, only read for the cgroup expanded by the monitor       |
+// A tick costs O(cgroups) small reads whatever the number of processes living in them. A cgroup removed while the
+// hierarchy is walked is skipped, the walk goes on
+namespace proc
+{
+static const std::filesystem::path kCgroupPath = "/sys/fs/cgroup/";
+
+struct CgroupStats
+{
+    std::string _path; // as in /proc/<pid>/cgroup, "/" being the root
+    unsigned long long _usageUsec{0u};
+    unsigned long long _memoryBytes{0u};
+    unsigned long long _pids{0u};
+    double _cpu{0.0}; // percent of one CPU since the previous sample, 0 on the first one
+};
+
+class CgroupCollector
+{
+public:
+    explicit CgroupCollector(const std::filesystem::path& cgroupRoot = kCgroupPath);
+
+    // walks the hierarchy once, sorted by path
+    const std::vector<CgroupStats>& sample(const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
+    inline const std::vector<CgroupStats>& getCgroups() const { return _cgroups; }
+
+    // the processes of the cgroup at `path` (as in CgroupStats::_path), not its' descendants' ; false when it is gone
+    bool members(std::string_view path, std::vector<uint>& pids) const;
+
+private:
+    struct CpuState
+    {
+        utils::CounterDelta _delta;
+        unsigned long long _lastSeenTick{0u};
+    };
+
+    bool readCgroup(const std::filesystem::path& directory, CgroupStats& stats);
+
+    std::filesystem::path _cgroupRoot;
+    std::vector<CgroupStats> _cgroups;
+    std::unordered_map<std::string, CpuState> _cpuStates;
+    unsigned long long _tick{0u};
+};
+}
\ No newline at end of file
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <ChurnGenerator.hpp>
+#include <OutputBuffer.hpp>
+#include <ProcessInfo.hpp>
+#include <SnapshotFormat.hpp>
+
+#include <chrono>
+#include <cstdint>
+
+// The collector against a churn storm : out --churn-bench [--churn-rate N] [--churn-threads N] [--churn-lifetime MS]
+// [-n SCANS] [-d SEC] [--io auto|sync|uring] [-f text|csv|jsonl] [-o FILE]
+// Every scan is timed and its' pids kept. Once the storm is stopped (its' ledger complete) each scan is checked against
+// the children that were there for all of its' duration : forked before it started, reaped after it ended (zombies
+// included, their entry stays until then). One of them not in the scan is missed. A pid reused within the run could
+// hide a miss, pid_max makes it unlikely at the rates of a CI runner
+namespace proc
+{
+namespace cli
+{
+struct Options;
+}
+
+namespace churn
+{
+struct Report
+{
+    uint _scans{0u};
+    // of a scan, in ms
+    double _p50Ms{0.0};
+    double _p90Ms{0.0};
+    double _p99Ms{0.0};
+    double _maxMs{0.0};
+    std::uint64_t _expected{0u}; // (scan, child there all along) pairs
+    std::uint64_t _missed{0u};
+    std::uint64_t _vanished{0u}; // listed, gone before the read
+    double _cpuMsPerScan{0.0};   // of the process, the scans only
+    double _cpuPercent{0.0};     // of one core over the run, pauses between scans included
+    std::size_t _spawned{0u};
+    double _spawnedPerSecond{0.0};
+    std::uint64_t _forkFailures{0u};
+
+    inline double missedFraction() const { return _expected == 0u ? 0.0 : static_cast<double>(_missed) / static_cast<double>(_expected); }
+};
+
+// `scans` scans of `collector`, `interval` apart, while `generator` churns ; the generator is stopped on return
+Report measure(ProcessInfo& collector, Generator& generator, const uint scans, const std::chrono::milliseconds interval);
+
+void appendReport(utils::OutputBuffer& out, const format::Kind kind, const Config& config, const Report& report);
+
+// returns the process exit code, 1 when a process was missed
+int run(const cli::Options& options);
+}
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <sys/types.h>
+
+// Storms of short-lived processes, the churn of a CI runner (compilers, test binaries, shell one-liners) on demand.
+// The storm is a forked process of its' own : it forks a child every 1/rate seconds, each child starting its' threads
+// with a raw clone(), living a lifetime drawn around the mean and exiting ; it reaps them as they go. Being single
+// threaded the storm can fork safely whatever the threads of the process that started it.
+// Every child is written down in a ledger shared with the starter (a MAP_SHARED mapping) : its' pid, when it existed
+// at the latest (after fork returned) and when it was gone at the earliest (before the wait that reaped it), so that
+// a scan can be checked against the processes that were there for all of its' duration
+namespace proc
+{
+namespace churn
+{
+struct Config
+{
+    uint _processesPerSecond{200u};
+    uint _threadsPerProcess{4u}; // besides the main one
+    uint _lifetimeMs{100u};      // mean, each child lives between none and twice as long
+};
+
+// a child of the storm, times on CLOCK_MONOTONIC in ns
+struct Child
+{
+    pid_t _pid;
+    std::uint64_t _forkedNs;
+    std::uint64_t _reapedNs; // 0 -> not reaped yet
+};
+
+class Generator
+{
+public:
+    // children past it are still forked, not written down
+    static constexpr std::size_t kLedgerCapacity = 1u << 18;
+
+    // throws SeverityException<SeriousException> when the ledger cannot be mapped or the storm forked
+    explicit Generator(const Config& config);
+    // stop()s
+    ~Generator();
+
+    Generator(const Generator&) = delete;
+    Generator& operator=(const Generator&) = delete;
+
+    // no new child from now on, returns once every child is reaped and the storm is gone
+    void stop();
+
+    // written down so far ; complete (every child reaped) once stop() returned
+    std::size_t size() const;
+    inline const Child& at(const std::size_t index) const { return _ledger->_children[index]; }
+    inline std::uint64_t getForkFailures() const { return _ledger->_forkFailures.load(std::memory_order_relaxed); }
+    inline pid_t getStormPid() const { return _storm; }
+
+private:
+    struct Ledger
+    {
+        std::atomic<bool> _stop;
+        std::atomic<std::size_t> _size;
+        std::atomic<std::uint64_t> _forkFailures;
+        Child _children[kLedgerCapacity];
+    };
+
+    Ledger* _ledger{nullptr};
+    pid_t _storm{-1};
+};
+
+// CLOCK_MONOTONIC in ns, the clock of the ledger
+std::uint64_t monotonicNs();
+}
+}
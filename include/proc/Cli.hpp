@@ -1,5 +1,7 @@
 #pragma once
 
+#include <CliOptions.hpp>
+
 #include <filesystem>
 
 // we should be able to present something like this : 
@@ -16,10 +18,14 @@
 // +-----------------------------------------------------------------------------+
 // [Q] Quit | [K] Kill Process | [F] Filter | [S] Sort | [R] Refresh
 
+// [F] opens a prompt taking a filter in the language of --where (see Query.hpp), eg. cpu > 5 && uptime < 10m ; in
+// the grouped view the groups stay whole, the filter picks the members shown under the expanded one
+
 namespace proc
 {
 namespace cli
 {
-void display(const std::filesystem::path& exportedFile);
+// with rules in the options, the alerts they fire show below the totals and go to the alert log
+void display(const std::filesystem::path& exportedFile, const Options& options);
 }
 }
\ No newline at end of file
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <SnapshotFormat.hpp>
+#include <BatchFileReader.hpp>
+#include <CollectorBudget.hpp>
+#include <SnapshotDiff.hpp>
+#include <ChurnGenerator.hpp>
+#include <ProcessSignaller.hpp>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Command line of the monitor :
+// out                                   -> interactive monitor (default) on a terminal, drawn from the last export
+//                                          while the first scan runs ; a single scan exported otherwise
+// out -b [-g] [-n N] [-d SEC] [-f csv|jsonl|text] [-o FILE]
+//                                       -> batch mode, N snapshots every SEC seconds streamed to stdout or FILE,
+//                                          per cgroup with -g
+// out -k SIG -p PID:START[,...] [-w MS] -> signal the listed processes if they still are the ones started at START,
+//                                          waiting up to MS for them to exit
+// out --diff BEFORE [AFTER] [--top K] [--by cpu|memory|threads] [-f text|csv|jsonl] [-o FILE]
+//                                       -> top movers between two exports, AFTER being a live scan when left out ;
+//                                          a table by default, a stream of rows with -f csv|jsonl
+// out --select EXPORT [--where FILTER] [-f text|csv|jsonl] [-o FILE]
+//                                       -> the rows of an export matching the filter (see Query.hpp), text by default
+// out --churn-bench [--churn-rate N] [--churn-threads N] [--churn-lifetime MS] [-n SCANS] [-d SEC] [-f text|csv|jsonl]
+//                                       -> the collector scanning under a storm of short-lived processes : latency
+//                                          percentiles, processes missed, vanished entries, cpu cost (see ChurnBench.hpp)
+// monitor/batch/diff [--where FILTER]   -> only the processes matching the filter, eg. "cpu > 5 && uptime < 10m"
+// any mode [--profile-json FILE]        -> per-stage latency histograms of the collector dumped at exit (and on
+//                                          SIGUSR1 while the monitor runs)
+//                                          (needs a build configured with -DENABLE_PROFILING=ON)
+// any mode [--io auto|sync|uring]       -> how the /proc/<pid>/stat files of a scan are read
+// monitor/batch [--rules FILE [--alert-log FILE]]
+//                                       -> threshold rules evaluated every tick, alerts appended to the log
+// monitor/batch [--budget PERCENT] [--priority normal|nice|idle]
+//                                       -> collector cost kept under PERCENT of one core, collector thread priority
+namespace proc
+{
+namespace cli
+{
+enum class Mode
+{
+    Monitor,
+    Batch,
+    Signal,
+    Diff,
+    Select,
+    ChurnBench
+};
+
+struct Options
+{
+    Mode _mode{Mode::Monitor};
+    uint _iterations{1u};
+    double _delaySeconds{1.0};
+    format::Kind _format{format::Kind::Csv};
+    std::filesystem::path _output; // empty -> stdout
+    bool _cgroups{false};
+    int _signal{-1};
+    std::vector<SignalTarget> _targets;
+    uint _exitWaitMs{2000u};
+    utils::procfs::IoBackend _ioBackend{utils::procfs::IoBackend::Auto};
+    std::filesystem::path _profileOutput; // empty -> no dump, made absolute as the collector moves into /proc
+    std::filesystem::path _rulesFile; // empty -> no rules
+    std::filesystem::path _alertLog; // alerts.log in the working directory by default, absolute as well
+    double _budgetPercent{0.0}; // 0 -> unlimited
+    budget::Priority _priority{budget::Priority::Normal};
+    std::filesystem::path _diffBefore;
+    std::filesystem::path _diffAfter; // empty -> a live scan
+    uint _top{10u}; // 0 -> every change
+    diff::Metric _diffMetric{diff::Metric::Cpu};
+    std::string _where; // empty -> every process, checked by parseOptions
+    std::filesystem::path _selectFile;
+    churn::Config _churn;
+};
+
+// throws SeverityException<SeriousException> on unknown flags or malformed values
+Options parseOptions(const int argc, const char* const argv[]);
+std::string usage();
+}
+}
\ No newline at end of file
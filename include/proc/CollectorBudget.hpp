@@ -0,0 +1,69 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <string_view>
+
+// The collector keeps its' own cost under a budget, eg. 2% of one core, so that on a saturated host the monitor doesn't
+// become part of the problem. Every tick is measured with getrusage(RUSAGE_THREAD) (cpu of the collecting thread only,
+// the io_uring and kernel work done on its' behalf included) and smoothed ; then, in this order :
+// 1. the refresh interval is widened up to kMaxWiden times the requested one, so that cost / interval fits the budget
+// 2. past that, the sampled set is shrunk : 1 in `stride` processes is read per tick, round robin on the pid, the
+//    others keeping their last values
+// Both move back as soon as the cost allows it. A budget of 0 never throttles
+namespace proc
+{
+namespace budget
+{
+enum class Priority
+{
+    Normal,
+    Nice,  // nice 19 and the lowest best-effort I/O priority
+    Idle   // SCHED_IDLE and the idle I/O class : only runs when nothing else wants the cpu or the disk
+};
+
+// "normal", "nice" or "idle" ; false when unknown
+bool parsePriority(std::string_view text, Priority& priority);
+
+// applies to the calling thread (and to the threads it spawns afterwards) ; false, with a WARNING, when refused
+bool applyPriority(const Priority priority);
+
+// cpu (user + system) consumed so far by the calling thread
+std::chrono::microseconds threadCpuTime();
+
+class CollectorBudget
+{
+public:
+    static constexpr uint kMaxWiden = 8u;
+    static constexpr uint kMaxStride = 16u;
+
+    // `budgetPercent` of one core, 0 -> unlimited
+    CollectorBudget(const double budgetPercent, const std::chrono::milliseconds interval);
+
+    // around one tick of the calling thread
+    inline void beginTick() { _tickStart = threadCpuTime(); }
+    inline void endTick() { record(threadCpuTime() - _tickStart); }
+    // cost of the last tick, done at the current stride
+    void record(const std::chrono::microseconds tickCpu);
+
+    inline std::chrono::milliseconds getInterval() const { return _interval; }
+    inline uint getStride() const { return _stride; }
+    inline bool isDegraded() const { return _interval > _requested || _stride > 1u; }
+    // smoothed cpu of the collector over its' refresh interval, in % of one core
+    double getCostPercent() const;
+    // "| Refresh: 1.0s - collector 0.4% of a core (budget 2.0%)"
+    // "| Refresh: 4.0s (throttled from 1.0s, 1 in 2 processes per tick) - collector 1.9% of a core (budget 2.0%)"
+    std::string describe() const;
+
+private:
+    double _budget; // fraction of one core
+    std::chrono::milliseconds _requested;
+    std::chrono::milliseconds _interval;
+    uint _stride{1u};
+    // smoothed cpu of a tick when every process is read, in µs
+    double _fullTickCpu{0.0};
+    bool _measured{false};
+    std::chrono::microseconds _tickStart{0};
+};
+}
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <ProcessInfo.hpp>
+#include <OutputBuffer.hpp>
+
+#include <condition_variable>
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <sys/uio.h>
+
+// Write-behind exporter : submit() copies the rows of a snapshot and returns, a writer thread formats them into
+// reusable chunks, writev()s them into a temporary file next to the export and rename()s it over the export.
+// A reader opening the export sees the previous snapshot or the new one, never a half written file.
+// One snapshot at most waits for the writer : when the disk is slower than the collector, a newer snapshot replaces
+// the waiting one (coalesced) so the export lags by one write, never by a backlog, and submit() never waits on I/O
+namespace proc
+{
+class ExportWriter
+{
+public:
+    enum class Durability
+    {
+        Rename, // atomic for the readers, the rename may be lost on a power failure
+        Fsync   // the temporary file is fsync()ed before being renamed
+    };
+    // formatted rows per chunk, a chunk being one iovec of the writev
+    static constexpr std::size_t kChunkBytes = 64u * 1024u;
+
+    explicit ExportWriter(const std::filesystem::path& exportPath, const Durability durability = Durability::Rename);
+    // the waiting snapshot is still published
+    ~ExportWriter();
+
+    ExportWriter(const ExportWriter&) = delete;
+    ExportWriter& operator=(const ExportWriter&) = delete;
+
+    // takes a copy of `snapshot` for the writer, with the names of its' rows when `names` is given (the ids mean
+    // nothing outside of the collector) ; a snapshot not yet picked up by it is dropped
+    void submit(const PidTable_t& snapshot, const utils::StringTable* names = nullptr);
+    // blocks until every snapshot submitted so far is published (or failed to)
+    void waitIdle();
+
+    inline const std::filesystem::path& getPath() const { return _path; }
+    std::size_t getPublished();
+    std::size_t getCoalesced();
+    std::size_t getFailed();
+
+private:
+    // the rows and, back to back, their names ; both keep their capacity from one snapshot to the next
+    struct Snapshot
+    {
+        std::vector<std::pair<uint, PidStats>> _rows;
+        std::string _names;
+        std::vector<std::size_t> _nameEnds; // one per row, empty without names
+    };
+
+    void run();
+    // formats `snapshot` into _chunks and fills _iovecs with them
+    void serialize(const Snapshot& snapshot);
+    bool publish();
+
+    std::filesystem::path _path;
+    std::filesystem::path _tempPath;
+    Durability _durability;
+
+    std::mutex _mutex;
+    std::condition_variable _wakeWriter;
+    std::condition_variable _idle;
+    Snapshot _pending;       // submitted, waiting for the writer
+    bool _hasPending{false};
+    bool _writing{false};
+    bool _stopping{false};
+    std::size_t _published{0u};
+    std::size_t _coalesced{0u};
+    std::size_t _failed{0u};
+
+    // writer thread only, kept from one snapshot to the next
+    Snapshot _writingSnapshot;
+    std::vector<std::unique_ptr<utils::OutputBuffer>> _chunks;
+    std::vector<iovec> _iovecs;
+
+    std::thread _writer; // last, started once everything above is built
+};
+}
@@ -1,25 +1,107 @@
 #pragma once
 
 #include <ProcessInfo.hpp>
+#include <UniqueFd.hpp>
+#include <cstdint>
 #include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
+#include <sys/stat.h>
 
 namespace proc
 {
 
+struct MalformedLine
+{
+    std::size_t _line; // 1-based
+    std::string _reason;
+};
+
+// one "Pid: 15386 cpu: 4.58% memory: 1.55% threads: 11 time: 0:0:2.400 user: 1000 session: 15386 name: bash" line of
+// an export, '\n' excluded. Numbers are read the way stod/stoi did, what follows them up to the next blank being
+// ignored. User and session are optional (0 when left out), so is the name which runs to the end of the line, `name`
+// (when given) views it in `line` ;
+// the reason of a rejection is returned, nullptr when the line was decoded
+const char* parseExportedLine(std::string_view line, uint& pid, PidStats& stats, std::string_view* name = nullptr);
+
+// every row of an export in file order, decoded the way ExportedFileWrapper does (duplicates included), the names
+// interned into `names` when given, left out otherwise ; false when the file cannot be opened. `threads` 0 -> one per core
+bool readExportedRows(const std::filesystem::path& exportedFilePath, std::vector<std::pair<uint, PidStats>>& rows,
+    std::vector<MalformedLine>& malformed, const uint threads = 0u, utils::StringTable* names = nullptr);
+
+// The whole export is mmap'ed and cut on line boundaries into chunks of at least kMinChunkBytes, decoded in parallel
+// with from_chars and merged in file order (the first row of a pid wins). Malformed lines are skipped and reported
+// with their line number, blank ones are ignored. The names are interned into the table of the wrapper, the ids of
+// its' rows refer to it.
+// Follow mode : the directory of the export is watched with inotify, a new export counting as published once it is
+// renamed over the path or closed after writing (a half written file is never read). refresh() then reparses it, unless
+// it is the same file or the same bytes as the snapshot held, and swaps the new snapshot in whole : getPids() and the
+// malformed lines are the new ones right away, a paging pass in progress (getCurrentIter, getPidsByStep) goes on over
+// the snapshot it started on, kept alive until resetIter() moves to the newest. The names table only grows, ids stay valid
 class ExportedFileWrapper
 {
 public:
-    explicit ExportedFileWrapper(const std::filesystem::path& exportedFilePath);
+    static constexpr std::size_t kMinChunkBytes = 1u << 20;
+
+    // `threads` 0 -> one per core
+    explicit ExportedFileWrapper(const std::filesystem::path& exportedFilePath, const uint threads = 0u);
     PidStatus_t getPidsByStep(const uint step);
     void toDebug();
     PidStatus_t& getPids();
     PidStatus_t::iterator getCurrentIter();
     bool isIterPointingEnd();
     void resetIter();
+    inline const std::vector<MalformedLine>& getMalformedLines() const { return _snapshot->_malformed; }
+    inline const utils::StringTable& getNames() const { return _names; }
+    // names of rows coming from elsewhere (a live scan) get an id here
+    inline utils::StringTable& accessNames() { return _names; }
+
+    // starts the follow mode ; false (logged) when inotify is unavailable, the wrapper then only changes on reload()
+    bool follow();
+    // back to changing on reload() only, the fd of the follow mode is closed
+    void unfollow();
+    // readable once something happened in the directory of the export, to be waited on with poll/epoll ; -1 -> not following
+    inline int getFollowFd() const { return _watch.valid() ? _watch.get() : -1; }
+    // drains the notifications without blocking ; true when a newly published export was swapped in
+    bool refresh();
+    // the export read again unless unchanged, whatever the notifications ; true when it was swapped in
+    bool reload();
+    // bumped by every swap, a reader holding rows can tell they are from an older snapshot
+    inline std::uint64_t getGeneration() const { return _generation; }
+
 private:
-    PidStatus_t _pids;
+    struct Snapshot
+    {
+        PidStatus_t _pids;
+        std::vector<MalformedLine> _malformed;
+    };
+    // what tells a published export from the one held without reading it
+    struct FileIdentity
+    {
+        std::uint64_t _device{0u};
+        std::uint64_t _inode{0u};
+        std::uint64_t _size{0u};
+        std::int64_t _modifiedNs{0};
+        bool operator==(const FileIdentity& other) const;
+    };
+    static FileIdentity identityOf(const struct stat& status);
+
+    void load(Snapshot& snapshot, std::string_view content, const uint threads);
+
+    std::filesystem::path _path;
+    uint _threads;
+    std::shared_ptr<Snapshot> _snapshot;
+    std::shared_ptr<Snapshot> _paged; // the snapshot _pidsIter walks
     PidStatus_t::iterator _pidsIter;
+    utils::StringTable _names;
+    FileIdentity _identity;
+    std::size_t _contentHash{0u}; // of the snapshot held, only computed while following
+    bool _hashed{false};
+    std::uint64_t _generation{0u};
+    utils::UniqueFd _watch; // inotify, on the directory : a rename over the export replaces its' inode
 };
 
-}
\ No newline at end of file
+}
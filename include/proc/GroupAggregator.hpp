@@ -0,0 +1,87 @@
+#pragma once
+
+#include <ProcessInfo.hpp>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Processes folded by executable name, user, session (stat field 6) or cgroup : count, cpu, memory and threads of each group.
+// A rebuild is one hash-aggregation pass over a snapshot ; after it the rows that change are handed over one at a
+// time and only their group moves, by the difference between the values it had and the new ones.
+// Every group keeps its' members in a vector (swap-remove, the slot of each pid remembered) so that expanding one costs
+// its' size and a frame costs the number of groups, whatever the number of processes
+namespace proc
+{
+namespace group
+{
+enum class GroupBy
+{
+    Name,
+    User,
+    Session
+};
+static constexpr const char* kGroupByLabels[] = {"Name", "User", "Session"};
+
+enum class Order
+{
+    Cpu,
+    Memory,
+    Threads,
+    Count
+};
+
+// what `stats` is grouped under : its' name id, uid, session or cgroup id
+std::uint32_t keyOf(const GroupBy by, const PidStats& stats);
+
+struct Group
+{
+    std::uint32_t _key;
+    double _cpu{0.0};
+    double _memory{0.0};
+    std::uint64_t _threads{0u};
+    std::vector<uint> _members; // pids, in no order
+};
+
+class Aggregator
+{
+public:
+    explicit Aggregator(const GroupBy by = GroupBy::Name) : _by(by) {}
+
+    // every group built again from `snapshot`, grouped by `by`
+    void rebuild(const PidStatus_t& snapshot, const GroupBy by);
+    // `pid` now has `stats` : added, or moved by the delta, to another group when its' key changed
+    void update(const uint pid, const PidStats& stats);
+    // nothing when `pid` isn't known
+    void remove(const uint pid);
+
+    // nullptr when no process has `key`
+    const Group* find(const std::uint32_t key) const;
+    // up to `count` groups, first by `order` (the key breaking ties) ; the cost is the number of
+    // groups, `top` is reused from one frame to the next
+    void top(const std::size_t count, const Order order, std::vector<const Group*>& top) const;
+
+    inline GroupBy getGroupBy() const { return _by; }
+    inline std::size_t size() const { return _groups.size(); }
+    inline std::size_t getProcessCount() const { return _members.size(); }
+
+private:
+    struct Member
+    {
+        std::uint32_t _key;
+        std::size_t _slot; // in the _members of its' group
+        double _cpu;
+        double _memory;
+        uint _threads;
+    };
+
+    Group& groupOf(const std::uint32_t key);
+    void leave(const uint pid, const Member& member);
+
+    GroupBy _by;
+    std::vector<Group> _groups;                             // no empty group, swap-removed
+    std::unordered_map<std::uint32_t, std::size_t> _index;  // key -> position in _groups
+    std::unordered_map<uint, Member> _members;
+};
+}
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <ProcessInfo.hpp>
+#include <Gorilla.hpp>
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Bounded in-memory history of the metrics, per process and for the whole system :
+// every series is a ring of blocks, a block holding up to kSamplesPerBlock samples as compressed columns
+// (timestamps delta-of-delta, cpu and memory delta coded after quantization to hundredths of a percent, the
+// precision of the export) plus the count/sum/max of each column.
+// The ring has room for the configured window (eg. 15 minutes at 1 Hz = 900 samples) and one more block, its' storage
+// being reserved up front : the memory of a tracked process never grows past getBudgetBytes(), whatever its' lifetime.
+// A block sealed early because its' columns were full (a very noisy series) shortens the covered window instead.
+// Window queries read the summaries of the blocks fully inside the window and only decode the others, the 95th
+// percentile decoding the values of the window once (O(samples))
+namespace proc
+{
+enum class Metric
+{
+    Cpu,
+    Memory
+};
+static constexpr std::size_t kMetricCount = 2u;
+
+struct WindowStats
+{
+    double _avg{0.0};
+    double _max{0.0};
+    double _p95{0.0};
+    std::size_t _samples{0u};
+};
+
+class MetricSeries
+{
+public:
+    static constexpr std::size_t kSamplesPerBlock = 64u;
+
+    explicit MetricSeries(const std::size_t maxBlocks);
+
+    void append(const std::int64_t timestampMs, const double cpu, const double memory);
+    void clear();
+
+    // samples taken at or after `fromMs` ; `scratch` holds the values for the percentile, its' capacity is reused
+    WindowStats query(const Metric metric, const std::int64_t fromMs, std::vector<std::int64_t>& scratch, const bool withPercentile = true) const;
+    // the `count` most recent values (less when the series is shorter), oldest first
+    void lastValues(const Metric metric, const std::size_t count, std::vector<double>& values) const;
+
+    std::size_t size() const;
+    inline std::int64_t lastTimestamp() const { return _lastMs; }
+    inline std::size_t getBudgetBytes() const { return _blocks.capacity() * sizeof(Block); }
+
+private:
+    // 12 words per column : 64 samples of 1 Hz timestamps with jitter, or of a busy metric, fit in 768 bits
+    struct Block
+    {
+        utils::gorilla::IntColumn<12u, 2u> _time;
+        std::array<utils::gorilla::IntColumn<12u, 1u>, kMetricCount> _values;
+        std::array<std::int64_t, kMetricCount> _sum{};
+        std::array<std::int64_t, kMetricCount> _max{};
+        std::int64_t _firstMs{0};
+        std::int64_t _lastMs{0};
+
+        void clear();
+        bool fits(const std::int64_t timestampMs, const std::array<std::int64_t, kMetricCount>& values) const;
+    };
+
+    // blocks from the oldest to the newest
+    template<class Visitor>
+    void forEachBlock(Visitor&& visitor) const;
+
+    std::size_t _maxBlocks;
+    std::vector<Block> _blocks;
+    std::size_t _oldest{0u};
+    std::int64_t _lastMs{0};
+};
+
+class MetricHistory
+{
+public:
+    // 15 minutes at 1 Hz
+    explicit MetricHistory(const std::size_t windowSamples = 900u);
+
+    // one tick of the processes : series of a pid whose starttime changed start over, series not fed for a whole
+    // window of ticks are dropped
+    void record(const std::int64_t timestampMs, const PidStatus_t& snapshot);
+    // total busy cpu and used memory percentages
+    void recordSystem(const std::int64_t timestampMs, const double cpu, const double memory);
+
+    // nullptr when the pid isn't tracked
+    const MetricSeries* find(const uint pid) const;
+    inline const MetricSeries& system() const { return _system; }
+    // over the `windowMs` up to the latest timestamp recorded
+    WindowStats query(const MetricSeries& series, const Metric metric, const std::int64_t windowMs) const;
+
+    inline std::size_t getTrackedCount() const { return _processes.size(); }
+    inline std::size_t getWindowSamples() const { return _windowSamples; }
+
+private:
+    struct Tracked
+    {
+        unsigned long long _startTime;
+        std::uint64_t _lastTick;
+        MetricSeries _series;
+    };
+
+    std::size_t blocksForWindow() const;
+
+    std::size_t _windowSamples;
+    std::uint64_t _tick{0u};
+    std::int64_t _lastRecordMs{0};
+    std::unordered_map<uint, Tracked> _processes;
+    MetricSeries _system;
+    mutable std::vector<std::int64_t> _scratch;
+};
+
+// "▁▂▄█▇▃" one glyph per sample of the last `width` ones, scaled to the highest of them (at least 1%) ;
+// blank on the left when the series is shorter than the width
+std::string renderSparkline(const MetricSeries& series, const Metric metric, const std::size_t width);
+}
\ No newline at end of file
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <ProcessInfo.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Where a process runs rather than how much : the cpu it last ran on (stat field 39, as the scan parsed it), how many
+// cpus its' affinity allows (sched_getaffinity, the Cpus_allowed mask of /proc/<pid>/status without the file) and how
+// much of its' memory sits on another NUMA node than that cpu, from /proc/<pid>/numa_maps :
+// 7f1c2a000000 default anon=512 dirty=512 N0=384 N1=128 kernelpagesize_kB=4
+// numa_maps walks every mapping of the process and is expensive, it is the slow tier : read at most every
+// kNumaRefreshMs per process and kNumaReadsPerSample per sample. Nothing is read for a process nobody looks at,
+// only the visible or flagged ones are handed to sample()
+namespace proc
+{
+namespace placement
+{
+static const std::filesystem::path kNodePath = "/sys/devices/system/node/";
+
+// "0-3,8,10-11" -> {0,1,2,3,8,10,11} ; false on a malformed list
+bool parseCpuList(std::string_view list, std::vector<uint>& cpus);
+
+// kB per node over every mapping, the pages weighted by their kernelpagesize_kB ; indexed by node
+std::vector<unsigned long long> parseNumaMaps(std::string_view content);
+
+// cpu -> node, from node<N>/cpulist. A host without the node directory is seen as one node
+class NumaTopology
+{
+public:
+    explicit NumaTopology(const std::filesystem::path& nodeRoot = kNodePath);
+    // -1 for a cpu not listed in any node
+    int nodeOfCpu(const int cpu) const;
+    inline std::size_t getNodeCount() const { return _nodeCount; }
+
+private:
+    std::vector<int> _cpuToNode;
+    std::size_t _nodeCount{1u};
+};
+
+struct Placement
+{
+    int _lastCpu{-1};
+    uint _allowedCpus{0u};
+    std::vector<unsigned long long> _kbPerNode; // empty -> numa_maps not read yet
+    std::int64_t _numaReadMs{0};
+    unsigned long long _startTime{0u};
+
+    // share of the memory living off the node of _lastCpu, in [0, 1] ; -1 when unknown
+    double remoteRatio(const NumaTopology& topology) const;
+};
+
+class PlacementSampler
+{
+public:
+    static constexpr std::int64_t kNumaRefreshMs = 10'000;
+    static constexpr std::size_t kNumaReadsPerSample = 8u;
+
+    explicit PlacementSampler(const std::filesystem::path& procRoot = kProcPath, NumaTopology topology = NumaTopology());
+
+    // the processes of `rows` only, the others are forgotten : the last cpu and the starttime are the ones of their' row,
+    // only the affinity (each time) and numa_maps (slow tier) are read
+    void sample(const std::vector<std::pair<uint, const PidStats*>>& rows, const std::int64_t nowMs);
+    // nullptr when not sampled (not asked for)
+    const Placement* find(const uint pid) const;
+    inline const NumaTopology& getTopology() const { return _topology; }
+
+private:
+    void readNumaMaps(const uint pid, Placement& placement);
+
+    std::filesystem::path _procRoot;
+    NumaTopology _topology;
+    std::unordered_map<uint, Placement> _placements;
+    std::vector<uint> _seen;
+    std::string _buffer; // numa_maps content, kept from one read to the next
+};
+
+// processes of `rows` that last ran on each cpu, the ones without a processor (not scanned) left out
+std::vector<uint> occupancy(const PidStatus_t& rows, const std::size_t cpus);
+
+// "| Processes per cpu: 2.1. 3..1" a digit per cpu ('.' none, '+' ten or more), a blank every 8 cpus
+std::string renderOccupancy(const std::vector<uint>& perCpu);
+}
+}
@@ -1,9 +1,18 @@
 #pragma once
 
+#include <array>
 #include <unordered_map>
 #include <string>
 #include <math.h>
+#include <charconv>
 #include <filesystem>
+#include <memory>
+#include <string_view>
+#include <vector>
+#include <BatchFileReader.hpp>
+#include <PidTable.hpp>
+#include <StringTable.hpp>
+#include <TickArena.hpp>
 
 // Sequence of number and their stats based on the number of appearence eg : 
 // 1415 (colord) S 1 1415 1415 0 -1 4194560 2271 2377 16 141 1 5 1 9 20 0 4 0 1266 328105984 3675 18446744073709551615 
@@ -67,12 +76,24 @@
 namespace proc
 {
 static const std::filesystem::path kProcPath = "/proc/";
+// relative to the parent of the directory the collector was started from
+static const std::filesystem::path kExportFile = "export/ProcessesStatus.txt";
 
 struct PidStats
 {
     double _cpu;
     double _memory;
     uint _threads;
+    // starttime (22) in clock ticks since boot, together with the pid it identifies a process across pid reuse
+    unsigned long long _startTime{0};
+    // processor (39), the cpu it last ran on ; -1 when unknown
+    int _processor{-1};
+    // comm (2) and the command line, ids in the StringTable of the owner of the row (collector, export wrapper)
+    utils::StringTable::Id _name{utils::StringTable::kEmpty};
+    utils::StringTable::Id _cmdline{utils::StringTable::kEmpty};
+    // owner of /proc/<pid> (the effective uid, read with the cmdline) and session (6), what processes are grouped by
+    uint _uid{0u};
+    uint _session{0u};
     // TODO: in C++20 use std::chrono and its' explicit members hh_mm_ss
     struct timezone
     {
@@ -84,42 +105,121 @@ struct PidStats
     struct timezone _timezone;
 };
 
+// a snapshot owned by value (export wrapper, monitor, diffs) ; the collector's live processes are a PidTable_t
 typedef std::unordered_map<uint, PidStats> PidStatus_t;
+// the fields of a stat file that matter, parsed in place : _values[i] is field kPositions[i] (comm being 2)
+struct StatFields
+{
+    static constexpr std::array<uint, 7u> kPositions{6u, 14u, 15u, 20u, 22u, 24u, 39u};
+
+    // field `position`, std::out_of_range when it isn't one of kPositions
+    long long at(const uint position) const;
+    inline bool operator==(const StatFields& other) const { return _values == other._values; }
+
+    std::array<long long, kPositions.size()> _values{};
+};
+// the live processes of the collector, updated in place from one scan to the next
+typedef utils::PidTable<PidStats> PidTable_t;
+
+class ExportWriter;
 
 class ProcessInfo
 {
 public:
-    ProcessInfo();
-    ~ProcessInfo()=default;
+    // the stat files of a scan are fetched through `ioBackend`, io_uring being used whenever the kernel allows it
+    explicit ProcessInfo(const utils::procfs::IoBackend ioBackend = utils::procfs::IoBackend::Auto);
+    ~ProcessInfo();
 
+    // scan then export, returns once the export file holds this scan
     void readAndDisplayProcDir();
+    // one pass over /proc : the processes seen are updated in place, the gone ones swept. No export is made
+    const PidTable_t& scanProcDir();
+    // priority pass ahead of a full scan : only `pids` are read, in that order, the missing ones left as they were
+    // and nothing swept
+    const PidTable_t& scanPids(const std::vector<uint>& pids);
+    // 1 in `stride` processes is read per scan, round robin on the pid, the others keeping their last values ; 1 -> all
+    inline void setSampleStride(const uint stride){ _sampleStride = stride == 0u ? 1u : stride; }
     std::string debugProcContent();
     inline const std::filesystem::path& getOldPath(){ return _oldPath; }
+    // the names of the rows of the collector
+    inline const utils::StringTable& getNames() const { return _names; }
+    // one more every time the names are compacted : the ids handed out before mean nothing anymore
+    inline std::uint64_t getNamesGeneration() const { return _namesGeneration; }
+    // blocks until the exports handed over so far are published
+    void waitForExport();
+    // listed then gone before their stat file could be read, since the collector was built
+    inline std::uint64_t getVanishedEntries() const { return _vanishedEntries; }
 
 protected:
     uint getPidNum(const std::filesystem::directory_entry& entry);
-    std::unordered_map<uint, std::string> fillStatMap(const std::filesystem::path& statDir);
+    StatFields fillStatMap(const std::filesystem::path& statDir);
+    StatFields parseStatLine(std::string_view statContent);
     double getGenericUptime(const std::filesystem::path& uptimePath);
-    double calculateCpu(const std::unordered_map<uint, std::string>& pidStat, const double& uptime);
-    double calculateMemory(const std::unordered_map<uint, std::string>& pidStat, const double meminfo);
+    double calculateCpu(const StatFields& pidStat, const double& uptime);
+    double calculateMemory(const StatFields& pidStat, const double meminfo);
+    // hands the current snapshot to the write-behind exporter, the file is replaced later on its' thread
     void exportInFile();
     double getMeminfo(const std::filesystem::path& meminfoPath);
-    PidStats::timezone calculateProcessUptime(const std::unordered_map<uint, std::string>& statMap, const double uptime);
+    PidStats::timezone calculateProcessUptime(const StatFields& statMap, const double uptime);
     
-    inline PidStatus_t& accessPidStatus(){ return _pidStatus; }
-    inline const PidStatus_t& getPidStatus() { return _pidStatus; } 
+    inline PidTable_t& accessPidStatus(){ return _pidStatus; }
+    inline const PidTable_t& getPidStatus() { return _pidStatus; }
     inline std::filesystem::path& accessOldPath(){ return _oldPath; }
 
+    // two decimals, rounded, eg. 0.05 -> "0.05%" ; the export itself goes through format::appendPercent
     inline std::string refineDouble(const double value)
     {
-        return value < 1 ? 
-            "0." + std::to_string(static_cast<int>(value*100)) + "%" 
-            : std::to_string(static_cast<int>(value)) + "." + std::to_string(static_cast<int>((value - static_cast<int>(value))*100)) + "%";
+        char refined[64];
+        char* end = std::to_chars(refined, refined + sizeof(refined) - 1, value, std::chars_format::fixed, 2).ptr;
+        *end++ = '%';
+        return std::string(refined, end);
     }
 
+    inline const utils::procfs::BatchFileReader& getStatReader() const { return *_statReader; }
+    inline const utils::TickArena& getTickArena() const { return _tickArena; }
+    // pids listed by the last scan, read or not
+    inline std::size_t getLastScanSize() const { return _lastScanSize; }
+    // cmdline files read since the collector was built, one per new process or exec
+    inline std::uint64_t getCmdlineReads() const { return _cmdlineReads; }
+
 private:
-    PidStatus_t _pidStatus;
+    // what the stat files of one scan are read against
+    struct Scan
+    {
+        double uptime;
+        double meminfo;
+        bool keepScanning;
+        std::pmr::vector<uint> pids;
+        utils::procfs::PathList statPaths;
+    };
+    // uptime and meminfo of `scan`, false (logged) when they cannot be read
+    bool beginScan(Scan& scan);
+    // every stat file of `scan` in one go, the pids read upserted
+    void readScan(Scan& scan);
+    // the name ids and the uid of `pid` : kept from `previous` while it is the same process under the same comm, comm
+    // and cmdline interned and the uid read again otherwise (a new process, or an exec)
+    void resolveNames(const uint pid, std::string_view comm, const PidStats* previous, PidStats& stats);
+    // the live names re-interned into a new table once the current one holds too many dead ones
+    void compactNames();
+
+    // sized from pid_max, its' memory stays the one of the peak of live processes
+    PidTable_t _pidStatus;
     std::filesystem::path _oldPath;
+    std::unique_ptr<utils::procfs::BatchFileReader> _statReader;
+    // built by the first export, its' writer thread lives as long as the collector
+    std::unique_ptr<ExportWriter> _exporter;
+    // temporaries of a scan, released at its' end
+    utils::TickArena _tickArena;
+    std::size_t _lastScanSize{0u};
+    // comm and cmdline of the processes, read once per (pid, starttime) and again on exec
+    utils::StringTable _names;
+    // bytes of _names right after its' last compaction
+    std::size_t _namesLiveBytes{0u};
+    std::uint64_t _namesGeneration{0u};
+    std::uint64_t _cmdlineReads{0u};
+    std::uint64_t _vanishedEntries{0u};
+    uint _sampleStride{1u};
+    uint _sampleRound{0u};
 };
 
 }
\ No newline at end of file
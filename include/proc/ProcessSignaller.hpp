@@ -0,0 +1,82 @@
+#pragma once
+
+#include <ProcessInfo.hpp>
+
+#include <chrono>
+#include <filesystem>
+#include <vector>
+
+// Kill/stop/continue for a whole selection of processes, race free against pid reuse :
+// 1) pidfd_open pins every target, whatever happens to the pid number afterwards the fd keeps pointing to that process
+// 2) /proc/<pid>/stat starttime (22) is compared with the one of the target (given with the pid, or the one of a scan) ;
+//    a mismatch means the pid got recycled in between, so that process is left alone
+// 3) pidfd_send_signal delivers through the pinned fd
+// 4) for terminating signals, all the fds are put in one epoll set (a pidfd turns readable on exit) and waited together
+// Every target costs a constant number of syscalls and no sleep-poll loop is involved. The soft RLIMIT_NOFILE is raised
+// up to the hard one for the pidfds ; beyond it the targets go in batches, each one waited for before the next
+namespace proc
+{
+namespace cli
+{
+struct Options;
+}
+
+struct SignalTarget
+{
+    uint _pid;
+    unsigned long long _startTime;
+};
+
+enum class SignalOutcome
+{
+    Exited,           // the process is gone after the signal
+    Delivered,        // signal sent and the process is still there (stop/cont or no exit waited for)
+    TimedOut,         // signal sent but the process didn't exit within the wait window
+    AlreadyGone,      // the pid didn't exist anymore before the signal
+    IdentityMismatch, // the pid was reused by another process, nothing was sent
+    PermissionDenied,
+    Unsupported,      // kernel without pidfd support
+    Failed
+};
+
+struct SignalReport
+{
+    uint _pid;
+    SignalOutcome _outcome;
+    int _errno{0};
+    // time between the signal and the observed exit (or the end of the wait for the rest)
+    std::chrono::microseconds _latency{0};
+};
+
+const char* toString(const SignalOutcome outcome);
+// accepts names with or without the SIG prefix (TERM, SIGKILL, ...) and plain numbers, -1 when unknown
+int parseSignal(std::string_view name);
+
+class ProcessSignaller
+{
+public:
+    explicit ProcessSignaller(const std::filesystem::path& procRoot = kProcPath);
+
+    // reports come back in the same order as the targets
+    std::vector<SignalReport> deliver(const std::vector<SignalTarget>& targets, const int signal, const std::chrono::milliseconds exitWait);
+
+protected:
+    // starttime (22) of /proc/<pid>/stat read with a single open/read/close, 0 when the process is gone
+    unsigned long long readStartTime(const uint pid) const;
+
+private:
+    // the `count` targets from `targets` with their' pidfds open together
+    void deliverBatch(const SignalTarget* targets, const std::size_t count, const int signal, const std::chrono::milliseconds exitWait,
+        std::vector<SignalReport>& reports);
+    void waitForExits(const std::vector<int>& pidfds, std::vector<SignalReport>& reports,
+        const std::vector<std::chrono::steady_clock::time_point>& sentAt, const std::chrono::milliseconds exitWait);
+
+    std::filesystem::path _procRoot;
+};
+
+namespace signalling
+{
+// signals the selected pid:starttime targets and prints one report line per target, in the order they were given
+int run(const cli::Options& options);
+}
+}
\ No newline at end of file
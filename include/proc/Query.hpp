@@ -0,0 +1,122 @@
+#pragma once
+
+#include <ProcessInfo.hpp>
+#include <StringTable.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Filters over the columns of a snapshot, eg. : cpu > 5 && mem > 1 && threads > 50 && uptime < 10m
+// Columns : cpu, memory|mem|rss (%), threads, uptime (s, or with a unit ms s m|min h), pid, uid|user (a number or a
+// login), session, name (a comm, quoted when it holds blanks : name == "Web Content")
+// Comparisons : > >= < <= == != (name : == != only) ; combined with && || ! and parentheses, && binding tighter
+// A filter is parsed once into a postfix program of column comparisons. It is evaluated over a batch of rows held
+// column by column, kBlockRows at a time : each comparison is a loop specialised on its' column type and operator
+// writing one bit per row, && || ! combine whole words, and the rows selected come out as a bitmap.
+// The same program serves the monitor, the batch stream, the diff and the offline selection of an export
+namespace proc
+{
+namespace cli
+{
+struct Options;
+}
+
+namespace query
+{
+enum class Column : std::uint8_t
+{
+    Pid,
+    Cpu,
+    Memory,
+    Threads,
+    Uptime,
+    Uid,
+    Session,
+    Name
+};
+
+enum class Comparison : std::uint8_t
+{
+    Less,
+    LessEqual,
+    Greater,
+    GreaterEqual,
+    Equal,
+    NotEqual
+};
+
+// a batch of rows, one vector per column ; names are ids of `_names` (no table -> every row has the empty name)
+struct Columns
+{
+    std::vector<uint> _pid;
+    std::vector<double> _cpu;
+    std::vector<double> _memory;
+    std::vector<uint> _threads;
+    std::vector<double> _uptime; // seconds
+    std::vector<uint> _uid;
+    std::vector<uint> _session;
+    std::vector<utils::StringTable::Id> _name;
+    const utils::StringTable* _names{nullptr};
+
+    void clear();
+    void reserve(const std::size_t rows);
+    void append(const uint pid, const PidStats& stats);
+    inline std::size_t size() const { return _pid.size(); }
+};
+
+// bit `row % 64` of word `row / 64`
+using Bitmap = std::vector<std::uint64_t>;
+inline bool isSelected(const Bitmap& selection, const std::size_t row) { return (selection[row / 64u] >> (row % 64u) & 1u) != 0u; }
+
+class Predicate
+{
+public:
+    static constexpr std::size_t kBlockRows = 1024u;
+
+    // every row
+    Predicate() = default;
+
+    // `selection` resized to the rows of `columns`, the bit of a row set when it holds
+    void evaluate(const Columns& columns, Bitmap& selection) const;
+
+    inline const std::string& getText() const { return _text; }
+    inline bool selectsAll() const { return _program.empty(); }
+
+private:
+    friend class Parser;
+    friend Predicate compile(std::string_view text);
+
+    enum class Op : std::uint8_t
+    {
+        Compare,
+        And,
+        Or,
+        Not
+    };
+    struct Instruction
+    {
+        Op _op;
+        Column _column;
+        Comparison _comparison;
+        double _value;       // numeric columns
+        std::string _string; // name
+    };
+
+    std::string _text;
+    std::vector<Instruction> _program; // postfix ; empty -> every row
+    std::size_t _depth{0u};            // of the bitmap stack
+};
+
+// throws SeverityException<SeriousException> on a malformed filter, telling where ; blank -> every row
+Predicate compile(std::string_view text);
+
+// the rows that hold kept in their order, the others dropped ; `names` is the table of their name ids
+void retain(std::vector<std::pair<uint, PidStats>>& rows, const Predicate& predicate, const utils::StringTable* names);
+
+// out --select EXPORT [--where FILTER] [-f text|csv|jsonl] [-o FILE] : the rows of an export that match
+int run(const cli::Options& options);
+}
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <ProcessInfo.hpp>
+#include <OutputBuffer.hpp>
+#include <UniqueFd.hpp>
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Threshold and alert rules, one per line in a rules file :
+// cpu > 80% for 30s          -> per process, the condition held for the whole duration
+// memory rising for 5m       -> per process, never dropping and above where it started (rss is an alias of memory)
+// threads >= 500             -> no duration, fires on the first tick it holds
+// count < 3 for 10s          -> whole system, the number of processes
+// count name=nginx < 2       -> whole system, the number of processes of that name (name="php fpm" with blanks)
+// Subjects : cpu, memory|rss (%), threads, uptime (s), count ; operators : > >= < <= rising ; durations : ms s m|min h
+// Rules are compiled once : the threshold rules of a subject are sorted so that the ones holding for a value are a
+// prefix, found with a binary search, and every process keeps the start of the streak of each of them along with when
+// the next one is due. A tick costs O(processes * subjects * log(rules)) plus the streaks starting, ending or due, and
+// never looks back at the history
+namespace proc
+{
+namespace rules
+{
+enum class Field : std::uint8_t
+{
+    Cpu,
+    Memory,
+    Threads,
+    Uptime,
+    Count
+};
+// the fields every process has, count being the system wide one
+static constexpr std::size_t kProcessFieldCount = 4u;
+
+enum class Kind : std::uint8_t
+{
+    Above,
+    AtLeast,
+    Below,
+    AtMost,
+    Rising
+};
+
+struct Rule
+{
+    std::string _text;
+    Field _field;
+    Kind _kind;
+    double _threshold{0.0};
+    std::int64_t _holdMs{0};
+    std::string _name; // count only, empty -> every process
+};
+
+// throws SeverityException<SeriousException> on malformed rules
+Rule compile(std::string_view text);
+// one rule per line, blank lines and '#' comments skipped ; the error tells the line
+std::vector<Rule> loadRules(const std::filesystem::path& rulesFile);
+
+struct Alert
+{
+    std::size_t _rule;
+    uint _pid; // 0 for the system wide rules
+    std::int64_t _sinceMs;
+    std::int64_t _firedMs;
+    double _value;
+};
+
+// "pid 1234 : cpu > 80% for 30s (value 93.20)"
+std::string describe(const Rule& rule, const Alert& alert);
+
+class RuleEngine
+{
+public:
+    explicit RuleEngine(std::vector<Rule> rules);
+
+    // the alerts fired by this tick : a condition fires once per streak, it can fire again after it stopped holding.
+    // `names` is the table of the name ids of the snapshot, the one `count name=` is looked up in (no table -> no
+    // process has the name)
+    const std::vector<Alert>& evaluate(const std::int64_t nowMs, const PidStatus_t& snapshot, const utils::StringTable* names = nullptr);
+    // the live table of the collector
+    const std::vector<Alert>& evaluate(const std::int64_t nowMs, const PidTable_t& snapshot, const utils::StringTable* names = nullptr);
+
+    inline const Rule& getRule(const std::size_t rule) const { return _rules[rule]; }
+    inline std::size_t getRuleCount() const { return _rules.size(); }
+    // conditions that fired and still hold
+    inline std::size_t getFiringCount() const { return _firing; }
+    inline std::size_t getTrackedCount() const { return _processes.size(); }
+
+private:
+    // a threshold rule normalized to `x > threshold` (strict) or `x >= threshold`, x being -value for Below/AtMost
+    struct Threshold
+    {
+        double _threshold;
+        bool _strict;
+        std::uint32_t _rule;
+        std::int64_t _holdMs;
+    };
+    struct Streak
+    {
+        std::int64_t _sinceMs;
+        bool _fired;
+    };
+    struct RisingStreak
+    {
+        double _startValue{0.0};
+        double _lastValue{0.0};
+        std::int64_t _sinceMs{0};
+        // the rising rules of a field are sorted by duration, the fired ones are a prefix
+        std::uint32_t _fired{0u};
+    };
+    // two threshold groups per field, upwards then downwards
+    static constexpr std::size_t kGroupCount = 2u * kProcessFieldCount;
+    static constexpr std::int64_t kNeverDue = std::numeric_limits<std::int64_t>::max();
+    struct Tracked
+    {
+        unsigned long long _startTime{0u};
+        std::uint64_t _tick{0u};
+        // the streaks of the rules holding, group after group
+        std::array<std::uint16_t, kGroupCount> _holding{};
+        std::vector<Streak> _streaks;
+        // per group, no streak can fire before : the streaks are only walked once it passed (right away at first)
+        std::array<std::int64_t, kGroupCount> _nextDueMs{};
+        std::array<RisingStreak, kProcessFieldCount> _rising{};
+    };
+
+    // fires the streaks of a group whose duration passed, returns when the next one is due
+    std::int64_t fireDueStreaks(const std::int64_t nowMs, const uint pid, const double value, const std::vector<Threshold>& thresholds, Streak* streaks, const std::size_t holding);
+    template<class Snapshot>
+    const std::vector<Alert>& evaluateSnapshot(const std::int64_t nowMs, const Snapshot& snapshot, const utils::StringTable* names);
+    // the value of each system wide rule : the size of the snapshot, or its' processes of the name of the rule
+    template<class Snapshot>
+    void countProcesses(const Snapshot& snapshot, const utils::StringTable* names);
+    void evaluateProcess(const std::int64_t nowMs, const uint pid, const std::array<double, kProcessFieldCount>& values, const bool fresh, Tracked& tracked);
+    void evaluateSystem(const std::int64_t nowMs);
+    void fire(const std::uint32_t rule, const uint pid, const std::int64_t sinceMs, const std::int64_t nowMs, const double value);
+    void forget(const Tracked& tracked);
+
+    std::vector<Rule> _rules;
+    std::array<std::vector<Threshold>, kGroupCount> _groups;
+    std::array<std::vector<std::uint32_t>, kProcessFieldCount> _risingRules;
+    // false when all the rules are system wide, the processes aren't tracked then
+    bool _perProcess{false};
+    std::vector<std::uint32_t> _systemRules;
+    std::vector<Streak> _systemStreaks;
+    std::vector<double> _systemCounts;
+    std::vector<RisingStreak> _systemRising;
+    bool _systemSeen{false};
+    // the name ids of the named count rules in the table of the tick, kEmpty for an unnamed one
+    std::vector<utils::StringTable::Id> _countedNames;
+    std::vector<bool> _countedNameKnown;
+
+    std::uint64_t _tick{0u};
+    std::unordered_map<uint, Tracked> _processes;
+    std::size_t _firing{0u};
+    std::vector<Alert> _fired;
+};
+
+// appends "<fired ms> <describe>" lines to a file, flushed once per tick
+class AlertLog
+{
+public:
+    // throws SeverityException<SeriousException> when the file cannot be opened
+    explicit AlertLog(const std::filesystem::path& logFile);
+
+    void append(const RuleEngine& engine, const std::vector<Alert>& alerts);
+
+private:
+    utils::UniqueFd _file;
+    utils::OutputBuffer _out;
+};
+}
+}
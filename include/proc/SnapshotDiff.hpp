@@ -0,0 +1,83 @@
+#pragma once
+
+#include <OutputBuffer.hpp>
+#include <ProcessInfo.hpp>
+#include <SnapshotFormat.hpp>
+
+#include <cstddef>
+#include <filesystem>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Two captures of the processes compared, eg. before and after a deploy : out --diff BEFORE [AFTER]
+// Both are held as arrays sorted by pid and merge-joined in one linear pass. Each pid ends up changed or unchanged
+// (in both), appeared (only after) or disappeared (only before). The top K movers of the ranked metric, appearances
+// and disappearances are kept in bounded heaps while the join runs : past the two arrays nothing grows with the captures.
+// An export doesn't carry the start time : a pid reused in between is seen as one process that changed
+namespace proc
+{
+namespace cli
+{
+struct Options;
+}
+
+namespace diff
+{
+enum class Metric
+{
+    Cpu,
+    Memory,
+    Threads
+};
+
+bool parseMetric(std::string_view name, Metric& metric);
+
+enum class Change
+{
+    Changed,
+    Appeared,
+    Disappeared
+};
+
+typedef std::vector<std::pair<uint, PidStats>> Rows_t;
+
+struct Mover
+{
+    uint _pid;
+    Change _change;
+    PidStats _before; // zeroed when appeared
+    PidStats _after;  // zeroed when disappeared
+    double _score;    // |after - before| of the metric when in both, its' value on the side that exists otherwise
+};
+
+struct DiffResult
+{
+    std::size_t _beforeCount{0u};
+    std::size_t _afterCount{0u};
+    std::size_t _changed{0u};   // cpu, memory or threads moved
+    std::size_t _unchanged{0u};
+    std::size_t _appeared{0u};
+    std::size_t _disappeared{0u};
+    // highest score first, ties by pid ; the movers are the changed pids whose ranked metric moved
+    std::vector<Mover> _movers;
+    std::vector<Mover> _appearedTop;
+    std::vector<Mover> _disappearedTop;
+};
+
+// by pid, the first row of a pid kept (same rule as ExportedFileWrapper)
+void sortByPid(Rows_t& rows);
+
+// both sorted by pid ; `topK` 0 -> every change kept, in pid order
+DiffResult diff(const Rows_t& before, const Rows_t& after, const Metric metric, const std::size_t topK);
+
+// human readable : counts, then the movers, appeared and disappeared sections
+void appendTable(utils::OutputBuffer& out, const DiffResult& result, const Metric metric,
+    std::string_view beforeName, std::string_view afterName);
+// one row per kept change, movers first, in the Csv (with its' header) or JsonLines format
+void appendStream(utils::OutputBuffer& out, const format::Kind kind, const DiffResult& result);
+
+// the diff mode of the command line, returns the process exit code
+int run(const cli::Options& options);
+}
+}
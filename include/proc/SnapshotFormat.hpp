@@ -0,0 +1,42 @@
+#pragma once
+
+#include <ProcessInfo.hpp>
+#include <CgroupCollector.hpp>
+#include <OutputBuffer.hpp>
+
+#include <cstdint>
+#include <string_view>
+
+// Row formatters of a snapshot, every one of them writes straight into an utils::OutputBuffer :
+// Text  -> Pid: 1415 cpu: 0.05% memory: 1.32% threads: 4 time: 0:20:31.700 user: 1000 session: 1415 name: colord
+//          (the export file format ; user and session left out when both are 0, the name when unknown)
+// Csv   -> 1700000000000,1415,0.05,1.32,4,1231.700                           (after the header line)
+// Jsonl -> {"ts":1700000000000,"pid":1415,"cpu":0.05,"memory":1.32,"threads":4,"uptime":1231.700}
+// Cgroup rows carry the same formats, with cpu in % of one CPU and memory in bytes :
+// Text  -> Cgroup: /kubepods/pod1 cpu: 12.50% memory: 104857600 pids: 12
+namespace proc
+{
+namespace format
+{
+enum class Kind
+{
+    Text,
+    Csv,
+    JsonLines
+};
+
+bool parseKind(std::string_view name, Kind& kind);
+
+// two decimals followed by '%', eg. 0.05 -> "0.05%"
+void appendPercent(utils::OutputBuffer& out, const double value);
+// header line for the formats that have one (Csv), nothing otherwise
+void appendHeader(utils::OutputBuffer& out, const Kind kind);
+// the timestamp is the wall-clock time of the snapshot in ms, the Text format ignores it ; `name` (the comm), the
+// user and the session are only written by the Text format, the Csv and JsonLines columns are left as they were
+void appendRow(utils::OutputBuffer& out, const Kind kind, const std::uint64_t timestampMs, const uint pid, const PidStats& stats,
+    std::string_view name = std::string_view());
+
+void appendCgroupHeader(utils::OutputBuffer& out, const Kind kind);
+void appendCgroupRow(utils::OutputBuffer& out, const Kind kind, const std::uint64_t timestampMs, const CgroupStats& stats);
+}
+}
\ No newline at end of file
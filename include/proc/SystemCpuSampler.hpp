@@ -0,0 +1,85 @@
+#pragma once
+
+#include <ProcessInfo.hpp>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// System wide CPU utilisation straight from /proc/stat, per core and in total :
+// cpu  10132153 290696 3084719 46828483 16683 0 25195 0 175628 0
+// cpu0 1393280 32966 572056 13343292 6130 0 17875 0 23933 0
+// | #  | Field      | Folded into |
+// | -- | ---------- | ----------- |
+// | 1  | user       | _user       |
+// | 2  | nice       | _user       |
+// | 3  | system     | _system     |
+// | 4  | idle       | _idle       |
+// | 5  | iowait     | _iowait     |
+// | 6  | irq        | _irq        |
+// | 7  | softirq    | _irq        |
+// | 8  | steal      | _steal      |
+// guest and guest_nice are already accounted inside user and nice.
+// The file is read with one read() into a buffer allocated once and the per-core counters live in arrays sized at
+// construction (hot-plugged cores grow them once), so a tick costs one small file read and no allocation.
+// A core gone offline has no line : its' usage is zeroed, and the first sample after it comes back only primes it again.
+namespace proc
+{
+struct CpuTimes
+{
+    unsigned long long _user{0u};
+    unsigned long long _nice{0u};
+    unsigned long long _system{0u};
+    unsigned long long _idle{0u};
+    unsigned long long _iowait{0u};
+    unsigned long long _irq{0u};
+    unsigned long long _softirq{0u};
+    unsigned long long _steal{0u};
+
+    inline unsigned long long sum() const { return _user + _nice + _system + _idle + _iowait + _irq + _softirq + _steal; }
+};
+
+// percentages of the elapsed time between two samples, they add up to 100
+struct CpuUsage
+{
+    double _user{0.0};
+    double _system{0.0};
+    double _idle{0.0};
+    double _iowait{0.0};
+    double _irq{0.0};
+    double _steal{0.0};
+
+    inline double busy() const { return _user + _system + _irq + _steal; }
+};
+
+class SystemCpuSampler
+{
+public:
+    explicit SystemCpuSampler(const std::filesystem::path& statPath = kProcPath / "stat");
+
+    // false when /proc/stat couldn't be read, the previous usage is kept then
+    bool sample();
+
+    inline const CpuUsage& getTotal() const { return _total; }
+    inline const std::vector<CpuUsage>& getCores() const { return _cores; }
+    // the first sample only primes the counters, usage is meaningful from the second one onwards
+    inline bool hasUsage() const { return _samples > 1u; }
+
+private:
+    void parse(std::string_view content);
+
+    std::filesystem::path _statPath;
+    std::vector<char> _readBuffer;
+    CpuTimes _previousTotal;
+    std::vector<CpuTimes> _previousCores;
+    CpuUsage _total;
+    std::vector<CpuUsage> _cores;
+    std::vector<unsigned long long> _coreSeen; // number of the last sample that had the core's line
+    unsigned long long _samples{0u};
+};
+
+// one line per core, for a handful of cores : "  0 [||||||||            ]  41.3%"
+std::string renderCpuBars(const std::vector<CpuUsage>& cores, const uint barWidth);
+// one glyph per core, `perRow` cores per row (at least one), the busier the denser " .:-=+*#%@" ; 256 cores fit in 4 rows of 64
+std::string renderCpuHeatmap(const std::vector<CpuUsage>& cores, const uint perRow);
+}
\ No newline at end of file
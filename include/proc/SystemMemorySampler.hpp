@@ -0,0 +1,80 @@
+#pragma once
+
+#include <ProcessInfo.hpp>
+
+#include <array>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// System memory and pressure, sampled together once per tick :
+// /proc/meminfo -> one read() into a fixed buffer, the configured keys are picked up in a single pass (values in kB)
+// /proc/pressure/{cpu,memory,io} -> PSI averages, the earliest saturation signal available :
+// some avg10=2.11 avg60=1.92 avg300=1.45 total=13936543
+// full avg10=0.00 avg60=0.00 avg300=0.00 total=0
+// "some" is the share of time at least one task stalled on the resource, "full" all of them at once (no full for cpu
+// before 5.13). Kernels without PSI (or booted with psi=0) just report the pressure as unavailable
+namespace proc
+{
+struct PressureStats
+{
+    double _someAvg10{0.0};
+    double _someAvg60{0.0};
+    double _someAvg300{0.0};
+    double _fullAvg10{0.0};
+    double _fullAvg60{0.0};
+    double _fullAvg300{0.0};
+    unsigned long long _someTotalUs{0u};
+    unsigned long long _fullTotalUs{0u};
+    bool _available{false};
+};
+
+enum class PressureResource
+{
+    Cpu,
+    Memory,
+    Io
+};
+
+class SystemMemorySampler
+{
+public:
+    // MemTotal and MemAvailable are always part of the keys, whatever is asked for
+    static const std::vector<std::string> kDefaultKeys;
+
+    explicit SystemMemorySampler(const std::filesystem::path& procRoot = kProcPath, const std::vector<std::string>& keys = kDefaultKeys);
+
+    // false when meminfo couldn't be read, the pressure being optional it never fails the sample
+    bool sample();
+
+    // kB of a configured key, false when the key isn't configured or wasn't in the last sample
+    bool getKb(std::string_view key, unsigned long long& kb) const;
+    inline unsigned long long getTotalKb() const { return _values[kMemTotalSlot]; }
+    // MemTotal - MemAvailable, the memory that cannot be handed out without reclaiming or swapping
+    unsigned long long getUsedKb() const;
+    double getUsedPercent() const;
+
+    inline const PressureStats& getPressure(const PressureResource resource) const { return _pressure[static_cast<std::size_t>(resource)]; }
+
+private:
+    static constexpr std::size_t kMemTotalSlot = 0u;
+    static constexpr std::size_t kMemAvailableSlot = 1u;
+
+    void parseMeminfo(std::string_view content);
+    void samplePressure(const PressureResource resource, const char* fileName);
+
+    std::filesystem::path _procRoot;
+    std::string _meminfoPath;
+    std::vector<std::string> _keys;
+    std::vector<unsigned long long> _values;
+    std::vector<bool> _found;
+    std::array<PressureStats, 3> _pressure;
+    std::array<char, 8192> _readBuffer;
+};
+
+// "6.3/16.0 GB used (39.4%)"
+std::string renderMemoryUsage(const SystemMemorySampler& memorySampler);
+// "cpu 2.11% | memory 0.00% | io 0.00%" from the some avg10 values, "n/a" per unavailable resource
+std::string renderPressure(const SystemMemorySampler& memorySampler);
+}
\ No newline at end of file
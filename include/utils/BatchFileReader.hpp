@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Batched readers of many small procfs files (one /proc/<pid>/stat per process) :
+// Sync    -> readFile per path, open/read/close one after another, 3 syscalls per file
+// IoUring -> the opens of up to kQueueDepth files are submitted with one io_uring_enter, then their linked
+//            read+close pairs with another one, so a whole batch costs a couple of syscall transitions.
+//            Needs IORING_OP_OPENAT/READ/CLOSE (5.6+) ; when io_uring is missing, disabled (kernel.io_uring_disabled)
+//            or filtered out by seccomp, Auto silently falls back to Sync. A failed io_uring_enter still hands every
+//            file of the batch over (the errno for the ones not read) and leaves the ring empty ; a ring that cannot
+//            be emptied is given up, the files then being read as Sync does
+// Raw syscalls on the uapi header, no liburing dependency
+namespace utils
+{
+namespace procfs
+{
+enum class IoBackend
+{
+    Auto,
+    Sync,
+    IoUring
+};
+
+// paths of a batch, usually drawn from the arena of a collector tick
+using PathList = std::pmr::vector<std::pmr::string>;
+
+// "auto", "sync" or "uring"
+bool parseIoBackend(std::string_view text, IoBackend& backend);
+
+// called once per path, in completion order : `content` is only valid until the call returns ;
+// `error` is the errno of a failed open/read, the content is empty then
+using FileConsumer = std::function<void(const std::size_t index, std::string_view content, const int error)>;
+
+class BatchFileReader
+{
+public:
+    // files bigger than that are truncated, /proc/<pid>/stat is well under 1KiB
+    static constexpr std::size_t kMaxFileSize = 4096u;
+
+    virtual ~BatchFileReader() = default;
+
+    virtual void readAll(const PathList& paths, const FileConsumer& consumer) = 0;
+    virtual const char* name() const = 0;
+
+    // syscalls issued by this reader since it was built
+    inline std::uint64_t getSyscalls() const { return _syscalls; }
+
+protected:
+    std::uint64_t _syscalls{0u};
+};
+
+class SyncFileReader : public BatchFileReader
+{
+public:
+    void readAll(const PathList& paths, const FileConsumer& consumer) override;
+    const char* name() const override { return "sync"; }
+
+private:
+    std::vector<char> _buffer = std::vector<char>(kMaxFileSize);
+};
+
+class IoUringFileReader : public BatchFileReader
+{
+public:
+    static constexpr unsigned kQueueDepth = 256u;
+
+    // nullptr when io_uring or one of the needed operations isn't available
+    static std::unique_ptr<IoUringFileReader> create();
+    ~IoUringFileReader() override;
+
+    IoUringFileReader(const IoUringFileReader&) = delete;
+    IoUringFileReader& operator=(const IoUringFileReader&) = delete;
+
+    void readAll(const PathList& paths, const FileConsumer& consumer) override;
+    const char* name() const override { return "io_uring"; }
+
+private:
+    struct Ring;
+
+    explicit IoUringFileReader(std::unique_ptr<Ring> ring);
+    void readChunk(const PathList& paths, const std::size_t first, const std::size_t count, const FileConsumer& consumer);
+    // after a failed io_uring_enter : the files of the chunk not handed over yet are, with `error` ; not `drained`
+    // (requests still in flight) the ring is given up
+    void failChunk(const std::size_t first, const std::size_t count, const int error, const bool drained, const FileConsumer& consumer);
+
+    std::unique_ptr<Ring> _ring;
+    std::vector<int> _fds;
+    std::vector<bool> _reported; // per file of the chunk in progress
+    std::vector<char> _buffers;
+    // a ring given up may still write into _buffers, the files are then read one after another into this one
+    bool _abandoned{false};
+    std::vector<char> _syncBuffer;
+};
+
+// Auto -> io_uring when usable, Sync otherwise ; IoUring -> nullptr when it isn't usable
+std::unique_ptr<BatchFileReader> makeBatchFileReader(const IoBackend backend);
+}
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <chrono>
+
+namespace utils
+{
+
+// Delta engine of monotonically increasing usage counters (cpu usec, jiffies, ...) :
+// the rate is the counter advance between two samples over the wall time that elapsed between them.
+// The first sample only primes the state, a counter that went backwards (reset, reused id) restarts it
+class CounterDelta
+{
+public:
+    // percentage of one CPU, `unitsPerSecond` being the counter resolution (1e6 for usec, CLK_TCK for jiffies)
+    inline double update(const unsigned long long counter, const std::chrono::steady_clock::time_point now, const double unitsPerSecond)
+    {
+        double percent{0.0};
+        if(_primed && counter >= _counter && now > _at)
+        {
+            const double elapsedSeconds = std::chrono::duration<double>(now - _at).count();
+            percent = 100.0 * (static_cast<double>(counter - _counter) / unitsPerSecond) / elapsedSeconds;
+        }
+        _counter = counter;
+        _at = now;
+        _primed = true;
+        return percent;
+    }
+
+    inline bool primed() const { return _primed; }
+
+private:
+    unsigned long long _counter{0u};
+    std::chrono::steady_clock::time_point _at;
+    bool _primed{false};
+};
+
+}
\ No newline at end of file
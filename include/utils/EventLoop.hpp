@@ -0,0 +1,69 @@
+#pragma once
+
+#include <UniqueFd.hpp>
+
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+// One epoll instance multiplexing everything an interactive loop waits on :
+// Input  -> a watched fd (stdin) became readable, the caller reads it
+// Signal -> one of the watched signals arrived through the signalfd, they are blocked for the whole process
+//           from watchSignals() on (call it before spawning threads so that every thread inherits the mask)
+// Wakeup -> wakeup() was called, `_count` times since the last wait, from any thread (eventfd), eg. a collector
+//           telling a new snapshot is ready
+// File   -> a watched fd of file system notifications (inotify) became readable, the caller drains it
+// Nothing spins : between two events the thread sleeps in epoll_wait
+namespace utils
+{
+class EventLoop
+{
+public:
+    enum class Source : std::uint8_t
+    {
+        Input,
+        Signal,
+        Wakeup,
+        File
+    };
+
+    struct Event
+    {
+        Source _source;
+        int _signal{0};
+        std::uint64_t _count{1u};
+    };
+
+    // throws SeverityException<SeriousException> when epoll or the eventfd cannot be created
+    EventLoop();
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    void watchInput(const int fd);
+    // stops watching the input, eg. once it reached EOF (it would be reported readable forever)
+    void unwatchInput();
+    void watchSignals(std::initializer_list<int> signals);
+    // eg. the one of a followed export, it stays ready until drained
+    void watchFile(const int fd);
+    // before the fd is closed, eg. once nothing follows the export anymore
+    void unwatchFile(const int fd);
+    // thread safe
+    void wakeup();
+
+    // blocks until at least one source is ready or `timeoutMs` passed (-1 -> forever) ; `events` is cleared first,
+    // the signal and wakeup sources are drained so they don't fire again for the same occurrence
+    std::size_t wait(std::vector<Event>& events, const int timeoutMs = -1);
+
+private:
+    void add(const int fd, const Source source);
+
+    UniqueFd _epoll;
+    UniqueFd _signals;
+    UniqueFd _wakeup;
+    int _input{-1};
+    // blocked by watchSignals, unblocked again by the dtor
+    std::vector<int> _blockedSignals;
+};
+}
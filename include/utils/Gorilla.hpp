@@ -0,0 +1,229 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Gorilla style compression of regular time series (Pelkonen et al., VLDB 2015), on integers :
+// the first value is stored raw, every next one as its' delta (Order 1, for the metrics) or as the delta of its'
+// delta (Order 2, for the timestamps of a fixed rate sampling) with a variable length prefix code :
+// | difference (zigzag)   | bits                  |
+// | --------------------- | --------------------- |
+// | 0                     | '0'                   |
+// | < 2^7                 | '10'   + 7            |
+// | < 2^12                | '110'  + 12           |
+// | < 2^20                | '1110' + 20           |
+// | anything else         | '1111' + 64           |
+// A steady series costs one bit per sample, a 1 Hz timestamp with a few ms of jitter nine.
+// Columns live in a fixed number of words : once full, append refuses the value and the caller seals the block
+namespace utils
+{
+namespace gorilla
+{
+template<std::size_t Words>
+class BitStream
+{
+public:
+    static constexpr std::uint32_t kCapacity = static_cast<std::uint32_t>(Words * 64u);
+
+    inline bool fits(const std::uint32_t bits) const { return _size + bits <= kCapacity; }
+    inline std::uint32_t size() const { return _size; }
+
+    // the `bits` low bits of value, most significant first ; fits(bits) has to be true
+    void write(std::uint64_t value, const unsigned bits)
+    {
+        value &= mask(bits);
+        const std::size_t word = _size / 64u;
+        const unsigned available = 64u - _size % 64u;
+        if(bits <= available)
+        {
+            _words[word] |= value << (available - bits);
+        }
+        else
+        {
+            _words[word] |= value >> (bits - available);
+            _words[word + 1u] |= value << (64u - (bits - available));
+        }
+        _size += bits;
+    }
+
+    std::uint64_t read(std::uint32_t& position, const unsigned bits) const
+    {
+        const std::size_t word = position / 64u;
+        const unsigned available = 64u - position % 64u;
+        position += bits;
+        if(bits <= available)
+        {
+            return (_words[word] >> (available - bits)) & mask(bits);
+        }
+        const std::uint64_t high = _words[word] & mask(available);
+        return (high << (bits - available)) | (_words[word + 1u] >> (64u - (bits - available)));
+    }
+
+    void clear()
+    {
+        _words.fill(0u);
+        _size = 0u;
+    }
+
+private:
+    static constexpr std::uint64_t mask(const unsigned bits) { return bits >= 64u ? ~0ull : (1ull << bits) - 1u; }
+
+    std::array<std::uint64_t, Words> _words{};
+    std::uint32_t _size{0u};
+};
+
+// width of the code of a difference, and the code itself
+inline unsigned encodedBits(const std::int64_t difference);
+template<std::size_t Words>
+void encode(BitStream<Words>& stream, const std::int64_t difference);
+template<std::size_t Words>
+std::int64_t decode(const BitStream<Words>& stream, std::uint32_t& position);
+
+template<std::size_t Words, unsigned Order>
+class IntColumn
+{
+    static_assert(Order == 1u || Order == 2u, "Delta or delta of delta");
+
+public:
+    // false (and nothing written) when the column is full
+    bool append(const std::int64_t value)
+    {
+        if(_count == 0u)
+        {
+            if(!_stream.fits(64u))
+            {
+                return false;
+            }
+            _stream.write(static_cast<std::uint64_t>(value), 64u);
+        }
+        else
+        {
+            const std::int64_t delta = value - _last;
+            const std::int64_t difference = Order == 1u ? delta : delta - _lastDelta;
+            if(!_stream.fits(encodedBits(difference)))
+            {
+                return false;
+            }
+            encode(_stream, difference);
+            _lastDelta = delta;
+        }
+        _last = value;
+        ++_count;
+        return true;
+    }
+
+    // room left for `value`
+    inline bool fits(const std::int64_t value) const
+    {
+        return _stream.fits(_count == 0u ? 64u : encodedBits(Order == 1u ? value - _last : value - _last - _lastDelta));
+    }
+    inline std::size_t count() const { return _count; }
+    inline std::uint32_t bits() const { return _stream.size(); }
+    inline std::int64_t last() const { return _last; }
+
+    void clear()
+    {
+        _stream.clear();
+        _count = 0u;
+        _last = 0;
+        _lastDelta = 0;
+    }
+
+    // sequential decoding, from the first value on
+    class Reader
+    {
+    public:
+        explicit Reader(const IntColumn& column) : _column(column) {}
+
+        std::int64_t next()
+        {
+            if(_read == 0u)
+            {
+                _value = static_cast<std::int64_t>(_column._stream.read(_position, 64u));
+            }
+            else
+            {
+                const std::int64_t difference = decode(_column._stream, _position);
+                _delta = Order == 1u ? difference : _delta + difference;
+                _value += _delta;
+            }
+            ++_read;
+            return _value;
+        }
+        inline bool done() const { return _read >= _column._count; }
+
+    private:
+        const IntColumn& _column;
+        std::uint32_t _position{0u};
+        std::size_t _read{0u};
+        std::int64_t _value{0};
+        std::int64_t _delta{0};
+    };
+
+private:
+    BitStream<Words> _stream;
+    std::size_t _count{0u};
+    std::int64_t _last{0};
+    std::int64_t _lastDelta{0};
+};
+
+inline std::uint64_t zigzag(const std::int64_t value)
+{
+    return (static_cast<std::uint64_t>(value) << 1u) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+inline std::int64_t unzigzag(const std::uint64_t value)
+{
+    return static_cast<std::int64_t>(value >> 1u) ^ -static_cast<std::int64_t>(value & 1u);
+}
+
+inline unsigned encodedBits(const std::int64_t difference)
+{
+    const std::uint64_t zigzagged = zigzag(difference);
+    return zigzagged == 0u ? 1u : (zigzagged < (1u << 7u) ? 9u : (zigzagged < (1u << 12u) ? 15u : (zigzagged < (1u << 20u) ? 24u : 68u)));
+}
+
+template<std::size_t Words>
+void encode(BitStream<Words>& stream, const std::int64_t difference)
+{
+    const std::uint64_t zigzagged = zigzag(difference);
+    if(zigzagged == 0u)
+    {
+        stream.write(0b0u, 1u);
+    }
+    else if(zigzagged < (1u << 7u))
+    {
+        stream.write(0b10u, 2u);
+        stream.write(zigzagged, 7u);
+    }
+    else if(zigzagged < (1u << 12u))
+    {
+        stream.write(0b110u, 3u);
+        stream.write(zigzagged, 12u);
+    }
+    else if(zigzagged < (1u << 20u))
+    {
+        stream.write(0b1110u, 4u);
+        stream.write(zigzagged, 20u);
+    }
+    else
+    {
+        stream.write(0b1111u, 4u);
+        stream.write(zigzagged, 64u);
+    }
+}
+
+template<std::size_t Words>
+std::int64_t decode(const BitStream<Words>& stream, std::uint32_t& position)
+{
+    static constexpr unsigned kWidths[] = {7u, 12u, 20u, 64u};
+    unsigned ones{0u};
+    while(ones < 4u && stream.read(position, 1u) == 1u)
+    {
+        ++ones;
+    }
+    return ones == 0u ? 0 : unzigzag(stream.read(position, kWidths[ones - 1u]));
+}
+}
+}
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <iostream>
+#include <string_view>
 
 static constexpr char ANSI_START[] = "\033[";
 static constexpr char RED[] = "1;31m";
@@ -11,29 +12,41 @@ static constexpr char CYAN[] = "1;36m";
 static constexpr char RESET[] = "0m";
 static constexpr char WHITE[] = "1;37m";
 
+namespace utils
+{
+// Every log macro writes through this sink. It points at std::cout unless a mode that owns stdout
+// (eg. batch streaming) redirects the diagnostics elsewhere
+inline std::ostream*& logSink()
+{
+    static std::ostream* sink = &std::cout;
+    return sink;
+}
+}
+
 namespace
 {
+// a view on __FILE__ : logging from the hot path doesn't allocate
 #define __LOGGING__SHORTEN__LOCATION__(path) \
 { \
-    std::string str(path); \
+    std::string_view str(path); \
     std::size_t lastSlash = str.find_last_of("/\\"); \
-    if(lastSlash != std::string::npos) \
+    if(lastSlash != std::string_view::npos) \
     { \
         str = str.substr(lastSlash+1); \
     } \
-    std::cout << ANSI_START << MAGENTA << str << "#" << __LINE__ << ": "; \
+    *utils::logSink() << ANSI_START << MAGENTA << str << "#" << __LINE__ << ": "; \
 }
 
 #define __LOGGING__(log, color) \
 { \
     __LOGGING__SHORTEN__LOCATION__(__FILE__); \
-    std::cout <<  ANSI_START << color << log << ANSI_START << RESET << std::endl; \
+    *utils::logSink() <<  ANSI_START << color << log << ANSI_START << RESET << std::endl; \
 }
 
 #define __LOGGING__UNIFIED(log, color) \
 { \
     __LOGGING__SHORTEN__LOCATION__(__FILE__) \
-    std::cout << ANSI_START << color << log << ANSI_START << RESET << std::endl; \
+    *utils::logSink() << ANSI_START << color << log << ANSI_START << RESET << std::endl; \
 }
 }
 
@@ -61,8 +74,3 @@ namespace
     #define DEBUG(log) \
         //nothing
 #endif
-
-namespace utils
-{
-
-}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace utils
+{
+
+// Reusable formatting buffer : numbers are rendered with std::to_chars straight into the storage and
+// the bytes are handed to the file descriptor with one large write() once the watermark is crossed.
+// The storage is allocated once in the ctor, so appending rows never touches the heap.
+// Without a file descriptor (fd < 0) the buffer keeps everything in memory and grows on demand.
+class OutputBuffer
+{
+public:
+    static constexpr std::size_t kDefaultCapacity = 1u << 16;
+
+    explicit OutputBuffer(const int fd = -1, const std::size_t capacity = kDefaultCapacity);
+    ~OutputBuffer();
+
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+    void append(const char c);
+    void append(std::string_view text);
+    void appendUint(const std::uint64_t value);
+    void appendInt(const std::int64_t value);
+    // zero padded on the left up to `width` digits, eg. (7, 3) -> "007"
+    void appendUintPadded(const std::uint64_t value, const unsigned width);
+    // fixed notation, rounded to `precision` decimals, eg. (0.05, 2) -> "0.05"
+    void appendFixed(const double value, const int precision);
+
+    void flush();
+    void clear();
+
+    inline std::string_view view() const { return std::string_view(_buffer.data(), _size); }
+    inline std::size_t size() const { return _size; }
+    inline int fd() const { return _fd; }
+
+private:
+    // guarantees `bytes` of free space after _size, flushing (or growing when memory backed)
+    char* reserveTail(const std::size_t bytes);
+
+    std::vector<char> _buffer;
+    std::size_t _size{0};
+    int _fd{-1};
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,255 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <sys/types.h>
+#include <utility>
+#include <vector>
+
+// Flat open-addressing table keyed by pid, for state living as long as the collector : linear probing on a
+// Fibonacci hash of the pid over two parallel arrays, the 8 bytes {pid, stamp} probed and the entries touched once
+// found. Every slot carries the generation of the last tick that saw its' pid :
+// beginTick() -> upsert()/touch() the pids seen -> sweep()
+// and the sweep drops every other one in a single linear pass, with backward-shift deletion so no tombstone is
+// ever left behind. The table grows by doubling at half load up to twice pid_max, and never shrinks : its' memory
+// follows the peak of live processes, not how many lived and died. Iteration is in slot order, unchanged by updates
+namespace utils
+{
+// /proc/sys/kernel/pid_max, the kernel upper limit (4194304) when it cannot be read
+std::size_t readPidMax();
+
+template<class Value>
+class PidTable
+{
+    struct Key
+    {
+        std::uint32_t _pid{0u};
+        std::uint32_t _stamp{0u}; // 0 -> empty slot
+    };
+
+public:
+    using value_type = std::pair<uint, Value>;
+    static constexpr std::size_t kMinCapacity = 64u;
+
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = typename PidTable::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type*;
+        using reference = const value_type&;
+
+        const_iterator(const PidTable* table, std::size_t slot) : _table(table), _slot(slot) { skipEmpty(); }
+        inline reference operator*() const { return _table->_entries[_slot]; }
+        inline pointer operator->() const { return &_table->_entries[_slot]; }
+        inline const_iterator& operator++() { ++_slot; skipEmpty(); return *this; }
+        inline bool operator==(const const_iterator& other) const { return _slot == other._slot; }
+        inline bool operator!=(const const_iterator& other) const { return _slot != other._slot; }
+
+    private:
+        inline void skipEmpty()
+        {
+            while(_slot < _table->_keys.size() && _table->_keys[_slot]._stamp == 0u)
+            {
+                ++_slot;
+            }
+        }
+
+        const PidTable* _table;
+        std::size_t _slot;
+    };
+
+    // `maxPids` bounds the growth, `expected` live pids are held without any rehash
+    explicit PidTable(const std::size_t maxPids = readPidMax(), const std::size_t expected = 0u)
+        : _maxCapacity(ceilPowerOfTwo(std::max<std::size_t>(maxPids, 1u)) * 2u)
+    {
+        rehash(std::min(_maxCapacity, std::max(kMinCapacity, ceilPowerOfTwo(expected * 2u))));
+    }
+
+    // a new generation : every pid is unseen until upserted or touched
+    inline void beginTick()
+    {
+        // 0 marks the empty slots, a wrapped generation skips it
+        if(++_generation == 0u)
+        {
+            ++_generation;
+        }
+    }
+
+    // the entry of `pid`, value-initialized when new ; seen by this tick either way
+    Value& upsert(const uint pid)
+    {
+        if((_size + 1u) * 2u > _keys.size() && _keys.size() < _maxCapacity)
+        {
+            rehash(_keys.size() * 2u);
+        }
+        std::size_t slot = home(pid);
+        while(_keys[slot]._stamp != 0u && _keys[slot]._pid != pid)
+        {
+            slot = (slot + 1u) & _mask;
+        }
+        if(_keys[slot]._stamp == 0u)
+        {
+            _keys[slot]._pid = pid;
+            _entries[slot] = value_type(pid, Value{});
+            ++_size;
+        }
+        _keys[slot]._stamp = _generation;
+        return _entries[slot].second;
+    }
+
+    // marks a pid seen without touching its' entry ; false when it isn't in the table
+    bool touch(const uint pid)
+    {
+        const std::size_t slot = locate(pid);
+        if(slot == kNotFound)
+        {
+            return false;
+        }
+        _keys[slot]._stamp = _generation;
+        return true;
+    }
+
+    // drops every pid not seen by this tick, returns how many
+    std::size_t sweep()
+    {
+        std::size_t swept{0u};
+        for(std::size_t slot=0; slot<_keys.size(); ++slot)
+        {
+            // the backward shift may bring another stale entry into this very slot
+            while(_keys[slot]._stamp != 0u && _keys[slot]._stamp != _generation)
+            {
+                eraseAt(slot);
+                ++swept;
+            }
+        }
+        return swept;
+    }
+
+    inline const Value* find(const uint pid) const
+    {
+        const std::size_t slot = locate(pid);
+        return slot == kNotFound ? nullptr : &_entries[slot].second;
+    }
+    inline Value* find(const uint pid)
+    {
+        const std::size_t slot = locate(pid);
+        return slot == kNotFound ? nullptr : &_entries[slot].second;
+    }
+    const Value& at(const uint pid) const
+    {
+        const Value* value = find(pid);
+        if(value == nullptr)
+        {
+            throw std::out_of_range("Pid " + std::to_string(pid) + " is not in the table");
+        }
+        return *value;
+    }
+
+    inline void clear()
+    {
+        for(Key& key : _keys)
+        {
+            key._stamp = 0u;
+        }
+        _size = 0u;
+    }
+
+    inline std::size_t size() const { return _size; }
+    inline bool empty() const { return _size == 0u; }
+    inline std::size_t capacity() const { return _keys.size(); }
+    inline const_iterator begin() const { return const_iterator(this, 0u); }
+    inline const_iterator end() const { return const_iterator(this, _keys.size()); }
+
+private:
+    static constexpr std::size_t kNotFound = static_cast<std::size_t>(-1);
+    // 2^32 / golden ratio, consecutive pids end up far apart instead of in one long probe run
+    static constexpr std::uint32_t kFibonacci = 2654435769u;
+
+    static std::size_t ceilPowerOfTwo(const std::size_t value)
+    {
+        std::size_t power{1u};
+        while(power < value)
+        {
+            power <<= 1u;
+        }
+        return power;
+    }
+
+    inline std::size_t home(const uint pid) const
+    {
+        return static_cast<std::size_t>((static_cast<std::uint64_t>(static_cast<std::uint32_t>(pid * kFibonacci)) << _bits) >> 32u);
+    }
+
+    std::size_t locate(const uint pid) const
+    {
+        for(std::size_t slot = home(pid); _keys[slot]._stamp != 0u; slot = (slot + 1u) & _mask)
+        {
+            if(_keys[slot]._pid == pid)
+            {
+                return slot;
+            }
+        }
+        return kNotFound;
+    }
+
+    // empties `hole` then pulls back the following entries of the run that may live there
+    void eraseAt(std::size_t hole)
+    {
+        _keys[hole]._stamp = 0u;
+        --_size;
+        for(std::size_t slot = (hole + 1u) & _mask; _keys[slot]._stamp != 0u; slot = (slot + 1u) & _mask)
+        {
+            // movable when its' home isn't between the hole (excluded) and where it sits
+            if(((slot - home(_keys[slot]._pid)) & _mask) >= ((slot - hole) & _mask))
+            {
+                _keys[hole] = _keys[slot];
+                _entries[hole] = std::move(_entries[slot]);
+                _keys[slot]._stamp = 0u;
+                hole = slot;
+            }
+        }
+    }
+
+    void rehash(const std::size_t capacity)
+    {
+        std::vector<Key> keys(capacity);
+        std::vector<value_type> entries(capacity);
+        keys.swap(_keys);
+        entries.swap(_entries);
+        _mask = capacity - 1u;
+        _bits = 0u;
+        while((std::size_t(1u) << _bits) < capacity)
+        {
+            ++_bits;
+        }
+        for(std::size_t slot=0; slot<keys.size(); ++slot)
+        {
+            if(keys[slot]._stamp == 0u)
+            {
+                continue;
+            }
+            std::size_t target = home(keys[slot]._pid);
+            while(_keys[target]._stamp != 0u)
+            {
+                target = (target + 1u) & _mask;
+            }
+            _keys[target] = keys[slot];
+            _entries[target] = std::move(entries[slot]);
+        }
+    }
+
+    std::vector<Key> _keys;
+    std::vector<value_type> _entries;
+    std::size_t _size{0u};
+    std::size_t _mask{0u};
+    uint _bits{0u};
+    std::size_t _maxCapacity;
+    std::uint32_t _generation{1u};
+};
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+#include <sys/types.h>
+
+// Readers for the small virtual files of procfs/sysfs/cgroupfs : the whole content is fetched with a single
+// open/read/close into a caller owned buffer and parsed in place, no stream and no heap involved
+namespace utils
+{
+namespace procfs
+{
+// bytes read, -1 when the file cannot be opened or read. The content is truncated to `capacity`
+ssize_t readFile(const char* path, char* buffer, const std::size_t capacity);
+
+// first unsigned integer of `text`, leading blanks skipped
+bool parseUnsigned(std::string_view text, unsigned long long& value);
+
+// value of a "key value" or "key: value kB" line, eg. cpu.stat, meminfo ; the key has to start a line
+bool findKeyValue(std::string_view content, std::string_view key, unsigned long long& value);
+}
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <termios.h>
+
+// RAII raw mode of a terminal : no line buffering and no echo, so that every key reaches the monitor as soon as it
+// is pressed, and reads never block (O_NONBLOCK). Ctrl-C still raises SIGINT (ISIG kept) for the event loop to catch.
+// Everything is put back by the dtor ; on something that isn't a terminal (a pipe, a test) nothing is changed
+namespace utils
+{
+class RawTerminal
+{
+public:
+    explicit RawTerminal(const int fd);
+    ~RawTerminal();
+
+    RawTerminal(const RawTerminal&) = delete;
+    RawTerminal& operator=(const RawTerminal&) = delete;
+
+    inline bool isRaw() const { return _raw; }
+
+private:
+    int _fd;
+    bool _raw{false};
+    int _flags{-1};
+    termios _original{};
+};
+}
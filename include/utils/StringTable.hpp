@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// Interned strings (process names, command lines) : every distinct string is stored once and known by a 32-bit id,
+// so that rows hold ids and comparing, grouping or sorting by name compares integers. The hundreds of php-fpm or
+// java of a host share one copy.
+// The characters live in blocks of kBlockBytes that never move, a view stays valid as long as the table ; the ids
+// index a flat array of views and an open addressing index (linear probing, power of two) finds a string by its' hash.
+// Nothing is ever removed : an owner whose strings come and go (pids exiting) interns the live ones into a new table
+// once this one has grown too much, and swaps
+namespace utils
+{
+class StringTable
+{
+public:
+    using Id = std::uint32_t;
+    // the empty string, every table has it
+    static constexpr Id kEmpty = 0u;
+    static constexpr std::size_t kBlockBytes = 64u * 1024u;
+
+    StringTable();
+
+    // the id of `text`, stored if first seen ; control characters (a '\n' in a comm) are replaced by '?'
+    Id intern(std::string_view text);
+    // the id of `text` when it was interned, nothing stored ; false otherwise
+    bool find(std::string_view text, Id& id) const;
+    // kEmpty's view for an id the table doesn't have
+    inline std::string_view view(const Id id) const { return id < _views.size() ? _views[id] : std::string_view(); }
+
+    // distinct strings, the empty one included
+    inline std::size_t size() const { return _views.size(); }
+    // characters stored
+    inline std::size_t bytes() const { return _bytes; }
+
+private:
+    std::string_view store(std::string_view text);
+    void grow();
+
+    std::vector<std::unique_ptr<char[]>> _blocks;
+    char* _current{nullptr};     // free part of the block being filled
+    std::size_t _currentLeft{0u};
+    std::size_t _bytes{0u};
+    std::vector<std::string_view> _views;
+    std::vector<std::size_t> _hashes; // of every id, the index is rebuilt without hashing again
+    std::vector<Id> _slots;           // id + 1, 0 -> free
+};
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <optional>
+#include <vector>
+
+// Monotonic arena for the temporaries of one collector tick (stat paths, tokens, stat maps...) :
+// allocating is a pointer bump, freeing is a no-op and everything is dropped at once by reset() at the end of the
+// tick. The arena lives in one buffer kept from tick to tick ; a tick needing more spills to the heap, and the buffer
+// is grown at the next reset so that a steady-state tick never reaches the global operator new
+namespace utils
+{
+class TickArena
+{
+public:
+    static constexpr std::size_t kDefaultCapacity = 64u * 1024u;
+
+    explicit TickArena(const std::size_t capacity = kDefaultCapacity);
+    TickArena(const TickArena&) = delete;
+    TickArena& operator=(const TickArena&) = delete;
+
+    inline std::pmr::memory_resource* resource() { return &*_arena; }
+    // nothing handed out by resource() may be used afterwards
+    void reset();
+
+    inline std::size_t getCapacity() const { return _buffer.size(); }
+    // bytes that did not fit in the buffer since the last reset
+    inline std::size_t getSpilledBytes() const { return _spill._bytes; }
+
+    // resets the arena when leaving the scope of a tick ; to be declared before the containers drawing from it
+    class Scope
+    {
+    public:
+        explicit Scope(TickArena& arena) : _arena(arena) {}
+        ~Scope() { _arena.reset(); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        TickArena& _arena;
+    };
+
+private:
+    // upstream of the arena, only there to notice the spills
+    class SpillResource : public std::pmr::memory_resource
+    {
+    public:
+        std::size_t _bytes{0u};
+
+    private:
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+        void do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+    };
+
+    std::vector<std::byte> _buffer;
+    SpillResource _spill;
+    std::optional<std::pmr::monotonic_buffer_resource> _arena;
+};
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <unistd.h>
+#include <utility>
+
+namespace utils
+{
+
+// RAII owner of a raw file descriptor, closes it once it goes out of scope
+// -1 is the "nothing owned" value, same as the kernel convention
+class UniqueFd
+{
+public:
+    UniqueFd() = default;
+    explicit UniqueFd(const int fd) : _fd(fd) {}
+    ~UniqueFd() { reset(); }
+
+    UniqueFd(const UniqueFd&) = delete;
+    UniqueFd& operator=(const UniqueFd&) = delete;
+    UniqueFd(UniqueFd&& other) noexcept : _fd(std::exchange(other._fd, -1)) {}
+    UniqueFd& operator=(UniqueFd&& other) noexcept
+    {
+        if(this != &other)
+        {
+            reset(std::exchange(other._fd, -1));
+        }
+        return *this;
+    }
+
+    inline int get() const { return _fd; }
+    inline bool valid() const { return _fd >= 0; }
+    inline int release() { return std::exchange(_fd, -1); }
+    inline void reset(const int fd = -1)
+    {
+        if(_fd >= 0)
+        {
+            ::close(_fd);
+        }
+        _fd = fd;
+    }
+
+private:
+    int _fd{-1};
+};
+
+}
\ No newline at end of file
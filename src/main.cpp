@@ -2,22 +2,83 @@
 #include <Validator.hpp>
 #include <LogTrace.hpp>
 #include <Cli.hpp>
+#include <CliOptions.hpp>
+#include <BatchMode.hpp>
+#include <ProcessSignaller.hpp>
+#include <SnapshotDiff.hpp>
+#include <Query.hpp>
+#include <ChurnBench.hpp>
+#include <Exception.hpp>
+#include <Profiler.hpp>
 
-// Filesystems only for C++17 as std::filesystem starts to exist from 17 and onwards
-int main()
+#include <unistd.h>
+
+namespace
 {
+int run(const proc::cli::Options& options)
+{
+    if(options._mode == proc::cli::Mode::Batch)
+    {
+        return proc::batch::run(options);
+    }
+    if(options._mode == proc::cli::Mode::Signal)
+    {
+        return proc::signalling::run(options);
+    }
+    if(options._mode == proc::cli::Mode::Diff)
+    {
+        return proc::diff::run(options);
+    }
+    if(options._mode == proc::cli::Mode::Select)
+    {
+        return proc::query::run(options);
+    }
+    if(options._mode == proc::cli::Mode::ChurnBench)
+    {
+        return proc::churn::run(options);
+    }
+
+    // on a terminal the monitor shows the last export right away and scans behind it, otherwise (scripts, the
+    // regression run) a single scan is exported and validated
+    if(::isatty(STDIN_FILENO) && ::isatty(STDOUT_FILENO))
+    {
+        proc::cli::display(std::filesystem::current_path().parent_path() / proc::kExportFile, options);
+        return 0;
+    }
+
     //method that will be removed as it will go to a function later;
-    proc::ProcessInfo aProcess;
+    proc::ProcessInfo aProcess(options._ioBackend);
     aProcess.readAndDisplayProcDir();
 
-    const std::filesystem::path exportedFile(aProcess.getOldPath().parent_path() / "export/ProcessesStatus.txt");
+    const std::filesystem::path exportedFile(aProcess.getOldPath().parent_path() / proc::kExportFile);
     if(!utils::validator::validateExportedFile(exportedFile))
     {
         ERROR("Validation failed. Check your file for potential corruptions");
         return 1;
     }
 
-    // proc::cli::display(exportedFile);
-    
     return 0;
-}
\ No newline at end of file
+}
+}
+
+// Filesystems only for C++17 as std::filesystem starts to exist from 17 and onwards
+int main(int argc, char* argv[])
+{
+    proc::cli::Options options;
+    try
+    {
+        options = proc::cli::parseOptions(argc, argv);
+    }
+    catch(const utils::SeverityException<utils::SeriousException>& e)
+    {
+        ERROR(e.what());
+        return 2;
+    }
+
+    const int status = run(options);
+    if(!options._profileOutput.empty())
+    {
+        utils::profiling::Profiler::instance().dumpJson(options._profileOutput);
+    }
+    return status;
+}
@@ -0,0 +1,151 @@
+#include <BatchMode.hpp>
+#include <CgroupCollector.hpp>
+#include <CollectorBudget.hpp>
+#include <Exception.hpp>
+#include <LogTrace.hpp>
+#include <OutputBuffer.hpp>
+#include <ProcessInfo.hpp>
+#include <Query.hpp>
+#include <RuleEngine.hpp>
+#include <SnapshotFormat.hpp>
+#include <UniqueFd.hpp>
+
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <thread>
+#include <unistd.h>
+
+namespace proc
+{
+namespace batch
+{
+namespace
+{
+std::uint64_t wallClockMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// runs `emitSnapshot(timestampMs)` N times on absolute deadlines, so the scan duration doesn't drift the sampling period.
+// Every emission is charged to `budget`, the next deadline moving further away while the collector is over it
+template<class EmitSnapshot>
+void streamSnapshots(const cli::Options& options, utils::OutputBuffer& out, budget::CollectorBudget& collectorBudget, EmitSnapshot&& emitSnapshot)
+{
+    const std::chrono::steady_clock::duration delay = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(options._delaySeconds));
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now();
+    bool degraded{false};
+    for(uint iteration=0; iteration<options._iterations; ++iteration)
+    {
+        if(iteration > 0)
+        {
+            std::this_thread::sleep_until(deadline);
+        }
+        collectorBudget.beginTick();
+        emitSnapshot(wallClockMs());
+        collectorBudget.endTick();
+        out.flush();
+
+        // stdout stays parsable, the operator learns how fresh the numbers are from stderr
+        if(collectorBudget.isDegraded() != degraded)
+        {
+            degraded = collectorBudget.isDegraded();
+            WARNING((degraded ? "Collector over its' budget : " : "Collector back within its' budget : ") << collectorBudget.describe());
+        }
+        deadline += degraded ? std::chrono::duration_cast<std::chrono::steady_clock::duration>(collectorBudget.getInterval()) : delay;
+    }
+}
+}
+
+int run(const cli::Options& options)
+{
+    utils::logSink() = &std::cerr;
+
+    // the collector moves the working directory to /proc, a relative output path has to be opened before that
+    utils::UniqueFd outputFile;
+    if(!options._output.empty())
+    {
+        outputFile.reset(::open(options._output.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+        if(!outputFile.valid())
+        {
+            ERROR("Cannot open " << options._output << " for streaming : " << std::strerror(errno));
+            return 1;
+        }
+    }
+
+    utils::OutputBuffer out(outputFile.valid() ? outputFile.get() : STDOUT_FILENO);
+    budget::applyPriority(options._priority);
+    budget::CollectorBudget collectorBudget(options._budgetPercent, std::chrono::milliseconds(static_cast<std::int64_t>(options._delaySeconds * 1000.0)));
+    try
+    {
+        if(options._cgroups)
+        {
+            CgroupCollector cgroups;
+            format::appendCgroupHeader(out, options._format);
+            streamSnapshots(options, out, collectorBudget, [&](const std::uint64_t timestampMs)
+            {
+                for(const CgroupStats& cgroup : cgroups.sample())
+                {
+                    format::appendCgroupRow(out, options._format, timestampMs, cgroup);
+                }
+            });
+            return 0;
+        }
+
+        std::unique_ptr<rules::RuleEngine> ruleEngine;
+        std::unique_ptr<rules::AlertLog> alertLog;
+        if(!options._rulesFile.empty())
+        {
+            ruleEngine = std::make_unique<rules::RuleEngine>(rules::loadRules(options._rulesFile));
+            alertLog = std::make_unique<rules::AlertLog>(options._alertLog);
+        }
+
+        ProcessInfo collector(options._ioBackend);
+        const query::Predicate filter = query::compile(options._where);
+        query::Columns columns;
+        query::Bitmap selection;
+        format::appendHeader(out, options._format);
+        streamSnapshots(options, out, collectorBudget, [&](const std::uint64_t timestampMs)
+        {
+            collector.setSampleStride(collectorBudget.getStride());
+            const PidTable_t& snapshot = collector.scanProcDir();
+            // the whole snapshot goes through the filter at once, the rows are then emitted in the order of the table
+            if(!filter.selectsAll())
+            {
+                columns.clear();
+                columns._names = &collector.getNames();
+                columns.reserve(snapshot.size());
+                for(const PidTable_t::value_type& pidWithStats : snapshot)
+                {
+                    columns.append(pidWithStats.first, pidWithStats.second);
+                }
+                filter.evaluate(columns, selection);
+            }
+            std::size_t row{0u};
+            for(const PidTable_t::value_type& pidWithStats : snapshot)
+            {
+                if(filter.selectsAll() || query::isSelected(selection, row))
+                {
+                    format::appendRow(out, options._format, timestampMs, pidWithStats.first, pidWithStats.second,
+                        collector.getNames().view(pidWithStats.second._name));
+                }
+                ++row;
+            }
+            if(ruleEngine)
+            {
+                alertLog->append(*ruleEngine, ruleEngine->evaluate(static_cast<std::int64_t>(timestampMs), snapshot, &collector.getNames()));
+            }
+        });
+    }
+    catch(const utils::SeverityException<utils::SeriousException>& e)
+    {
+        ERROR("Batch streaming stopped : " << e.what());
+        return 1;
+    }
+
+    return 0;
+}
+
+}
+}
\ No newline at end of file
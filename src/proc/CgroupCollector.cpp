@@ -0,0 +1,145 @@
+#include <CgroupCollector.hpp>
+#include <LogTrace.hpp>
+#include <ProcFile.hpp>
+
+#include <algorithm>
+#include <fstream>
+
+namespace proc
+{
+namespace
+{
+static constexpr double kMicrosecondsPerSecond = 1e6;
+}
+
+CgroupCollector::CgroupCollector(const std::filesystem::path& cgroupRoot)
+    : _cgroupRoot(cgroupRoot)
+{
+    // hybrid hosts mount the v1 controllers at the root and the unified hierarchy one level below
+    std::error_code error;
+    if(!std::filesystem::exists(_cgroupRoot / "cgroup.controllers", error)
+        && std::filesystem::exists(_cgroupRoot / "unified" / "cgroup.controllers", error))
+    {
+        _cgroupRoot /= "unified";
+        NOTIFY("Hybrid cgroup layout, using the unified hierarchy at " << _cgroupRoot);
+    }
+}
+
+bool CgroupCollector::readCgroup(const std::filesystem::path& directory, CgroupStats& stats)
+{
+    char content[1024];
+    const ssize_t cpuBytes = utils::procfs::readFile((directory / "cpu.stat").c_str(), content, sizeof(content));
+    if(cpuBytes <= 0 || !utils::procfs::findKeyValue(std::string_view(content, cpuBytes), "usage_usec", stats._usageUsec))
+    {
+        return false;
+    }
+
+    // the root cgroup has no memory.current nor pids.current, zero is the honest value there
+    stats._memoryBytes = 0u;
+    const ssize_t memoryBytes = utils::procfs::readFile((directory / "memory.current").c_str(), content, sizeof(content));
+    if(memoryBytes > 0)
+    {
+        utils::procfs::parseUnsigned(std::string_view(content, memoryBytes), stats._memoryBytes);
+    }
+
+    stats._pids = 0u;
+    const ssize_t pidsBytes = utils::procfs::readFile((directory / "pids.current").c_str(), content, sizeof(content));
+    if(pidsBytes > 0)
+    {
+        utils::procfs::parseUnsigned(std::string_view(content, pidsBytes), stats._pids);
+    }
+    return true;
+}
+
+const std::vector<CgroupStats>& CgroupCollector::sample(const std::chrono::steady_clock::time_point now)
+{
+    ++_tick;
+    _cgroups.clear();
+
+    // with the trailing separator, the path of a cgroup is what follows the root string
+    const std::string rootString = (_cgroupRoot / "").lexically_normal().string();
+    const auto collect = [&](const std::filesystem::path& directory)
+    {
+        CgroupStats stats;
+        if(!readCgroup(directory, stats))
+        {
+            return;
+        }
+
+        const std::string directoryString = directory.lexically_normal().string();
+        stats._path = "/" + directoryString.substr(std::min(rootString.size(), directoryString.size()));
+        if(stats._path.size() > 1u && stats._path.back() == '/')
+        {
+            stats._path.pop_back();
+        }
+
+        CpuState& cpuState = _cpuStates[stats._path];
+        stats._cpu = cpuState._delta.update(stats._usageUsec, now, kMicrosecondsPerSecond);
+        cpuState._lastSeenTick = _tick;
+        _cgroups.push_back(std::move(stats));
+    };
+
+    // one directory at a time rather than a recursive_directory_iterator : that one ends the whole walk when a
+    // directory it is about to enter was removed, what containers exiting do all the time
+    std::vector<std::filesystem::path> directories{_cgroupRoot};
+    while(!directories.empty())
+    {
+        const std::filesystem::path directory = std::move(directories.back());
+        directories.pop_back();
+        collect(directory);
+
+        std::error_code error;
+        for(std::filesystem::directory_iterator entry(directory, std::filesystem::directory_options::skip_permission_denied, error), end;
+            !error && entry != end; entry.increment(error))
+        {
+            if(entry->is_directory(error))
+            {
+                directories.push_back(entry->path());
+            }
+            // listed, then removed before it could be looked at
+            if(error == std::errc::no_such_file_or_directory)
+            {
+                error.clear();
+            }
+        }
+        // removed before it could be listed
+        if(error == std::errc::no_such_file_or_directory)
+        {
+            continue;
+        }
+        if(error)
+        {
+            WARNING("Cgroup hierarchy walk stopped early at " << directory << " : " << error.message());
+            break;
+        }
+    }
+
+    // cgroups that vanished take their' delta state with them
+    for(std::unordered_map<std::string, CpuState>::iterator state = _cpuStates.begin(); state != _cpuStates.end();)
+    {
+        state = state->second._lastSeenTick == _tick ? std::next(state) : _cpuStates.erase(state);
+    }
+
+    std::sort(_cgroups.begin(), _cgroups.end(), [](const CgroupStats& left, const CgroupStats& right)
+    {
+        return left._path < right._path;
+    });
+    return _cgroups;
+}
+
+bool CgroupCollector::members(std::string_view path, std::vector<uint>& pids) const
+{
+    pids.clear();
+    std::ifstream procs(_cgroupRoot / std::filesystem::path(path).relative_path() / "cgroup.procs");
+    if(!procs.is_open())
+    {
+        return false;
+    }
+    for(uint pid{0u}; procs >> pid;)
+    {
+        pids.push_back(pid);
+    }
+    return true;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,251 @@
+#include <ChurnBench.hpp>
+#include <CliOptions.hpp>
+#include <Exception.hpp>
+#include <LogTrace.hpp>
+#include <UniqueFd.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace proc
+{
+namespace churn
+{
+namespace
+{
+// what a scan saw, and when
+struct ScanSeen
+{
+    std::uint64_t _startNs;
+    std::uint64_t _endNs;
+    std::vector<uint> _pids; // sorted
+};
+
+std::uint64_t processCpuNs()
+{
+    timespec cpu{};
+    ::clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu);
+    return static_cast<std::uint64_t>(cpu.tv_sec) * 1'000'000'000u + static_cast<std::uint64_t>(cpu.tv_nsec);
+}
+
+// nearest rank of sorted `values`
+double percentile(const std::vector<double>& values, const double rank)
+{
+    if(values.empty())
+    {
+        return 0.0;
+    }
+    const std::size_t index = static_cast<std::size_t>(std::ceil(rank * static_cast<double>(values.size())));
+    return values[std::min(values.size(), std::max<std::size_t>(1u, index)) - 1u];
+}
+
+void appendLabel(utils::OutputBuffer& out, const format::Kind kind, std::string_view key, const bool first = false)
+{
+    if(kind == format::Kind::JsonLines)
+    {
+        out.append(first ? "{\"" : ",\"");
+        out.append(key);
+        out.append("\":");
+    }
+    else if(!first)
+    {
+        out.append(',');
+    }
+}
+}
+
+Report measure(ProcessInfo& collector, Generator& generator, const uint scans, const std::chrono::milliseconds interval)
+{
+    Report report;
+    report._scans = scans;
+    std::vector<ScanSeen> seen(scans);
+    std::vector<double> latenciesMs;
+    latenciesMs.reserve(scans);
+    // the first scan reads the cmdline of every process and grows the tables, it isn't what a collector costs for long
+    collector.scanProcDir();
+
+    const std::uint64_t vanishedBefore = collector.getVanishedEntries();
+    const std::uint64_t runStartNs = monotonicNs();
+    std::uint64_t cpuNs{0u};
+    for(uint scan=0; scan<scans; ++scan)
+    {
+        if(scan > 0u)
+        {
+            std::this_thread::sleep_for(interval);
+        }
+        const std::uint64_t cpuBeforeNs = processCpuNs();
+        seen[scan]._startNs = monotonicNs();
+        const PidTable_t& table = collector.scanProcDir();
+        seen[scan]._endNs = monotonicNs();
+        cpuNs += processCpuNs() - cpuBeforeNs;
+        latenciesMs.push_back(static_cast<double>(seen[scan]._endNs - seen[scan]._startNs) / 1e6);
+
+        seen[scan]._pids.reserve(table.size());
+        for(const PidTable_t::value_type& pidWithStats : table)
+        {
+            seen[scan]._pids.push_back(pidWithStats.first);
+        }
+        std::sort(seen[scan]._pids.begin(), seen[scan]._pids.end());
+    }
+    const std::uint64_t runNs = monotonicNs() - runStartNs;
+    report._vanished = collector.getVanishedEntries() - vanishedBefore;
+    report._cpuMsPerScan = scans == 0u ? 0.0 : static_cast<double>(cpuNs) / 1e6 / scans;
+    report._cpuPercent = runNs == 0u ? 0.0 : static_cast<double>(cpuNs) * 100.0 / static_cast<double>(runNs);
+
+    // every child reaped from here on : the ledger is complete
+    generator.stop();
+    report._spawned = generator.size();
+    report._spawnedPerSecond = runNs == 0u ? 0.0 : static_cast<double>(report._spawned) * 1e9 / static_cast<double>(runNs);
+    report._forkFailures = generator.getForkFailures();
+
+    std::sort(latenciesMs.begin(), latenciesMs.end());
+    report._p50Ms = percentile(latenciesMs, 0.50);
+    report._p90Ms = percentile(latenciesMs, 0.90);
+    report._p99Ms = percentile(latenciesMs, 0.99);
+    report._maxMs = latenciesMs.empty() ? 0.0 : latenciesMs.back();
+
+    for(const ScanSeen& scan : seen)
+    {
+        for(std::size_t index=0; index<generator.size(); ++index)
+        {
+            const Child& child = generator.at(index);
+            if(child._forkedNs < scan._startNs && child._reapedNs > scan._endNs)
+            {
+                ++report._expected;
+                report._missed += std::binary_search(scan._pids.begin(), scan._pids.end(), static_cast<uint>(child._pid)) ? 0u : 1u;
+            }
+        }
+    }
+    return report;
+}
+
+void appendReport(utils::OutputBuffer& out, const format::Kind kind, const Config& config, const Report& report)
+{
+    if(kind == format::Kind::Text)
+    {
+        out.append("Churn     : ");
+        out.appendUint(config._processesPerSecond);
+        out.append(" processes/s asked, ");
+        out.appendFixed(report._spawnedPerSecond, 1);
+        out.append(" forked/s (");
+        out.appendUint(report._forkFailures);
+        out.append(" fork failures), ");
+        out.appendUint(config._threadsPerProcess);
+        out.append(" threads each, ");
+        out.appendUint(config._lifetimeMs);
+        out.append(" ms mean lifetime\nScans     : ");
+        out.appendUint(report._scans);
+        out.append(", latency p50 ");
+        out.appendFixed(report._p50Ms, 2);
+        out.append(" ms | p90 ");
+        out.appendFixed(report._p90Ms, 2);
+        out.append(" ms | p99 ");
+        out.appendFixed(report._p99Ms, 2);
+        out.append(" ms | max ");
+        out.appendFixed(report._maxMs, 2);
+        out.append(" ms\nMissed    : ");
+        out.appendUint(report._missed);
+        out.append(" of ");
+        out.appendUint(report._expected);
+        out.append(" processes there for a whole scan (");
+        out.appendFixed(report.missedFraction() * 100.0, 3);
+        out.append("%)\nVanished  : ");
+        out.appendUint(report._vanished);
+        out.append(" entries listed then gone before their read\nCollector : ");
+        out.appendFixed(report._cpuMsPerScan, 2);
+        out.append(" ms of CPU per scan, ");
+        out.appendFixed(report._cpuPercent, 1);
+        out.append("% of one core\n");
+        return;
+    }
+
+    if(kind == format::Kind::Csv)
+    {
+        out.append("rate,threads,lifetime_ms,forked_per_s,fork_failures,scans,p50_ms,p90_ms,p99_ms,max_ms,expected,missed,"
+                   "missed_fraction,vanished,cpu_ms_per_scan,cpu_percent\n");
+    }
+    appendLabel(out, kind, "rate", true);
+    out.appendUint(config._processesPerSecond);
+    appendLabel(out, kind, "threads");
+    out.appendUint(config._threadsPerProcess);
+    appendLabel(out, kind, "lifetime_ms");
+    out.appendUint(config._lifetimeMs);
+    appendLabel(out, kind, "forked_per_s");
+    out.appendFixed(report._spawnedPerSecond, 1);
+    appendLabel(out, kind, "fork_failures");
+    out.appendUint(report._forkFailures);
+    appendLabel(out, kind, "scans");
+    out.appendUint(report._scans);
+    appendLabel(out, kind, "p50_ms");
+    out.appendFixed(report._p50Ms, 3);
+    appendLabel(out, kind, "p90_ms");
+    out.appendFixed(report._p90Ms, 3);
+    appendLabel(out, kind, "p99_ms");
+    out.appendFixed(report._p99Ms, 3);
+    appendLabel(out, kind, "max_ms");
+    out.appendFixed(report._maxMs, 3);
+    appendLabel(out, kind, "expected");
+    out.appendUint(report._expected);
+    appendLabel(out, kind, "missed");
+    out.appendUint(report._missed);
+    appendLabel(out, kind, "missed_fraction");
+    out.appendFixed(report.missedFraction(), 6);
+    appendLabel(out, kind, "vanished");
+    out.appendUint(report._vanished);
+    appendLabel(out, kind, "cpu_ms_per_scan");
+    out.appendFixed(report._cpuMsPerScan, 3);
+    appendLabel(out, kind, "cpu_percent");
+    out.appendFixed(report._cpuPercent, 2);
+    out.append(kind == format::Kind::JsonLines ? "}\n" : "\n");
+}
+
+int run(const cli::Options& options)
+{
+    utils::logSink() = &std::cerr;
+
+    // the collector moves the working directory to /proc, a relative output path has to be opened before that
+    utils::UniqueFd outputFile;
+    if(!options._output.empty())
+    {
+        outputFile.reset(::open(options._output.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+        if(!outputFile.valid())
+        {
+            ERROR("Cannot open " << options._output << " for the churn report : " << std::strerror(errno));
+            return 1;
+        }
+    }
+
+    Report report;
+    try
+    {
+        // forked before the collector starts any thread of its' own
+        Generator generator(options._churn);
+        ProcessInfo collector(options._ioBackend);
+        report = measure(collector, generator, options._iterations,
+            std::chrono::milliseconds(static_cast<std::int64_t>(options._delaySeconds * 1000.0)));
+    }
+    catch(const utils::SeverityException<utils::SeriousException>& e)
+    {
+        ERROR("Churn benchmark stopped : " << e.what());
+        return 1;
+    }
+
+    utils::OutputBuffer out(outputFile.valid() ? outputFile.get() : STDOUT_FILENO);
+    appendReport(out, options._format, options._churn, report);
+    out.flush();
+    if(report._missed > 0u)
+    {
+        ERROR(report._missed << " processes present for a whole scan were not in it");
+        return 1;
+    }
+    return 0;
+}
+}
+}
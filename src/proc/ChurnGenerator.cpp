@@ -0,0 +1,211 @@
+#include <ChurnGenerator.hpp>
+#include <Exception.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <new>
+#include <sched.h>
+#include <signal.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace proc
+{
+namespace churn
+{
+namespace
+{
+static constexpr std::size_t kThreadStackBytes = 64u * 1024u;
+// the storm checks for exited children at least this often, whatever the rate
+static constexpr std::uint64_t kMaxSleepNs = 5'000'000u;
+// behind by more than this (a slow fork, a descheduled storm), the missed children are given up rather than all forked at once
+static constexpr std::uint64_t kMaxLagNs = 1'000'000'000u;
+
+void sleepNs(const std::uint64_t ns)
+{
+    timespec duration{static_cast<time_t>(ns / 1'000'000'000u), static_cast<long>(ns % 1'000'000'000u)};
+    while(::nanosleep(&duration, &duration) != 0 && errno == EINTR)
+    {
+    }
+}
+
+// a thread of a child : it only has to exist until the child exits
+int sleeper(void*)
+{
+    for(;;)
+    {
+        ::pause();
+    }
+    return 0;
+}
+
+// what a child of the storm does, async-signal-safe calls only
+[[noreturn]] void runChild(const Config& config, const std::uint64_t lifetimeNs)
+{
+    for(uint thread=0; thread<config._threadsPerProcess; ++thread)
+    {
+        void* stack = ::mmap(nullptr, kThreadStackBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+        if(stack == MAP_FAILED)
+        {
+            break;
+        }
+        // a thread of the child (same thread group) : the exit of the child takes it along
+        ::clone(sleeper, static_cast<char*>(stack) + kThreadStackBytes,
+            CLONE_VM | CLONE_FS | CLONE_FILES | CLONE_SIGHAND | CLONE_THREAD | CLONE_SYSVSEM, nullptr);
+    }
+    sleepNs(lifetimeNs);
+    ::_exit(0);
+}
+
+// the one of `pid`, looked for from the newest : the children alive are the last ones forked
+Child* findUnreaped(Child* children, const std::size_t size, const pid_t pid)
+{
+    for(std::size_t index=size; index>0u; --index)
+    {
+        if(children[index - 1u]._pid == pid && children[index - 1u]._reapedNs == 0u)
+        {
+            return &children[index - 1u];
+        }
+    }
+    return nullptr;
+}
+
+// `blocking` -> until no child is left
+template<class Ledger>
+void reapChildren(Ledger& ledger, const bool blocking)
+{
+    for(;;)
+    {
+        // before the wait : the child was still there at that time
+        const std::uint64_t beforeWaitNs = monotonicNs();
+        const pid_t pid = ::waitpid(-1, nullptr, blocking ? 0 : WNOHANG);
+        if(pid < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if(pid <= 0)
+        {
+            return;
+        }
+        if(Child* child = findUnreaped(ledger._children, ledger._size.load(std::memory_order_relaxed), pid))
+        {
+            child->_reapedNs = beforeWaitNs;
+        }
+    }
+}
+
+// the storm process, the only writer of the ledger
+template<class Ledger>
+[[noreturn]] void runStorm(Ledger& ledger, const Config& config)
+{
+    // nobody left to stop it otherwise
+    ::prctl(PR_SET_PDEATHSIG, SIGKILL);
+    const std::uint64_t periodNs = 1'000'000'000u / std::max(1u, config._processesPerSecond);
+    const std::uint64_t meanLifetimeNs = static_cast<std::uint64_t>(config._lifetimeMs) * 1'000'000u;
+    // xorshift, the lifetimes only have to be spread
+    std::uint64_t random = static_cast<std::uint64_t>(::getpid()) * 0x9e3779b97f4a7c15ull | 1u;
+    std::uint64_t nextNs = monotonicNs();
+    while(!ledger._stop.load(std::memory_order_relaxed))
+    {
+        std::uint64_t nowNs = monotonicNs();
+        if(nowNs > nextNs + kMaxLagNs)
+        {
+            nextNs = nowNs;
+        }
+        for(; nextNs <= nowNs; nextNs += periodNs)
+        {
+            random ^= random << 13u;
+            random ^= random >> 7u;
+            random ^= random << 17u;
+            const std::uint64_t lifetimeNs = meanLifetimeNs == 0u ? 0u : random % (2u * meanLifetimeNs);
+            const pid_t pid = ::fork();
+            if(pid == 0)
+            {
+                runChild(config, lifetimeNs);
+            }
+            if(pid < 0)
+            {
+                ledger._forkFailures.fetch_add(1u, std::memory_order_relaxed);
+                continue;
+            }
+            // after fork returned : the child was there by then
+            const std::uint64_t forkedNs = monotonicNs();
+            const std::size_t size = ledger._size.load(std::memory_order_relaxed);
+            if(size < Generator::kLedgerCapacity)
+            {
+                ledger._children[size] = Child{pid, forkedNs, 0u};
+                ledger._size.store(size + 1u, std::memory_order_release);
+            }
+        }
+        reapChildren(ledger, false);
+        nowNs = monotonicNs();
+        sleepNs(std::min(kMaxSleepNs, nextNs > nowNs ? nextNs - nowNs : 0u));
+    }
+    reapChildren(ledger, true);
+    ::_exit(0);
+}
+}
+
+std::uint64_t monotonicNs()
+{
+    timespec now{};
+    ::clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<std::uint64_t>(now.tv_sec) * 1'000'000'000u + static_cast<std::uint64_t>(now.tv_nsec);
+}
+
+Generator::Generator(const Config& config)
+{
+    // zero filled, only the pages of the children written down are ever touched
+    void* mapping = ::mmap(nullptr, sizeof(Ledger), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if(mapping == MAP_FAILED)
+    {
+        throw utils::SeverityException<utils::SeriousException>(std::string("Cannot map the ledger of the churn : ") + std::strerror(errno));
+    }
+    _ledger = new(mapping) Ledger;
+    _ledger->_stop.store(false);
+    _ledger->_size.store(0u);
+    _ledger->_forkFailures.store(0u);
+
+    _storm = ::fork();
+    if(_storm == 0)
+    {
+        runStorm(*_ledger, config);
+    }
+    if(_storm < 0)
+    {
+        const int error = errno;
+        ::munmap(_ledger, sizeof(Ledger));
+        throw utils::SeverityException<utils::SeriousException>(std::string("Cannot fork the churn storm : ") + std::strerror(error));
+    }
+}
+
+Generator::~Generator()
+{
+    stop();
+    ::munmap(_ledger, sizeof(Ledger));
+}
+
+void Generator::stop()
+{
+    if(_storm <= 0)
+    {
+        return;
+    }
+    _ledger->_stop.store(true, std::memory_order_relaxed);
+    while(::waitpid(_storm, nullptr, 0) < 0 && errno == EINTR)
+    {
+    }
+    _storm = -1;
+}
+
+std::size_t Generator::size() const
+{
+    return _ledger->_size.load(std::memory_order_acquire);
+}
+}
+}
@@ -2,6 +2,40 @@
 #include <ProcessInfo.hpp>
 #include <string>
 #include <ExportedFileWrapper.hpp>
+#include <SystemCpuSampler.hpp>
+#include <SystemMemorySampler.hpp>
+#include <Profiler.hpp>
+#include <MetricHistory.hpp>
+#include <RuleEngine.hpp>
+#include <CollectorBudget.hpp>
+#include <Placement.hpp>
+#include <GroupAggregator.hpp>
+#include <CgroupCollector.hpp>
+#include <ProcessSignaller.hpp>
+#include <Query.hpp>
+#include <ExportWriter.hpp>
+#include <EventLoop.hpp>
+#include <RawTerminal.hpp>
+#include <Validator.hpp>
+#include <LogTrace.hpp>
+#include <Exception.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <pwd.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace proc
 {
@@ -9,42 +43,1265 @@ namespace cli
 {
 
 static constexpr char kUpperAndDownTableFormat[] = "+-----------------------------------------------------------------------------+\n";
-static constexpr char kTitleTableFormat[] = "| Modern Task Monitor - [Sort: CPU Usage] - [Filter: All]                    |\n";
+static constexpr char kTitle[] = "| Modern Task Monitor - [Sort: ";
+static constexpr char kTitleFilter[] = "] - [Filter: ";
+static constexpr std::size_t kTableWidth = 79u;
 static constexpr char kBoundariesInBetween[] = "+------+------------------+----------+------------+------------+-------------+\n";
 static constexpr char kColumnNames[] = "| PID  | Process Name     | CPU (%)  | Memory (%) | Threads    | Uptime      |\n";
-static constexpr char kTotalSumMetrics[] = "| Total CPU Usage: % | Memory:  GB used (%)                   |\n";
-static constexpr char kMenuDisplay[] = "[Q] Quit | [K] Kill Process | [F] Filter | [S] Sort | [R] Refresh\n";
+static constexpr char kPlacementColumnNames[] = "| PID  | Process Name     | CPU (%)  | Last CPU   | Affinity   | Remote mem  |\n";
+static constexpr char kTitlePlacement[] = " - [Placement]";
+static constexpr char kGroupColumnNames[] = "| #    | Group            | CPU (%)  | Memory (%) | Threads    | CPU/process |\n";
+static constexpr char kTitleGroup[] = " - [Group: ";
+static constexpr char kCgroupColumnNames[] = "| Tasks| Cgroup           | CPU (%)  | Memory (%) | Memory MB  | CPU/task    |\n";
+static constexpr char kTitleCgroup[] = " - [Group: Cgroup]";
+static constexpr char kFilterPrompt[] = "| Filter (Enter applies, empty shows all, Esc cancels) : ";
+static constexpr char kKillPrompt[] = "| Kill PID (Enter sends SIGTERM, Esc cancels) : ";
+static constexpr char kTotalCpuUsage[] = "| Total CPU Usage: ";
+static constexpr char kTotalMemoryUsage[] = "% | Memory: ";
+static constexpr char kPressure[] = "| Pressure (some avg10): ";
+static constexpr char kCpuHistory[] = "| CPU last minute: ";
+static constexpr char kAlerts[] = "| Alerts firing: ";
+static constexpr char kStale[] = "| Stale snapshot from ";
+static constexpr char kNoSnapshot[] = "| No snapshot persisted yet";
+static constexpr char kLiveScanRunning[] = " - live scan running";
+static constexpr char kTopRowsLive[] = " (rows shown are live)";
+static constexpr char kMenuDisplay[] = "[Q] Quit | [K] Kill Process | [F] Filter | [S] Sort | [R] Refresh | [P] Placement | [G] Group | [E] Expand\n";
 static constexpr int kStep = 5;
+// up to this many cores get a bar each, beyond that they are drawn as a heatmap row of one glyph per core
+static constexpr std::size_t kMaxCoresAsBars = 16u;
+static constexpr uint kCpuBarWidth = 40u;
+static constexpr uint kHeatmapCoresPerRow = 64u;
+static constexpr std::size_t kSparklineWidth = 30u;
+static constexpr std::int64_t kHistoryWindowMs = 60'000;
+static constexpr std::size_t kRecentAlerts = 5u;
+static constexpr std::size_t kRowSparklineWidth = 16u;
+// a grouped frame : this many groups at most, and members of the expanded one
+static constexpr std::size_t kMaxGroupRows = 20u;
+static constexpr std::size_t kMaxMemberRows = 10u;
+// the filter typed at the prompt, and the part of it the title shows
+static constexpr std::size_t kMaxFilterLength = 256u;
+static constexpr std::size_t kMaxFilterTitle = 24u;
+// cursor home and clear, then the frame
+static constexpr char kClearScreen[] = "\033[H\033[2J";
 
-void display(const std::filesystem::path& exportedFile)
+namespace
 {
-    ExportedFileWrapper wrapper(exportedFile);
-    wrapper.getPidsByStep(5);
-    std::string cliDisplay;
-    while(1)
+// | Total CPU Usage: 68.4% | Memory: 6.3/16.0 GB used (39.4%)
+// | Pressure (some avg10): cpu 2.11% | memory 0.00% | io 0.00%
+void appendTotals(std::string& cliDisplay, const SystemCpuSampler& cpuSampler, const SystemMemorySampler& memorySampler)
+{
+    char busy[32];
+    char* end = std::to_chars(busy, busy + sizeof(busy), cpuSampler.getTotal().busy(), std::chars_format::fixed, 1).ptr;
+    cliDisplay += kTotalCpuUsage;
+    cliDisplay.append(busy, end);
+    cliDisplay += kTotalMemoryUsage;
+    cliDisplay += renderMemoryUsage(memorySampler);
+    cliDisplay += '\n';
+    cliDisplay += kPressure;
+    cliDisplay += renderPressure(memorySampler);
+    cliDisplay += '\n';
+}
+
+// | CPU last minute: ▁▁▂▅█▇▃▁ avg 12.4% p95 48.0%
+void appendCpuHistory(std::string& cliDisplay, const MetricHistory& history)
+{
+    const WindowStats stats = history.query(history.system(), Metric::Cpu, kHistoryWindowMs);
+    char numbers[64];
+    char* end = std::to_chars(numbers, numbers + sizeof(numbers), stats._avg, std::chars_format::fixed, 1).ptr;
+    cliDisplay += kCpuHistory;
+    cliDisplay += renderSparkline(history.system(), Metric::Cpu, kSparklineWidth);
+    cliDisplay += " avg ";
+    cliDisplay.append(numbers, end);
+    end = std::to_chars(numbers, numbers + sizeof(numbers), stats._p95, std::chars_format::fixed, 1).ptr;
+    cliDisplay += "% p95 ";
+    cliDisplay.append(numbers, end);
+    cliDisplay += "%\n";
+}
+
+// | Alerts firing: 2
+// |   pid 1234 : cpu > 80% for 30s (value 93.20)
+void appendAlerts(std::string& cliDisplay, const rules::RuleEngine& ruleEngine, const std::deque<std::string>& recentAlerts)
+{
+    cliDisplay += kAlerts;
+    cliDisplay += std::to_string(ruleEngine.getFiringCount());
+    cliDisplay += '\n';
+    for(const std::string& alert : recentAlerts)
+    {
+        cliDisplay += "|   ";
+        cliDisplay += alert;
+        cliDisplay += '\n';
+    }
+}
+
+using Row = std::pair<uint, PidStats>;
+
+// the strings the collector interned since the names last handed over, in the order of their' ids : interned in that
+// order, the table of the loop gets the same ids as the one of the collector, the rows cross with their' ids as they
+// are. `_reset` when the collector compacted its' table, the strings then being all of the new one
+struct NewNames
+{
+    bool _reset{false};
+    std::string _text;
+    std::vector<std::size_t> _ends;
+};
+
+std::int64_t nowMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// last write of `file` in ms since the epoch, 0 when there is none
+std::int64_t modificationMs(const std::filesystem::path& file)
+{
+    struct stat status{};
+    if(::stat(file.c_str(), &status) != 0)
+    {
+        return 0;
+    }
+    return static_cast<std::int64_t>(status.st_mtim.tv_sec) * 1000 + status.st_mtim.tv_nsec / 1'000'000;
+}
+
+enum class SortKey
+{
+    Cpu,
+    Memory,
+    Threads,
+    Pid
+};
+static constexpr const char* kSortLabels[] = {"CPU Usage", "Memory", "Threads", "PID"};
+
+// a comm is at most 15 characters, the column fits it
+static constexpr std::size_t kNameWidth = 16u;
+
+// `text` left aligned in a `width` wide cell, eg. "| 42.3     "
+void appendCell(std::string& cliDisplay, std::string_view text, const std::size_t width)
+{
+    cliDisplay += "| ";
+    cliDisplay += text;
+    cliDisplay.append(width > text.size() ? width - text.size() : 0u, ' ');
+    cliDisplay += ' ';
+}
+
+std::string toFixed(const double value)
+{
+    char fixed[32];
+    return std::string(fixed, std::to_chars(fixed, fixed + sizeof(fixed), value, std::chars_format::fixed, 1).ptr);
+}
+
+std::string toTwoDigits(const uint value)
+{
+    return value < 10u ? "0" + std::to_string(value) : std::to_string(value);
+}
+
+// | 1234 | php-fpm          | 42.3     | 10.5       | 73         | 00:20:54    | ▁▂▅█
+void appendRow(std::string& cliDisplay, const uint pid, std::string_view name, const PidStats& stats, const MetricSeries* series)
+{
+    appendCell(cliDisplay, std::to_string(pid), 4u);
+    appendCell(cliDisplay, name.substr(0u, kNameWidth), kNameWidth);
+    appendCell(cliDisplay, toFixed(stats._cpu), 8u);
+    appendCell(cliDisplay, toFixed(stats._memory), 10u);
+    appendCell(cliDisplay, std::to_string(stats._threads), 10u);
+    appendCell(cliDisplay, toTwoDigits(stats._timezone._hours) + ":" + toTwoDigits(stats._timezone._minutes) + ":" + toTwoDigits(stats._timezone._seconds), 11u);
+    cliDisplay += "| ";
+    cliDisplay += series != nullptr ? renderSparkline(*series, Metric::Cpu, kRowSparklineWidth) : std::string();
+    cliDisplay += '\n';
+}
+
+// | 1234 | php-fpm          | 42.3     | 3          | 4/16       | 12.5%       |
+// unknown values (gone, not sampled yet, no NUMA) are shown as "-"
+void appendPlacementRow(std::string& cliDisplay, const uint pid, std::string_view name, const PidStats& stats, const placement::Placement* where,
+    const placement::NumaTopology& topology, const std::size_t cpus)
+{
+    appendCell(cliDisplay, std::to_string(pid), 4u);
+    appendCell(cliDisplay, name.substr(0u, kNameWidth), kNameWidth);
+    appendCell(cliDisplay, toFixed(stats._cpu), 8u);
+    const double remote = where != nullptr ? where->remoteRatio(topology) : -1.0;
+    appendCell(cliDisplay, where != nullptr && where->_lastCpu >= 0 ? std::to_string(where->_lastCpu) : "-", 10u);
+    appendCell(cliDisplay, where != nullptr && where->_allowedCpus > 0u ? std::to_string(where->_allowedCpus) + "/" + std::to_string(cpus) : "-", 10u);
+    appendCell(cliDisplay, remote >= 0.0 ? toFixed(remote * 100.0) + "%" : "-", 11u);
+    cliDisplay += "|\n";
+}
+
+// | 412  | nginx            | 42.3     | 10.5       | 2890       | 0.1         |
+void appendGroupRow(std::string& cliDisplay, std::string_view label, const group::Group& group)
+{
+    // what the deltas leave of a group back to idle may be a hair below 0
+    const double cpu = std::max(0.0, group._cpu);
+    appendCell(cliDisplay, std::to_string(group._members.size()), 4u);
+    appendCell(cliDisplay, label.substr(0u, kNameWidth), kNameWidth);
+    appendCell(cliDisplay, toFixed(cpu), 8u);
+    appendCell(cliDisplay, toFixed(std::max(0.0, group._memory)), 10u);
+    appendCell(cliDisplay, std::to_string(group._threads), 10u);
+    appendCell(cliDisplay, toFixed(cpu / static_cast<double>(group._members.size())), 11u);
+    cliDisplay += "|\n";
+}
+
+// | 12   | pod1             | 42.3     | 0.6        | 100.0      | 3.5         |
+// the numbers are the ones of the cgroup counters, the processes in it are not summed
+void appendGroupRow(std::string& cliDisplay, std::string_view label, const CgroupStats& cgroup, const unsigned long long totalKb)
+{
+    const double memory = totalKb == 0u ? 0.0 : static_cast<double>(cgroup._memoryBytes) / static_cast<double>(totalKb * 1024u) * 100.0;
+    appendCell(cliDisplay, std::to_string(cgroup._pids), 4u);
+    appendCell(cliDisplay, label.substr(0u, kNameWidth), kNameWidth);
+    appendCell(cliDisplay, toFixed(cgroup._cpu), 8u);
+    appendCell(cliDisplay, toFixed(memory), 10u);
+    appendCell(cliDisplay, toFixed(static_cast<double>(cgroup._memoryBytes) / (1024.0 * 1024.0)), 10u);
+    appendCell(cliDisplay, toFixed(cgroup._pids == 0u ? 0.0 : cgroup._cpu / static_cast<double>(cgroup._pids)), 11u);
+    cliDisplay += "|\n";
+}
+
+// Everything a frame shows : sample() moves the data forward (every scan of the live collector), render() only draws
+// it again (keys, resize) so that a key press is answered without touching /proc.
+// It starts on the last persisted export, shown as stale : its' first page stays on screen, without history nor rules,
+// until the live rows of that page and then the first full scan replace it. From then on the pages go through the
+// last scan of the collector, the export only being read again if no scan ever comes
+class Monitor
+{
+public:
+    Monitor(const std::filesystem::path& exportedFile, const Options& options)
+        : _exportedFile(exportedFile), _snapshotMs(modificationMs(exportedFile)), _wrapper(exportedFile), _filter(query::compile(options._where))
+    {
+        // exports published by any collector show up without a restart
+        _wrapper.follow();
+        if(!options._rulesFile.empty())
+        {
+            _ruleEngine = std::make_unique<rules::RuleEngine>(rules::loadRules(options._rulesFile));
+            _alertLog = std::make_unique<rules::AlertLog>(options._alertLog);
+        }
+    }
+
+    void sample()
+    {
+        _cpuSampler.sample();
+        _memorySampler.sample();
+        const std::int64_t sampleMs = nowMs();
+        _history.recordSystem(sampleMs, _cpuSampler.getTotal().busy(), _memorySampler.getUsedPercent());
+        if(_cgroupView)
+        {
+            sampleCgroups();
+        }
+        if(_stale)
+        {
+            // the stale page stays put, its' rows are the ones the live scan reads first
+            if(_pidMetrics.empty())
+            {
+                _pidMetrics = _wrapper.getPidsByStep(kStep);
+            }
+            return;
+        }
+
+        nextPage();
+        // every process of the scan, whatever the page : one sample per scan in each series
+        _history.record(sampleMs, _live);
+        if(_ruleEngine)
+        {
+            // the whole scan : a "for 30s" holds across pages and a count is the one of the system
+            const std::vector<rules::Alert>& alerts = _ruleEngine->evaluate(sampleMs, _live, &_scanNames);
+            _alertLog->append(*_ruleEngine, alerts);
+            for(const rules::Alert& alert : alerts)
+            {
+                _recentAlerts.push_back(rules::describe(_ruleEngine->getRule(alert._rule), alert));
+                if(_recentAlerts.size() > kRecentAlerts)
+                {
+                    _recentAlerts.pop_front();
+                }
+                // flagged : its' placement is followed even off the page
+                if(alert._pid != 0u)
+                {
+                    _flaggedPids.push_back(alert._pid);
+                    if(_flaggedPids.size() > kRecentAlerts)
+                    {
+                        _flaggedPids.pop_front();
+                    }
+                }
+            }
+        }
+        if(_placementView || !_flaggedPids.empty())
+        {
+            samplePlacement(sampleMs);
+        }
+    }
+
+    // the live values of the stale page, `asked` missing from `live` are gone ; `names` are the ones of `live`
+    void applyTopRows(const std::vector<uint>& asked, const std::vector<Row>& live, const std::vector<std::string>& names)
+    {
+        for(const uint pid : asked)
+        {
+            _pidMetrics.erase(pid);
+            if(_groupBy)
+            {
+                _groups.remove(pid);
+            }
+        }
+        for(std::size_t row=0; row<live.size(); ++row)
+        {
+            PidStats& stats = _pidMetrics[live[row].first] = live[row].second;
+            stats._name = _wrapper.accessNames().intern(names[row]);
+            if(_groupBy)
+            {
+                _groups.update(live[row].first, stats);
+            }
+        }
+        _topRowsLive = true;
+    }
+
+    // a full scan of the live collector, `names` what its' table got since the previous one and `cost` what it cost
+    // (CollectorBudget::describe) : it replaces the export (or the previous scan) as what the pages and the groups are
+    // made of, the groups moved by the processes that changed or left
+    void applyScan(const std::vector<Row>& rows, const NewNames& names, std::string_view cost)
+    {
+        _cost = cost;
+        // compacted with the one of the collector, never more names than it
+        if(names._reset)
+        {
+            _scanNames = utils::StringTable();
+        }
+        for(std::size_t name=0, start=0; name<names._ends.size(); start = names._ends[name++])
+        {
+            _scanNames.intern(std::string_view(names._text).substr(start, names._ends[name] - start));
+        }
+        _scanned.clear();
+        for(const Row& row : rows)
+        {
+            _scanned.emplace(row.first, row.second);
+        }
+        // new ids for the same names : the groups by name are made again
+        const bool renamed = names._reset && _groupBy == group::GroupBy::Name;
+        if(_groupBy && !_stale && !renamed)
+        {
+            for(const PidStatus_t::value_type& pidWithStats : _live)
+            {
+                if(_scanned.find(pidWithStats.first) == _scanned.end())
+                {
+                    _groups.remove(pidWithStats.first);
+                }
+            }
+            for(const PidStatus_t::value_type& pidWithStats : _scanned)
+            {
+                _groups.update(pidWithStats.first, pidWithStats.second);
+            }
+        }
+        _live.swap(_scanned);
+        if((std::exchange(_stale, false) || renamed) && _groupBy)
+        {
+            regroup();
+        }
+        if(renamed)
+        {
+            _expanded = std::nullopt;
+        }
+    }
+
+    // while stale, an export published by another collector : the groups follow it right away, the page in progress
+    // ends on the previous one. False when nothing new came
+    bool followExport()
+    {
+        if(!_wrapper.refresh() || !_stale)
+        {
+            return false;
+        }
+        adoptExport();
+        return true;
+    }
+
+    inline int getFollowFd() const { return _wrapper.getFollowFd(); }
+    // the scans replaced the export, nothing published is of interest anymore
+    inline void unfollowExport() { _wrapper.unfollow(); }
+
+    // pids of the rows of the last frame, top first
+    std::vector<uint> getVisiblePids() const
+    {
+        std::vector<uint> pids;
+        pids.reserve(_rows.size());
+        for(const Row& row : _rows)
+        {
+            pids.push_back(row.first);
+        }
+        return pids;
+    }
+
+    // the placement of the visible processes (placement view only) and of the flagged ones, nothing else : the last cpu
+    // is the one of their' row, the sampler only reads the affinity and numa_maps
+    void samplePlacement(const std::int64_t nowMs)
+    {
+        _placementPids.assign(_flaggedPids.begin(), _flaggedPids.end());
+        if(_placementView)
+        {
+            for(const PidStatus_t::value_type& pidWithStats : _pidMetrics)
+            {
+                _placementPids.push_back(pidWithStats.first);
+            }
+        }
+        std::sort(_placementPids.begin(), _placementPids.end());
+        _placementPids.erase(std::unique(_placementPids.begin(), _placementPids.end()), _placementPids.end());
+        _placementRows.clear();
+        for(const uint pid : _placementPids)
+        {
+            if(const PidStats* stats = statsOf(pid))
+            {
+                _placementRows.emplace_back(pid, stats);
+            }
+        }
+        _placements.sample(_placementRows, nowMs);
+    }
+
+    // keys go to the filter prompt, none of them is a command
+    inline bool isTyping() const { return _prompt.has_value(); }
+
+    // false when the key asks to quit
+    bool handleKey(const char key)
+    {
+        if(_prompt)
+        {
+            typeFilter(key);
+            return true;
+        }
+        // what became of a kill is shown until the next key
+        _promptError.clear();
+        switch(key)
+        {
+            case 'q' : case 'Q' : return false;
+            case 's' : case 'S' : _sortKey = static_cast<SortKey>((static_cast<int>(_sortKey) + 1) % 4); break;
+            case 'f' : case 'F' :
+                _prompt = _filter.getText();
+                _promptKind = Prompt::Filter;
+                break;
+            case 'k' : case 'K' :
+                _prompt.emplace();
+                _promptKind = Prompt::Kill;
+                break;
+            case 'g' : case 'G' :
+                // off -> name -> user -> session -> cgroup -> off
+                if(_cgroupView)
+                {
+                    _cgroupView = false;
+                }
+                else if(!_groupBy)
+                {
+                    _groupBy = group::GroupBy::Name;
+                }
+                else if(*_groupBy == group::GroupBy::Session)
+                {
+                    _groupBy = std::nullopt;
+                    _cgroupView = true;
+                }
+                else
+                {
+                    _groupBy = static_cast<group::GroupBy>(static_cast<int>(*_groupBy) + 1);
+                }
+                if(_groupBy)
+                {
+                    regroup();
+                }
+                _expanded = std::nullopt;
+                _expandedCgroup = std::nullopt;
+                // the first sample of the view has no CPU yet, the next scan gives it one
+                if(_cgroupView)
+                {
+                    sampleCgroups();
+                }
+                break;
+            case 'e' : case 'E' : expandNext(); break;
+            case 'p' : case 'P' :
+                _placementView = !_placementView;
+                // nothing was sampled for the page while the view was off
+                if(_placementView)
+                {
+                    samplePlacement(nowMs());
+                }
+                break;
+            default : break;
+        }
+        return true;
+    }
+
+    const std::string& render()
+    {
+        PROFILE_SCOPE(Render);
+        _cliDisplay = kClearScreen;
+        _cliDisplay += kUpperAndDownTableFormat;
+        const std::size_t titleStart = _cliDisplay.size();
+        _cliDisplay += kTitle;
+        // groups have no pid, they are ordered by their number of processes instead
+        _cliDisplay += (_groupBy || _cgroupView) && _sortKey == SortKey::Pid ? "Processes" : kSortLabels[static_cast<int>(_sortKey)];
+        _cliDisplay += kTitleFilter;
+        _cliDisplay += _filter.selectsAll() ? std::string_view("All") : std::string_view(_filter.getText()).substr(0u, kMaxFilterTitle);
+        _cliDisplay += ']';
+        if(_placementView)
+        {
+            _cliDisplay += kTitlePlacement;
+        }
+        if(_groupBy)
+        {
+            _cliDisplay += kTitleGroup;
+            _cliDisplay += group::kGroupByLabels[static_cast<int>(*_groupBy)];
+            _cliDisplay += ']';
+        }
+        if(_cgroupView)
+        {
+            _cliDisplay += kTitleCgroup;
+        }
+        _cliDisplay.append(kTableWidth - 1u - std::min(kTableWidth - 1u, _cliDisplay.size() - titleStart), ' ');
+        _cliDisplay += "|\n";
+        // how fresh the numbers are, throttling included
+        const std::size_t refreshStart = _cliDisplay.size();
+        if(_stale)
+        {
+            appendStale();
+        }
+        else
+        {
+            _cliDisplay += _cost;
+        }
+        _cliDisplay.append(kTableWidth - 1u - std::min(kTableWidth - 1u, _cliDisplay.size() - refreshStart), ' ');
+        _cliDisplay += "|\n";
+        _cliDisplay += kBoundariesInBetween;
+        _cliDisplay += _groupBy ? kGroupColumnNames : _cgroupView ? kCgroupColumnNames : _placementView ? kPlacementColumnNames : kColumnNames;
+        _cliDisplay += kBoundariesInBetween;
+
+        if(_groupBy)
+        {
+            appendGroups();
+        }
+        else if(_cgroupView)
+        {
+            appendCgroups();
+        }
+        else
+        {
+            _rows.assign(_pidMetrics.begin(), _pidMetrics.end());
+            query::retain(_rows, _filter, &names());
+            sortRows(_rows.size());
+            for(const Row& row : _rows)
+            {
+                appendRowOfView(row);
+            }
+        }
+        _cliDisplay += kBoundariesInBetween;
+
+        // the total comes from /proc/stat : summing the processes would double count and miss the kernel time
+        appendTotals(_cliDisplay, _cpuSampler, _memorySampler);
+        appendCpuHistory(_cliDisplay, _history);
+        if(_ruleEngine)
+        {
+            appendAlerts(_cliDisplay, *_ruleEngine, _recentAlerts);
+        }
+        _cliDisplay += kUpperAndDownTableFormat;
+        _cliDisplay += _cpuSampler.getCores().size() <= kMaxCoresAsBars ?
+            renderCpuBars(_cpuSampler.getCores(), kCpuBarWidth) : renderCpuHeatmap(_cpuSampler.getCores(), kHeatmapCoresPerRow);
+        if(_placementView)
+        {
+            // every process of the last scan, the live rows of the page while stale (those of the export have no cpu)
+            _cliDisplay += placement::renderOccupancy(placement::occupancy(_stale ? _pidMetrics : _live, _cpuSampler.getCores().size()));
+        }
+#if defined(SHARED_PROFILING)
+        // debug overlay : where the time of the collector and of the previous frames went
+        _cliDisplay += utils::profiling::Profiler::instance().renderOverlay();
+#endif
+        if(_prompt)
+        {
+            _cliDisplay += _promptKind == Prompt::Filter ? kFilterPrompt : kKillPrompt;
+            _cliDisplay += *_prompt;
+            _cliDisplay += '\n';
+        }
+        // the error of the prompt, or what became of the last kill
+        if(!_promptError.empty())
+        {
+            _cliDisplay += "| ";
+            _cliDisplay += _promptError;
+            _cliDisplay += '\n';
+        }
+        _cliDisplay += kMenuDisplay;
+        return _cliDisplay;
+    }
+
+private:
+    // the filter or the pid being typed : Enter compiles the filter (an error keeps the prompt open) or kills the pid,
+    // Esc gives up on it
+    void typeFilter(const char key)
+    {
+        switch(key)
+        {
+            case '\r' : case '\n' :
+                if(_promptKind == Prompt::Kill)
+                {
+                    killTyped();
+                    _prompt = std::nullopt;
+                    break;
+                }
+                try
+                {
+                    _filter = query::compile(*_prompt);
+                    _prompt = std::nullopt;
+                    _promptError.clear();
+                }
+                catch(const utils::SeverityException<utils::SeriousException>& e)
+                {
+                    _promptError = e.what();
+                }
+                break;
+            case '\x1b' :
+                _prompt = std::nullopt;
+                _promptError.clear();
+                break;
+            case '\x7f' : case '\b' :
+                if(!_prompt->empty())
+                {
+                    _prompt->pop_back();
+                }
+                break;
+            default :
+                if(key >= ' ' && _prompt->size() < kMaxFilterLength && (_promptKind == Prompt::Filter || std::isdigit(static_cast<unsigned char>(key))))
+                {
+                    *_prompt += key;
+                }
+                break;
+        }
+    }
+
+    // SIGTERM to the pid typed if it still is the process of the last scan (or of the live rows of the page) : the rows
+    // of the export carry no starttime, what is only known from them is not signalled
+    void killTyped()
+    {
+        uint pid{0u};
+        std::from_chars(_prompt->data(), _prompt->data() + _prompt->size(), pid);
+        const PidStats* stats = pid != 0u ? statsOf(pid) : nullptr;
+        if(stats == nullptr || stats->_startTime == 0u)
+        {
+            _promptError = "Kill " + *_prompt + " : not a process of the last scan";
+            return;
+        }
+        const SignalReport report = _signaller.deliver({SignalTarget{pid, stats->_startTime}}, SIGTERM, std::chrono::milliseconds(0)).front();
+        _promptError = "Kill " + std::to_string(pid) + " : " + toString(report._outcome);
+        if(report._errno != 0)
+        {
+            _promptError.append(" (").append(std::strerror(report._errno)).append(")");
+        }
+    }
+
+    void adoptExport()
     {
-        cliDisplay = kUpperAndDownTableFormat;
-        cliDisplay += kTitleTableFormat;
-        cliDisplay += kBoundariesInBetween;
-        cliDisplay += kColumnNames;
-        cliDisplay += kBoundariesInBetween;
-        
-        const PidStatus_t pidMetrics = wrapper.getPidsByStep(kStep);
-        for(const PidStatus_t::value_type& pidWithMetrics : pidMetrics)
+        _snapshotMs = modificationMs(_exportedFile);
+        if(_groupBy)
         {
-            std::string PidMetricRow("| " + std::to_string(pidWithMetrics.first) + " | ");
-            
+            regroup();
         }
+    }
 
-        cliDisplay += kBoundariesInBetween;
+    // the groups of the last scan ; while stale the ones of the whole export, the live rows of the page over it
+    void regroup()
+    {
+        if(!_stale)
+        {
+            _groups.rebuild(_live, *_groupBy);
+            return;
+        }
+        _groups.rebuild(_wrapper.getPids(), *_groupBy);
+        for(const PidStatus_t::value_type& pidWithStats : _pidMetrics)
+        {
+            _groups.update(pidWithStats.first, pidWithStats.second);
+        }
+    }
 
-        // calculate the sum of these metrics
+    // the kStep lowest pids of the last scan past the previous page, from the lowest again once all of it was shown
+    void nextPage()
+    {
+        _pagePids.clear();
+        for(const PidStatus_t::value_type& pidWithStats : _live)
+        {
+            if(pidWithStats.first > _pageEnd)
+            {
+                _pagePids.push_back(pidWithStats.first);
+            }
+        }
+        if(_pagePids.empty())
+        {
+            _pageEnd = 0u;
+            for(const PidStatus_t::value_type& pidWithStats : _live)
+            {
+                _pagePids.push_back(pidWithStats.first);
+            }
+        }
+        const std::size_t shown = std::min<std::size_t>(kStep, _pagePids.size());
+        std::partial_sort(_pagePids.begin(), _pagePids.begin() + static_cast<std::ptrdiff_t>(shown), _pagePids.end());
+        _pidMetrics.clear();
+        for(std::size_t index=0; index<shown; ++index)
+        {
+            _pidMetrics.emplace(_pagePids[index], _live.find(_pagePids[index])->second);
+            _pageEnd = _pagePids[index];
+        }
+    }
 
-        cliDisplay += kUpperAndDownTableFormat;
+    // the expansion moves down the groups of the last frame, past the last one nothing is expanded
+    void expandNext()
+    {
+        if(_cgroupView)
+        {
+            expandNextCgroup();
+            return;
+        }
+        if(!_groupBy)
+        {
+            return;
+        }
+        std::size_t next{0u};
+        if(_expanded)
+        {
+            next = static_cast<std::size_t>(std::find(_shownGroups.begin(), _shownGroups.end(), *_expanded) - _shownGroups.begin()) + 1u;
+        }
+        _expanded = next < _shownGroups.size() ? std::optional<std::uint32_t>(_shownGroups[next]) : std::nullopt;
+    }
+
+    // the first `count` of _rows in the order of _sortKey, the rest dropped
+    void sortRows(const std::size_t count)
+    {
+        const auto first = [this](const Row& left, const Row& right)
+        {
+            switch(_sortKey)
+            {
+                case SortKey::Cpu : return left.second._cpu > right.second._cpu;
+                case SortKey::Memory : return left.second._memory > right.second._memory;
+                case SortKey::Threads : return left.second._threads > right.second._threads;
+                case SortKey::Pid : break;
+            }
+            return left.first < right.first;
+        };
+        const std::size_t shown = std::min(count, _rows.size());
+        std::partial_sort(_rows.begin(), _rows.begin() + static_cast<std::ptrdiff_t>(shown), _rows.end(), first);
+        _rows.resize(shown);
     }
+
+    void appendRowOfView(const Row& row)
+    {
+        if(_placementView)
+        {
+            appendPlacementRow(_cliDisplay, row.first, names().view(row.second._name), row.second,
+                _placements.find(row.first), _placements.getTopology(), _cpuSampler.getCores().size());
+        }
+        else
+        {
+            appendRow(_cliDisplay, row.first, names().view(row.second._name), row.second, _history.find(row.first));
+        }
+    }
+
+    // the biggest groups, the members of the expanded one right under it : the cost is the one of the groups and of
+    // the expanded members, not of the processes
+    void appendGroups()
+    {
+        static constexpr group::Order kOrders[] = {group::Order::Cpu, group::Order::Memory, group::Order::Threads, group::Order::Count};
+        _groups.top(kMaxGroupRows, kOrders[static_cast<int>(_sortKey)], _topGroups);
+        _shownGroups.clear();
+        _rows.clear();
+        for(const group::Group* shown : _topGroups)
+        {
+            _shownGroups.push_back(shown->_key);
+            appendGroupRow(_cliDisplay, groupLabel(shown->_key), *shown);
+            if(_expanded == shown->_key)
+            {
+                appendMembers(shown->_members);
+            }
+        }
+    }
+
+    // the cgroups of the hierarchy, from their' own counters : the cost is the one of the cgroups and of the members
+    // of the expanded one, whatever the number of processes. The root is left out, it is the total below
+    void appendCgroups()
+    {
+        _topCgroups.clear();
+        for(const CgroupStats& cgroup : _cgroups.getCgroups())
+        {
+            if(cgroup._path != "/")
+            {
+                _topCgroups.push_back(&cgroup);
+            }
+        }
+        const auto first = [this](const CgroupStats* left, const CgroupStats* right)
+        {
+            switch(_sortKey)
+            {
+                case SortKey::Cpu : return left->_cpu > right->_cpu;
+                case SortKey::Memory : return left->_memoryBytes > right->_memoryBytes;
+                case SortKey::Threads : case SortKey::Pid : break;
+            }
+            return left->_pids > right->_pids;
+        };
+        const std::size_t shown = std::min(kMaxGroupRows, _topCgroups.size());
+        std::partial_sort(_topCgroups.begin(), _topCgroups.begin() + static_cast<std::ptrdiff_t>(shown), _topCgroups.end(), first);
+        _topCgroups.resize(shown);
+
+        _shownCgroups.clear();
+        _rows.clear();
+        for(const CgroupStats* cgroup : _topCgroups)
+        {
+            _shownCgroups.push_back(cgroup->_path);
+            // the end of the path, where the pod and the container are
+            const std::string_view path = cgroup->_path;
+            appendGroupRow(_cliDisplay, path.substr(path.size() - std::min(path.size(), kNameWidth)), *cgroup, _memorySampler.getTotalKb());
+            if(_expandedCgroup == cgroup->_path)
+            {
+                appendMembers(_cgroupMembers);
+            }
+        }
+    }
+
+    // the processes of the expanded group, indented under it with the columns of a group
+    void appendMembers(const std::vector<uint>& pids)
+    {
+        for(const uint pid : pids)
+        {
+            if(const PidStats* stats = statsOf(pid))
+            {
+                _rows.emplace_back(pid, *stats);
+            }
+        }
+        query::retain(_rows, _filter, &names());
+        sortRows(kMaxMemberRows);
+        for(const Row& row : _rows)
+        {
+            _label.assign("  ").append(names().view(row.second._name));
+            appendRow(_cliDisplay, row.first, _label, row.second, _history.find(row.first));
+        }
+    }
+
+    // the counters of every cgroup and the cgroup.procs of the expanded one, a cgroup gone is not expanded anymore
+    void sampleCgroups()
+    {
+        _cgroups.sample();
+        if(_expandedCgroup && !_cgroups.members(*_expandedCgroup, _cgroupMembers))
+        {
+            _expandedCgroup = std::nullopt;
+        }
+    }
+
+    // as expandNext, along the cgroups of the last frame
+    void expandNextCgroup()
+    {
+        std::size_t next{0u};
+        if(_expandedCgroup)
+        {
+            next = static_cast<std::size_t>(std::find(_shownCgroups.begin(), _shownCgroups.end(), *_expandedCgroup) - _shownCgroups.begin()) + 1u;
+        }
+        _expandedCgroup = next < _shownCgroups.size() ? std::optional<std::string>(_shownCgroups[next]) : std::nullopt;
+        if(_expandedCgroup && !_cgroups.members(*_expandedCgroup, _cgroupMembers))
+        {
+            _expandedCgroup = std::nullopt;
+        }
+    }
+
+    // what the ids of the rows shown are of : the table of the export (the live rows of the page interned in it) while
+    // stale, the copy of the one of the collector afterwards
+    inline const utils::StringTable& names() const { return _stale ? _wrapper.getNames() : _scanNames; }
+
+    // the row of the last scan ; while stale the live row of the page when there is one, the one of the export otherwise
+    const PidStats* statsOf(const uint pid)
+    {
+        if(!_stale)
+        {
+            const auto scanned = _live.find(pid);
+            return scanned == _live.end() ? nullptr : &scanned->second;
+        }
+        const auto live = _pidMetrics.find(pid);
+        if(live != _pidMetrics.end())
+        {
+            return &live->second;
+        }
+        const auto exported = _wrapper.getPids().find(pid);
+        return exported == _wrapper.getPids().end() ? nullptr : &exported->second;
+    }
+
+    std::string_view groupLabel(const std::uint32_t key)
+    {
+        switch(*_groupBy)
+        {
+            case group::GroupBy::Name : return names().view(key);
+            case group::GroupBy::User : break;
+            case group::GroupBy::Session : return _label = "session " + std::to_string(key);
+        }
+        // looked up once per uid, the passwd database may be remote
+        auto [found, isNew] = _userNames.try_emplace(key);
+        if(isNew)
+        {
+            char buffer[1024];
+            struct passwd entry{};
+            struct passwd* result{nullptr};
+            found->second = ::getpwuid_r(key, &entry, buffer, sizeof(buffer), &result) == 0 && result != nullptr ?
+                std::string(result->pw_name) : std::to_string(key);
+        }
+        return found->second;
+    }
+
+    // | Stale snapshot from 42s ago - live scan running (rows shown are live)
+    void appendStale()
+    {
+        if(_snapshotMs == 0)
+        {
+            _cliDisplay += kNoSnapshot;
+        }
+        else
+        {
+            _cliDisplay += kStale;
+            _cliDisplay += std::to_string(std::max<std::int64_t>(0, nowMs() - _snapshotMs) / 1000);
+            _cliDisplay += "s ago";
+        }
+        _cliDisplay += kLiveScanRunning;
+        if(_topRowsLive)
+        {
+            _cliDisplay += kTopRowsLive;
+        }
+    }
+
+    std::filesystem::path _exportedFile;
+    std::int64_t _snapshotMs; // of the persisted export, 0 -> none
+    bool _stale{true};
+    bool _topRowsLive{false};
+    ExportedFileWrapper _wrapper;
+    SystemCpuSampler _cpuSampler;
+    SystemMemorySampler _memorySampler;
+    MetricHistory _history;
+    std::string _cost; // of the last scan, by the budget of the collector
+    std::unique_ptr<rules::RuleEngine> _ruleEngine;
+    std::unique_ptr<rules::AlertLog> _alertLog;
+    std::deque<std::string> _recentAlerts;
+    PidStatus_t _pidMetrics; // the page
+    PidStatus_t _live;       // the last scan, empty while stale
+    PidStatus_t _scanned;    // the one coming in, swapped with _live
+    utils::StringTable _scanNames; // of _live, same ids as in the table of the collector
+    std::vector<uint> _pagePids;
+    uint _pageEnd{0u};       // highest pid of the page shown
+    std::vector<Row> _rows;
+    SortKey _sortKey{SortKey::Cpu};
+    query::Predicate _filter;
+    enum class Prompt
+    {
+        Filter,
+        Kill
+    };
+    std::optional<std::string> _prompt; // nullopt -> not typing a filter nor a pid
+    Prompt _promptKind{Prompt::Filter};
+    ProcessSignaller _signaller;
+    std::string _promptError;
+    placement::PlacementSampler _placements;
+    std::deque<uint> _flaggedPids;
+    std::vector<uint> _placementPids;
+    std::vector<std::pair<uint, const PidStats*>> _placementRows;
+    bool _placementView{false};
+    std::optional<group::GroupBy> _groupBy; // nullopt -> one row per process
+    group::Aggregator _groups;
+    std::vector<const group::Group*> _topGroups;
+    std::vector<std::uint32_t> _shownGroups; // keys of the last frame, top first
+    std::optional<std::uint32_t> _expanded;
+    bool _cgroupView{false};
+    CgroupCollector _cgroups;
+    std::vector<const CgroupStats*> _topCgroups;
+    std::vector<std::string> _shownCgroups; // paths of the last frame, top first
+    std::optional<std::string> _expandedCgroup;
+    std::vector<uint> _cgroupMembers; // of the expanded one
+    std::unordered_map<uint, std::string> _userNames;
+    std::string _label;
+    std::string _cliDisplay;
+};
+
+// The collector of the monitor, off the thread of the event loop : the pids on screen are read first and handed over,
+// then /proc is scanned every interval, each scan exported (the first one validated) and handed over. Each step ends
+// with a wakeup of the loop. A scan not taken by the loop in time is replaced by the next one, the names it brought
+// are kept for it. The rows cross with the ids of the collector, only the names it didn't hand over yet are copied.
+// The budget measures this thread only (the scan, the copy for the exporter and the one for the loop) and widens its'
+// interval and stride ; the priority of the options is lowered on it (and on the exporter it starts), the loop keeps
+// answering the keys at the normal one
+class LiveCollector
+{
+public:
+    LiveCollector(const Options& options, const std::filesystem::path& exportedFile, std::vector<uint> visiblePids,
+        const std::chrono::milliseconds interval, utils::EventLoop& loop)
+        : _exportedFile(exportedFile), _visiblePids(std::move(visiblePids)), _priority(options._priority),
+          _budget(options._budgetPercent, interval), _thread(&LiveCollector::run, this, options._ioBackend, std::ref(loop))
+    {}
+    // a scan in flight is not interrupted, leaving waits for it
+    ~LiveCollector()
+    {
+        {
+            const std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _wake.notify_one();
+        _thread.join();
+    }
+
+    // once, when the visible pids were read : the ones asked, the rows of those still alive and their names (the ids
+    // of the rows belong to the collector)
+    bool takeTopRows(std::vector<uint>& asked, std::vector<Row>& live, std::vector<std::string>& names)
+    {
+        const std::lock_guard<std::mutex> lock(_mutex);
+        if(!_topRowsReady)
+        {
+            return false;
+        }
+        _topRowsReady = false;
+        asked = _visiblePids;
+        live.swap(_topRows);
+        names.swap(_topNames);
+        return true;
+    }
+
+    // the rows of the last full scan, the names new since the previous call and its' cost, when one came since then
+    bool takeScan(std::vector<Row>& rows, NewNames& names, std::string& cost)
+    {
+        const std::lock_guard<std::mutex> lock(_mutex);
+        if(!_scanReady)
+        {
+            return false;
+        }
+        _scanReady = false;
+        rows.swap(_scanRows);
+        std::swap(names, _scanNames);
+        // what the loop handed back is filled from scratch
+        _scanNames._reset = false;
+        _scanNames._text.clear();
+        _scanNames._ends.clear();
+        cost.swap(_scanCost);
+        return true;
+    }
+
+    // the next scan starts now rather than at the end of the interval
+    void scanNow()
+    {
+        {
+            const std::lock_guard<std::mutex> lock(_mutex);
+            _scanNow = true;
+        }
+        _wake.notify_one();
+    }
+
+private:
+    void run(const utils::procfs::IoBackend ioBackend, utils::EventLoop& loop)
+    {
+        budget::applyPriority(_priority);
+        ProcessInfo collector(ioBackend);
+        const PidTable_t& topPids = collector.scanPids(_visiblePids);
+        {
+            const std::lock_guard<std::mutex> lock(_mutex);
+            for(const uint pid : _visiblePids)
+            {
+                if(const PidStats* stats = topPids.find(pid))
+                {
+                    _topRows.emplace_back(pid, *stats);
+                    _topNames.emplace_back(collector.getNames().view(stats->_name));
+                }
+            }
+            _topRowsReady = true;
+        }
+        loop.wakeup();
+
+        // write-behind : the scans don't wait for the disk, but for the first export which is checked
+        ExportWriter exporter(_exportedFile);
+        std::vector<Row> rows;
+        std::string cost;
+        std::uint64_t namesGeneration = collector.getNamesGeneration();
+        utils::StringTable::Id namesSent{1u}; // kEmpty is in every table
+        for(bool first = true;; first = false)
+        {
+            collector.setSampleStride(_budget.getStride());
+            _budget.beginTick();
+            const PidTable_t& snapshot = collector.scanProcDir();
+            exporter.submit(snapshot, &collector.getNames());
+            // the buffers swapped back and forth with the loop keep their capacity
+            rows.assign(snapshot.begin(), snapshot.end());
+            _budget.endTick();
+            // the first export is waited for and checked, outside of the measured tick
+            if(first)
+            {
+                exporter.waitIdle();
+                if(!utils::validator::validateExportedFile(_exportedFile))
+                {
+                    ERROR("Validation failed. Check your file for potential corruptions");
+                }
+            }
+            cost = _budget.describe();
+            {
+                const std::lock_guard<std::mutex> lock(_mutex);
+                _scanRows.swap(rows);
+                // appended to the names of a scan the loop didn't take : those are not known on its' side yet
+                const utils::StringTable& names = collector.getNames();
+                if(collector.getNamesGeneration() != namesGeneration)
+                {
+                    namesGeneration = collector.getNamesGeneration();
+                    namesSent = 1u;
+                    _scanNames._reset = true;
+                    _scanNames._text.clear();
+                    _scanNames._ends.clear();
+                }
+                for(; namesSent<names.size(); ++namesSent)
+                {
+                    _scanNames._text += names.view(namesSent);
+                    _scanNames._ends.push_back(_scanNames._text.size());
+                }
+                _scanCost.swap(cost);
+                _scanReady = true;
+            }
+            loop.wakeup();
+
+            std::unique_lock<std::mutex> lock(_mutex);
+            _wake.wait_for(lock, _budget.getInterval(), [this]{ return _stopping || _scanNow; });
+            if(_stopping)
+            {
+                return;
+            }
+            _scanNow = false;
+        }
+    }
+
+    std::filesystem::path _exportedFile;
+    const std::vector<uint> _visiblePids;
+    const budget::Priority _priority;
+    budget::CollectorBudget _budget; // collector thread only
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    bool _stopping{false};
+    bool _scanNow{false};
+    std::vector<Row> _topRows;
+    std::vector<std::string> _topNames;
+    bool _topRowsReady{false};
+    std::vector<Row> _scanRows;
+    NewNames _scanNames;
+    std::string _scanCost;
+    bool _scanReady{false};
+    std::thread _thread; // last, started once everything above is built
+};
+
+void draw(std::string_view frame)
+{
+    while(!frame.empty())
+    {
+        const ssize_t written = ::write(STDOUT_FILENO, frame.data(), frame.size());
+        if(written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if(written <= 0)
+        {
+            return;
+        }
+        frame.remove_prefix(static_cast<std::size_t>(written));
+    }
+}
+
+// kill -USR1 : the histograms recorded so far, without waiting for the exit
+void dumpProfile(const std::filesystem::path& profileOutput)
+{
+    if(profileOutput.empty())
+    {
+        WARNING("SIGUSR1 asks for a profiling dump, start with --profile-json FILE to get one");
+        return;
+    }
+    if(utils::profiling::Profiler::instance().dumpJson(profileOutput))
+    {
+        NOTIFY("Profiling dumped in " << profileOutput);
+    }
+}
 }
 
+// The monitor sleeps in the event loop between two events : keys from the raw terminal, SIGWINCH, SIGINT/SIGTERM,
+// SIGUSR1 (a profiling dump), the wakeups of the live collector (a scan every -d seconds, R asking for one right away)
+// and, until its' first scan, the exports published by another collector. A key is answered by drawing the frame
+// again right away.
+// The first frame is the persisted export, nothing of /proc but the system totals is read before it is drawn
+void display(const std::filesystem::path& exportedFile, const Options& options)
+{
+    // stdout is the frame
+    utils::logSink() = &std::cerr;
+    // 1ms between two scans is as fast as it goes
+    const std::chrono::milliseconds interval(std::max<std::int64_t>(1, static_cast<std::int64_t>(options._delaySeconds * 1000.0)));
+    Monitor monitor(exportedFile, options);
+    utils::EventLoop loop;
+    loop.watchSignals({SIGWINCH, SIGINT, SIGTERM, SIGUSR1});
+    const utils::RawTerminal terminal(STDIN_FILENO);
+    loop.watchInput(STDIN_FILENO);
+    if(monitor.getFollowFd() >= 0)
+    {
+        loop.watchFile(monitor.getFollowFd());
+    }
 
+    monitor.sample();
+    draw(monitor.render());
+    LiveCollector collector(options, exportedFile, monitor.getVisiblePids(), interval, loop);
+    std::vector<uint> askedPids;
+    std::vector<Row> liveRows;
+    std::vector<std::string> liveNames;
+    NewNames newNames;
+    std::string scanCost;
+    std::vector<utils::EventLoop::Event> events;
+    for(bool running = true; running;)
+    {
+        loop.wait(events);
+        bool resample{false};
+        bool redraw{false};
+        for(const utils::EventLoop::Event& event : events)
+        {
+            switch(event._source)
+            {
+                case utils::EventLoop::Source::Input :
+                {
+                    char keys[64];
+                    const ssize_t count = ::read(STDIN_FILENO, keys, sizeof(keys));
+                    if(count == 0)
+                    {
+                        // stdin is over (eg. redirected from a file), the scans keep the monitor going
+                        loop.unwatchInput();
+                    }
+                    for(ssize_t key=0; key<count && running; ++key)
+                    {
+                        const bool typing = monitor.isTyping();
+                        running = monitor.handleKey(keys[key]);
+                        if(!typing && (keys[key] == 'r' || keys[key] == 'R'))
+                        {
+                            collector.scanNow();
+                        }
+                        redraw = true;
+                    }
+                    break;
+                }
+                case utils::EventLoop::Source::Wakeup :
+                    if(collector.takeTopRows(askedPids, liveRows, liveNames))
+                    {
+                        monitor.applyTopRows(askedPids, liveRows, liveNames);
+                        redraw = true;
+                    }
+                    if(collector.takeScan(liveRows, newNames, scanCost))
+                    {
+                        if(monitor.getFollowFd() >= 0)
+                        {
+                            loop.unwatchFile(monitor.getFollowFd());
+                            monitor.unfollowExport();
+                        }
+                        monitor.applyScan(liveRows, newNames, scanCost);
+                        resample = true;
+                    }
+                    break;
+                case utils::EventLoop::Source::File :
+                    redraw |= monitor.followExport();
+                    break;
+                case utils::EventLoop::Source::Signal :
+                    if(event._signal == SIGUSR1)
+                    {
+                        dumpProfile(options._profileOutput);
+                        break;
+                    }
+                    running &= event._signal == SIGWINCH;
+                    redraw = true;
+                    break;
+            }
+        }
 
+        if(running && resample)
+        {
+            monitor.sample();
+        }
+        if(running && (resample || redraw))
+        {
+            draw(monitor.render());
+        }
+    }
+}
+
+}
 }
-}
\ No newline at end of file
@@ -0,0 +1,293 @@
+#include <CliOptions.hpp>
+#include <Exception.hpp>
+#include <ProcessSignaller.hpp>
+#include <Query.hpp>
+
+#include <charconv>
+#include <string_view>
+
+namespace proc
+{
+namespace cli
+{
+namespace
+{
+// the churn benchmark defaults, many scans close together
+static constexpr uint kChurnBenchScans = 50u;
+static constexpr double kChurnBenchDelaySeconds = 0.1;
+
+std::string_view nextValue(const int argc, const char* const argv[], int& index)
+{
+    if(index + 1 >= argc)
+    {
+        throw utils::SeverityException<utils::SeriousException>("Flag " + std::string(argv[index]) + " expects a value");
+    }
+    return argv[++index];
+}
+
+template<class Number>
+Number toNumber(std::string_view flag, std::string_view value)
+{
+    Number number{};
+    const std::from_chars_result result = std::from_chars(value.data(), value.data() + value.size(), number);
+    if(result.ec != std::errc() || result.ptr != value.data() + value.size())
+    {
+        throw utils::SeverityException<utils::SeriousException>("Value " + std::string(value) + " of flag " + std::string(flag) + " is not a valid number");
+    }
+    return number;
+}
+
+// comma separated pid:starttime, eg. "120:4685,455:90211" : the starttime (22 of /proc/<pid>/stat) is the identity
+// the process is signalled on, a pid alone could be one recycled since it was picked
+std::vector<SignalTarget> toTargetList(std::string_view flag, std::string_view value)
+{
+    std::vector<SignalTarget> targets;
+    while(!value.empty())
+    {
+        const std::size_t comma = value.find(',');
+        const std::string_view target = value.substr(0, comma);
+        const std::size_t colon = target.find(':');
+        if(colon == std::string_view::npos)
+        {
+            throw utils::SeverityException<utils::SeriousException>("Process " + std::string(target) + " of flag " + std::string(flag)
+                + " comes without its' starttime, use PID:STARTTIME (field 22 of /proc/PID/stat)");
+        }
+        targets.push_back(SignalTarget{toNumber<uint>(flag, target.substr(0, colon)), toNumber<unsigned long long>(flag, target.substr(colon + 1))});
+        value = comma == std::string_view::npos ? std::string_view() : value.substr(comma + 1);
+    }
+    return targets;
+}
+}
+
+Options parseOptions(const int argc, const char* const argv[])
+{
+    Options options;
+    bool formatGiven{false};
+    bool iterationsGiven{false};
+    bool delayGiven{false};
+    for(int i=1; i<argc; ++i)
+    {
+        const std::string_view flag(argv[i]);
+        if(flag == "-b" || flag == "--batch")
+        {
+            options._mode = Mode::Batch;
+        }
+        else if(flag == "-g" || flag == "--cgroups")
+        {
+            options._cgroups = true;
+        }
+        else if(flag == "-n" || flag == "--iterations")
+        {
+            options._iterations = toNumber<uint>(flag, nextValue(argc, argv, i));
+            iterationsGiven = true;
+        }
+        else if(flag == "-d" || flag == "--delay")
+        {
+            options._delaySeconds = toNumber<double>(flag, nextValue(argc, argv, i));
+            delayGiven = true;
+            if(options._delaySeconds < 0.0)
+            {
+                throw utils::SeverityException<utils::SeriousException>("Delay between snapshots cannot be negative");
+            }
+        }
+        else if(flag == "-f" || flag == "--format")
+        {
+            const std::string_view kind = nextValue(argc, argv, i);
+            if(!format::parseKind(kind, options._format))
+            {
+                throw utils::SeverityException<utils::SeriousException>("Unknown output format " + std::string(kind) + ", expected csv, jsonl or text");
+            }
+            formatGiven = true;
+        }
+        else if(flag == "-o" || flag == "--output")
+        {
+            options._output = std::filesystem::path(std::string(nextValue(argc, argv, i)));
+        }
+        else if(flag == "-k" || flag == "--signal")
+        {
+            const std::string_view signal = nextValue(argc, argv, i);
+            options._mode = Mode::Signal;
+            options._signal = parseSignal(signal);
+            if(options._signal < 0)
+            {
+                throw utils::SeverityException<utils::SeriousException>("Unknown signal " + std::string(signal));
+            }
+        }
+        else if(flag == "-p" || flag == "--pids")
+        {
+            options._targets = toTargetList(flag, nextValue(argc, argv, i));
+        }
+        else if(flag == "-w" || flag == "--wait")
+        {
+            options._exitWaitMs = toNumber<uint>(flag, nextValue(argc, argv, i));
+        }
+        else if(flag == "--io")
+        {
+            const std::string_view backend = nextValue(argc, argv, i);
+            if(!utils::procfs::parseIoBackend(backend, options._ioBackend))
+            {
+                throw utils::SeverityException<utils::SeriousException>("Unknown I/O backend " + std::string(backend) + ", expected auto, sync or uring");
+            }
+        }
+        else if(flag == "--profile-json")
+        {
+            options._profileOutput = std::filesystem::absolute(std::filesystem::path(std::string(nextValue(argc, argv, i))));
+        }
+        else if(flag == "--rules")
+        {
+            options._rulesFile = std::filesystem::absolute(std::filesystem::path(std::string(nextValue(argc, argv, i))));
+        }
+        else if(flag == "--alert-log")
+        {
+            options._alertLog = std::filesystem::absolute(std::filesystem::path(std::string(nextValue(argc, argv, i))));
+        }
+        else if(flag == "--budget")
+        {
+            options._budgetPercent = toNumber<double>(flag, nextValue(argc, argv, i));
+            if(options._budgetPercent < 0.0 || options._budgetPercent > 100.0)
+            {
+                throw utils::SeverityException<utils::SeriousException>("Collector budget is a percentage of one core, between 0 and 100");
+            }
+        }
+        else if(flag == "--priority")
+        {
+            const std::string_view priority = nextValue(argc, argv, i);
+            if(!budget::parsePriority(priority, options._priority))
+            {
+                throw utils::SeverityException<utils::SeriousException>("Unknown priority " + std::string(priority) + ", expected normal, nice or idle");
+            }
+        }
+        else if(flag == "--diff")
+        {
+            options._mode = Mode::Diff;
+            options._diffBefore = std::filesystem::absolute(std::filesystem::path(std::string(nextValue(argc, argv, i))));
+            // the second capture is optional, a live scan stands in for it
+            if(i + 1 < argc && argv[i + 1][0] != '-')
+            {
+                options._diffAfter = std::filesystem::absolute(std::filesystem::path(std::string(argv[++i])));
+            }
+        }
+        else if(flag == "--top")
+        {
+            options._top = toNumber<uint>(flag, nextValue(argc, argv, i));
+        }
+        else if(flag == "--by")
+        {
+            const std::string_view metric = nextValue(argc, argv, i);
+            if(!diff::parseMetric(metric, options._diffMetric))
+            {
+                throw utils::SeverityException<utils::SeriousException>("Unknown metric " + std::string(metric) + ", expected cpu, memory or threads");
+            }
+        }
+        else if(flag == "--where")
+        {
+            options._where = std::string(nextValue(argc, argv, i));
+            // a typo fails here rather than once the collector is running
+            query::compile(options._where);
+        }
+        else if(flag == "--select")
+        {
+            options._mode = Mode::Select;
+            options._selectFile = std::filesystem::absolute(std::filesystem::path(std::string(nextValue(argc, argv, i))));
+        }
+        else if(flag == "--churn-bench")
+        {
+            options._mode = Mode::ChurnBench;
+        }
+        else if(flag == "--churn-rate")
+        {
+            options._churn._processesPerSecond = toNumber<uint>(flag, nextValue(argc, argv, i));
+            if(options._churn._processesPerSecond == 0u)
+            {
+                throw utils::SeverityException<utils::SeriousException>("A churn rate is at least one process per second");
+            }
+        }
+        else if(flag == "--churn-threads")
+        {
+            options._churn._threadsPerProcess = toNumber<uint>(flag, nextValue(argc, argv, i));
+        }
+        else if(flag == "--churn-lifetime")
+        {
+            options._churn._lifetimeMs = toNumber<uint>(flag, nextValue(argc, argv, i));
+        }
+        else
+        {
+            throw utils::SeverityException<utils::SeriousException>("Unknown flag " + std::string(flag) + "\n" + usage());
+        }
+    }
+
+    if(!options._rulesFile.empty() && options._alertLog.empty())
+    {
+        options._alertLog = std::filesystem::absolute("alerts.log");
+    }
+    // a diff is read by a person unless a stream format was asked for, a selection can be loaded back as an export
+    if((options._mode == Mode::Diff || options._mode == Mode::Select) && !formatGiven)
+    {
+        options._format = format::Kind::Text;
+    }
+    // a benchmark is a run of scans close together, read by a person unless a stream format was asked for
+    if(options._mode == Mode::ChurnBench)
+    {
+        options._iterations = iterationsGiven ? options._iterations : kChurnBenchScans;
+        options._delaySeconds = delayGiven ? options._delaySeconds : kChurnBenchDelaySeconds;
+        options._format = formatGiven ? options._format : format::Kind::Text;
+    }
+    if(options._cgroups && !options._where.empty())
+    {
+        throw utils::SeverityException<utils::SeriousException>("--where filters processes, cgroups have none of their columns");
+    }
+    if(options._mode == Mode::Signal && options._targets.empty())
+    {
+        throw utils::SeverityException<utils::SeriousException>("A signal needs the processes to deliver to, use -p PID:STARTTIME[,...]");
+    }
+    return options;
+}
+
+std::string usage()
+{
+    return
+        "Usage: out [-b [-g] [-n ITERATIONS] [-d SECONDS] [-f csv|jsonl|text] [-o FILE]]\n"
+        "       out -k SIGNAL -p PID:STARTTIME[,PID:STARTTIME...] [-w MILLISECONDS]\n"
+        "       out --diff BEFORE [AFTER] [--top K] [--by cpu|memory|threads] [-f text|csv|jsonl] [-o FILE]\n"
+        "       out --select EXPORT [-f text|csv|jsonl] [-o FILE]\n"
+        "       out --churn-bench [--churn-rate N] [--churn-threads N] [--churn-lifetime MS] [-n SCANS] [-d SEC]\n"
+        "                         [-f text|csv|jsonl] [-o FILE]\n"
+        "       any of the above [--io auto|sync|uring] [--profile-json FILE] [--rules FILE [--alert-log FILE]]\n"
+        "                        [--budget PERCENT] [--priority normal|nice|idle] [--where FILTER]\n"
+        "  -b, --batch        stream snapshots instead of the interactive monitor\n"
+        "  -g, --cgroups      stream cgroup v2 aggregates (cpu.stat, memory.current, pids.current) instead of processes\n"
+        "  -n, --iterations   number of snapshots in batch mode (default 1)\n"
+        "  -d, --delay        seconds between two snapshots, or two refreshes of the monitor (default 1.0)\n"
+        "  -f, --format       csv (default), jsonl or text\n"
+        "  -o, --output       file to stream into instead of stdout\n"
+        "  -k, --signal       TERM, KILL, STOP, CONT, ... or a number, delivered through pidfds\n"
+        "  -p, --pids         comma separated processes to signal, each with its' starttime (field 22 of /proc/PID/stat)\n"
+        "  -w, --wait         milliseconds to wait for the signalled processes to exit (default 2000)\n"
+        "  --diff             compare two exports (ProcessesStatus.txt), a live scan standing in for a missing AFTER ;\n"
+        "                     a table with -f text (default), one row per change with -f csv or jsonl\n"
+        "  --top              movers, appeared and disappeared processes kept each (default 10, 0 keeps every change)\n"
+        "  --by               metric the movers are ranked by : cpu (default), memory or threads\n"
+        "  --select           the rows of an export matching --where, as text (default) or -f csv|jsonl\n"
+        "  --churn-bench      scans (-n, 50 by default) every -d seconds (0.1) while short-lived processes are forked,\n"
+        "                     reporting the scan latency, the processes missed, the vanished entries and the cpu cost\n"
+        "  --churn-rate       processes forked per second by the churn benchmark (200)\n"
+        "  --churn-threads    threads started by each of them besides the main one (4)\n"
+        "  --churn-lifetime   their mean lifetime in ms (100), each one living between none and twice as long\n"
+        "  --where            only the processes matching a filter over cpu, memory|mem|rss, threads, uptime, pid,\n"
+        "                     uid|user, session and name, eg. \"cpu > 5 && mem > 1 && uptime < 10m || name == nginx\"\n"
+        "  --io               backend reading the /proc files of a scan, io_uring when available (default auto)\n"
+        "  --profile-json     dump the per-stage latency histograms of the collector as JSON at exit\n"
+        "                     (and on SIGUSR1 while the monitor runs)\n"
+        "  --rules            threshold rules, one per line, eg. \"cpu > 80% for 30s\", \"rss rising for 5m\", \"count < 3\"\n"
+        "  --alert-log        file the fired alerts are appended to (default alerts.log)\n"
+        "  --budget           cpu of the collector kept under this % of one core, widening the refresh then sampling\n"
+        "                     fewer processes per tick (default 0, unlimited)\n"
+        "  --priority         scheduling of the collector thread : normal (default), nice (nice 19, lowest I/O priority)\n"
+        "                     or idle (SCHED_IDLE, idle I/O class)\n"
+        "monitor keys : Q quit, R refresh now, S next sort column, F type a filter (as --where, Enter applies it,\n"
+        "               empty shows all, Esc cancels), P toggle the placement view (last cpu, affinity, memory off the\n"
+        "               NUMA node of that cpu), G group by name, user, session or not, E expand the next group\n";
+}
+
+}
+}
\ No newline at end of file
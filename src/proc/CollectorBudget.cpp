@@ -0,0 +1,174 @@
+#include <CollectorBudget.hpp>
+#include <LogTrace.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace proc
+{
+namespace budget
+{
+namespace
+{
+// linux/ioprio.h, not exported by glibc
+constexpr int kIoprioWhoProcess = 1;
+constexpr int kIoprioClassShift = 13;
+constexpr int kIoprioClassBestEffort = 2;
+constexpr int kIoprioClassIdle = 3;
+constexpr int kLowestBestEffort = 7;
+constexpr int kLowestNice = 19;
+
+// the weight of the last tick in the smoothed cost
+constexpr double kSmoothing = 0.5;
+
+bool setIoPriority(const int ioClass, const int level)
+{
+    // the "process" of ioprio_set is a thread id, 0 being the calling thread
+    return ::syscall(SYS_ioprio_set, kIoprioWhoProcess, 0, (ioClass << kIoprioClassShift) | level) == 0;
+}
+
+// "250ms" below a second, "2.5s" from there on
+void appendSeconds(std::string& text, const std::chrono::milliseconds interval)
+{
+    if(interval < std::chrono::seconds(1))
+    {
+        text += std::to_string(interval.count()) + "ms";
+        return;
+    }
+    char seconds[32];
+    text.append(seconds, std::to_chars(seconds, seconds + sizeof(seconds), static_cast<double>(interval.count()) / 1000.0, std::chars_format::fixed, 1).ptr);
+    text += 's';
+}
+
+void appendPercent(std::string& text, const double percent)
+{
+    char number[32];
+    text.append(number, std::to_chars(number, number + sizeof(number), percent, std::chars_format::fixed, 1).ptr);
+    text += '%';
+}
+}
+
+bool parsePriority(std::string_view text, Priority& priority)
+{
+    if(text == "normal")
+    {
+        priority = Priority::Normal;
+    }
+    else if(text == "nice")
+    {
+        priority = Priority::Nice;
+    }
+    else if(text == "idle")
+    {
+        priority = Priority::Idle;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+bool applyPriority(const Priority priority)
+{
+    switch(priority)
+    {
+        case Priority::Normal :
+            return true;
+        case Priority::Nice :
+            // on linux the nice value is per thread, addressed by its' tid
+            if(::setpriority(PRIO_PROCESS, static_cast<id_t>(::syscall(SYS_gettid)), kLowestNice) != 0
+                || !setIoPriority(kIoprioClassBestEffort, kLowestBestEffort))
+            {
+                WARNING("Collector cannot lower its' priority : " << std::strerror(errno) << ". Running at normal priority...");
+                return false;
+            }
+            return true;
+        case Priority::Idle :
+        {
+            const sched_param param{};
+            const int error = ::pthread_setschedparam(::pthread_self(), SCHED_IDLE, &param);
+            if(error != 0 || !setIoPriority(kIoprioClassIdle, 0))
+            {
+                WARNING("Collector cannot move to the idle scheduling class : " << std::strerror(error != 0 ? error : errno) << ". Running at normal priority...");
+                return false;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+std::chrono::microseconds threadCpuTime()
+{
+    rusage usage{};
+    ::getrusage(RUSAGE_THREAD, &usage);
+    return std::chrono::seconds(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec)
+        + std::chrono::microseconds(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+}
+
+CollectorBudget::CollectorBudget(const double budgetPercent, const std::chrono::milliseconds interval)
+    : _budget(budgetPercent / 100.0), _requested(interval), _interval(interval)
+{}
+
+void CollectorBudget::record(const std::chrono::microseconds tickCpu)
+{
+    // a tick at stride N read 1 in N processes, what a full one would cost is extrapolated from it
+    const double fullTickCpu = static_cast<double>(tickCpu.count()) * static_cast<double>(_stride);
+    _fullTickCpu = _measured ? kSmoothing * fullTickCpu + (1.0 - kSmoothing) * _fullTickCpu : fullTickCpu;
+    _measured = true;
+    if(_budget <= 0.0)
+    {
+        return;
+    }
+
+    // interval at which a full tick fits the budget, in ms
+    const double needed = _fullTickCpu / 1000.0 / _budget;
+    const double requested = static_cast<double>(std::max(_requested, std::chrono::milliseconds(1)).count());
+    const double widest = requested * kMaxWiden;
+    _stride = needed <= widest ? 1u : std::min(kMaxStride, static_cast<uint>(std::ceil(needed / widest)));
+    const double interval = std::clamp(needed / static_cast<double>(_stride), requested, widest);
+    _interval = needed <= requested ? _requested : std::chrono::milliseconds(static_cast<std::int64_t>(std::ceil(interval)));
+}
+
+double CollectorBudget::getCostPercent() const
+{
+    const double interval = static_cast<double>(std::max(_interval, std::chrono::milliseconds(1)).count());
+    return _fullTickCpu / static_cast<double>(_stride) / 1000.0 / interval * 100.0;
+}
+
+std::string CollectorBudget::describe() const
+{
+    std::string text("| Refresh: ");
+    appendSeconds(text, _interval);
+    if(isDegraded())
+    {
+        text += " (throttled from ";
+        appendSeconds(text, _requested);
+        if(_stride > 1u)
+        {
+            text += ", 1 in " + std::to_string(_stride) + " processes per tick";
+        }
+        text += ')';
+    }
+    text += " - collector ";
+    appendPercent(text, getCostPercent());
+    text += " of a core";
+    if(_budget > 0.0)
+    {
+        text += " (budget ";
+        appendPercent(text, _budget * 100.0);
+        text += ')';
+    }
+    return text;
+}
+}
+}
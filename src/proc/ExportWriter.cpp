@@ -0,0 +1,195 @@
+#include <ExportWriter.hpp>
+#include <LogTrace.hpp>
+#include <SnapshotFormat.hpp>
+#include <UniqueFd.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <unistd.h>
+
+namespace proc
+{
+namespace
+{
+// several writers of one export (tests, two collectors) must not share a temporary file
+std::atomic<uint> writerCount{0u};
+
+// the whole of `iovecs`, resumed after a short write ; false with errno set on failure
+bool writeAll(const int fd, std::vector<iovec>& iovecs)
+{
+    std::size_t first{0u};
+    while(first < iovecs.size())
+    {
+        const int count = static_cast<int>(std::min<std::size_t>(iovecs.size() - first, IOV_MAX));
+        const ssize_t written = ::writev(fd, iovecs.data() + first, count);
+        if(written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if(written < 0)
+        {
+            return false;
+        }
+        std::size_t left = static_cast<std::size_t>(written);
+        while(first < iovecs.size() && left >= iovecs[first].iov_len)
+        {
+            left -= iovecs[first].iov_len;
+            ++first;
+        }
+        if(left > 0u)
+        {
+            iovecs[first].iov_base = static_cast<char*>(iovecs[first].iov_base) + left;
+            iovecs[first].iov_len -= left;
+        }
+    }
+    return true;
+}
+}
+
+ExportWriter::ExportWriter(const std::filesystem::path& exportPath, const Durability durability)
+    : _path(exportPath),
+      _tempPath(exportPath.string() + ".tmp." + std::to_string(::getpid()) + '.' + std::to_string(writerCount.fetch_add(1u))),
+      _durability(durability),
+      _writer(&ExportWriter::run, this)
+{}
+
+ExportWriter::~ExportWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _wakeWriter.notify_one();
+    _writer.join();
+}
+
+void ExportWriter::submit(const PidTable_t& snapshot, const utils::StringTable* names)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if(_hasPending)
+        {
+            ++_coalesced;
+        }
+        // assign() and clear() keep the capacity of the previous snapshot, a steady collector copies without allocating
+        _pending._rows.assign(snapshot.begin(), snapshot.end());
+        _pending._names.clear();
+        _pending._nameEnds.clear();
+        if(names != nullptr)
+        {
+            for(const auto& [pidNum, stats] : _pending._rows)
+            {
+                _pending._names += names->view(stats._name);
+                _pending._nameEnds.push_back(_pending._names.size());
+            }
+        }
+        _hasPending = true;
+    }
+    _wakeWriter.notify_one();
+}
+
+void ExportWriter::waitIdle()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _idle.wait(lock, [this]{ return !_hasPending && !_writing; });
+}
+
+std::size_t ExportWriter::getPublished()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _published;
+}
+
+std::size_t ExportWriter::getCoalesced()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _coalesced;
+}
+
+std::size_t ExportWriter::getFailed()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _failed;
+}
+
+void ExportWriter::run()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    while(true)
+    {
+        _wakeWriter.wait(lock, [this]{ return _hasPending || _stopping; });
+        if(!_hasPending)
+        {
+            return;
+        }
+        // the two row buffers trade places, the collector fills the other one meanwhile
+        std::swap(_pending, _writingSnapshot);
+        _hasPending = false;
+        _writing = true;
+        lock.unlock();
+
+        serialize(_writingSnapshot);
+        const bool published = publish();
+
+        lock.lock();
+        _writing = false;
+        ++(published ? _published : _failed);
+        _idle.notify_all();
+    }
+}
+
+void ExportWriter::serialize(const Snapshot& snapshot)
+{
+    std::size_t used{0u};
+    for(std::size_t row=0; row<snapshot._rows.size(); ++row)
+    {
+        const auto& [pidNum, stats] = snapshot._rows[row];
+        if(used == 0u || _chunks[used - 1u]->size() >= kChunkBytes)
+        {
+            if(used == _chunks.size())
+            {
+                // a row never exceeds a few hundred bytes, the margin keeps the chunk from growing
+                _chunks.push_back(std::make_unique<utils::OutputBuffer>(-1, kChunkBytes + 512u));
+            }
+            _chunks[used++]->clear();
+        }
+        const std::size_t nameStart = row == 0u || snapshot._nameEnds.empty() ? 0u : snapshot._nameEnds[row - 1u];
+        const std::string_view name = snapshot._nameEnds.empty() ? std::string_view() :
+            std::string_view(snapshot._names).substr(nameStart, snapshot._nameEnds[row] - nameStart);
+        format::appendRow(*_chunks[used - 1u], format::Kind::Text, 0u, pidNum, stats, name);
+    }
+
+    _iovecs.clear();
+    for(std::size_t chunk=0; chunk<used; ++chunk)
+    {
+        const std::string_view bytes = _chunks[chunk]->view();
+        _iovecs.push_back(iovec{const_cast<char*>(bytes.data()), bytes.size()});
+    }
+}
+
+bool ExportWriter::publish()
+{
+    utils::UniqueFd temp(::open(_tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+    if(!temp.valid())
+    {
+        ERROR("Cannot create " << _tempPath << " : " << std::strerror(errno) << ". The export keeps its' previous snapshot");
+        return false;
+    }
+    const bool written = writeAll(temp.get(), _iovecs) && (_durability != Durability::Fsync || ::fsync(temp.get()) == 0);
+    // close() may be the one reporting a failed write back on some filesystems
+    const bool closed = ::close(temp.release()) == 0;
+    if(!written || !closed || std::rename(_tempPath.c_str(), _path.c_str()) != 0)
+    {
+        ERROR("Cannot publish the export " << _path << " : " << std::strerror(errno) << ". The export keeps its' previous snapshot");
+        ::unlink(_tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+}
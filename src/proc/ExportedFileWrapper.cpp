@@ -1,91 +1,493 @@
 #include <LogTrace.hpp>
 #include <ProcessInfo.hpp>
 #include <ExportedFileWrapper.hpp>
-#include <fstream>
-#include <sstream>
+#include <UniqueFd.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
+#include <limits.h>
 #include <string>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
 
 namespace proc
 {
 namespace
 {
-void setSecondsAndMs(PidStats::timezone& tmz, const std::string& timeValue)
+// read-only mapping of a whole file, empty when it couldn't be mapped
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::filesystem::path& path)
+    {
+        const utils::UniqueFd file(::open(path.c_str(), O_RDONLY | O_CLOEXEC));
+        if(!file.valid() || ::fstat(file.get(), &_status) != 0)
+        {
+            return;
+        }
+        _found = true;
+        if(_status.st_size == 0)
+        {
+            return;
+        }
+        void* mapping = ::mmap(nullptr, static_cast<std::size_t>(_status.st_size), PROT_READ, MAP_PRIVATE, file.get(), 0);
+        if(mapping == MAP_FAILED)
+        {
+            ERROR("Exported file cannot be mapped : " << std::strerror(errno));
+            return;
+        }
+        ::madvise(mapping, static_cast<std::size_t>(_status.st_size), MADV_SEQUENTIAL);
+        _data = static_cast<const char*>(mapping);
+        _size = static_cast<std::size_t>(_status.st_size);
+    }
+    ~MappedFile()
+    {
+        if(_data != nullptr)
+        {
+            ::munmap(const_cast<char*>(_data), _size);
+        }
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    inline bool found() const { return _found; }
+    inline std::string_view content() const { return std::string_view(_data, _size); }
+    // of the file mapped, taken on the same descriptor
+    inline const struct stat& status() const { return _status; }
+
+private:
+    const char* _data{nullptr};
+    std::size_t _size{0u};
+    bool _found{false};
+    struct stat _status{};
+};
+
+// fields of a line, left to right
+class LineCursor
+{
+public:
+    explicit LineCursor(std::string_view line) : _at(line.data()), _end(line.data() + line.size()) {}
+
+    bool key(std::string_view expected)
+    {
+        skipBlanks();
+        if(static_cast<std::size_t>(_end - _at) < expected.size() || std::string_view(_at, expected.size()) != expected)
+        {
+            return false;
+        }
+        _at += expected.size();
+        return true;
+    }
+
+    // the number, then whatever sticks to it ("4.58%")
+    template<class Number>
+    bool value(Number& number)
+    {
+        skipBlanks();
+        const std::from_chars_result result = std::from_chars(_at, _end, number);
+        if(result.ec != std::errc())
+        {
+            return false;
+        }
+        _at = result.ptr;
+        while(_at != _end && *_at != ' ')
+        {
+            ++_at;
+        }
+        return true;
+    }
+
+    // the number, then `separator`
+    bool value(uint& number, const char separator)
+    {
+        const std::from_chars_result result = std::from_chars(_at, _end, number);
+        if(result.ec != std::errc() || result.ptr == _end || *result.ptr != separator)
+        {
+            return false;
+        }
+        _at = result.ptr + 1;
+        return true;
+    }
+
+    bool exact(uint& number)
+    {
+        const std::from_chars_result result = std::from_chars(_at, _end, number);
+        _at = result.ptr;
+        return result.ec == std::errc();
+    }
+
+    // up to the end of the line, trailing blanks excluded
+    std::string_view rest()
+    {
+        const char* end = _end;
+        while(end != _at && (end[-1] == ' ' || end[-1] == '\r'))
+        {
+            --end;
+        }
+        return std::string_view(_at, static_cast<std::size_t>(end - _at));
+    }
+
+    bool done()
+    {
+        skipBlanks();
+        return _at == _end;
+    }
+
+    void skipBlanks()
+    {
+        while(_at != _end && (*_at == ' ' || *_at == '\r'))
+        {
+            ++_at;
+        }
+    }
+
+private:
+    const char* _at;
+    const char* _end;
+};
+
+// decoded rows and rejected lines of a chunk, the line numbers relative to the chunk start
+struct Chunk
 {
-    std::string token;
-    std::istringstream ssSecondsAndMs(timeValue);
+    std::string_view _content;
+    std::vector<std::pair<uint, PidStats>> _rows;
+    std::vector<std::string_view> _names; // of every row, in the mapping
+    std::vector<MalformedLine> _malformed;
+    std::size_t _lines{0u};
+};
 
-    std::getline(ssSecondsAndMs, token, '.');
-    tmz._seconds = std::stoi(token);
+void parseChunk(Chunk& chunk)
+{
+    std::string_view content = chunk._content;
+    // the rows of a chunk run at ~70 bytes each
+    chunk._rows.reserve(content.size() / 64u);
+    chunk._names.reserve(content.size() / 64u);
+    while(!content.empty())
+    {
+        const std::size_t newLine = content.find('\n');
+        const std::string_view line = content.substr(0, newLine);
+        content = newLine == std::string_view::npos ? std::string_view() : content.substr(newLine + 1);
+        ++chunk._lines;
+        if(line.find_first_not_of(" \r") == std::string_view::npos)
+        {
+            continue;
+        }
 
-    std::getline(ssSecondsAndMs, token, '.');
-    tmz._ms = std::stoi(token);
+        uint pid{0u};
+        PidStats stats{};
+        std::string_view name;
+        if(const char* reason = parseExportedLine(line, pid, stats, &name))
+        {
+            chunk._malformed.push_back(MalformedLine{chunk._lines, reason});
+            continue;
+        }
+        chunk._rows.emplace_back(pid, stats);
+        chunk._names.push_back(name);
+    }
 }
 
-PidStats::timezone getTimeZoneFromFile(const std::string& entityValue)
+// `content` cut on line boundaries into up to `threads` chunks decoded in parallel, in file order
+std::vector<Chunk> decodeChunks(std::string_view content, const uint threads)
 {
-    PidStats::timezone tmz;
-    std::istringstream ssEntityValue(entityValue);
-    for(int i=0; i<3; ++i)
+    // chunks end right after a '\n', so that no line is split
+    const std::size_t chunkCount = std::max<std::size_t>(1u, std::min<std::size_t>(threads, content.size() / ExportedFileWrapper::kMinChunkBytes));
+    std::vector<Chunk> chunks(chunkCount);
+    std::size_t start{0u};
+    for(std::size_t chunk=0; chunk<chunkCount; ++chunk)
     {
-        std::string timeValue;
-        std::getline(ssEntityValue, timeValue, ':');
+        std::size_t end = content.size();
+        if(chunk + 1u < chunkCount)
+        {
+            const std::size_t newLine = content.find('\n', std::max(start, content.size() * (chunk + 1u) / chunkCount));
+            end = newLine == std::string_view::npos ? content.size() : newLine + 1u;
+        }
+        chunks[chunk]._content = content.substr(start, end - start);
+        start = end;
+    }
+
+    std::vector<std::thread> workers;
+    workers.reserve(chunkCount - 1u);
+    for(std::size_t chunk=1; chunk<chunkCount; ++chunk)
+    {
+        workers.emplace_back(parseChunk, std::ref(chunks[chunk]));
+    }
+    parseChunk(chunks[0]);
+    for(std::thread& worker : workers)
+    {
+        worker.join();
+    }
+    return chunks;
+}
 
-        // reminder : the format is hh:mm:ss.ms , so we have to parse the ss.ms
-        switch(i)
+// the rejected lines of every chunk, numbered from the start of the file
+void collectMalformed(std::vector<Chunk>& chunks, std::vector<MalformedLine>& malformed)
+{
+    std::size_t firstLine{0u};
+    for(Chunk& chunk : chunks)
+    {
+        for(MalformedLine& line : chunk._malformed)
         {
-            case 0 : tmz._hours = std::stoi(timeValue); break;
-            case 1 : tmz._minutes = std::stoi(timeValue); break;
-            case 2 : setSecondsAndMs(tmz, timeValue); break;
+            line._line += firstLine;
+            malformed.push_back(std::move(line));
         }
+        firstLine += chunk._lines;
     }
-    return tmz;
+}
+
+uint workerCount(const uint threads)
+{
+    return threads == 0u ? std::max(1u, std::thread::hardware_concurrency()) : threads;
 }
 }
 
+const char* parseExportedLine(std::string_view line, uint& pid, PidStats& stats, std::string_view* name)
+{
+    LineCursor cursor(line);
+    if(!cursor.key("Pid:") || !cursor.value(pid))
+    {
+        return "expected \"Pid: <number>\"";
+    }
+    if(!cursor.key("cpu:") || !cursor.value(stats._cpu))
+    {
+        return "expected \"cpu: <percentage>\"";
+    }
+    if(!cursor.key("memory:") || !cursor.value(stats._memory))
+    {
+        return "expected \"memory: <percentage>\"";
+    }
+    if(!cursor.key("threads:") || !cursor.value(stats._threads))
+    {
+        return "expected \"threads: <number>\"";
+    }
+
+    // reminder : the format is hh:mm:ss.ms
+    PidStats::timezone& uptime = stats._timezone;
+    if(!cursor.key("time:"))
+    {
+        return "expected \"time: hh:mm:ss.ms\"";
+    }
+    cursor.skipBlanks();
+    if(!cursor.value(uptime._hours, ':') || !cursor.value(uptime._minutes, ':') || !cursor.value(uptime._seconds, '.') || !cursor.exact(uptime._ms))
+    {
+        return "expected \"time: hh:mm:ss.ms\"";
+    }
+    if(name != nullptr)
+    {
+        *name = std::string_view();
+    }
+    if(cursor.done())
+    {
+        return nullptr;
+    }
+    if(cursor.key("user:"))
+    {
+        if(!cursor.value(stats._uid) || !cursor.key("session:") || !cursor.value(stats._session))
+        {
+            return "expected \"user: <number> session: <number>\"";
+        }
+        if(cursor.done())
+        {
+            return nullptr;
+        }
+    }
+    if(!cursor.key("name:"))
+    {
+        return "unexpected content after the time";
+    }
+    cursor.skipBlanks();
+    if(name != nullptr)
+    {
+        *name = cursor.rest();
+    }
+    return nullptr;
+}
 
-ExportedFileWrapper::ExportedFileWrapper(const std::filesystem::path& exportedFilePath)
+ExportedFileWrapper::ExportedFileWrapper(const std::filesystem::path& exportedFilePath, const uint threads)
+    : _path(exportedFilePath), _threads(workerCount(threads)), _snapshot(std::make_shared<Snapshot>()), _paged(_snapshot)
 {
-    std::ifstream exportedFile(exportedFilePath);
-    if(!exportedFile)
+    _pidsIter = _paged->_pids.end();
+    const MappedFile exportedFile(exportedFilePath);
+    if(!exportedFile.found())
     {
         ERROR("Exported file not found. Nothing to wrap");
         return;
     }
 
-    std::string fileLine;
-    PidStatus_t::iterator debugIter;
-    while(std::getline(exportedFile, fileLine))
+    _identity = identityOf(exportedFile.status());
+    load(*_snapshot, exportedFile.content(), _threads);
+    _pidsIter = _paged->_pids.begin();
+}
+
+ExportedFileWrapper::FileIdentity ExportedFileWrapper::identityOf(const struct stat& status)
+{
+    return FileIdentity{static_cast<std::uint64_t>(status.st_dev), static_cast<std::uint64_t>(status.st_ino), static_cast<std::uint64_t>(status.st_size),
+        static_cast<std::int64_t>(status.st_mtim.tv_sec) * 1'000'000'000 + status.st_mtim.tv_nsec};
+}
+
+bool ExportedFileWrapper::FileIdentity::operator==(const FileIdentity& other) const
+{
+    return _device == other._device && _inode == other._inode && _size == other._size && _modifiedNs == other._modifiedNs;
+}
+
+void ExportedFileWrapper::load(Snapshot& snapshot, std::string_view content, const uint threads)
+{
+    std::vector<Chunk> chunks = decodeChunks(content, threads);
+    // no reserve : the map grows the way it did with one row at a time, the order the rows are iterated in stays the same
+    for(const Chunk& chunk : chunks)
+    {
+        for(std::size_t row=0; row<chunk._rows.size(); ++row)
+        {
+            const auto [inserted, isNew] = snapshot._pids.emplace(chunk._rows[row].first, chunk._rows[row].second);
+            // interned here, on one thread : the decoding ones only found the names
+            if(isNew)
+            {
+                inserted->second._name = _names.intern(chunk._names[row]);
+            }
+        }
+    }
+    collectMalformed(chunks, snapshot._malformed);
+    for(const MalformedLine& malformed : snapshot._malformed)
     {
-        DEBUG("Decoding line : " << fileLine);
+        WARNING("Malformed line " << malformed._line << " in " << _path << " : " << malformed._reason << ". Skipping...");
+    }
+}
 
-        std::string token;
-        std::istringstream ss(fileLine);
-        PidStatus_t::iterator pidsIter;
-        for(int i=0; i<5; ++i)
+bool ExportedFileWrapper::follow()
+{
+    if(_watch.valid())
+    {
+        return true;
+    }
+    _watch.reset(::inotify_init1(IN_NONBLOCK | IN_CLOEXEC));
+    // published by a rename into the directory (ExportWriter) or written in place and closed
+    if(!_watch.valid() || ::inotify_add_watch(_watch.get(), _path.parent_path().c_str(), IN_MOVED_TO | IN_CLOSE_WRITE) < 0)
+    {
+        ERROR("Cannot follow the export " << _path << " : " << std::strerror(errno));
+        _watch.reset();
+        return false;
+    }
+    // from now on the bytes held are told apart from a republished copy of them : the file is hashed once here, or
+    // read again when it changed since the wrapper was built
+    const MappedFile exportedFile(_path);
+    if(exportedFile.found() && identityOf(exportedFile.status()) == _identity)
+    {
+        _contentHash = std::hash<std::string_view>()(exportedFile.content());
+        _hashed = true;
+        return true;
+    }
+    reload();
+    return true;
+}
+
+void ExportedFileWrapper::unfollow()
+{
+    _watch.reset();
+    // only kept up to date while following
+    _hashed = false;
+}
+
+bool ExportedFileWrapper::refresh()
+{
+    if(!_watch.valid())
+    {
+        return false;
+    }
+    const std::string exportName = _path.filename().string();
+    bool published{false};
+    alignas(inotify_event) char events[16u * (sizeof(inotify_event) + NAME_MAX + 1u)];
+    ssize_t count{0};
+    while((count = ::read(_watch.get(), events, sizeof(events))) > 0)
+    {
+        for(const char* at = events; at < events + count; )
         {
-            std::string systemEntity;
-            std::string entityValue;
-            std::getline(ss, systemEntity, ' ');
-            std::getline(ss, entityValue, ' ');
-            
-            systemEntity.pop_back(); // remove the ':'
-            debugIter = pidsIter;
-            switch(i)
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(at);
+            // the temporary files of the writers land in the same directory
+            published |= event->len > 0u && exportName == event->name;
+            // notifications were lost, the export may be among them
+            published |= (event->mask & IN_Q_OVERFLOW) != 0u;
+            // the watch itself gone (the directory removed) : nothing more will come
+            if(event->mask & IN_IGNORED)
             {
-                case 0 : pidsIter = _pids.emplace(std::stoi(entityValue), PidStats()).first; break;
-                case 1 : pidsIter->second._cpu = std::stod(entityValue); break; 
-                case 2 : pidsIter->second._memory = std::stod(entityValue); break;
-                case 3 : pidsIter->second._threads = std::stoi(entityValue); break;
-                case 4 : pidsIter->second._timezone = getTimeZoneFromFile(entityValue); break;
+                WARNING("The directory of the export " << _path << " is no longer watched");
             }
+            at += sizeof(inotify_event) + event->len;
+        }
+    }
+    return published && reload();
+}
+
+bool ExportedFileWrapper::reload()
+{
+    const MappedFile exportedFile(_path);
+    // gone in between : the snapshot held stays
+    if(!exportedFile.found())
+    {
+        return false;
+    }
+    const FileIdentity identity = identityOf(exportedFile.status());
+    if(identity == _identity)
+    {
+        return false;
+    }
+    _identity = identity;
+    if(_watch.valid())
+    {
+        // the same bytes published again (an idle system, a writer with nothing new) : nothing to parse
+        const std::size_t contentHash = std::hash<std::string_view>()(exportedFile.content());
+        const bool unchanged = _hashed && contentHash == _contentHash;
+        _contentHash = contentHash;
+        _hashed = true;
+        if(unchanged)
+        {
+            return false;
+        }
+    }
+
+    std::shared_ptr<Snapshot> fresh = std::make_shared<Snapshot>();
+    load(*fresh, exportedFile.content(), _threads);
+    // _paged keeps the one of the pass in progress alive
+    _snapshot = std::move(fresh);
+    ++_generation;
+    return true;
+}
+
+bool readExportedRows(const std::filesystem::path& exportedFilePath, std::vector<std::pair<uint, PidStats>>& rows,
+    std::vector<MalformedLine>& malformed, const uint threads, utils::StringTable* names)
+{
+    const MappedFile exportedFile(exportedFilePath);
+    if(!exportedFile.found())
+    {
+        return false;
+    }
+    std::vector<Chunk> chunks = decodeChunks(exportedFile.content(), workerCount(threads));
+    std::size_t total{0u};
+    for(const Chunk& chunk : chunks)
+    {
+        total += chunk._rows.size();
+    }
+    rows.clear();
+    rows.reserve(total);
+    for(const Chunk& chunk : chunks)
+    {
+        const std::size_t first = rows.size();
+        rows.insert(rows.end(), chunk._rows.begin(), chunk._rows.end());
+        for(std::size_t row=0; names != nullptr && row<chunk._names.size(); ++row)
+        {
+            rows[first + row].second._name = names->intern(chunk._names[row]);
         }
     }
-    _pidsIter = _pids.begin();
+    collectMalformed(chunks, malformed);
+    return true;
 }
 
 void ExportedFileWrapper::toDebug()
 {
-    for(const PidStatus_t::value_type& pidToStats : _pids)
+    for(const PidStatus_t::value_type& pidToStats : _snapshot->_pids)
     {
         PidStats::timezone timezone = pidToStats.second._timezone;
         INFO(
@@ -101,7 +503,7 @@ PidStatus_t ExportedFileWrapper::getPidsByStep(const uint step)
 {
     PidStatus_t pidsByStep;
 
-    for(uint i=0; i<step && _pidsIter != _pids.end(); ++i)
+    for(uint i=0; i<step && _pidsIter != _paged->_pids.end(); ++i)
     {
         pidsByStep.insert(*_pidsIter);
         ++_pidsIter;
@@ -111,7 +513,7 @@ PidStatus_t ExportedFileWrapper::getPidsByStep(const uint step)
 
 PidStatus_t& ExportedFileWrapper::getPids()
 {
-    return _pids;
+    return _snapshot->_pids;
 }
 
 PidStatus_t::iterator ExportedFileWrapper::getCurrentIter()
@@ -121,12 +523,14 @@ PidStatus_t::iterator ExportedFileWrapper::getCurrentIter()
 
 bool ExportedFileWrapper::isIterPointingEnd()
 {
-    return _pidsIter == _pids.end();
+    return _pidsIter == _paged->_pids.end();
 }
 
+// a new pass starts over the newest snapshot, the one of the previous pass is let go
 void ExportedFileWrapper::resetIter()
 {
-    _pidsIter = _pids.begin();
+    _paged = _snapshot;
+    _pidsIter = _paged->_pids.begin();
 }
 
 }
\ No newline at end of file
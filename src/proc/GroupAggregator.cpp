@@ -0,0 +1,139 @@
+#include <GroupAggregator.hpp>
+
+#include <algorithm>
+
+namespace proc
+{
+namespace group
+{
+std::uint32_t keyOf(const GroupBy by, const PidStats& stats)
+{
+    switch(by)
+    {
+        case GroupBy::Name : return stats._name;
+        case GroupBy::User : return stats._uid;
+        case GroupBy::Session : return stats._session;
+    }
+    return stats._name;
+}
+
+void Aggregator::rebuild(const PidStatus_t& snapshot, const GroupBy by)
+{
+    _by = by;
+    _groups.clear();
+    _index.clear();
+    _members.clear();
+    _members.reserve(snapshot.size());
+    for(const PidStatus_t::value_type& pidWithStats : snapshot)
+    {
+        update(pidWithStats.first, pidWithStats.second);
+    }
+}
+
+void Aggregator::update(const uint pid, const PidStats& stats)
+{
+    const std::uint32_t key = keyOf(_by, stats);
+    const auto [found, isNew] = _members.try_emplace(pid, Member{key, 0u, 0.0, 0.0, 0u});
+    Member& member = found->second;
+    bool joins = isNew;
+    if(!isNew && member._key != key)
+    {
+        // an exec (name), a setuid or a setsid : it moves to the group of its' new key with all of its' values
+        leave(pid, member);
+        member = Member{key, 0u, 0.0, 0.0, 0u};
+        joins = true;
+    }
+    Group& group = groupOf(key);
+    if(joins)
+    {
+        member._slot = group._members.size();
+        group._members.push_back(pid);
+    }
+    group._cpu += stats._cpu - member._cpu;
+    group._memory += stats._memory - member._memory;
+    group._threads = group._threads + stats._threads - member._threads;
+    member._cpu = stats._cpu;
+    member._memory = stats._memory;
+    member._threads = stats._threads;
+}
+
+void Aggregator::remove(const uint pid)
+{
+    const auto found = _members.find(pid);
+    if(found == _members.end())
+    {
+        return;
+    }
+    leave(pid, found->second);
+    _members.erase(found);
+}
+
+const Group* Aggregator::find(const std::uint32_t key) const
+{
+    const auto found = _index.find(key);
+    return found == _index.end() ? nullptr : &_groups[found->second];
+}
+
+void Aggregator::top(const std::size_t count, const Order order, std::vector<const Group*>& top) const
+{
+    top.clear();
+    for(const Group& group : _groups)
+    {
+        top.push_back(&group);
+    }
+    const auto first = [order](const Group* left, const Group* right)
+    {
+        switch(order)
+        {
+            case Order::Cpu : if(left->_cpu != right->_cpu) { return left->_cpu > right->_cpu; } break;
+            case Order::Memory : if(left->_memory != right->_memory) { return left->_memory > right->_memory; } break;
+            case Order::Threads : if(left->_threads != right->_threads) { return left->_threads > right->_threads; } break;
+            case Order::Count : if(left->_members.size() != right->_members.size()) { return left->_members.size() > right->_members.size(); } break;
+        }
+        return left->_key < right->_key;
+    };
+    const std::size_t shown = std::min(count, top.size());
+    std::partial_sort(top.begin(), top.begin() + static_cast<std::ptrdiff_t>(shown), top.end(), first);
+    top.resize(shown);
+}
+
+Group& Aggregator::groupOf(const std::uint32_t key)
+{
+    const auto [found, isNew] = _index.try_emplace(key, _groups.size());
+    if(isNew)
+    {
+        _groups.push_back(Group{key, 0.0, 0.0, 0u, {}});
+    }
+    return _groups[found->second];
+}
+
+// `pid` out of the group of `member`, the group dropped once empty
+void Aggregator::leave(const uint pid, const Member& member)
+{
+    const auto found = _index.find(member._key);
+    Group& group = _groups[found->second];
+    group._cpu -= member._cpu;
+    group._memory -= member._memory;
+    group._threads -= member._threads;
+    const uint last = group._members.back();
+    group._members[member._slot] = last;
+    group._members.pop_back();
+    if(last != pid)
+    {
+        _members.at(last)._slot = member._slot;
+    }
+    if(!group._members.empty())
+    {
+        return;
+    }
+    const std::size_t position = found->second;
+    _index.erase(found);
+    if(position + 1u != _groups.size())
+    {
+        _groups[position] = std::move(_groups.back());
+        _index[_groups[position]._key] = position;
+    }
+    _groups.pop_back();
+}
+}
+}
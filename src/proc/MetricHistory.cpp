@@ -0,0 +1,282 @@
+#include <MetricHistory.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace proc
+{
+namespace
+{
+// metrics are kept as hundredths of a percent
+static constexpr double kQuantum = 100.0;
+static constexpr const char* kSparkGlyphs[] = {"▁", "▂", "▃", "▄", "▅", "▆", "▇", "█"};
+
+inline std::int64_t quantize(const double value)
+{
+    return static_cast<std::int64_t>(std::llround(value * kQuantum));
+}
+
+inline double dequantize(const std::int64_t value)
+{
+    return static_cast<double>(value) / kQuantum;
+}
+}
+
+void MetricSeries::Block::clear()
+{
+    _time.clear();
+    for(std::size_t metric=0; metric<kMetricCount; ++metric)
+    {
+        _values[metric].clear();
+        _sum[metric] = 0;
+        _max[metric] = 0;
+    }
+    _firstMs = _lastMs = 0;
+}
+
+bool MetricSeries::Block::fits(const std::int64_t timestampMs, const std::array<std::int64_t, kMetricCount>& values) const
+{
+    if(_time.count() >= kSamplesPerBlock || !_time.fits(timestampMs))
+    {
+        return false;
+    }
+    for(std::size_t metric=0; metric<kMetricCount; ++metric)
+    {
+        if(!_values[metric].fits(values[metric]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+MetricSeries::MetricSeries(const std::size_t maxBlocks) : _maxBlocks(std::max<std::size_t>(maxBlocks, 2u))
+{
+    _blocks.reserve(_maxBlocks);
+}
+
+void MetricSeries::clear()
+{
+    _blocks.clear();
+    _oldest = 0u;
+    _lastMs = 0;
+}
+
+void MetricSeries::append(const std::int64_t timestampMs, const double cpu, const double memory)
+{
+    const std::array<std::int64_t, kMetricCount> values{quantize(cpu), quantize(memory)};
+    const std::size_t newest = _blocks.empty() ? 0u : (_oldest + _blocks.size() - 1u) % _blocks.size();
+    Block* block = _blocks.empty() ? nullptr : &_blocks[newest];
+    if(block == nullptr || !block->fits(timestampMs, values))
+    {
+        // seal the newest block : a new one while the ring has room, the oldest one recycled afterwards
+        if(_blocks.size() < _maxBlocks)
+        {
+            block = &_blocks.emplace_back();
+        }
+        else
+        {
+            block = &_blocks[_oldest];
+            block->clear();
+            _oldest = (_oldest + 1u) % _blocks.size();
+        }
+        block->_firstMs = timestampMs;
+    }
+
+    block->_time.append(timestampMs);
+    for(std::size_t metric=0; metric<kMetricCount; ++metric)
+    {
+        block->_values[metric].append(values[metric]);
+        block->_sum[metric] += values[metric];
+        block->_max[metric] = block->_values[metric].count() == 1u ? values[metric] : std::max(block->_max[metric], values[metric]);
+    }
+    block->_lastMs = timestampMs;
+    _lastMs = timestampMs;
+}
+
+template<class Visitor>
+void MetricSeries::forEachBlock(Visitor&& visitor) const
+{
+    for(std::size_t block=0; block<_blocks.size(); ++block)
+    {
+        visitor(_blocks[(_oldest + block) % _blocks.size()]);
+    }
+}
+
+std::size_t MetricSeries::size() const
+{
+    std::size_t samples{0u};
+    forEachBlock([&samples](const Block& block) { samples += block._time.count(); });
+    return samples;
+}
+
+WindowStats MetricSeries::query(const Metric metric, const std::int64_t fromMs, std::vector<std::int64_t>& scratch, const bool withPercentile) const
+{
+    const std::size_t column = static_cast<std::size_t>(metric);
+    std::int64_t sum{0};
+    std::int64_t max{0};
+    std::size_t samples{0u};
+    scratch.clear();
+
+    forEachBlock([&](const Block& block)
+    {
+        if(block._lastMs < fromMs)
+        {
+            return;
+        }
+        const std::size_t count = block._time.count();
+        if(block._firstMs >= fromMs)
+        {
+            // the whole block is in the window : the summary answers avg and max
+            sum += block._sum[column];
+            max = samples == 0u ? block._max[column] : std::max(max, block._max[column]);
+            samples += count;
+            if(withPercentile)
+            {
+                utils::gorilla::IntColumn<12u, 1u>::Reader values(block._values[column]);
+                while(!values.done())
+                {
+                    scratch.push_back(values.next());
+                }
+            }
+            return;
+        }
+
+        // straddling the start of the window, the timestamps tell which samples are in
+        utils::gorilla::IntColumn<12u, 2u>::Reader times(block._time);
+        utils::gorilla::IntColumn<12u, 1u>::Reader values(block._values[column]);
+        while(!times.done())
+        {
+            const std::int64_t timestampMs = times.next();
+            const std::int64_t value = values.next();
+            if(timestampMs < fromMs)
+            {
+                continue;
+            }
+            sum += value;
+            max = samples == 0u ? value : std::max(max, value);
+            ++samples;
+            if(withPercentile)
+            {
+                scratch.push_back(value);
+            }
+        }
+    });
+
+    WindowStats stats;
+    stats._samples = samples;
+    if(samples == 0u)
+    {
+        return stats;
+    }
+    stats._avg = dequantize(sum) / static_cast<double>(samples);
+    stats._max = dequantize(max);
+    if(withPercentile)
+    {
+        // nearest rank
+        const std::size_t rank = static_cast<std::size_t>(std::ceil(0.95 * static_cast<double>(scratch.size())));
+        std::vector<std::int64_t>::iterator p95 = scratch.begin() + static_cast<std::ptrdiff_t>(std::max<std::size_t>(rank, 1u) - 1u);
+        std::nth_element(scratch.begin(), p95, scratch.end());
+        stats._p95 = dequantize(*p95);
+    }
+    return stats;
+}
+
+void MetricSeries::lastValues(const Metric metric, const std::size_t count, std::vector<double>& values) const
+{
+    values.clear();
+    const std::size_t total = size();
+    std::size_t skip = total > count ? total - count : 0u;
+    forEachBlock([&](const Block& block)
+    {
+        const std::size_t blockCount = block._time.count();
+        if(skip >= blockCount)
+        {
+            skip -= blockCount;
+            return;
+        }
+        utils::gorilla::IntColumn<12u, 1u>::Reader reader(block._values[static_cast<std::size_t>(metric)]);
+        for(; !reader.done(); )
+        {
+            const std::int64_t value = reader.next();
+            if(skip > 0u)
+            {
+                --skip;
+                continue;
+            }
+            values.push_back(dequantize(value));
+        }
+    });
+}
+
+MetricHistory::MetricHistory(const std::size_t windowSamples)
+    : _windowSamples(windowSamples), _system(blocksForWindow())
+{
+}
+
+// the blocks covering the window, and the one being filled past its' start
+std::size_t MetricHistory::blocksForWindow() const
+{
+    return (_windowSamples + MetricSeries::kSamplesPerBlock - 1u) / MetricSeries::kSamplesPerBlock + 1u;
+}
+
+void MetricHistory::record(const std::int64_t timestampMs, const PidStatus_t& snapshot)
+{
+    ++_tick;
+    _lastRecordMs = std::max(_lastRecordMs, timestampMs);
+    for(const PidStatus_t::value_type& pidWithStats : snapshot)
+    {
+        std::unordered_map<uint, Tracked>::iterator tracked = _processes.find(pidWithStats.first);
+        if(tracked == _processes.end())
+        {
+            tracked = _processes.emplace(pidWithStats.first, Tracked{pidWithStats.second._startTime, _tick, MetricSeries(blocksForWindow())}).first;
+        }
+        else if(tracked->second._startTime != pidWithStats.second._startTime)
+        {
+            // the pid has been reused by another process
+            tracked->second._series.clear();
+            tracked->second._startTime = pidWithStats.second._startTime;
+        }
+        tracked->second._lastTick = _tick;
+        tracked->second._series.append(timestampMs, pidWithStats.second._cpu, pidWithStats.second._memory);
+    }
+
+    for(std::unordered_map<uint, Tracked>::iterator tracked = _processes.begin(); tracked != _processes.end();)
+    {
+        tracked = _tick - tracked->second._lastTick >= _windowSamples ? _processes.erase(tracked) : std::next(tracked);
+    }
+}
+
+void MetricHistory::recordSystem(const std::int64_t timestampMs, const double cpu, const double memory)
+{
+    _lastRecordMs = std::max(_lastRecordMs, timestampMs);
+    _system.append(timestampMs, cpu, memory);
+}
+
+const MetricSeries* MetricHistory::find(const uint pid) const
+{
+    const std::unordered_map<uint, Tracked>::const_iterator tracked = _processes.find(pid);
+    return tracked == _processes.end() ? nullptr : &tracked->second._series;
+}
+
+WindowStats MetricHistory::query(const MetricSeries& series, const Metric metric, const std::int64_t windowMs) const
+{
+    return series.query(metric, _lastRecordMs - windowMs + 1, _scratch);
+}
+
+std::string renderSparkline(const MetricSeries& series, const Metric metric, const std::size_t width)
+{
+    std::vector<double> values;
+    series.lastValues(metric, width, values);
+
+    const double highest = std::max(1.0, values.empty() ? 0.0 : *std::max_element(values.begin(), values.end()));
+    std::string sparkline(width - values.size(), ' ');
+    for(const double value : values)
+    {
+        const std::size_t level = static_cast<std::size_t>(std::clamp(value / highest, 0.0, 1.0) * 7.0 + 0.5);
+        sparkline += kSparkGlyphs[level];
+    }
+    return sparkline;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,302 @@
+#include <Placement.hpp>
+#include <LogTrace.hpp>
+#include <ProcFile.hpp>
+#include <UniqueFd.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <fcntl.h>
+#include <sched.h>
+#include <unistd.h>
+
+namespace proc
+{
+namespace placement
+{
+namespace
+{
+// sched_getaffinity mask size, in cpus
+constexpr int kMaxCpus = 8192;
+
+bool toNumber(std::string_view text, uint& value)
+{
+    return !text.empty() && std::from_chars(text.data(), text.data() + text.size(), value).ptr == text.data() + text.size();
+}
+
+// the whole file into `buffer`, numa_maps of a big process easily goes past any fixed size
+bool readWhole(const std::filesystem::path& path, std::string& buffer)
+{
+    const utils::UniqueFd fd(::open(path.c_str(), O_RDONLY | O_CLOEXEC));
+    if(!fd.valid())
+    {
+        return false;
+    }
+    buffer.resize(std::max<std::size_t>(buffer.capacity(), 64u * 1024u));
+    std::size_t size{0u};
+    while(true)
+    {
+        if(size == buffer.size())
+        {
+            buffer.resize(buffer.size() * 2u);
+        }
+        const ssize_t bytes = ::read(fd.get(), buffer.data() + size, buffer.size() - size);
+        if(bytes < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if(bytes < 0)
+        {
+            return false;
+        }
+        if(bytes == 0)
+        {
+            break;
+        }
+        size += static_cast<std::size_t>(bytes);
+    }
+    buffer.resize(size);
+    return true;
+}
+
+uint allowedCpus(const uint pid)
+{
+    cpu_set_t* mask = CPU_ALLOC(kMaxCpus);
+    const std::size_t maskSize = CPU_ALLOC_SIZE(kMaxCpus);
+    CPU_ZERO_S(maskSize, mask);
+    const uint count = ::sched_getaffinity(static_cast<pid_t>(pid), maskSize, mask) == 0 ? static_cast<uint>(CPU_COUNT_S(maskSize, mask)) : 0u;
+    CPU_FREE(mask);
+    return count;
+}
+}
+
+bool parseCpuList(std::string_view list, std::vector<uint>& cpus)
+{
+    while(!list.empty() && (list.back() == '\n' || list.back() == ' '))
+    {
+        list.remove_suffix(1);
+    }
+    while(!list.empty())
+    {
+        const std::size_t comma = list.find(',');
+        const std::string_view range = list.substr(0, comma);
+        const std::size_t dash = range.find('-');
+        uint first{0u};
+        if(!toNumber(range.substr(0, dash), first))
+        {
+            return false;
+        }
+        uint last{first};
+        if((dash != std::string_view::npos && !toNumber(range.substr(dash + 1), last)) || last < first)
+        {
+            return false;
+        }
+        for(uint cpu=first; cpu<=last; ++cpu)
+        {
+            cpus.push_back(cpu);
+        }
+        list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+    }
+    return true;
+}
+
+std::vector<unsigned long long> parseNumaMaps(std::string_view content)
+{
+    std::vector<unsigned long long> kbPerNode;
+    std::vector<std::pair<uint, unsigned long long>> pages; // of the current mapping
+    while(!content.empty())
+    {
+        const std::size_t lineEnd = content.find('\n');
+        std::string_view line = content.substr(0, lineEnd);
+        content = lineEnd == std::string_view::npos ? std::string_view() : content.substr(lineEnd + 1);
+
+        // N<node>=<pages> tokens, then kernelpagesize_kB=<kB> closing the line
+        pages.clear();
+        unsigned long long pageKb{4u};
+        while(!line.empty())
+        {
+            const std::size_t blank = line.find(' ');
+            const std::string_view token = line.substr(0, blank);
+            line = blank == std::string_view::npos ? std::string_view() : line.substr(blank + 1);
+
+            const std::size_t equal = token.find('=');
+            if(equal == std::string_view::npos)
+            {
+                continue;
+            }
+            uint node{0u};
+            unsigned long long value{0u};
+            const std::string_view number = token.substr(equal + 1);
+            if(std::from_chars(number.data(), number.data() + number.size(), value).ptr != number.data() + number.size())
+            {
+                continue;
+            }
+            if(token[0] == 'N' && toNumber(token.substr(1, equal - 1), node))
+            {
+                pages.emplace_back(node, value);
+            }
+            else if(token.substr(0, equal) == "kernelpagesize_kB")
+            {
+                pageKb = value;
+            }
+        }
+        for(const std::pair<uint, unsigned long long>& nodePages : pages)
+        {
+            if(nodePages.first >= kbPerNode.size())
+            {
+                kbPerNode.resize(nodePages.first + 1u, 0u);
+            }
+            kbPerNode[nodePages.first] += nodePages.second * pageKb;
+        }
+    }
+    return kbPerNode;
+}
+
+NumaTopology::NumaTopology(const std::filesystem::path& nodeRoot)
+{
+    std::error_code error;
+    std::size_t nodes{0u};
+    for(std::filesystem::directory_iterator entry(nodeRoot, error), end; !error && entry != end; entry.increment(error))
+    {
+        const std::string name = entry->path().filename().string();
+        uint node{0u};
+        if(name.compare(0, 4, "node") != 0 || !toNumber(std::string_view(name).substr(4), node))
+        {
+            continue;
+        }
+        char content[4096];
+        const ssize_t bytes = utils::procfs::readFile((entry->path() / "cpulist").c_str(), content, sizeof(content));
+        std::vector<uint> cpus;
+        if(bytes < 0 || !parseCpuList(std::string_view(content, static_cast<std::size_t>(bytes)), cpus))
+        {
+            WARNING("Cpus of NUMA node " << node << " cannot be read. Its' cpus count as unknown...");
+            continue;
+        }
+        for(const uint cpu : cpus)
+        {
+            if(cpu >= _cpuToNode.size())
+            {
+                _cpuToNode.resize(cpu + 1u, -1);
+            }
+            _cpuToNode[cpu] = static_cast<int>(node);
+        }
+        nodes = std::max<std::size_t>(nodes, node + 1u);
+    }
+    _nodeCount = std::max<std::size_t>(nodes, 1u);
+}
+
+int NumaTopology::nodeOfCpu(const int cpu) const
+{
+    if(cpu < 0)
+    {
+        return -1;
+    }
+    if(_cpuToNode.empty())
+    {
+        return 0;
+    }
+    return static_cast<std::size_t>(cpu) < _cpuToNode.size() ? _cpuToNode[cpu] : -1;
+}
+
+double Placement::remoteRatio(const NumaTopology& topology) const
+{
+    const int node = topology.nodeOfCpu(_lastCpu);
+    unsigned long long total{0u};
+    for(const unsigned long long kb : _kbPerNode)
+    {
+        total += kb;
+    }
+    if(node < 0 || total == 0u)
+    {
+        return -1.0;
+    }
+    const unsigned long long local = static_cast<std::size_t>(node) < _kbPerNode.size() ? _kbPerNode[node] : 0u;
+    return static_cast<double>(total - local) / static_cast<double>(total);
+}
+
+PlacementSampler::PlacementSampler(const std::filesystem::path& procRoot, NumaTopology topology)
+    : _procRoot(procRoot), _topology(std::move(topology))
+{}
+
+void PlacementSampler::readNumaMaps(const uint pid, Placement& placement)
+{
+    if(!readWhole(_procRoot / std::to_string(pid) / "numa_maps", _buffer))
+    {
+        // no NUMA support in the kernel, or not ours to read : the ratio stays unknown
+        placement._kbPerNode.clear();
+        return;
+    }
+    placement._kbPerNode = parseNumaMaps(_buffer);
+}
+
+void PlacementSampler::sample(const std::vector<std::pair<uint, const PidStats*>>& rows, const std::int64_t nowMs)
+{
+    std::size_t numaReads{0u};
+    _seen.clear();
+    for(const std::pair<uint, const PidStats*>& row : rows)
+    {
+        const uint pid = row.first;
+        _seen.push_back(pid);
+        Placement& placement = _placements[pid];
+        const unsigned long long previousStart = placement._startTime;
+        placement._startTime = row.second->_startTime;
+        placement._lastCpu = row.second->_processor;
+        // a reused pid is another process, its' memory layout has nothing to do with the previous one
+        if(previousStart != 0u && previousStart != placement._startTime)
+        {
+            placement._kbPerNode.clear();
+            placement._numaReadMs = 0;
+        }
+        placement._allowedCpus = allowedCpus(pid);
+
+        const bool numaDue = placement._numaReadMs == 0 || nowMs - placement._numaReadMs >= kNumaRefreshMs;
+        if(numaDue && numaReads < kNumaReadsPerSample)
+        {
+            readNumaMaps(pid, placement);
+            placement._numaReadMs = nowMs;
+            ++numaReads;
+        }
+    }
+
+    std::sort(_seen.begin(), _seen.end());
+    for(std::unordered_map<uint, Placement>::iterator placementIter = _placements.begin(); placementIter != _placements.end();)
+    {
+        placementIter = std::binary_search(_seen.begin(), _seen.end(), placementIter->first) ? std::next(placementIter) : _placements.erase(placementIter);
+    }
+}
+
+const Placement* PlacementSampler::find(const uint pid) const
+{
+    const std::unordered_map<uint, Placement>::const_iterator placement = _placements.find(pid);
+    return placement != _placements.end() ? &placement->second : nullptr;
+}
+
+std::vector<uint> occupancy(const PidStatus_t& rows, const std::size_t cpus)
+{
+    std::vector<uint> perCpu(cpus, 0u);
+    for(const PidStatus_t::value_type& pidWithStats : rows)
+    {
+        if(pidWithStats.second._processor >= 0 && static_cast<std::size_t>(pidWithStats.second._processor) < cpus)
+        {
+            ++perCpu[pidWithStats.second._processor];
+        }
+    }
+    return perCpu;
+}
+
+std::string renderOccupancy(const std::vector<uint>& perCpu)
+{
+    std::string occupancy("| Processes per cpu: ");
+    for(std::size_t cpu=0; cpu<perCpu.size(); ++cpu)
+    {
+        if(cpu > 0u && cpu % 8u == 0u)
+        {
+            occupancy += ' ';
+        }
+        occupancy += perCpu[cpu] == 0u ? '.' : perCpu[cpu] >= 10u ? '+' : static_cast<char>('0' + perCpu[cpu]);
+    }
+    occupancy += '\n';
+    return occupancy;
+}
+}
+}
@@ -1,11 +1,20 @@
 #include "Exception.hpp"
 #include <ProcessInfo.hpp>
 #include <LogTrace.hpp>
+#include <BatchFileReader.hpp>
+#include <ExportWriter.hpp>
+#include <ProcFile.hpp>
+#include <Profiler.hpp>
+#include <SnapshotFormat.hpp>
 
+#include <algorithm>
 #include <cctype>
+#include <cerrno>
+#include <charconv>
 #include <cmath>
 #include <cstddef>
 #include <cstdlib>
+#include <cstring>
 #include <ctime>
 #include <exception>
 #include <filesystem>
@@ -14,14 +23,80 @@
 #include <string>
 #include <unordered_map>
 #include <fstream>
-#include <unordered_set>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <stdexcept>
 #include <unistd.h>
 
 namespace proc
 {
+namespace
+{
+// relative to /proc (the working directory of the collector), built once so a tick doesn't allocate them
+static const std::filesystem::path kUptimeFile{"uptime"};
+static const std::filesystem::path kMeminfoFile{"meminfo"};
+
+// readdir works in the buffer of the DIR, unlike std::filesystem::directory_iterator allocating every entry
+inline dirent* nextEntry(DIR* procDir)
+{
+    PROFILE_SCOPE(DirectoryIteration);
+    return ::readdir(procDir);
+}
+
+// comm (2) of a stat line, without its' parentheses ; it may hold blanks and parentheses, it ends at the last ')'
+std::string_view statComm(std::string_view statContent)
+{
+    const std::size_t open = statContent.find('(');
+    const std::size_t close = statContent.rfind(')');
+    return open == std::string_view::npos || close == std::string_view::npos || close < open ?
+        std::string_view() : statContent.substr(open + 1u, close - open - 1u);
+}
+
+template<class Number>
+Number statValue(const StatFields& statMap, const uint position)
+{
+    return static_cast<Number>(statMap.at(position));
+}
+
+// one step of the scan for a single pid, with the severity handling of the scan. False when the scan has to stop
+template<class Step>
+bool runPidStep(std::string_view where, const Step& step)
+{
+    try
+    {
+        step();
+    }
+    catch(const utils::HarmlessException& e)
+    {
+        NOTIFY("Harmless exception caught : " << e.what());
+    }
+    catch(const utils::ModerateException& e)
+    {
+        WARNING("Pid name cannot be extracted. Pid in dir path : " << where << ", won't be included, because : " << e.what() << ". Skipping...");
+    }
+    catch(const utils::SeriousException& e)
+    {
+        ERROR("Unrecoverable error occured : " << e.what() << ", process will stop right away");
+        return false;
+    }
+    catch(const std::exception& e)
+    {
+        WARNING("Pid name cannot be extracted due to a non-runtime error (worth checking), " << e.what() << ". Skipping...");
+    }
+    return true;
+}
+}
 
-ProcessInfo::ProcessInfo()
+ProcessInfo::ProcessInfo(const utils::procfs::IoBackend ioBackend)
+    : _statReader(utils::procfs::makeBatchFileReader(ioBackend))
 {
+    if(_statReader == nullptr)
+    {
+        WARNING("io_uring was asked for but cannot be used here, /proc files will be read synchronously");
+        _statReader = utils::procfs::makeBatchFileReader(utils::procfs::IoBackend::Sync);
+    }
+
     _oldPath = std::filesystem::current_path();
     if(!std::filesystem::equivalent(std::filesystem::current_path(), kProcPath))
     {
@@ -50,13 +125,24 @@ uint ProcessInfo::getPidNum(const std::filesystem::directory_entry& entry)
     throw utils::SeverityException<utils::ModerateException>("Pid name of the current dir path: " + ss.str() + ", cannot be extracted. Skipping...");
 }
 
-// DONE
-std::unordered_map<uint, std::string> ProcessInfo::fillStatMap(const std::filesystem::path& statDir)
+long long StatFields::at(const uint position) const
 {
-    std::unordered_map<uint, std::string> statMap;
-    static const std::unordered_set<uint> kPosThatMatter{14,15,20,22,24};
+    const auto found = std::find(kPositions.begin(), kPositions.end(), position);
+    if(found == kPositions.end())
+    {
+        throw std::out_of_range("Stat field " + std::to_string(position) + " is not parsed");
+    }
+    return _values[static_cast<std::size_t>(found - kPositions.begin())];
+}
 
-    std::ifstream statFile(statDir.string());
+// DONE
+StatFields ProcessInfo::fillStatMap(const std::filesystem::path& statDir)
+{
+    std::ifstream statFile;
+    {
+        PROFILE_SCOPE(StatRead);
+        statFile.open(statDir.string());
+    }
     if(!statFile.is_open())
     {
         throw utils::SeverityException<utils::ModerateException>("Unable to open stat file. In specific in dir: " + statDir.string() + ". Skipping..." );
@@ -65,26 +151,46 @@ std::unordered_map<uint, std::string> ProcessInfo::fillStatMap(const std::filesy
     std::string singleLineStatFile;
     std::getline(statFile, singleLineStatFile);
 
-    INFO("Stat file found for: " << statDir << " with content: " << singleLineStatFile << ". Parsing..."); // TODO : Can be set as debug
+    DEBUG("Stat file found for: " << statDir << " with content: " << singleLineStatFile << ". Parsing...");
+    return parseStatLine(singleLineStatFile);
+}
 
-    std::istringstream ss(singleLineStatFile);
+// the content of a stat file, as read by fillStatMap or handed over by the batch reader of scanProcDir
+StatFields ProcessInfo::parseStatLine(std::string_view statContent)
+{
+    PROFILE_SCOPE(StatParse);
+
+    StatFields statMap;
+    std::size_t parsed{0u};
+
+    statContent = statContent.substr(0, statContent.find('\n'));
     uint tokenPos{1u};
-    while(1)
+    // comm may hold blanks, eg. "(Web Content)" : the fields after it are counted from its' closing parenthesis
+    const std::size_t commEnd = statContent.rfind(')');
+    if(commEnd != std::string_view::npos)
     {
-        std::string token;
-        if(!std::getline(ss, token, ' '))
-        {
-            break;
-        }
-        if(kPosThatMatter.find(tokenPos) != kPosThatMatter.end())
+        statContent = statContent.substr(std::min(commEnd + 2u, statContent.size()));
+        tokenPos = 3u;
+    }
+    // the positions are increasing, the line is left once the last one is parsed
+    while(!statContent.empty() && parsed < StatFields::kPositions.size())
+    {
+        const std::size_t separator = statContent.find(' ');
+        if(tokenPos == StatFields::kPositions[parsed])
         {
-            statMap.emplace(tokenPos, token);
+            const std::string_view field = statContent.substr(0, separator);
+            if(std::from_chars(field.data(), field.data() + field.size(), statMap._values[parsed]).ec != std::errc())
+            {
+                throw utils::SeverityException<utils::ModerateException>("Stat field " + std::to_string(tokenPos) + " is not a number : " + std::string(field) + ". Skipping...");
+            }
+            ++parsed;
         }
+        statContent = separator == std::string_view::npos ? std::string_view() : statContent.substr(separator + 1);
         ++tokenPos;
     }
 
     // TODO : Do we really have to check here this ?? Maybe needless if -> better think about it !
-    if(statMap.size() != 5)
+    if(parsed != StatFields::kPositions.size())
     {
         throw utils::SeverityException<utils::ModerateException>("Some entries were missed during parsing. Calculations will be undone. Skipping...");
     }
@@ -96,182 +202,304 @@ std::unordered_map<uint, std::string> ProcessInfo::fillStatMap(const std::filesy
 // total_time = utime (14) + stime (15);
 // seconds = uptime /proc/uptime - (starttime (22) / CLK_TCK sysconf(_SC_CLK_TCK) );
 // cpu_usage = 100 * ((total_time / CLK_TCK sysconf(_SC_CLK_TCK) ) / seconds);
-double ProcessInfo::calculateCpu(const std::unordered_map<uint, std::string>& statMap, const double& uptime)
+double ProcessInfo::calculateCpu(const StatFields& statMap, const double& uptime)
 {
-    double total_time = std::stod(statMap.at(14u)) + std::stod(statMap.at(15u));
-    double seconds = uptime - (std::stod(statMap.at(22u)) / static_cast<double>(sysconf(_SC_CLK_TCK))); // convert the starttime (it is calculated by clock ticks to seconds)
-    return 100 * ((total_time / static_cast<double>(sysconf(_SC_CLK_TCK))) / seconds);
+    const double clockTicks = static_cast<double>(sysconf(_SC_CLK_TCK));
+    double total_time = statValue<double>(statMap, 14u) + statValue<double>(statMap, 15u);
+    double seconds = uptime - (statValue<double>(statMap, 22u) / clockTicks); // convert the starttime (it is calculated by clock ticks to seconds)
+    // started in the current tick, or after an uptime read with 2 decimals only : it has lived one tick at least
+    seconds = std::max(seconds, 1.0 / clockTicks);
+    return 100 * ((total_time / clockTicks) / seconds);
 }
 
 //DONE
+// one read() of the whole file, MemTotal is looked up in place
 double ProcessInfo::getMeminfo(const std::filesystem::path& meminfoPath)
 {
-    std::ifstream meminfoFile(meminfoPath);
-    if(!meminfoFile.is_open())
+    char content[8192];
+    const ssize_t bytes = utils::procfs::readFile(meminfoPath.c_str(), content, sizeof(content));
+    if(bytes < 0)
     {
         throw utils::SeverityException<utils::SeriousException>("Meminfo file cannot be opened or wasn't found. Memory consumption won't be calculated");
     }
 
-    // No complexity at all, 99% MemTotal entry would be first
-    std::string line;
-    while(std::getline(meminfoFile, line))
-    {
-        std::size_t memtotalIndex = line.find("MemTotal");
-        if(memtotalIndex != std::string::npos)
-        {
-            break;
-        }
-    }
-
-    std::istringstream ss(line);
-    while(std::getline(ss, line, ' '))
+    unsigned long long memTotal{0u};
+    if(!utils::procfs::findKeyValue(std::string_view(content, static_cast<std::size_t>(bytes)), "MemTotal", memTotal))
     {
-        if(std::isdigit(line[0]))
-        {
-            return std::stod(line);
-        }
+        throw utils::SeverityException<utils::SeriousException>("MemTotal doesn't exist or it wasn't found");
     }
-
-    throw utils::SeverityException<utils::SeriousException>("MemTotal doesn't exist or it wasn't found");
+    return static_cast<double>(memTotal);
 }
 
 // DONE
 // grep MemTotal /proc/meminfo
 // # Example output: MemTotal:       16312036 kB
 // mem_usage = (rss (24) * page_size sysconf(_SC_PAGESIZE)) / total_memory_bytes (content from files is in kB) * 100.0;
-double ProcessInfo::calculateMemory(const std::unordered_map<uint, std::string>& statMap, const double meminfo)
+double ProcessInfo::calculateMemory(const StatFields& statMap, const double meminfo)
 {
-    return ((std::stod(statMap.at(24u)) * static_cast<double>(sysconf(_SC_PAGESIZE))) / (meminfo * 1024)) * 100.0;
+    return ((statValue<double>(statMap, 24u) * static_cast<double>(sysconf(_SC_PAGESIZE))) / (meminfo * 1024)) * 100.0;
 }
 
 // DONE
 //process_uptime = uptime /proc/uptime (1) - (starttime (22) / CLK_TCK sysconf(_SC_CLK_TCK));
-PidStats::timezone ProcessInfo::calculateProcessUptime(const std::unordered_map<uint, std::string>& statMap, const double uptime)
+PidStats::timezone ProcessInfo::calculateProcessUptime(const StatFields& statMap, const double uptime)
 {
     PidStats::timezone processTimezone;
 
-    const double processTimeInSeconds = uptime - (std::stod(statMap.at(22u)) / sysconf(_SC_CLK_TCK)); // in seconds
+    // a process started after /proc/uptime was read comes out a hair below 0 : it is just born
+    const double processTimeInSeconds = std::max(0.0, uptime - (statValue<double>(statMap, 22u) / sysconf(_SC_CLK_TCK))); // in seconds
     processTimezone._hours = processTimeInSeconds / 3600;
     processTimezone._minutes = (processTimeInSeconds - (processTimezone._hours*3600)) / 60;   
     const double secondsRemaining = processTimeInSeconds - static_cast<double>(processTimezone._hours*3600) - static_cast<double>(processTimezone._minutes*60);
     processTimezone._seconds = secondsRemaining; // on-purpose truncating the decimal  as we want integer seconds
-    processTimezone._ms = std::round((secondsRemaining - processTimezone._seconds) * 1000); // it's ok if we take at least a 3-digit ms
-
-    // if the time has even 0ms after calculation, the pids may be either workers from kernel or zombie processes :
-    // 1) workers : they exist in /proc/ but they never occupy anything and they are lost in an instant
-    // 2) zombie pids : they have finished executing and they are terminated but they still occupy a pid entry
-    if(processTimezone._hours == processTimezone._minutes
-        && processTimezone._minutes == processTimezone._seconds
-        && processTimezone._seconds == processTimezone._ms
-        && processTimezone._ms == 0)
-    {
-        throw utils::SeverityException<utils::HarmlessException>("Worker or Zombie process, all the metrics will be fake");
-    }
+    processTimezone._ms = std::min(999.0, std::round((secondsRemaining - processTimezone._seconds) * 1000)); // it's ok if we take at least a 3-digit ms
 
+    // an uptime of 0 used to be taken for a kernel worker or a zombie and the process dropped : it is a process started
+    // within the last clock tick (uptime and starttime both have a 10ms resolution), under fork churn a good share of
+    // the new ones. Zombies keep the starttime they were born with, kernel workers are ordinary processes here
     return processTimezone;
 }
 
 // DONE
 double ProcessInfo::getGenericUptime(const std::filesystem::path& uptimePath)
 {
-    std::ifstream uptimeFile(uptimePath);
-    std::string singleLine;
-    std::getline(uptimeFile, singleLine);
+    char content[128];
+    const ssize_t bytes = utils::procfs::readFile(uptimePath.c_str(), content, sizeof(content));
+    const std::string_view singleLine(content, bytes > 0 ? static_cast<std::size_t>(bytes) : 0u);
 
     std::size_t separatorIndex = singleLine.find_first_of(' ');
-    if(separatorIndex == std::string::npos)
+    if(separatorIndex == std::string_view::npos)
     {
         throw utils::SeverityException<utils::SeriousException>("Unrecoverable error. Cannot extract generic process uptime from /proc/uptime. Cannot calculate anything");
     }
 
     // rawUptime because the other value we truncated was the uptime during idle procedure
-    return std::stod(singleLine.substr(0, separatorIndex));
+    double rawUptime{0.0};
+    if(std::from_chars(singleLine.data(), singleLine.data() + separatorIndex, rawUptime).ec != std::errc())
+    {
+        throw std::invalid_argument("Uptime is not a number : " + std::string(singleLine.substr(0, separatorIndex)));
+    }
+    return rawUptime;
 }
 
+ProcessInfo::~ProcessInfo() = default;
+
 // DONE
 void ProcessInfo::exportInFile()
 {
-    std::filesystem::path projectPathFileExport = _oldPath.parent_path() / "export/ProcessesStatus.txt";
-
-    INFO("Exporting process data in a file called: ProcessesStatus.txt" << projectPathFileExport);
-
-    std::ofstream processesStatus(projectPathFileExport);
-    if(!processesStatus)
+    PROFILE_SCOPE(Export);
+    const std::filesystem::path projectPathFileExport = _oldPath.parent_path() / kExportFile;
+    if(_exporter == nullptr || _exporter->getPath() != projectPathFileExport)
     {
-        throw utils::SeverityException<utils::SeriousException>("ERROR: Cannot open the file to export Pid statuses");
+        INFO("Exporting process data in a file called: ProcessesStatus.txt" << projectPathFileExport);
+        _exporter = std::make_unique<ExportWriter>(projectPathFileExport);
     }
+    // only the copy of the rows is paid here, formatting and I/O happen on the writer thread
+    _exporter->submit(_pidStatus, &_names);
+}
 
-    std::ostringstream ss;
-    for(const auto& [pidNum, stats] : _pidStatus)
+void ProcessInfo::waitForExport()
+{
+    if(_exporter != nullptr)
     {
-        ss << "Pid: " << pidNum << " cpu: " << refineDouble(stats._cpu) << " memory: " << refineDouble(stats._memory) << " threads: " << stats._threads << " time: " << 
-            stats._timezone._hours << ":" << stats._timezone._minutes << ":" << stats._timezone._seconds << "." << stats._timezone._ms << std::endl;
+        _exporter->waitIdle();
     }
-    processesStatus << ss.str();
-
-    processesStatus.close();
 }
 
 void ProcessInfo::readAndDisplayProcDir()
+{
+    scanProcDir();
+
+    // after the extraction process, an exportation one begins right after to keep them in a file(so that we won't have to recalculate every time)
+    exportInFile();
+    // the caller reads the file right away
+    waitForExport();
+}
+
+bool ProcessInfo::beginScan(Scan& scan)
 {
     // uptime is the same for every process out there -> in seconds
-    double uptime;
-    double meminfo;
     try
     {
-        uptime = getGenericUptime(std::filesystem::path(std::filesystem::current_path() / "uptime"));
-        meminfo = getMeminfo(std::filesystem::path(std::filesystem::current_path() / "meminfo"));
+        scan.uptime = getGenericUptime(kUptimeFile);
+        scan.meminfo = getMeminfo(kMeminfoFile);
     }
     catch(const utils::SeriousException& e)
     {
         ERROR("ERROR : /proc/uptime decoding issue : " << e.what() );
-        return;
+        return false;
     }
+    return true;
+}
 
-    for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(std::filesystem::current_path()))
+void ProcessInfo::readScan(Scan& scan)
+{
+    // through the batch reader, parsed as each one comes in ; the consumer only captures two pointers so that
+    // std::function keeps it inline
+    _statReader->readAll(scan.statPaths, [this, &scan](const std::size_t index, std::string_view content, const int error)
     {
-        try
+        if(!scan.keepScanning)
         {
-            // each process is being defined as a directory
-            if(entry.is_directory())
-            {
-                PidStats pidStats;
-                const uint pidNum = getPidNum(entry);
-                
-                const std::unordered_map<uint, std::string> statMap = fillStatMap(
-                    std::filesystem::path(std::filesystem::current_path() / std::to_string(pidNum) / "stat"));
-                
-                pidStats._cpu = calculateCpu(statMap, uptime);
-                pidStats._memory = calculateMemory(statMap, meminfo);
-                pidStats._threads = static_cast<uint>(std::stoi(statMap.at(20)));
-                pidStats._timezone = calculateProcessUptime(statMap, uptime);
-
-                _pidStatus.emplace(pidNum, pidStats);
-            }
+            return;
         }
-        catch(const utils::HarmlessException& e)
+        // exited (and reaped) between the listing and the read : expected under churn, counted rather than logged
+        if(error == ENOENT || error == ESRCH)
         {
-            NOTIFY("Harmless exception caught : " << e.what());
+            ++_vanishedEntries;
+            return;
         }
-        catch(const utils::ModerateException& e)
+        if(error != 0)
         {
-            WARNING("Pid name cannot be extracted. Pid in dir path : " << entry << ", won't be included, because : " << e.what() << ". Skipping...");
+            WARNING("Unable to open stat file. In specific in dir: " << scan.statPaths[index] << " (" << std::strerror(error) << "). Skipping...");
+            return;
         }
-        catch(const utils::SeriousException& e)
+        scan.keepScanning = runPidStep(scan.statPaths[index], [this, index, content, &scan]()
         {
-            ERROR("Unrecoverable error occured : " << e.what() << ", process will stop right away");
-            return;
+            const StatFields statMap = parseStatLine(content);
+
+            PROFILE_SCOPE(Calculate);
+            PidStats pidStats;
+            pidStats._cpu = calculateCpu(statMap, scan.uptime);
+            pidStats._memory = calculateMemory(statMap, scan.meminfo);
+            pidStats._threads = statValue<uint>(statMap, 20u);
+            pidStats._timezone = calculateProcessUptime(statMap, scan.uptime);
+            pidStats._startTime = statValue<unsigned long long>(statMap, 22u);
+            pidStats._processor = statValue<int>(statMap, 39u);
+            pidStats._session = statValue<uint>(statMap, 6u);
+            resolveNames(scan.pids[index], statComm(content), _pidStatus.find(scan.pids[index]), pidStats);
+            _pidStatus.upsert(scan.pids[index]) = pidStats;
+        });
+    });
+}
+
+void ProcessInfo::resolveNames(const uint pid, std::string_view comm, const PidStats* previous, PidStats& stats)
+{
+    // an exec changes the comm, not the starttime
+    stats._name = _names.intern(comm);
+    if(previous != nullptr && previous->_startTime == stats._startTime && previous->_name == stats._name)
+    {
+        stats._cmdline = previous->_cmdline;
+        stats._uid = previous->_uid;
+        return;
+    }
+
+    char path[32];
+    char* end = std::to_chars(path, path + sizeof(path), pid).ptr;
+    *end = '\0';
+    // /proc/<pid> belongs to the effective uid of the process, a setuid exec shows up through the comm like any other
+    struct stat status{};
+    stats._uid = ::stat(path, &status) == 0 ? status.st_uid : 0u;
+    std::memcpy(end, "/cmdline", sizeof("/cmdline"));
+    char content[utils::procfs::BatchFileReader::kMaxFileSize];
+    const ssize_t bytes = utils::procfs::readFile(path, content, sizeof(content));
+    ++_cmdlineReads;
+    // the arguments are ended by '\0', kernel threads have none
+    std::size_t length = bytes > 0 ? static_cast<std::size_t>(bytes) : 0u;
+    while(length > 0u && content[length - 1u] == '\0')
+    {
+        --length;
+    }
+    std::replace(content, content + length, '\0', ' ');
+    stats._cmdline = _names.intern(std::string_view(content, length));
+}
+
+void ProcessInfo::compactNames()
+{
+    utils::StringTable live;
+    for(const PidTable_t::value_type& pidWithStats : _pidStatus)
+    {
+        PidStats& stats = *_pidStatus.find(pidWithStats.first);
+        stats._name = live.intern(_names.view(stats._name));
+        stats._cmdline = live.intern(_names.view(stats._cmdline));
+    }
+    DEBUG("Names compacted from " << _names.bytes() << " to " << live.bytes() << " bytes");
+    _names = std::move(live);
+    _namesLiveBytes = _names.bytes();
+    ++_namesGeneration;
+}
+
+const PidTable_t& ProcessInfo::scanPids(const std::vector<uint>& pids)
+{
+    PROFILE_SCOPE(Scan);
+    const utils::TickArena::Scope tick(_tickArena);
+    Scan scan{0.0, 0.0, true, std::pmr::vector<uint>(_tickArena.resource()), utils::procfs::PathList(_tickArena.resource())};
+    if(!beginScan(scan))
+    {
+        return _pidStatus;
+    }
+    scan.pids.assign(pids.begin(), pids.end());
+    scan.statPaths.reserve(pids.size());
+    char name[16];
+    for(const uint pid : pids)
+    {
+        scan.statPaths.emplace_back(std::string_view(name, static_cast<std::size_t>(std::to_chars(name, name + sizeof(name), pid).ptr - name))).append("/stat");
+    }
+    readScan(scan);
+    return _pidStatus;
+}
+
+// Every temporary of the tick is drawn from _tickArena (released when leaving) and the processes live in the flat
+// _pidStatus, so that once the arena and the table have grown to the size of the system a scan makes no heap allocation.
+// Mark and sweep : the pids read (or listed but left for another round) are stamped with the generation of the scan,
+// the others are swept at its' end
+const PidTable_t& ProcessInfo::scanProcDir()
+{
+    PROFILE_SCOPE(Scan);
+    const utils::TickArena::Scope tick(_tickArena);
+    _pidStatus.beginTick();
+    // at a stride of N only the pids of this round are read, the others keep their last values
+    const uint round = _sampleRound++ % _sampleStride;
+
+    Scan scan{0.0, 0.0, true, std::pmr::vector<uint>(_tickArena.resource()), utils::procfs::PathList(_tickArena.resource())};
+    if(!beginScan(scan))
+    {
+        _pidStatus.sweep();
+        return _pidStatus;
+    }
+
+    // 1. the pids, "<pid>/stat" relative to the working directory, each process is being defined as a directory
+    DIR* procDir = ::opendir(".");
+    if(procDir == nullptr)
+    {
+        ERROR("Unrecoverable error occured : the processes directory cannot be listed (" << std::strerror(errno) << ")");
+        _pidStatus.sweep();
+        return _pidStatus;
+    }
+    scan.pids.reserve(_lastScanSize);
+    scan.statPaths.reserve(_lastScanSize);
+    for(const dirent* entry = nextEntry(procDir); entry != nullptr; entry = nextEntry(procDir))
+    {
+        uint pidNum{0u};
+        const std::string_view name(entry->d_name);
+        const bool isPid = (entry->d_type == DT_DIR || entry->d_type == DT_UNKNOWN)
+            && std::from_chars(name.data(), name.data() + name.size(), pidNum).ptr == name.data() + name.size();
+        if(isPid && pidNum % _sampleStride == round)
+        {
+            scan.pids.push_back(pidNum);
+            scan.statPaths.emplace_back(name).append("/stat");
         }
-        catch(const std::exception& e)
+        else if(isPid)
         {
-            WARNING("Pid name cannot be extracted due to a non-runtime error (worth checking), " << e.what() << ". Skipping...");
+            // still alive, read by another round
+            _pidStatus.touch(pidNum);
         }
     }
+    ::closedir(procDir);
+    _lastScanSize = scan.pids.size();
 
-    INFO("Process has been completed successfully (with some skips ?) and a total of: " << _pidStatus.size() << " processes. Exporting...");
+    // 2. every stat file in one go, parsed as each one comes in
+    readScan(scan);
 
-    // after the extraction process, an exportation one begins right after to keep them in a file(so that we won't have to recalculate every time)
-    exportInFile();
+    // gone, or unreadable this time : either way not seen by this scan
+    _pidStatus.sweep();
+    // the names of the processes gone stay in the table until they outweigh the live ones
+    if(_names.bytes() > 2u * _namesLiveBytes + utils::StringTable::kBlockBytes)
+    {
+        compactNames();
+    }
+
+    INFO("Process has been completed successfully (with some skips ?) and a total of: " << _pidStatus.size() << " processes.");
+    return _pidStatus;
 }
 
 std::string ProcessInfo::debugProcContent()
@@ -0,0 +1,329 @@
+#include <ProcessSignaller.hpp>
+#include <CliOptions.hpp>
+#include <LogTrace.hpp>
+#include <ProcFile.hpp>
+#include <UniqueFd.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <csignal>
+#include <cstring>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace proc
+{
+namespace
+{
+static constexpr uint kStartTimeField = 22u;
+static constexpr std::size_t kMaxEpollEventsPerWait = 256u;
+// left to the rest of the process (stdio, the epoll set, the stat being read, the logs) besides the pidfds of a batch
+static constexpr rlim_t kReservedFds = 64u;
+
+struct SignalName
+{
+    const char* _name;
+    int _signal;
+};
+
+static constexpr SignalName kSignalNames[] = {
+    {"HUP", SIGHUP}, {"INT", SIGINT}, {"QUIT", SIGQUIT}, {"KILL", SIGKILL}, {"USR1", SIGUSR1}, {"USR2", SIGUSR2},
+    {"TERM", SIGTERM}, {"CONT", SIGCONT}, {"STOP", SIGSTOP}, {"TSTP", SIGTSTP}
+};
+
+int pidfdOpen(const uint pid)
+{
+    return static_cast<int>(::syscall(SYS_pidfd_open, static_cast<pid_t>(pid), 0u));
+}
+
+int pidfdSendSignal(const int pidfd, const int signal)
+{
+    return static_cast<int>(::syscall(SYS_pidfd_send_signal, pidfd, signal, nullptr, 0u));
+}
+
+SignalOutcome outcomeFromErrno(const int error)
+{
+    switch(error)
+    {
+        case ESRCH : return SignalOutcome::AlreadyGone;
+        case EPERM : return SignalOutcome::PermissionDenied;
+        case ENOSYS : return SignalOutcome::Unsupported;
+        default : return SignalOutcome::Failed;
+    }
+}
+
+// how many pidfds may be open together : the soft limit is raised up to the hard one when `count` needs it
+std::size_t fdBatchSize(const std::size_t count)
+{
+    struct rlimit limit{};
+    if(::getrlimit(RLIMIT_NOFILE, &limit) != 0)
+    {
+        return std::max<std::size_t>(1u, count);
+    }
+    const rlim_t wanted = static_cast<rlim_t>(count) + kReservedFds;
+    if(limit.rlim_cur != RLIM_INFINITY && limit.rlim_cur < wanted)
+    {
+        const rlim_t previous = limit.rlim_cur;
+        limit.rlim_cur = limit.rlim_max == RLIM_INFINITY ? wanted : std::min(wanted, limit.rlim_max);
+        if(::setrlimit(RLIMIT_NOFILE, &limit) != 0)
+        {
+            limit.rlim_cur = previous;
+        }
+    }
+    if(limit.rlim_cur == RLIM_INFINITY || limit.rlim_cur >= wanted)
+    {
+        return std::max<std::size_t>(1u, count);
+    }
+    return limit.rlim_cur > kReservedFds ? static_cast<std::size_t>(limit.rlim_cur - kReservedFds) : 1u;
+}
+
+// stop/continue style signals never end the process, there is no exit to wait for
+bool endsProcess(const int signal)
+{
+    return signal != 0 && signal != SIGSTOP && signal != SIGCONT && signal != SIGTSTP
+        && signal != SIGTTIN && signal != SIGTTOU && signal != SIGCHLD && signal != SIGWINCH && signal != SIGURG;
+}
+}
+
+const char* toString(const SignalOutcome outcome)
+{
+    switch(outcome)
+    {
+        case SignalOutcome::Exited : return "exited";
+        case SignalOutcome::Delivered : return "delivered";
+        case SignalOutcome::TimedOut : return "timed-out";
+        case SignalOutcome::AlreadyGone : return "already-gone";
+        case SignalOutcome::IdentityMismatch : return "identity-mismatch";
+        case SignalOutcome::PermissionDenied : return "permission-denied";
+        case SignalOutcome::Unsupported : return "unsupported";
+        case SignalOutcome::Failed : return "failed";
+    }
+    return "unknown";
+}
+
+int parseSignal(std::string_view name)
+{
+    int number{-1};
+    const std::from_chars_result result = std::from_chars(name.data(), name.data() + name.size(), number);
+    if(result.ec == std::errc() && result.ptr == name.data() + name.size())
+    {
+        return number >= 0 && number < NSIG ? number : -1;
+    }
+
+    if(name.substr(0, 3) == "SIG")
+    {
+        name.remove_prefix(3);
+    }
+    for(const SignalName& signalName : kSignalNames)
+    {
+        if(name == signalName._name)
+        {
+            return signalName._signal;
+        }
+    }
+    return -1;
+}
+
+ProcessSignaller::ProcessSignaller(const std::filesystem::path& procRoot) : _procRoot(procRoot)
+{
+}
+
+unsigned long long ProcessSignaller::readStartTime(const uint pid) const
+{
+    const std::filesystem::path statPath(_procRoot / std::to_string(pid) / "stat");
+    char line[4096];
+    const ssize_t bytes = utils::procfs::readFile(statPath.c_str(), line, sizeof(line));
+    if(bytes <= 0)
+    {
+        return 0u;
+    }
+
+    // comm (2) may contain spaces and parentheses, the fields are counted from the last ')' which is field 2's end
+    const std::string_view content(line, static_cast<std::size_t>(bytes));
+    std::size_t position = content.rfind(')');
+    if(position == std::string_view::npos)
+    {
+        return 0u;
+    }
+    for(uint field=2u; field<kStartTimeField && position != std::string_view::npos; ++field)
+    {
+        position = content.find(' ', position + 1);
+    }
+    if(position == std::string_view::npos)
+    {
+        return 0u;
+    }
+
+    unsigned long long startTime{0u};
+    std::from_chars(content.data() + position + 1, content.data() + content.size(), startTime);
+    return startTime;
+}
+
+std::vector<SignalReport> ProcessSignaller::deliver(const std::vector<SignalTarget>& targets, const int signal, const std::chrono::milliseconds exitWait)
+{
+    std::vector<SignalReport> reports;
+    reports.reserve(targets.size());
+    const std::size_t batchSize = fdBatchSize(targets.size());
+    if(batchSize < targets.size())
+    {
+        WARNING("RLIMIT_NOFILE leaves room for " << batchSize << " pidfds, the " << targets.size() << " targets go in batches");
+    }
+    for(std::size_t first=0; first<targets.size(); first+=batchSize)
+    {
+        deliverBatch(targets.data() + first, std::min(batchSize, targets.size() - first), signal, exitWait, reports);
+    }
+    return reports;
+}
+
+void ProcessSignaller::deliverBatch(const SignalTarget* targets, const std::size_t count, const int signal,
+    const std::chrono::milliseconds exitWait, std::vector<SignalReport>& reports)
+{
+    std::vector<SignalReport> batch(count);
+    std::vector<utils::UniqueFd> ownedPidfds(count);
+    std::vector<int> waitablePidfds(count, -1);
+    std::vector<std::chrono::steady_clock::time_point> sentAt(count);
+
+    for(std::size_t i=0; i<count; ++i)
+    {
+        SignalReport& report = batch[i];
+        report._pid = targets[i]._pid;
+
+        ownedPidfds[i].reset(pidfdOpen(targets[i]._pid));
+        if(!ownedPidfds[i].valid())
+        {
+            report._errno = errno;
+            report._outcome = outcomeFromErrno(report._errno);
+            continue;
+        }
+
+        // the fd is pinned now, if the stat still shows the collected starttime the fd holds the process we listed
+        const unsigned long long currentStartTime = readStartTime(targets[i]._pid);
+        if(currentStartTime != targets[i]._startTime)
+        {
+            report._outcome = currentStartTime == 0u ? SignalOutcome::AlreadyGone : SignalOutcome::IdentityMismatch;
+            continue;
+        }
+
+        sentAt[i] = std::chrono::steady_clock::now();
+        if(pidfdSendSignal(ownedPidfds[i].get(), signal) != 0)
+        {
+            report._errno = errno;
+            report._outcome = outcomeFromErrno(report._errno);
+            continue;
+        }
+
+        report._outcome = SignalOutcome::Delivered;
+        waitablePidfds[i] = ownedPidfds[i].get();
+    }
+
+    if(exitWait.count() > 0 && endsProcess(signal))
+    {
+        waitForExits(waitablePidfds, batch, sentAt, exitWait);
+    }
+    reports.insert(reports.end(), batch.begin(), batch.end());
+}
+
+void ProcessSignaller::waitForExits(const std::vector<int>& pidfds, std::vector<SignalReport>& reports,
+    const std::vector<std::chrono::steady_clock::time_point>& sentAt, const std::chrono::milliseconds exitWait)
+{
+    utils::UniqueFd epollFd(::epoll_create1(EPOLL_CLOEXEC));
+    if(!epollFd.valid())
+    {
+        WARNING("Cannot create the epoll set to wait for exits : " << std::strerror(errno) << ". Reporting signals as delivered only");
+        return;
+    }
+
+    std::size_t pending{0u};
+    for(std::size_t i=0; i<pidfds.size(); ++i)
+    {
+        if(pidfds[i] < 0)
+        {
+            continue;
+        }
+        // one shot : an exited process is reported once and doesn't have to be removed from the set
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLONESHOT;
+        event.data.u64 = i;
+        if(::epoll_ctl(epollFd.get(), EPOLL_CTL_ADD, pidfds[i], &event) != 0)
+        {
+            // sent, but its' exit can't be waited for
+            reports[i]._errno = errno;
+            reports[i]._outcome = SignalOutcome::Failed;
+            continue;
+        }
+        ++pending;
+    }
+
+    std::vector<epoll_event> events(std::min(std::max(pending, std::size_t{1u}), kMaxEpollEventsPerWait));
+    const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + exitWait;
+    while(pending > 0u)
+    {
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if(now >= deadline)
+        {
+            break;
+        }
+        const int timeoutMs = static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(deadline - now).count());
+        const int ready = ::epoll_wait(epollFd.get(), events.data(), static_cast<int>(events.size()), timeoutMs);
+        if(ready < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            WARNING("Waiting for exits got interrupted : " << std::strerror(errno));
+            break;
+        }
+
+        const std::chrono::steady_clock::time_point exitSeen = std::chrono::steady_clock::now();
+        for(int e=0; e<ready; ++e)
+        {
+            const std::size_t index = static_cast<std::size_t>(events[e].data.u64);
+            reports[index]._outcome = SignalOutcome::Exited;
+            reports[index]._latency = std::chrono::duration_cast<std::chrono::microseconds>(exitSeen - sentAt[index]);
+        }
+        pending -= static_cast<std::size_t>(ready);
+    }
+
+    for(std::size_t i=0; i<pidfds.size(); ++i)
+    {
+        if(pidfds[i] >= 0 && reports[i]._outcome == SignalOutcome::Delivered)
+        {
+            reports[i]._outcome = SignalOutcome::TimedOut;
+            reports[i]._latency = std::chrono::duration_cast<std::chrono::microseconds>(exitWait);
+        }
+    }
+}
+
+namespace signalling
+{
+int run(const cli::Options& options)
+{
+    const std::chrono::milliseconds exitWait(endsProcess(options._signal) ? options._exitWaitMs : 0u);
+    ProcessSignaller signaller;
+    const std::vector<SignalReport> reports = signaller.deliver(options._targets, options._signal, exitWait);
+
+    int exitCode{0};
+    for(const SignalReport& report : reports)
+    {
+        std::cout << report._pid << " " << toString(report._outcome) << " " << report._latency.count() << "us";
+        if(report._errno != 0)
+        {
+            std::cout << " (" << std::strerror(report._errno) << ")";
+        }
+        std::cout << "\n";
+        if(report._outcome != SignalOutcome::Exited && report._outcome != SignalOutcome::Delivered)
+        {
+            exitCode = 1;
+        }
+    }
+    std::cout.flush();
+    return exitCode;
+}
+}
+
+}
\ No newline at end of file
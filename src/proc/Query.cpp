@@ -0,0 +1,587 @@
+#include <Query.hpp>
+#include <CliOptions.hpp>
+#include <Exception.hpp>
+#include <ExportedFileWrapper.hpp>
+#include <LogTrace.hpp>
+#include <OutputBuffer.hpp>
+#include <SnapshotFormat.hpp>
+#include <UniqueFd.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
+#include <pwd.h>
+#include <unistd.h>
+
+namespace proc
+{
+namespace query
+{
+namespace
+{
+static constexpr std::size_t kBlockWords = Predicate::kBlockRows / 64u;
+
+// characters of a filter, left to right
+class Scanner
+{
+public:
+    explicit Scanner(std::string_view text) : _text(text) {}
+
+    std::string_view word()
+    {
+        skipSpaces();
+        const std::size_t start = _position;
+        while(_position < _text.size() && (std::isalpha(static_cast<unsigned char>(_text[_position])) || _text[_position] == '_'))
+        {
+            ++_position;
+        }
+        return _text.substr(start, _position - start);
+    }
+
+    // up to a blank, a parenthesis or an operator, eg. a comm like kworker/0:1-events
+    std::string_view bare()
+    {
+        skipSpaces();
+        const std::size_t start = _position;
+        while(_position < _text.size() && !std::isspace(static_cast<unsigned char>(_text[_position])) && std::strchr("()&|!=<>\"", _text[_position]) == nullptr)
+        {
+            ++_position;
+        }
+        return _text.substr(start, _position - start);
+    }
+
+    // the rest of "..." once its' opening quote is consumed, with \" and \\ escaped ; false when it is never closed
+    bool quoted(std::string& text)
+    {
+        text.clear();
+        for(; _position < _text.size() && _text[_position] != '"'; ++_position)
+        {
+            if(_text[_position] == '\\' && _position + 1u < _text.size())
+            {
+                ++_position;
+            }
+            text += _text[_position];
+        }
+        if(_position == _text.size())
+        {
+            return false;
+        }
+        ++_position;
+        return true;
+    }
+
+    bool consume(std::string_view token)
+    {
+        skipSpaces();
+        if(_text.substr(_position, token.size()) != token)
+        {
+            return false;
+        }
+        _position += token.size();
+        return true;
+    }
+
+    bool number(double& value)
+    {
+        skipSpaces();
+        const std::from_chars_result result = std::from_chars(_text.data() + _position, _text.data() + _text.size(), value);
+        if(result.ec != std::errc())
+        {
+            return false;
+        }
+        _position = static_cast<std::size_t>(result.ptr - _text.data());
+        return true;
+    }
+
+    bool done()
+    {
+        skipSpaces();
+        return _position == _text.size();
+    }
+
+    inline std::size_t position() const { return _position; }
+
+private:
+    void skipSpaces()
+    {
+        while(_position < _text.size() && std::isspace(static_cast<unsigned char>(_text[_position])))
+        {
+            ++_position;
+        }
+    }
+
+    std::string_view _text;
+    std::size_t _position{0u};
+};
+
+bool parseColumn(std::string_view word, Column& column)
+{
+    static constexpr std::pair<std::string_view, Column> kColumns[] =
+        {{"pid", Column::Pid}, {"cpu", Column::Cpu}, {"memory", Column::Memory}, {"mem", Column::Memory}, {"rss", Column::Memory},
+         {"threads", Column::Threads}, {"uptime", Column::Uptime}, {"uid", Column::Uid}, {"user", Column::Uid},
+         {"session", Column::Session}, {"name", Column::Name}};
+    for(const std::pair<std::string_view, Column>& known : kColumns)
+    {
+        if(known.first == word)
+        {
+            column = known.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+// longest first, ">=" is not ">" followed by "="
+bool parseComparison(Scanner& scanner, Comparison& comparison)
+{
+    static constexpr std::pair<std::string_view, Comparison> kComparisons[] =
+        {{">=", Comparison::GreaterEqual}, {"<=", Comparison::LessEqual}, {"==", Comparison::Equal}, {"!=", Comparison::NotEqual},
+         {">", Comparison::Greater}, {"<", Comparison::Less}};
+    for(const std::pair<std::string_view, Comparison>& known : kComparisons)
+    {
+        if(scanner.consume(known.first))
+        {
+            comparison = known.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parseSecondsUnit(std::string_view unit, double& toSeconds)
+{
+    static constexpr std::pair<std::string_view, double> kUnits[] =
+        {{"", 1.0}, {"ms", 0.001}, {"s", 1.0}, {"m", 60.0}, {"min", 60.0}, {"h", 3600.0}};
+    for(const std::pair<std::string_view, double>& known : kUnits)
+    {
+        if(known.first == unit)
+        {
+            toSeconds = known.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool lookupUid(const std::string& login, double& uid)
+{
+    char buffer[1024];
+    struct passwd entry{};
+    struct passwd* result{nullptr};
+    if(::getpwnam_r(login.c_str(), &entry, buffer, sizeof(buffer), &result) != 0 || result == nullptr)
+    {
+        return false;
+    }
+    uid = static_cast<double>(result->pw_uid);
+    return true;
+}
+
+// one bit per row of `column` in `bits`, the comparison inlined in the loop of 64
+template<class Value, class Threshold, class Holds>
+void compareBlock(const Value* column, const std::size_t rows, const Threshold threshold, Holds holds, std::uint64_t* bits)
+{
+    for(std::size_t word=0; word * 64u < rows; ++word)
+    {
+        const Value* values = column + word * 64u;
+        const std::size_t count = std::min<std::size_t>(64u, rows - word * 64u);
+        std::uint64_t mask{0u};
+        for(std::size_t bit=0; bit<count; ++bit)
+        {
+            mask |= static_cast<std::uint64_t>(holds(values[bit], threshold)) << bit;
+        }
+        bits[word] = mask;
+    }
+}
+
+template<class Value, class Threshold>
+void compareColumn(const Value* column, const std::size_t rows, const Comparison comparison, const Threshold threshold, std::uint64_t* bits)
+{
+    switch(comparison)
+    {
+        case Comparison::Less : compareBlock(column, rows, threshold, std::less<>(), bits); break;
+        case Comparison::LessEqual : compareBlock(column, rows, threshold, std::less_equal<>(), bits); break;
+        case Comparison::Greater : compareBlock(column, rows, threshold, std::greater<>(), bits); break;
+        case Comparison::GreaterEqual : compareBlock(column, rows, threshold, std::greater_equal<>(), bits); break;
+        case Comparison::Equal : compareBlock(column, rows, threshold, std::equal_to<>(), bits); break;
+        case Comparison::NotEqual : compareBlock(column, rows, threshold, std::not_equal_to<>(), bits); break;
+    }
+}
+
+// every bit of the `rows` first ones, none after
+void fillRows(std::uint64_t* bits, const std::size_t rows)
+{
+    const std::size_t words = (rows + 63u) / 64u;
+    std::fill(bits, bits + words, ~std::uint64_t{0u});
+    if(rows % 64u != 0u)
+    {
+        bits[words - 1u] = (std::uint64_t{1u} << (rows % 64u)) - 1u;
+    }
+}
+}
+
+void Columns::clear()
+{
+    _pid.clear();
+    _cpu.clear();
+    _memory.clear();
+    _threads.clear();
+    _uptime.clear();
+    _uid.clear();
+    _session.clear();
+    _name.clear();
+}
+
+void Columns::reserve(const std::size_t rows)
+{
+    _pid.reserve(rows);
+    _cpu.reserve(rows);
+    _memory.reserve(rows);
+    _threads.reserve(rows);
+    _uptime.reserve(rows);
+    _uid.reserve(rows);
+    _session.reserve(rows);
+    _name.reserve(rows);
+}
+
+void Columns::append(const uint pid, const PidStats& stats)
+{
+    const PidStats::timezone& uptime = stats._timezone;
+    _pid.push_back(pid);
+    _cpu.push_back(stats._cpu);
+    _memory.push_back(stats._memory);
+    _threads.push_back(stats._threads);
+    _uptime.push_back(uptime._hours * 3600.0 + uptime._minutes * 60.0 + uptime._seconds + uptime._ms / 1000.0);
+    _uid.push_back(stats._uid);
+    _session.push_back(stats._session);
+    _name.push_back(stats._name);
+}
+
+// recursive descent, the program written in postfix as the operands close :
+// or := and ('||' and)* ; and := unary ('&&' unary)* ; unary := '!' unary | '(' or ')' | column comparison value
+class Parser
+{
+public:
+    Parser(std::string_view text, std::vector<Predicate::Instruction>& program) : _text(text), _scanner(text), _program(program) {}
+
+    std::size_t parse()
+    {
+        parseOr();
+        if(!_scanner.done())
+        {
+            malformed("&&, || or the end of the filter");
+        }
+        return _depth;
+    }
+
+private:
+    void parseOr()
+    {
+        parseAnd();
+        while(_scanner.consume("||"))
+        {
+            parseAnd();
+            emit(Predicate::Op::Or, -1);
+        }
+    }
+
+    void parseAnd()
+    {
+        parseUnary();
+        while(_scanner.consume("&&"))
+        {
+            parseUnary();
+            emit(Predicate::Op::And, -1);
+        }
+    }
+
+    void parseUnary()
+    {
+        if(_scanner.consume("!"))
+        {
+            parseUnary();
+            emit(Predicate::Op::Not, 0);
+        }
+        else if(_scanner.consume("("))
+        {
+            parseOr();
+            if(!_scanner.consume(")"))
+            {
+                malformed(")");
+            }
+        }
+        else
+        {
+            parseCondition();
+        }
+    }
+
+    void parseCondition()
+    {
+        Predicate::Instruction instruction{Predicate::Op::Compare, Column::Pid, Comparison::Equal, 0.0, std::string()};
+        if(!parseColumn(_scanner.word(), instruction._column))
+        {
+            malformed("a column : cpu, memory, threads, uptime, pid, uid, session or name");
+        }
+        if(!parseComparison(_scanner, instruction._comparison))
+        {
+            malformed("a comparison : > >= < <= == !=");
+        }
+
+        switch(instruction._column)
+        {
+            case Column::Name :
+                if(instruction._comparison != Comparison::Equal && instruction._comparison != Comparison::NotEqual)
+                {
+                    malformed("== or != , names are not ordered");
+                }
+                if(_scanner.consume("\""))
+                {
+                    if(!_scanner.quoted(instruction._string))
+                    {
+                        malformed("the closing \" of the name");
+                    }
+                }
+                else
+                {
+                    instruction._string = std::string(_scanner.bare());
+                    if(instruction._string.empty())
+                    {
+                        malformed("a name, quoted when it holds blanks");
+                    }
+                }
+                break;
+            case Column::Uid :
+                if(!_scanner.number(instruction._value))
+                {
+                    const std::string login(_scanner.bare());
+                    if(login.empty() || !lookupUid(login, instruction._value))
+                    {
+                        malformed("a uid or a known login");
+                    }
+                }
+                break;
+            case Column::Uptime :
+            {
+                double toSeconds{1.0};
+                if(!_scanner.number(instruction._value))
+                {
+                    malformed("a number of seconds");
+                }
+                // "10m", the unit stuck to the number
+                if(!parseSecondsUnit(_scanner.word(), toSeconds))
+                {
+                    malformed("a duration unit : ms s m min h");
+                }
+                instruction._value *= toSeconds;
+                break;
+            }
+            default :
+                if(!_scanner.number(instruction._value))
+                {
+                    malformed("a number");
+                }
+                if(instruction._column == Column::Cpu || instruction._column == Column::Memory)
+                {
+                    _scanner.consume("%");
+                }
+                break;
+        }
+        _program.push_back(std::move(instruction));
+        push(1);
+    }
+
+    void emit(const Predicate::Op op, const int stackChange)
+    {
+        _program.push_back(Predicate::Instruction{op, Column::Pid, Comparison::Equal, 0.0, std::string()});
+        push(stackChange);
+    }
+
+    void push(const int stackChange)
+    {
+        _stack = static_cast<std::size_t>(static_cast<int>(_stack) + stackChange);
+        _depth = std::max(_depth, _stack);
+    }
+
+    [[noreturn]] void malformed(std::string_view expected) const
+    {
+        throw utils::SeverityException<utils::SeriousException>("Malformed filter \"" + std::string(_text) + "\" at " +
+            std::to_string(_scanner.position() + 1u) + " : expected " + std::string(expected));
+    }
+
+    std::string_view _text;
+    Scanner _scanner;
+    std::vector<Predicate::Instruction>& _program;
+    std::size_t _stack{0u};
+    std::size_t _depth{0u};
+};
+
+Predicate compile(std::string_view text)
+{
+    Predicate predicate;
+    predicate._text = std::string(text);
+    if(Scanner(text).done())
+    {
+        return predicate;
+    }
+    predicate._depth = Parser(text, predicate._program).parse();
+    return predicate;
+}
+
+void Predicate::evaluate(const Columns& columns, Bitmap& selection) const
+{
+    const std::size_t rows = columns.size();
+    selection.assign((rows + 63u) / 64u, 0u);
+    if(rows == 0u)
+    {
+        return;
+    }
+    if(_program.empty())
+    {
+        fillRows(selection.data(), rows);
+        return;
+    }
+
+    // the names looked up once per batch : one missing from the table is no row's
+    std::vector<utils::StringTable::Id> nameIds(_program.size(), utils::StringTable::kEmpty);
+    std::vector<bool> nameKnown(_program.size(), false);
+    for(std::size_t index=0; index<_program.size(); ++index)
+    {
+        if(_program[index]._op == Op::Compare && _program[index]._column == Column::Name)
+        {
+            utils::StringTable::Id id{utils::StringTable::kEmpty};
+            nameKnown[index] = columns._names != nullptr ? columns._names->find(_program[index]._string, id) : _program[index]._string.empty();
+            nameIds[index] = id;
+        }
+    }
+
+    std::vector<std::uint64_t> stack(_depth * kBlockWords);
+    for(std::size_t start=0; start<rows; start+=kBlockRows)
+    {
+        const std::size_t blockRows = std::min(kBlockRows, rows - start);
+        const std::size_t blockWords = (blockRows + 63u) / 64u;
+        std::size_t top{0u};
+        for(std::size_t index=0; index<_program.size(); ++index)
+        {
+            const Instruction& instruction = _program[index];
+            // the free slot : the operands of && || ! are the one or two below it
+            std::uint64_t* bits = stack.data() + top * kBlockWords;
+            switch(instruction._op)
+            {
+                case Op::Compare :
+                    switch(instruction._column)
+                    {
+                        case Column::Pid : compareColumn(columns._pid.data() + start, blockRows, instruction._comparison, instruction._value, bits); break;
+                        case Column::Cpu : compareColumn(columns._cpu.data() + start, blockRows, instruction._comparison, instruction._value, bits); break;
+                        case Column::Memory : compareColumn(columns._memory.data() + start, blockRows, instruction._comparison, instruction._value, bits); break;
+                        case Column::Threads : compareColumn(columns._threads.data() + start, blockRows, instruction._comparison, instruction._value, bits); break;
+                        case Column::Uptime : compareColumn(columns._uptime.data() + start, blockRows, instruction._comparison, instruction._value, bits); break;
+                        case Column::Uid : compareColumn(columns._uid.data() + start, blockRows, instruction._comparison, instruction._value, bits); break;
+                        case Column::Session : compareColumn(columns._session.data() + start, blockRows, instruction._comparison, instruction._value, bits); break;
+                        case Column::Name :
+                            if(nameKnown[index])
+                            {
+                                compareColumn(columns._name.data() + start, blockRows, instruction._comparison, nameIds[index], bits);
+                            }
+                            else if(instruction._comparison == Comparison::NotEqual)
+                            {
+                                fillRows(bits, blockRows);
+                            }
+                            else
+                            {
+                                std::fill(bits, bits + blockWords, std::uint64_t{0u});
+                            }
+                            break;
+                    }
+                    ++top;
+                    break;
+                case Op::And :
+                    std::transform(bits - 2u * kBlockWords, bits - 2u * kBlockWords + blockWords, bits - kBlockWords, bits - 2u * kBlockWords, std::bit_and<>());
+                    --top;
+                    break;
+                case Op::Or :
+                    std::transform(bits - 2u * kBlockWords, bits - 2u * kBlockWords + blockWords, bits - kBlockWords, bits - 2u * kBlockWords, std::bit_or<>());
+                    --top;
+                    break;
+                case Op::Not :
+                    std::transform(bits - kBlockWords, bits - kBlockWords + blockWords, bits - kBlockWords, std::bit_not<>());
+                    break;
+            }
+        }
+        std::copy(stack.data(), stack.data() + blockWords, selection.data() + start / 64u);
+    }
+    // what a negation set past the last row
+    if(rows % 64u != 0u)
+    {
+        selection.back() &= (std::uint64_t{1u} << (rows % 64u)) - 1u;
+    }
+}
+
+void retain(std::vector<std::pair<uint, PidStats>>& rows, const Predicate& predicate, const utils::StringTable* names)
+{
+    if(predicate.selectsAll())
+    {
+        return;
+    }
+    Columns columns;
+    columns._names = names;
+    columns.reserve(rows.size());
+    for(const std::pair<uint, PidStats>& row : rows)
+    {
+        columns.append(row.first, row.second);
+    }
+    Bitmap selection;
+    predicate.evaluate(columns, selection);
+    std::size_t kept{0u};
+    for(std::size_t row=0; row<rows.size(); ++row)
+    {
+        if(isSelected(selection, row))
+        {
+            rows[kept++] = rows[row];
+        }
+    }
+    rows.resize(kept);
+}
+
+int run(const cli::Options& options)
+{
+    utils::logSink() = &std::cerr;
+    utils::UniqueFd outputFile;
+    if(!options._output.empty())
+    {
+        outputFile.reset(::open(options._output.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+        if(!outputFile.valid())
+        {
+            ERROR("Cannot open " << options._output << " for the selection : " << std::strerror(errno));
+            return 1;
+        }
+    }
+
+    std::vector<std::pair<uint, PidStats>> rows;
+    std::vector<MalformedLine> malformed;
+    utils::StringTable names;
+    if(!readExportedRows(options._selectFile, rows, malformed, 0u, &names))
+    {
+        ERROR("Cannot open the export " << options._selectFile);
+        return 1;
+    }
+    if(!malformed.empty())
+    {
+        WARNING(malformed.size() << " malformed lines skipped in " << options._selectFile << ", the first one at line " << malformed.front()._line << " : " << malformed.front()._reason);
+    }
+    retain(rows, compile(options._where), &names);
+
+    utils::OutputBuffer out(outputFile.valid() ? outputFile.get() : STDOUT_FILENO);
+    format::appendHeader(out, options._format);
+    for(const std::pair<uint, PidStats>& row : rows)
+    {
+        format::appendRow(out, options._format, 0u, row.first, row.second, names.view(row.second._name));
+    }
+    out.flush();
+    return 0;
+}
+}
+}
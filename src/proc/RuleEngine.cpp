@@ -0,0 +1,567 @@
+#include <RuleEngine.hpp>
+#include <Exception.hpp>
+#include <LogTrace.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <limits>
+
+namespace proc
+{
+namespace rules
+{
+namespace
+{
+static constexpr std::int64_t kNotHolding = std::numeric_limits<std::int64_t>::min();
+
+// characters of a rule, left to right
+class Scanner
+{
+public:
+    explicit Scanner(std::string_view text) : _text(text) {}
+
+    std::string_view word()
+    {
+        skipSpaces();
+        const std::size_t start = _position;
+        while(_position < _text.size() && std::isalpha(static_cast<unsigned char>(_text[_position])))
+        {
+            ++_position;
+        }
+        return _text.substr(start, _position - start);
+    }
+
+    bool consume(std::string_view token)
+    {
+        skipSpaces();
+        if(_text.substr(_position, token.size()) != token)
+        {
+            return false;
+        }
+        _position += token.size();
+        return true;
+    }
+
+    bool number(double& value)
+    {
+        skipSpaces();
+        const std::from_chars_result result = std::from_chars(_text.data() + _position, _text.data() + _text.size(), value);
+        if(result.ec != std::errc())
+        {
+            return false;
+        }
+        _position = static_cast<std::size_t>(result.ptr - _text.data());
+        return true;
+    }
+
+    // "php fpm" or php-fpm, up to a blank or an operator ; false when empty or when the quote isn't closed
+    bool name(std::string& value)
+    {
+        skipSpaces();
+        if(_position < _text.size() && _text[_position] == '"')
+        {
+            const std::size_t close = _text.find('"', _position + 1u);
+            if(close == std::string_view::npos)
+            {
+                return false;
+            }
+            value = std::string(_text.substr(_position + 1u, close - _position - 1u));
+            _position = close + 1u;
+            return !value.empty();
+        }
+        const std::size_t start = _position;
+        while(_position < _text.size() && !std::isspace(static_cast<unsigned char>(_text[_position])) && _text[_position] != '<' && _text[_position] != '>')
+        {
+            ++_position;
+        }
+        value = std::string(_text.substr(start, _position - start));
+        return !value.empty();
+    }
+
+    bool done()
+    {
+        skipSpaces();
+        return _position == _text.size();
+    }
+
+private:
+    void skipSpaces()
+    {
+        while(_position < _text.size() && std::isspace(static_cast<unsigned char>(_text[_position])))
+        {
+            ++_position;
+        }
+    }
+
+    std::string_view _text;
+    std::size_t _position{0u};
+};
+
+[[noreturn]] void malformed(std::string_view text, std::string_view expected)
+{
+    throw utils::SeverityException<utils::SeriousException>("Malformed rule \"" + std::string(text) + "\" : expected " + std::string(expected));
+}
+
+bool parseField(std::string_view subject, Field& field)
+{
+    static constexpr std::pair<std::string_view, Field> kSubjects[] =
+        {{"cpu", Field::Cpu}, {"memory", Field::Memory}, {"rss", Field::Memory}, {"threads", Field::Threads},
+         {"uptime", Field::Uptime}, {"count", Field::Count}};
+    for(const std::pair<std::string_view, Field>& known : kSubjects)
+    {
+        if(known.first == subject)
+        {
+            field = known.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parseDurationUnit(std::string_view unit, double& toMs)
+{
+    static constexpr std::pair<std::string_view, double> kUnits[] =
+        {{"ms", 1.0}, {"s", 1000.0}, {"m", 60'000.0}, {"min", 60'000.0}, {"h", 3'600'000.0}};
+    for(const std::pair<std::string_view, double>& known : kUnits)
+    {
+        if(known.first == unit)
+        {
+            toMs = known.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool holds(const Rule& rule, const double value)
+{
+    switch(rule._kind)
+    {
+        case Kind::Above: return value > rule._threshold;
+        case Kind::AtLeast: return value >= rule._threshold;
+        case Kind::Below: return value < rule._threshold;
+        case Kind::AtMost: return value <= rule._threshold;
+        case Kind::Rising: break;
+    }
+    return false;
+}
+
+// cpu, memory, threads and uptime in seconds
+std::array<double, kProcessFieldCount> valuesOf(const PidStats& stats)
+{
+    const PidStats::timezone& uptime = stats._timezone;
+    return {stats._cpu, stats._memory, static_cast<double>(stats._threads),
+        uptime._hours * 3600.0 + uptime._minutes * 60.0 + uptime._seconds + uptime._ms / 1000.0};
+}
+}
+
+Rule compile(std::string_view text)
+{
+    Rule rule;
+    rule._text = std::string(text);
+    Scanner scanner(text);
+    if(!parseField(scanner.word(), rule._field))
+    {
+        malformed(text, "cpu, memory, rss, threads, uptime or count first");
+    }
+    if(scanner.consume("name="))
+    {
+        if(rule._field != Field::Count)
+        {
+            malformed(text, "name= on count only");
+        }
+        if(!scanner.name(rule._name))
+        {
+            malformed(text, "a process name after name=");
+        }
+    }
+
+    if(scanner.consume(">="))
+    {
+        rule._kind = Kind::AtLeast;
+    }
+    else if(scanner.consume("<="))
+    {
+        rule._kind = Kind::AtMost;
+    }
+    else if(scanner.consume(">"))
+    {
+        rule._kind = Kind::Above;
+    }
+    else if(scanner.consume("<"))
+    {
+        rule._kind = Kind::Below;
+    }
+    else if(scanner.word() == "rising")
+    {
+        rule._kind = Kind::Rising;
+    }
+    else
+    {
+        malformed(text, "one of > >= < <= rising after the subject");
+    }
+
+    if(rule._kind != Kind::Rising)
+    {
+        if(!scanner.number(rule._threshold))
+        {
+            malformed(text, "a number after the operator");
+        }
+        if(scanner.consume("%") && rule._field != Field::Cpu && rule._field != Field::Memory)
+        {
+            malformed(text, "no % on a subject that isn't a percentage");
+        }
+    }
+
+    if(!scanner.done())
+    {
+        double duration{0.0};
+        double toMs{0.0};
+        if(scanner.word() != "for" || !scanner.number(duration) || duration < 0.0 || !parseDurationUnit(scanner.word(), toMs))
+        {
+            malformed(text, "\"for <duration>\" with ms, s, m, min or h as unit");
+        }
+        rule._holdMs = static_cast<std::int64_t>(duration * toMs);
+    }
+
+    if(!scanner.done())
+    {
+        malformed(text, "nothing after the duration");
+    }
+    return rule;
+}
+
+std::vector<Rule> loadRules(const std::filesystem::path& rulesFile)
+{
+    std::ifstream file(rulesFile);
+    if(!file)
+    {
+        throw utils::SeverityException<utils::SeriousException>("Rules file " + rulesFile.string() + " cannot be opened");
+    }
+
+    std::vector<Rule> rules;
+    std::string line;
+    for(uint lineNumber=1; std::getline(file, line); ++lineNumber)
+    {
+        const std::string_view text = std::string_view(line).substr(0, line.find('#'));
+        if(text.find_first_not_of(" \t\r") == std::string_view::npos)
+        {
+            continue;
+        }
+        try
+        {
+            rules.push_back(compile(text.substr(0, text.find_last_not_of(" \t\r") + 1)));
+        }
+        catch(const utils::SeverityException<utils::SeriousException>& e)
+        {
+            throw utils::SeverityException<utils::SeriousException>(rulesFile.string() + ":" + std::to_string(lineNumber) + " : " + e.what());
+        }
+    }
+    return rules;
+}
+
+std::string describe(const Rule& rule, const Alert& alert)
+{
+    char value[64];
+    char* end = std::to_chars(value, value + sizeof(value), alert._value, std::chars_format::fixed, 2).ptr;
+    std::string description(alert._pid == 0u ? "system" : "pid " + std::to_string(alert._pid));
+    description += " : ";
+    description += rule._text;
+    description += " (value ";
+    description.append(value, end);
+    description += ')';
+    return description;
+}
+
+RuleEngine::RuleEngine(std::vector<Rule> rules) : _rules(std::move(rules))
+{
+    for(std::uint32_t rule=0; rule<_rules.size(); ++rule)
+    {
+        const Rule& compiled = _rules[rule];
+        if(compiled._field == Field::Count)
+        {
+            _systemRules.push_back(rule);
+            continue;
+        }
+
+        const std::size_t field = static_cast<std::size_t>(compiled._field);
+        if(compiled._kind == Kind::Rising)
+        {
+            _risingRules[field].push_back(rule);
+            continue;
+        }
+        const bool downwards = compiled._kind == Kind::Below || compiled._kind == Kind::AtMost;
+        const bool strict = compiled._kind == Kind::Above || compiled._kind == Kind::Below;
+        _groups[2u * field + (downwards ? 1u : 0u)].push_back(
+            Threshold{downwards ? -compiled._threshold : compiled._threshold, strict, rule, compiled._holdMs});
+    }
+
+    // ascending thresholds, `>=` before `>` on a tie : whatever the value, the rules holding are a prefix
+    for(std::vector<Threshold>& group : _groups)
+    {
+        if(group.size() > std::numeric_limits<std::uint16_t>::max())
+        {
+            throw utils::SeverityException<utils::SeriousException>("Too many threshold rules on a single subject");
+        }
+        std::stable_sort(group.begin(), group.end(), [](const Threshold& left, const Threshold& right)
+        {
+            return left._threshold != right._threshold ? left._threshold < right._threshold : !left._strict && right._strict;
+        });
+    }
+    for(std::vector<std::uint32_t>& rising : _risingRules)
+    {
+        std::stable_sort(rising.begin(), rising.end(), [this](const std::uint32_t left, const std::uint32_t right)
+        {
+            return _rules[left]._holdMs < _rules[right]._holdMs;
+        });
+    }
+    _systemStreaks.assign(_systemRules.size(), Streak{kNotHolding, false});
+    _systemCounts.assign(_systemRules.size(), 0.0);
+    _systemRising.assign(_systemRules.size(), RisingStreak{});
+    _countedNames.assign(_systemRules.size(), utils::StringTable::kEmpty);
+    _countedNameKnown.assign(_systemRules.size(), false);
+    _perProcess = _systemRules.size() != _rules.size();
+    INFO("Compiled " << _rules.size() << " rules, " << _systemRules.size() << " of them system wide");
+}
+
+const std::vector<Alert>& RuleEngine::evaluate(const std::int64_t nowMs, const PidStatus_t& snapshot, const utils::StringTable* names)
+{
+    return evaluateSnapshot(nowMs, snapshot, names);
+}
+
+const std::vector<Alert>& RuleEngine::evaluate(const std::int64_t nowMs, const PidTable_t& snapshot, const utils::StringTable* names)
+{
+    return evaluateSnapshot(nowMs, snapshot, names);
+}
+
+template<class Snapshot>
+void RuleEngine::countProcesses(const Snapshot& snapshot, const utils::StringTable* names)
+{
+    // the names looked up once per tick : one missing from the table is no process'
+    bool anyNamed{false};
+    for(std::size_t system=0; system<_systemRules.size(); ++system)
+    {
+        const std::string& name = _rules[_systemRules[system]]._name;
+        _countedNameKnown[system] = !name.empty() && names != nullptr && names->find(name, _countedNames[system]);
+        anyNamed |= _countedNameKnown[system];
+        _systemCounts[system] = name.empty() ? static_cast<double>(snapshot.size()) : 0.0;
+    }
+    if(!anyNamed)
+    {
+        return;
+    }
+    for(const typename Snapshot::value_type& pidWithStats : snapshot)
+    {
+        for(std::size_t system=0; system<_systemRules.size(); ++system)
+        {
+            _systemCounts[system] += _countedNameKnown[system] && _countedNames[system] == pidWithStats.second._name ? 1.0 : 0.0;
+        }
+    }
+}
+
+// both snapshots iterate over (pid, stats) pairs and know their size
+template<class Snapshot>
+const std::vector<Alert>& RuleEngine::evaluateSnapshot(const std::int64_t nowMs, const Snapshot& snapshot, const utils::StringTable* names)
+{
+    ++_tick;
+    _fired.clear();
+    if(_perProcess)
+    {
+        for(const typename Snapshot::value_type& pidWithStats : snapshot)
+        {
+            const PidStats& stats = pidWithStats.second;
+            std::pair<std::unordered_map<uint, Tracked>::iterator, bool> tracked = _processes.try_emplace(pidWithStats.first);
+            bool fresh = tracked.second;
+            if(!fresh && tracked.first->second._startTime != stats._startTime)
+            {
+                // the pid has been reused, the streaks of the previous process are over
+                forget(tracked.first->second);
+                tracked.first->second = Tracked{};
+                fresh = true;
+            }
+            tracked.first->second._startTime = stats._startTime;
+            tracked.first->second._tick = _tick;
+            evaluateProcess(nowMs, pidWithStats.first, valuesOf(stats), fresh, tracked.first->second);
+        }
+
+        // every pid of the snapshot is tracked : as many tracked as in the snapshot means none is gone
+        for(std::unordered_map<uint, Tracked>::iterator tracked = _processes.begin(); _processes.size() != snapshot.size() && tracked != _processes.end();)
+        {
+            if(tracked->second._tick == _tick)
+            {
+                ++tracked;
+                continue;
+            }
+            forget(tracked->second);
+            tracked = _processes.erase(tracked);
+        }
+    }
+
+    countProcesses(snapshot, names);
+    evaluateSystem(nowMs);
+    return _fired;
+}
+
+void RuleEngine::evaluateProcess(const std::int64_t nowMs, const uint pid, const std::array<double, kProcessFieldCount>& values, const bool fresh, Tracked& tracked)
+{
+    std::size_t offset{0u};
+    for(std::size_t group=0; group<kGroupCount; ++group)
+    {
+        const std::vector<Threshold>& thresholds = _groups[group];
+        if(thresholds.empty())
+        {
+            continue;
+        }
+        const double value = values[group / 2u];
+        const double normalized = group % 2u == 0u ? value : -value;
+        const std::size_t holding = static_cast<std::size_t>(std::partition_point(thresholds.begin(), thresholds.end(), [normalized](const Threshold& threshold)
+        {
+            return threshold._strict ? normalized > threshold._threshold : normalized >= threshold._threshold;
+        }) - thresholds.begin());
+
+        // the streaks of the rules that stopped holding end, the ones that started holding begin now
+        const std::size_t wasHolding = tracked._holding[group];
+        const std::vector<Streak>::iterator first = tracked._streaks.begin() + static_cast<std::ptrdiff_t>(offset);
+        if(holding < wasHolding)
+        {
+            _firing -= static_cast<std::size_t>(std::count_if(first + static_cast<std::ptrdiff_t>(holding), first + static_cast<std::ptrdiff_t>(wasHolding),
+                [](const Streak& streak) { return streak._fired; }));
+            tracked._streaks.erase(first + static_cast<std::ptrdiff_t>(holding), first + static_cast<std::ptrdiff_t>(wasHolding));
+        }
+        else if(holding > wasHolding)
+        {
+            tracked._streaks.insert(first + static_cast<std::ptrdiff_t>(wasHolding), holding - wasHolding, Streak{nowMs, false});
+            for(std::size_t rule=wasHolding; rule<holding; ++rule)
+            {
+                tracked._nextDueMs[group] = std::min(tracked._nextDueMs[group], nowMs + thresholds[rule]._holdMs);
+            }
+        }
+        tracked._holding[group] = static_cast<std::uint16_t>(holding);
+
+        if(nowMs >= tracked._nextDueMs[group])
+        {
+            tracked._nextDueMs[group] = fireDueStreaks(nowMs, pid, value, thresholds, &tracked._streaks[offset], holding);
+        }
+        offset += holding;
+    }
+
+    for(std::size_t field=0; field<kProcessFieldCount; ++field)
+    {
+        const std::vector<std::uint32_t>& rising = _risingRules[field];
+        if(rising.empty())
+        {
+            continue;
+        }
+        const double value = values[field];
+        RisingStreak& streak = tracked._rising[field];
+        if(fresh || value < streak._lastValue)
+        {
+            _firing -= streak._fired;
+            streak = RisingStreak{value, value, nowMs, 0u};
+        }
+        streak._lastValue = value;
+        while(value > streak._startValue && streak._fired < rising.size() && nowMs - streak._sinceMs >= _rules[rising[streak._fired]]._holdMs)
+        {
+            fire(rising[streak._fired], pid, streak._sinceMs, nowMs, value);
+            ++streak._fired;
+        }
+    }
+}
+
+std::int64_t RuleEngine::fireDueStreaks(const std::int64_t nowMs, const uint pid, const double value, const std::vector<Threshold>& thresholds, Streak* streaks, const std::size_t holding)
+{
+    std::int64_t nextDueMs = kNeverDue;
+    for(std::size_t rule=0; rule<holding; ++rule)
+    {
+        Streak& streak = streaks[rule];
+        if(streak._fired)
+        {
+            continue;
+        }
+        const std::int64_t dueMs = streak._sinceMs + thresholds[rule]._holdMs;
+        if(nowMs < dueMs)
+        {
+            nextDueMs = std::min(nextDueMs, dueMs);
+            continue;
+        }
+        streak._fired = true;
+        fire(thresholds[rule]._rule, pid, streak._sinceMs, nowMs, value);
+    }
+    return nextDueMs;
+}
+
+void RuleEngine::evaluateSystem(const std::int64_t nowMs)
+{
+    for(std::size_t system=0; system<_systemRules.size(); ++system)
+    {
+        const double count = _systemCounts[system];
+        RisingStreak& risingStreak = _systemRising[system];
+        if(!_systemSeen || count < risingStreak._lastValue)
+        {
+            risingStreak = RisingStreak{count, count, nowMs, 0u};
+        }
+        risingStreak._lastValue = count;
+
+        const Rule& rule = _rules[_systemRules[system]];
+        Streak& streak = _systemStreaks[system];
+        const bool rising = rule._kind == Kind::Rising;
+        const bool holding = rising ? count > risingStreak._startValue : holds(rule, count);
+        const std::int64_t sinceMs = rising ? risingStreak._sinceMs : (streak._sinceMs == kNotHolding ? nowMs : streak._sinceMs);
+        if(!holding || streak._sinceMs != sinceMs)
+        {
+            _firing -= streak._fired ? 1u : 0u;
+            streak = Streak{holding ? sinceMs : kNotHolding, false};
+        }
+        if(holding && !streak._fired && nowMs - sinceMs >= rule._holdMs)
+        {
+            streak._fired = true;
+            fire(_systemRules[system], 0u, sinceMs, nowMs, count);
+        }
+    }
+    _systemSeen = true;
+}
+
+void RuleEngine::fire(const std::uint32_t rule, const uint pid, const std::int64_t sinceMs, const std::int64_t nowMs, const double value)
+{
+    _fired.push_back(Alert{rule, pid, sinceMs, nowMs, value});
+    ++_firing;
+}
+
+void RuleEngine::forget(const Tracked& tracked)
+{
+    _firing -= static_cast<std::size_t>(std::count_if(tracked._streaks.begin(), tracked._streaks.end(), [](const Streak& streak) { return streak._fired; }));
+    for(const RisingStreak& rising : tracked._rising)
+    {
+        _firing -= rising._fired;
+    }
+}
+
+AlertLog::AlertLog(const std::filesystem::path& logFile)
+    : _file(::open(logFile.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644)), _out(_file.get())
+{
+    if(!_file.valid())
+    {
+        throw utils::SeverityException<utils::SeriousException>("Alert log " + logFile.string() + " cannot be opened : " + std::strerror(errno));
+    }
+}
+
+void AlertLog::append(const RuleEngine& engine, const std::vector<Alert>& alerts)
+{
+    for(const Alert& alert : alerts)
+    {
+        _out.appendInt(alert._firedMs);
+        _out.append(' ');
+        _out.append(describe(engine.getRule(alert._rule), alert));
+        _out.append('\n');
+    }
+    if(!alerts.empty())
+    {
+        _out.flush();
+    }
+}
+}
+}
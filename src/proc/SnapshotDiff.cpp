@@ -0,0 +1,428 @@
+#include <SnapshotDiff.hpp>
+#include <CliOptions.hpp>
+#include <ExportedFileWrapper.hpp>
+#include <LogTrace.hpp>
+#include <Query.hpp>
+#include <UniqueFd.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+namespace proc
+{
+namespace diff
+{
+namespace
+{
+static constexpr const char* kMetricLabels[] = {"CPU (%)", "Memory (%)", "Threads"};
+static constexpr const char* kChangeLabels[] = {"changed", "appeared", "disappeared"};
+static constexpr char kTableBoundary[] = "+---------+------------------------------+------------------------------+----------------------+\n";
+static constexpr char kTableColumns[] = "| PID     | CPU (%)                      | Memory (%)                   | Threads              |\n";
+static constexpr int kMetricPrecision = 2;
+
+double valueOf(const PidStats& stats, const Metric metric)
+{
+    switch(metric)
+    {
+        case Metric::Cpu : return stats._cpu;
+        case Metric::Memory : return stats._memory;
+        case Metric::Threads : return static_cast<double>(stats._threads);
+    }
+    return 0.0;
+}
+
+// highest score first, the lowest pid among equals
+bool ranksHigher(const Mover& left, const Mover& right)
+{
+    return left._score > right._score || (left._score == right._score && left._pid < right._pid);
+}
+
+// The K best movers seen so far in a heap whose front is the worst of them, an offer below it costs one comparison.
+// K 0 keeps everything, in the order offered
+class TopK
+{
+public:
+    explicit TopK(const std::size_t k) : _k(k)
+    {
+        _heap.reserve(k);
+    }
+
+    void offer(const Mover& mover)
+    {
+        if(_k == 0u)
+        {
+            _heap.push_back(mover);
+        }
+        else if(_heap.size() < _k)
+        {
+            _heap.push_back(mover);
+            std::push_heap(_heap.begin(), _heap.end(), ranksHigher);
+        }
+        else if(ranksHigher(mover, _heap.front()))
+        {
+            std::pop_heap(_heap.begin(), _heap.end(), ranksHigher);
+            _heap.back() = mover;
+            std::push_heap(_heap.begin(), _heap.end(), ranksHigher);
+        }
+    }
+
+    std::vector<Mover> take()
+    {
+        if(_k != 0u)
+        {
+            std::sort(_heap.begin(), _heap.end(), ranksHigher);
+        }
+        return std::move(_heap);
+    }
+
+private:
+    std::size_t _k;
+    std::vector<Mover> _heap;
+};
+
+std::string toFixed(const double value)
+{
+    char fixed[32];
+    return std::string(fixed, std::to_chars(fixed, fixed + sizeof(fixed), value, std::chars_format::fixed, kMetricPrecision).ptr);
+}
+
+// "4.20 -> 9.10 (+4.90)", "- -> 9.10" when appeared, "4.20 -> -" when disappeared
+std::string describeValue(const Mover& mover, const Metric metric)
+{
+    const bool hasBefore = mover._change != Change::Appeared;
+    const bool hasAfter = mover._change != Change::Disappeared;
+    const double before = valueOf(mover._before, metric);
+    const double after = valueOf(mover._after, metric);
+    const auto render = [metric](const double value)
+    {
+        return metric == Metric::Threads ? std::to_string(static_cast<std::int64_t>(value)) : toFixed(value);
+    };
+
+    std::string text = (hasBefore ? render(before) : "-") + " -> " + (hasAfter ? render(after) : "-");
+    if(hasBefore && hasAfter && before != after)
+    {
+        text += after > before ? " (+" : " (-";
+        text += render(std::fabs(after - before));
+        text += ')';
+    }
+    return text;
+}
+
+void appendCell(utils::OutputBuffer& out, std::string_view text, const std::size_t width)
+{
+    out.append("| ");
+    out.append(text);
+    for(std::size_t pad=text.size(); pad<width; ++pad)
+    {
+        out.append(' ');
+    }
+    out.append(' ');
+}
+
+void appendSection(utils::OutputBuffer& out, std::string_view title, const std::vector<Mover>& movers)
+{
+    out.append(title);
+    out.append('\n');
+    out.append(kTableBoundary);
+    out.append(kTableColumns);
+    out.append(kTableBoundary);
+    for(const Mover& mover : movers)
+    {
+        appendCell(out, std::to_string(mover._pid), 7u);
+        appendCell(out, describeValue(mover, Metric::Cpu), 28u);
+        appendCell(out, describeValue(mover, Metric::Memory), 28u);
+        appendCell(out, describeValue(mover, Metric::Threads), 20u);
+        out.append("|\n");
+    }
+    out.append(kTableBoundary);
+}
+
+// a value of the side the process exists on, nothing (csv) or null (json) otherwise
+void appendStreamValue(utils::OutputBuffer& out, const format::Kind kind, const bool exists, const double value, const bool integer)
+{
+    if(!exists)
+    {
+        out.append(kind == format::Kind::JsonLines ? "null" : "");
+    }
+    else if(integer)
+    {
+        out.appendUint(static_cast<std::uint64_t>(value));
+    }
+    else
+    {
+        out.appendFixed(value, kMetricPrecision);
+    }
+}
+
+void appendStreamRow(utils::OutputBuffer& out, const format::Kind kind, const Mover& mover)
+{
+    static constexpr const char* kJsonKeys[] = {"cpu", "memory", "threads"};
+    const bool hasBefore = mover._change != Change::Appeared;
+    const bool hasAfter = mover._change != Change::Disappeared;
+    const bool json = kind == format::Kind::JsonLines;
+
+    out.append(json ? "{\"pid\":" : "");
+    out.appendUint(mover._pid);
+    out.append(json ? ",\"change\":\"" : ",");
+    out.append(kChangeLabels[static_cast<int>(mover._change)]);
+    out.append(json ? "\"" : "");
+    for(const Metric metric : {Metric::Cpu, Metric::Memory, Metric::Threads})
+    {
+        const bool integer = metric == Metric::Threads;
+        if(json)
+        {
+            out.append(",\"");
+            out.append(kJsonKeys[static_cast<int>(metric)]);
+            out.append("_before\":");
+        }
+        else
+        {
+            out.append(',');
+        }
+        appendStreamValue(out, kind, hasBefore, valueOf(mover._before, metric), integer);
+        if(json)
+        {
+            out.append(",\"");
+            out.append(kJsonKeys[static_cast<int>(metric)]);
+            out.append("_after\":");
+        }
+        else
+        {
+            out.append(',');
+        }
+        appendStreamValue(out, kind, hasAfter, valueOf(mover._after, metric), integer);
+    }
+    out.append(json ? "}\n" : "\n");
+}
+
+// the rows of an export matching `filter` in file order ; false (logged) when it cannot be read
+bool loadExport(const std::filesystem::path& exportedFile, const query::Predicate& filter, Rows_t& rows)
+{
+    std::vector<MalformedLine> malformed;
+    // the names are only needed by a filter on them, each capture numbers its' own
+    utils::StringTable names;
+    if(!readExportedRows(exportedFile, rows, malformed, 0u, filter.selectsAll() ? nullptr : &names))
+    {
+        ERROR("Cannot open the export " << exportedFile);
+        return false;
+    }
+    if(!malformed.empty())
+    {
+        WARNING(malformed.size() << " malformed lines skipped in " << exportedFile << ", the first one at line " << malformed.front()._line << " : " << malformed.front()._reason);
+    }
+    query::retain(rows, filter, &names);
+    return true;
+}
+}
+
+bool parseMetric(std::string_view name, Metric& metric)
+{
+    if(name == "cpu")
+    {
+        metric = Metric::Cpu;
+    }
+    else if(name == "memory")
+    {
+        metric = Metric::Memory;
+    }
+    else if(name == "threads")
+    {
+        metric = Metric::Threads;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+void sortByPid(Rows_t& rows)
+{
+    // the 8 bytes keys {pid, position} are sorted instead of the rows : the position breaks the ties in file order
+    // so the first row of a pid comes first, and each row is moved once when gathered
+    std::vector<std::uint64_t> keys(rows.size());
+    for(std::size_t position=0; position<rows.size(); ++position)
+    {
+        keys[position] = static_cast<std::uint64_t>(rows[position].first) << 32u | position;
+    }
+    std::sort(keys.begin(), keys.end());
+
+    Rows_t sorted;
+    sorted.reserve(rows.size());
+    for(const std::uint64_t key : keys)
+    {
+        const uint pid = static_cast<uint>(key >> 32u);
+        if(sorted.empty() || sorted.back().first != pid)
+        {
+            sorted.push_back(rows[key & 0xffffffffu]);
+        }
+    }
+    rows.swap(sorted);
+}
+
+DiffResult diff(const Rows_t& before, const Rows_t& after, const Metric metric, const std::size_t topK)
+{
+    DiffResult result;
+    result._beforeCount = before.size();
+    result._afterCount = after.size();
+    TopK movers(topK);
+    TopK appeared(topK);
+    TopK disappeared(topK);
+
+    std::size_t left{0u};
+    std::size_t right{0u};
+    while(left < before.size() || right < after.size())
+    {
+        const bool onlyBefore = right == after.size() || (left < before.size() && before[left].first < after[right].first);
+        const bool onlyAfter = left == before.size() || (right < after.size() && after[right].first < before[left].first);
+        if(onlyBefore)
+        {
+            ++result._disappeared;
+            disappeared.offer(Mover{before[left].first, Change::Disappeared, before[left].second, PidStats{}, valueOf(before[left].second, metric)});
+            ++left;
+        }
+        else if(onlyAfter)
+        {
+            ++result._appeared;
+            appeared.offer(Mover{after[right].first, Change::Appeared, PidStats{}, after[right].second, valueOf(after[right].second, metric)});
+            ++right;
+        }
+        else
+        {
+            const PidStats& was = before[left].second;
+            const PidStats& is = after[right].second;
+            if(was._cpu != is._cpu || was._memory != is._memory || was._threads != is._threads)
+            {
+                ++result._changed;
+                const double score = std::fabs(valueOf(is, metric) - valueOf(was, metric));
+                if(score > 0.0)
+                {
+                    movers.offer(Mover{before[left].first, Change::Changed, was, is, score});
+                }
+            }
+            else
+            {
+                ++result._unchanged;
+            }
+            ++left;
+            ++right;
+        }
+    }
+
+    result._movers = movers.take();
+    result._appearedTop = appeared.take();
+    result._disappearedTop = disappeared.take();
+    return result;
+}
+
+void appendTable(utils::OutputBuffer& out, const DiffResult& result, const Metric metric,
+    std::string_view beforeName, std::string_view afterName)
+{
+    out.append("Diff ");
+    out.append(beforeName);
+    out.append(" (");
+    out.appendUint(result._beforeCount);
+    out.append(" processes) -> ");
+    out.append(afterName);
+    out.append(" (");
+    out.appendUint(result._afterCount);
+    out.append(" processes)\nChanged ");
+    out.appendUint(result._changed);
+    out.append(" | Unchanged ");
+    out.appendUint(result._unchanged);
+    out.append(" | Appeared ");
+    out.appendUint(result._appeared);
+    out.append(" | Disappeared ");
+    out.appendUint(result._disappeared);
+    out.append("\n\n");
+
+    appendSection(out, std::string("Top movers by ") + kMetricLabels[static_cast<int>(metric)], result._movers);
+    out.append('\n');
+    appendSection(out, "Appeared", result._appearedTop);
+    out.append('\n');
+    appendSection(out, "Disappeared", result._disappearedTop);
+}
+
+void appendStream(utils::OutputBuffer& out, const format::Kind kind, const DiffResult& result)
+{
+    if(kind == format::Kind::Csv)
+    {
+        out.append("pid,change,cpu_before,cpu_after,memory_before,memory_after,threads_before,threads_after\n");
+    }
+    for(const std::vector<Mover>* movers : {&result._movers, &result._appearedTop, &result._disappearedTop})
+    {
+        for(const Mover& mover : *movers)
+        {
+            appendStreamRow(out, kind, mover);
+        }
+    }
+}
+
+int run(const cli::Options& options)
+{
+    utils::logSink() = &std::cerr;
+
+    // a live scan moves the working directory to /proc, a relative output path has to be opened before that
+    utils::UniqueFd outputFile;
+    if(!options._output.empty())
+    {
+        outputFile.reset(::open(options._output.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+        if(!outputFile.valid())
+        {
+            ERROR("Cannot open " << options._output << " for the diff : " << std::strerror(errno));
+            return 1;
+        }
+    }
+
+    // both captures are loaded, filtered and sorted side by side : a process left out by --where is in neither
+    const query::Predicate filter = query::compile(options._where);
+    Rows_t before;
+    bool beforeLoaded{false};
+    std::thread beforeLoader([&]
+    {
+        beforeLoaded = loadExport(options._diffBefore, filter, before);
+        sortByPid(before);
+    });
+
+    Rows_t after;
+    bool afterLoaded{true};
+    if(options._diffAfter.empty())
+    {
+        ProcessInfo collector(options._ioBackend);
+        const PidTable_t& snapshot = collector.scanProcDir();
+        after.assign(snapshot.begin(), snapshot.end());
+        query::retain(after, filter, &collector.getNames());
+    }
+    else
+    {
+        afterLoaded = loadExport(options._diffAfter, filter, after);
+    }
+    sortByPid(after);
+    beforeLoader.join();
+    if(!beforeLoaded || !afterLoaded)
+    {
+        return 1;
+    }
+
+    const DiffResult result = diff(before, after, options._diffMetric, options._top);
+    utils::OutputBuffer out(outputFile.valid() ? outputFile.get() : STDOUT_FILENO);
+    if(options._format == format::Kind::Text)
+    {
+        appendTable(out, result, options._diffMetric, options._diffBefore.filename().string(),
+            options._diffAfter.empty() ? std::string("live scan") : options._diffAfter.filename().string());
+    }
+    else
+    {
+        appendStream(out, options._format, result);
+    }
+    out.flush();
+    return 0;
+}
+}
+}
@@ -0,0 +1,208 @@
+#include <SnapshotFormat.hpp>
+
+namespace proc
+{
+namespace format
+{
+namespace
+{
+static constexpr int kMetricPrecision = 2;
+
+// uptime of the process rendered as seconds.ms, eg. 0:20:31.700 -> 1231.700
+void appendUptimeSeconds(utils::OutputBuffer& out, const PidStats::timezone& tmz)
+{
+    out.appendUint(static_cast<std::uint64_t>(tmz._hours) * 3600u + tmz._minutes * 60u + tmz._seconds);
+    out.append('.');
+    out.appendUintPadded(tmz._ms, 3u);
+}
+
+// cgroup paths are free text : quoted and escaped for the formats that need it
+void appendQuoted(utils::OutputBuffer& out, const Kind kind, std::string_view text)
+{
+    out.append('"');
+    for(const char c : text)
+    {
+        if(c == '"')
+        {
+            out.append(kind == Kind::Csv ? "\"\"" : "\\\"");
+        }
+        else if(c == '\\' && kind == Kind::JsonLines)
+        {
+            out.append("\\\\");
+        }
+        else
+        {
+            out.append(c);
+        }
+    }
+    out.append('"');
+}
+
+void appendTextRow(utils::OutputBuffer& out, const uint pid, const PidStats& stats, std::string_view name)
+{
+    out.append("Pid: ");
+    out.appendUint(pid);
+    out.append(" cpu: ");
+    appendPercent(out, stats._cpu);
+    out.append(" memory: ");
+    appendPercent(out, stats._memory);
+    out.append(" threads: ");
+    out.appendUint(stats._threads);
+    out.append(" time: ");
+    out.appendUint(stats._timezone._hours);
+    out.append(':');
+    out.appendUint(stats._timezone._minutes);
+    out.append(':');
+    out.appendUint(stats._timezone._seconds);
+    out.append('.');
+    out.appendUint(stats._timezone._ms);
+    // kernel threads (root, no session) and rows of an older export stay as they were
+    if(stats._uid != 0u || stats._session != 0u)
+    {
+        out.append(" user: ");
+        out.appendUint(stats._uid);
+        out.append(" session: ");
+        out.appendUint(stats._session);
+    }
+    // last : a comm may hold blanks, it runs to the end of the line
+    if(!name.empty())
+    {
+        out.append(" name: ");
+        out.append(name);
+    }
+    out.append('\n');
+}
+
+void appendCsvRow(utils::OutputBuffer& out, const std::uint64_t timestampMs, const uint pid, const PidStats& stats)
+{
+    out.appendUint(timestampMs);
+    out.append(',');
+    out.appendUint(pid);
+    out.append(',');
+    out.appendFixed(stats._cpu, kMetricPrecision);
+    out.append(',');
+    out.appendFixed(stats._memory, kMetricPrecision);
+    out.append(',');
+    out.appendUint(stats._threads);
+    out.append(',');
+    appendUptimeSeconds(out, stats._timezone);
+    out.append('\n');
+}
+
+void appendJsonRow(utils::OutputBuffer& out, const std::uint64_t timestampMs, const uint pid, const PidStats& stats)
+{
+    out.append("{\"ts\":");
+    out.appendUint(timestampMs);
+    out.append(",\"pid\":");
+    out.appendUint(pid);
+    out.append(",\"cpu\":");
+    out.appendFixed(stats._cpu, kMetricPrecision);
+    out.append(",\"memory\":");
+    out.appendFixed(stats._memory, kMetricPrecision);
+    out.append(",\"threads\":");
+    out.appendUint(stats._threads);
+    out.append(",\"uptime\":");
+    appendUptimeSeconds(out, stats._timezone);
+    out.append("}\n");
+}
+}
+
+bool parseKind(std::string_view name, Kind& kind)
+{
+    if(name == "text")
+    {
+        kind = Kind::Text;
+    }
+    else if(name == "csv")
+    {
+        kind = Kind::Csv;
+    }
+    else if(name == "jsonl" || name == "json")
+    {
+        kind = Kind::JsonLines;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+void appendPercent(utils::OutputBuffer& out, const double value)
+{
+    out.appendFixed(value, kMetricPrecision);
+    out.append('%');
+}
+
+void appendHeader(utils::OutputBuffer& out, const Kind kind)
+{
+    if(kind == Kind::Csv)
+    {
+        out.append("ts,pid,cpu,memory,threads,uptime\n");
+    }
+}
+
+void appendRow(utils::OutputBuffer& out, const Kind kind, const std::uint64_t timestampMs, const uint pid, const PidStats& stats,
+    std::string_view name)
+{
+    switch(kind)
+    {
+        case Kind::Text : appendTextRow(out, pid, stats, name); break;
+        case Kind::Csv : appendCsvRow(out, timestampMs, pid, stats); break;
+        case Kind::JsonLines : appendJsonRow(out, timestampMs, pid, stats); break;
+    }
+}
+
+void appendCgroupHeader(utils::OutputBuffer& out, const Kind kind)
+{
+    if(kind == Kind::Csv)
+    {
+        out.append("ts,cgroup,cpu,memory,pids\n");
+    }
+}
+
+void appendCgroupRow(utils::OutputBuffer& out, const Kind kind, const std::uint64_t timestampMs, const CgroupStats& stats)
+{
+    switch(kind)
+    {
+        case Kind::Text :
+            out.append("Cgroup: ");
+            out.append(stats._path);
+            out.append(" cpu: ");
+            appendPercent(out, stats._cpu);
+            out.append(" memory: ");
+            out.appendUint(stats._memoryBytes);
+            out.append(" pids: ");
+            out.appendUint(stats._pids);
+            out.append('\n');
+            break;
+        case Kind::Csv :
+            out.appendUint(timestampMs);
+            out.append(',');
+            appendQuoted(out, kind, stats._path);
+            out.append(',');
+            out.appendFixed(stats._cpu, kMetricPrecision);
+            out.append(',');
+            out.appendUint(stats._memoryBytes);
+            out.append(',');
+            out.appendUint(stats._pids);
+            out.append('\n');
+            break;
+        case Kind::JsonLines :
+            out.append("{\"ts\":");
+            out.appendUint(timestampMs);
+            out.append(",\"cgroup\":");
+            appendQuoted(out, kind, stats._path);
+            out.append(",\"cpu\":");
+            out.appendFixed(stats._cpu, kMetricPrecision);
+            out.append(",\"memory\":");
+            out.appendUint(stats._memoryBytes);
+            out.append(",\"pids\":");
+            out.appendUint(stats._pids);
+            out.append("}\n");
+            break;
+    }
+}
+
+}
+}
\ No newline at end of file
@@ -0,0 +1,221 @@
+#include <SystemCpuSampler.hpp>
+#include <ProcFile.hpp>
+#include <LogTrace.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <unistd.h>
+
+namespace proc
+{
+namespace
+{
+// ~150 bytes per cpu line, plus intr/softirq lines that grow with the irq count
+static constexpr std::size_t kInitialReadBuffer = 1u << 16;
+static constexpr char kHeatmapLevels[] = " .:-=+*#%@";
+
+// "cpu  ..." or "cpuN ..." ; returns the position after the label and the core index (-1 for the total line)
+bool parseCpuLabel(std::string_view line, std::size_t& position, long& core)
+{
+    if(line.size() < 4u || line.compare(0, 3, "cpu") != 0)
+    {
+        return false;
+    }
+    position = 3u;
+    if(line[position] == ' ')
+    {
+        core = -1;
+        return true;
+    }
+    const std::from_chars_result result = std::from_chars(line.data() + position, line.data() + line.size(), core);
+    if(result.ec != std::errc())
+    {
+        return false;
+    }
+    position = static_cast<std::size_t>(result.ptr - line.data());
+    return true;
+}
+
+CpuTimes parseTimes(std::string_view line, std::size_t position)
+{
+    CpuTimes times;
+    unsigned long long* const ordered[] = {
+        &times._user, &times._nice, &times._system, &times._idle, &times._iowait, &times._irq, &times._softirq, &times._steal
+    };
+    for(unsigned long long* const field : ordered)
+    {
+        while(position < line.size() && line[position] == ' ')
+        {
+            ++position;
+        }
+        const std::from_chars_result result = std::from_chars(line.data() + position, line.data() + line.size(), *field);
+        if(result.ec != std::errc())
+        {
+            break; // older kernels stop before steal
+        }
+        position = static_cast<std::size_t>(result.ptr - line.data());
+    }
+    return times;
+}
+
+CpuUsage usageBetween(const CpuTimes& previous, const CpuTimes& current)
+{
+    CpuUsage usage;
+    if(current.sum() <= previous.sum())
+    {
+        return usage;
+    }
+
+    const double elapsed = static_cast<double>(current.sum() - previous.sum());
+    // counters never go backwards except when a core is hot-plugged back, clamp instead of wrapping
+    const auto percent = [elapsed](const unsigned long long before, const unsigned long long after)
+    {
+        return after > before ? 100.0 * static_cast<double>(after - before) / elapsed : 0.0;
+    };
+    usage._user = percent(previous._user + previous._nice, current._user + current._nice);
+    usage._system = percent(previous._system, current._system);
+    usage._idle = percent(previous._idle, current._idle);
+    usage._iowait = percent(previous._iowait, current._iowait);
+    usage._irq = percent(previous._irq + previous._softirq, current._irq + current._softirq);
+    usage._steal = percent(previous._steal, current._steal);
+    return usage;
+}
+}
+
+SystemCpuSampler::SystemCpuSampler(const std::filesystem::path& statPath)
+    : _statPath(statPath), _readBuffer(kInitialReadBuffer)
+{
+    const long configuredCores = ::sysconf(_SC_NPROCESSORS_CONF);
+    const std::size_t cores = configuredCores > 0 ? static_cast<std::size_t>(configuredCores) : 1u;
+    _previousCores.resize(cores);
+    _cores.resize(cores);
+    _coreSeen.resize(cores);
+}
+
+bool SystemCpuSampler::sample()
+{
+    ssize_t bytes = utils::procfs::readFile(_statPath.c_str(), _readBuffer.data(), _readBuffer.size());
+    // a full buffer may be a truncated file, grow once and read again (irq heavy hosts)
+    while(bytes == static_cast<ssize_t>(_readBuffer.size()))
+    {
+        _readBuffer.resize(_readBuffer.size() * 2);
+        bytes = utils::procfs::readFile(_statPath.c_str(), _readBuffer.data(), _readBuffer.size());
+    }
+    if(bytes <= 0)
+    {
+        WARNING("System CPU usage cannot be sampled, " << _statPath << " is unreadable");
+        return false;
+    }
+
+    parse(std::string_view(_readBuffer.data(), static_cast<std::size_t>(bytes)));
+    ++_samples;
+    return true;
+}
+
+void SystemCpuSampler::parse(std::string_view content)
+{
+    const unsigned long long sampleNumber = _samples + 1u;
+    std::size_t lineStart{0u};
+    while(lineStart < content.size())
+    {
+        std::size_t lineEnd = content.find('\n', lineStart);
+        if(lineEnd == std::string_view::npos)
+        {
+            lineEnd = content.size();
+        }
+        const std::string_view line = content.substr(lineStart, lineEnd - lineStart);
+        lineStart = lineEnd + 1;
+
+        std::size_t position{0u};
+        long core{-1};
+        if(!parseCpuLabel(line, position, core))
+        {
+            // the cpu lines come first and together, nothing left to look at after them
+            if(line.compare(0, 3, "cpu") != 0)
+            {
+                break;
+            }
+            continue;
+        }
+
+        const CpuTimes times = parseTimes(line, position);
+        if(core < 0)
+        {
+            _total = _samples > 0u ? usageBetween(_previousTotal, times) : CpuUsage();
+            _previousTotal = times;
+            continue;
+        }
+
+        const std::size_t index = static_cast<std::size_t>(core);
+        if(index >= _cores.size())
+        {
+            _cores.resize(index + 1u);
+            _previousCores.resize(index + 1u);
+            _coreSeen.resize(index + 1u);
+        }
+        // a core back online has no previous counters to compare with
+        _cores[index] = _samples > 0u && _coreSeen[index] == _samples ? usageBetween(_previousCores[index], times) : CpuUsage();
+        _previousCores[index] = times;
+        _coreSeen[index] = sampleNumber;
+    }
+
+    // offline cores aren't listed, they don't keep the usage they had before
+    for(std::size_t index=0; index<_cores.size(); ++index)
+    {
+        if(_coreSeen[index] != sampleNumber)
+        {
+            _cores[index] = CpuUsage();
+        }
+    }
+}
+
+std::string renderCpuBars(const std::vector<CpuUsage>& cores, const uint barWidth)
+{
+    std::string bars;
+    char label[32];
+    for(std::size_t core=0; core<cores.size(); ++core)
+    {
+        const double busy = std::clamp(cores[core].busy(), 0.0, 100.0);
+        const uint filled = static_cast<uint>(busy / 100.0 * barWidth + 0.5);
+
+        char* end = std::to_chars(label, label + sizeof(label), core).ptr;
+        bars.append(std::max<std::ptrdiff_t>(0, 3 - (end - label)), ' ');
+        bars.append(label, end);
+        bars += " [";
+        bars.append(filled, '|');
+        bars.append(barWidth - filled, ' ');
+        bars += "] ";
+
+        end = std::to_chars(label, label + sizeof(label), busy, std::chars_format::fixed, 1).ptr;
+        bars.append(std::max<std::ptrdiff_t>(0, 5 - (end - label)), ' ');
+        bars.append(label, end);
+        bars += "%\n";
+    }
+    return bars;
+}
+
+std::string renderCpuHeatmap(const std::vector<CpuUsage>& cores, const uint perRow)
+{
+    std::string heatmap;
+    char label[32];
+    const std::size_t levels = sizeof(kHeatmapLevels) - 2u; // last index, without the '\0'
+    // no row of 0 cores, it would never get past the first one
+    const std::size_t columns = std::max(perRow, 1u);
+    for(std::size_t rowStart=0; rowStart<cores.size(); rowStart+=columns)
+    {
+        // the row label is the first core of the row, so a glyph can be mapped back to its' core
+        char* end = std::to_chars(label, label + sizeof(label), rowStart).ptr;
+        heatmap.append(std::max<std::ptrdiff_t>(0, 4 - (end - label)), ' ');
+        heatmap.append(label, end);
+        heatmap += " |";
+        for(std::size_t core=rowStart; core<std::min(cores.size(), rowStart + columns); ++core)
+        {
+            const double busy = std::clamp(cores[core].busy(), 0.0, 100.0);
+            heatmap += kHeatmapLevels[static_cast<std::size_t>(busy / 100.0 * levels + 0.5)];
+        }
+        heatmap += "|\n";
+    }
+    return heatmap;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,194 @@
+#include <SystemMemorySampler.hpp>
+#include <LogTrace.hpp>
+#include <ProcFile.hpp>
+
+#include <algorithm>
+#include <charconv>
+
+namespace proc
+{
+namespace
+{
+static constexpr double kKbPerGb = 1024.0 * 1024.0;
+
+// value following `label` (eg. "avg10=") in a PSI line
+template<class Number>
+void parsePressureField(std::string_view line, std::string_view label, Number& value)
+{
+    const std::size_t position = line.find(label);
+    if(position != std::string_view::npos)
+    {
+        const char* begin = line.data() + position + label.size();
+        std::from_chars(begin, line.data() + line.size(), value);
+    }
+}
+
+void appendFixed(std::string& text, const double value, const int precision)
+{
+    char number[64];
+    char* end = std::to_chars(number, number + sizeof(number), value, std::chars_format::fixed, precision).ptr;
+    text.append(number, end);
+}
+}
+
+const std::vector<std::string> SystemMemorySampler::kDefaultKeys{
+    "MemTotal", "MemAvailable", "MemFree", "Buffers", "Cached", "SwapTotal", "SwapFree", "SwapCached", "Dirty", "Writeback"
+};
+
+SystemMemorySampler::SystemMemorySampler(const std::filesystem::path& procRoot, const std::vector<std::string>& keys)
+    : _procRoot(procRoot), _meminfoPath((procRoot / "meminfo").string()), _keys{"MemTotal", "MemAvailable"}
+{
+    for(const std::string& key : keys)
+    {
+        if(std::find(_keys.begin(), _keys.end(), key) == _keys.end())
+        {
+            _keys.push_back(key);
+        }
+    }
+    _values.assign(_keys.size(), 0u);
+    _found.assign(_keys.size(), false);
+}
+
+bool SystemMemorySampler::sample()
+{
+    const ssize_t bytes = utils::procfs::readFile(_meminfoPath.c_str(), _readBuffer.data(), _readBuffer.size());
+    if(bytes <= 0)
+    {
+        WARNING("System memory cannot be sampled, " << _meminfoPath << " is unreadable");
+        return false;
+    }
+    parseMeminfo(std::string_view(_readBuffer.data(), static_cast<std::size_t>(bytes)));
+
+    samplePressure(PressureResource::Cpu, "pressure/cpu");
+    samplePressure(PressureResource::Memory, "pressure/memory");
+    samplePressure(PressureResource::Io, "pressure/io");
+    return true;
+}
+
+// "Cached:          1671052 kB" ; every line is looked at once, the key list being a handful of entries
+void SystemMemorySampler::parseMeminfo(std::string_view content)
+{
+    std::fill(_found.begin(), _found.end(), false);
+    std::size_t remaining = _keys.size();
+
+    std::size_t lineStart{0u};
+    while(lineStart < content.size() && remaining > 0u)
+    {
+        std::size_t lineEnd = content.find('\n', lineStart);
+        if(lineEnd == std::string_view::npos)
+        {
+            lineEnd = content.size();
+        }
+        const std::string_view line = content.substr(lineStart, lineEnd - lineStart);
+        lineStart = lineEnd + 1;
+
+        const std::size_t colon = line.find(':');
+        if(colon == std::string_view::npos)
+        {
+            continue;
+        }
+        const std::string_view key = line.substr(0, colon);
+        for(std::size_t slot=0; slot<_keys.size(); ++slot)
+        {
+            if(!_found[slot] && key == _keys[slot])
+            {
+                _found[slot] = utils::procfs::parseUnsigned(line.substr(colon + 1), _values[slot]);
+                remaining -= _found[slot] ? 1u : 0u;
+                break;
+            }
+        }
+    }
+}
+
+void SystemMemorySampler::samplePressure(const PressureResource resource, const char* fileName)
+{
+    PressureStats& pressure = _pressure[static_cast<std::size_t>(resource)];
+    const ssize_t bytes = utils::procfs::readFile((_procRoot / fileName).c_str(), _readBuffer.data(), _readBuffer.size());
+    pressure = PressureStats();
+    if(bytes <= 0)
+    {
+        return;
+    }
+
+    const std::string_view content(_readBuffer.data(), static_cast<std::size_t>(bytes));
+    const std::size_t fullStart = content.find("full ");
+    const std::string_view some = content.substr(0, fullStart);
+    parsePressureField(some, "avg10=", pressure._someAvg10);
+    parsePressureField(some, "avg60=", pressure._someAvg60);
+    parsePressureField(some, "avg300=", pressure._someAvg300);
+    parsePressureField(some, "total=", pressure._someTotalUs);
+    if(fullStart != std::string_view::npos)
+    {
+        const std::string_view full = content.substr(fullStart);
+        parsePressureField(full, "avg10=", pressure._fullAvg10);
+        parsePressureField(full, "avg60=", pressure._fullAvg60);
+        parsePressureField(full, "avg300=", pressure._fullAvg300);
+        parsePressureField(full, "total=", pressure._fullTotalUs);
+    }
+    pressure._available = content.compare(0, 5, "some ") == 0;
+}
+
+bool SystemMemorySampler::getKb(std::string_view key, unsigned long long& kb) const
+{
+    for(std::size_t slot=0; slot<_keys.size(); ++slot)
+    {
+        if(_keys[slot] == key)
+        {
+            kb = _values[slot];
+            return _found[slot];
+        }
+    }
+    return false;
+}
+
+unsigned long long SystemMemorySampler::getUsedKb() const
+{
+    const unsigned long long total = _values[kMemTotalSlot];
+    const unsigned long long available = _values[kMemAvailableSlot];
+    return _found[kMemAvailableSlot] && available <= total ? total - available : 0u;
+}
+
+double SystemMemorySampler::getUsedPercent() const
+{
+    return getTotalKb() > 0u ? 100.0 * static_cast<double>(getUsedKb()) / static_cast<double>(getTotalKb()) : 0.0;
+}
+
+std::string renderMemoryUsage(const SystemMemorySampler& memorySampler)
+{
+    std::string usage;
+    appendFixed(usage, static_cast<double>(memorySampler.getUsedKb()) / kKbPerGb, 1);
+    usage += '/';
+    appendFixed(usage, static_cast<double>(memorySampler.getTotalKb()) / kKbPerGb, 1);
+    usage += " GB used (";
+    appendFixed(usage, memorySampler.getUsedPercent(), 1);
+    usage += "%)";
+    return usage;
+}
+
+std::string renderPressure(const SystemMemorySampler& memorySampler)
+{
+    static constexpr std::pair<PressureResource, const char*> kResources[] = {
+        {PressureResource::Cpu, "cpu "}, {PressureResource::Memory, "memory "}, {PressureResource::Io, "io "}
+    };
+
+    std::string pressure;
+    for(const auto& [resource, name] : kResources)
+    {
+        if(!pressure.empty())
+        {
+            pressure += " | ";
+        }
+        pressure += name;
+        const PressureStats& stats = memorySampler.getPressure(resource);
+        if(!stats._available)
+        {
+            pressure += "n/a";
+            continue;
+        }
+        appendFixed(pressure, stats._someAvg10, 2);
+        pressure += '%';
+    }
+    return pressure;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,449 @@
+#include <BatchFileReader.hpp>
+#include <LogTrace.hpp>
+#include <ProcFile.hpp>
+#include <Profiler.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace utils
+{
+namespace procfs
+{
+namespace
+{
+// user_data of a completion : index of the file in the chunk, the low bit tells the close apart from the open/read
+static constexpr std::uint64_t kCloseTag = 1u;
+// failed io_uring_enter calls after which the requests in flight aren't waited for anymore
+static constexpr unsigned kMaxEnterFailures = 3u;
+
+int ioUringSetup(const unsigned entries, io_uring_params* params)
+{
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+int ioUringEnter(const int ringFd, const unsigned toSubmit, const unsigned minComplete, const unsigned flags)
+{
+    return static_cast<int>(::syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+int ioUringRegister(const int ringFd, const unsigned opcode, void* argument, const unsigned count)
+{
+    return static_cast<int>(::syscall(__NR_io_uring_register, ringFd, opcode, argument, count));
+}
+
+// open, read and close one file after another
+void readRange(const PathList& paths, const std::size_t first, const std::size_t count, std::vector<char>& buffer,
+    std::uint64_t& syscalls, const FileConsumer& consumer)
+{
+    for(std::size_t index=first; index<first + count; ++index)
+    {
+        ssize_t bytes;
+        {
+            PROFILE_SCOPE(StatRead);
+            bytes = readFile(paths[index].c_str(), buffer.data(), buffer.size());
+        }
+        const int error = bytes < 0 ? errno : 0;
+        // open, read, close ; only the open when the file is gone
+        syscalls += bytes < 0 && error == ENOENT ? 1u : 3u;
+        consumer(index, bytes < 0 ? std::string_view() : std::string_view(buffer.data(), static_cast<std::size_t>(bytes)), error);
+    }
+}
+
+// io_uring_enter until `pending` completions went to `onCompletion`, the last `toSubmit` entries queued being
+// submitted on the way. On a failure (EINTR aside) the entries not submitted yet are taken back, each handed to
+// `onRetracted`, and the ones in flight are still waited for without submitting anything. Returns the errno of the
+// first failure, 0 when none ; `drained` is false when requests are left in flight
+template<class Ring, class OnCompletion, class OnRetracted>
+int submitAndWait(Ring& ring, unsigned toSubmit, unsigned pending, std::uint64_t& syscalls, bool& drained,
+    OnCompletion&& onCompletion, OnRetracted&& onRetracted)
+{
+    int error{0};
+    unsigned failures{0u};
+    while(pending > 0u)
+    {
+        int entered;
+        {
+            PROFILE_SCOPE(StatRead);
+            entered = ioUringEnter(ring._fd, toSubmit, pending, IORING_ENTER_GETEVENTS);
+        }
+        ++syscalls;
+        if(entered < 0 && errno != EINTR)
+        {
+            error = error == 0 ? errno : error;
+            // one completion each, none of them will come
+            pending -= toSubmit;
+            ring.retract(toSubmit, onRetracted);
+            toSubmit = 0u;
+            if(++failures >= kMaxEnterFailures)
+            {
+                pending -= ring.reap(onCompletion);
+                break;
+            }
+        }
+        else if(entered > 0)
+        {
+            toSubmit -= std::min<unsigned>(toSubmit, static_cast<unsigned>(entered));
+        }
+        pending -= ring.reap(onCompletion);
+    }
+    drained = pending == 0u;
+    return error;
+}
+}
+
+bool parseIoBackend(std::string_view text, IoBackend& backend)
+{
+    if(text == "auto")
+    {
+        backend = IoBackend::Auto;
+    }
+    else if(text == "sync")
+    {
+        backend = IoBackend::Sync;
+    }
+    else if(text == "uring" || text == "io_uring")
+    {
+        backend = IoBackend::IoUring;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+void SyncFileReader::readAll(const PathList& paths, const FileConsumer& consumer)
+{
+    readRange(paths, 0u, paths.size(), _buffer, _syscalls, consumer);
+}
+
+// the three rings shared with the kernel
+struct IoUringFileReader::Ring
+{
+    ~Ring()
+    {
+        if(_sqes != MAP_FAILED)
+        {
+            ::munmap(_sqes, _sqesSize);
+        }
+        if(_cqRing != MAP_FAILED && _cqRing != _sqRing)
+        {
+            ::munmap(_cqRing, _cqRingSize);
+        }
+        if(_sqRing != MAP_FAILED)
+        {
+            ::munmap(_sqRing, _sqRingSize);
+        }
+        if(_fd >= 0)
+        {
+            ::close(_fd);
+        }
+    }
+
+    bool map(const io_uring_params& params)
+    {
+        _sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        _cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0u;
+        if(singleMmap)
+        {
+            _sqRingSize = _cqRingSize = std::max(_sqRingSize, _cqRingSize);
+        }
+
+        _sqRing = ::mmap(nullptr, _sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQ_RING);
+        if(_sqRing == MAP_FAILED)
+        {
+            return false;
+        }
+        _cqRing = singleMmap ? _sqRing :
+            ::mmap(nullptr, _cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_CQ_RING);
+        _sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        _sqes = ::mmap(nullptr, _sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQES);
+        if(_cqRing == MAP_FAILED || _sqes == MAP_FAILED)
+        {
+            return false;
+        }
+
+        char* sq = static_cast<char*>(_sqRing);
+        _sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        _sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        _sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        char* cq = static_cast<char*>(_cqRing);
+        _cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        _cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        _cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        _cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    bool supports(std::initializer_list<unsigned> opcodes)
+    {
+        std::vector<char> storage(sizeof(io_uring_probe) + 256u * sizeof(io_uring_probe_op), 0);
+        io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(storage.data());
+        if(ioUringRegister(_fd, IORING_REGISTER_PROBE, probe, 256u) < 0)
+        {
+            return false;
+        }
+        for(const unsigned opcode : opcodes)
+        {
+            if(opcode > probe->last_op || (probe->ops[opcode].flags & IO_URING_OP_SUPPORTED) == 0u)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // the kernel only looks at the new tail once io_uring_enter is called
+    io_uring_sqe& nextSqe()
+    {
+        const unsigned tail = *_sqTail;
+        const unsigned slot = tail & _sqMask;
+        io_uring_sqe& sqe = static_cast<io_uring_sqe*>(_sqes)[slot];
+        std::memset(&sqe, 0, sizeof(sqe));
+        _sqArray[slot] = slot;
+        __atomic_store_n(_sqTail, tail + 1u, __ATOMIC_RELEASE);
+        return sqe;
+    }
+
+    // the last `count` entries queued, never submitted, are taken back (the kernel only reads up to the tail it is
+    // given on io_uring_enter), `onRetracted` getting the user_data of each
+    template<class OnRetracted>
+    void retract(const unsigned count, OnRetracted&& onRetracted)
+    {
+        const unsigned tail = *_sqTail;
+        for(unsigned entry=tail - count; entry != tail; ++entry)
+        {
+            onRetracted(static_cast<io_uring_sqe*>(_sqes)[_sqArray[entry & _sqMask]].user_data);
+        }
+        __atomic_store_n(_sqTail, tail - count, __ATOMIC_RELEASE);
+    }
+
+    template<class OnCompletion>
+    unsigned reap(OnCompletion&& onCompletion)
+    {
+        unsigned head = *_cqHead;
+        const unsigned tail = __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE);
+        unsigned reaped{0u};
+        for(; head != tail; ++head, ++reaped)
+        {
+            const io_uring_cqe& cqe = _cqes[head & _cqMask];
+            onCompletion(cqe.user_data, cqe.res);
+        }
+        __atomic_store_n(_cqHead, head, __ATOMIC_RELEASE);
+        return reaped;
+    }
+
+    int _fd{-1};
+    void* _sqRing{MAP_FAILED};
+    void* _cqRing{MAP_FAILED};
+    void* _sqes{MAP_FAILED};
+    std::size_t _sqRingSize{0u};
+    std::size_t _cqRingSize{0u};
+    std::size_t _sqesSize{0u};
+    unsigned* _sqTail{nullptr};
+    unsigned _sqMask{0u};
+    unsigned* _sqArray{nullptr};
+    unsigned* _cqHead{nullptr};
+    unsigned* _cqTail{nullptr};
+    unsigned _cqMask{0u};
+    io_uring_cqe* _cqes{nullptr};
+};
+
+std::unique_ptr<IoUringFileReader> IoUringFileReader::create()
+{
+    std::unique_ptr<Ring> ring = std::make_unique<Ring>();
+    io_uring_params params{};
+    // every file of a chunk has its' read and close queued at once
+    ring->_fd = ioUringSetup(2u * kQueueDepth, &params);
+    if(ring->_fd < 0)
+    {
+        NOTIFY("io_uring is not available (" << std::strerror(errno) << "), /proc files will be read synchronously");
+        return nullptr;
+    }
+    if(!ring->map(params) || !ring->supports({IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_CLOSE}))
+    {
+        NOTIFY("io_uring lacks openat/read/close on this kernel, /proc files will be read synchronously");
+        return nullptr;
+    }
+    return std::unique_ptr<IoUringFileReader>(new IoUringFileReader(std::move(ring)));
+}
+
+IoUringFileReader::IoUringFileReader(std::unique_ptr<Ring> ring)
+    : _ring(std::move(ring)), _fds(kQueueDepth, -1), _reported(kQueueDepth, false), _buffers(kQueueDepth * kMaxFileSize)
+{
+}
+
+IoUringFileReader::~IoUringFileReader() = default;
+
+void IoUringFileReader::readAll(const PathList& paths, const FileConsumer& consumer)
+{
+    for(std::size_t first=0; first<paths.size(); first+=kQueueDepth)
+    {
+        const std::size_t count = std::min<std::size_t>(kQueueDepth, paths.size() - first);
+        if(_abandoned)
+        {
+            readRange(paths, first, count, _syncBuffer, _syscalls, consumer);
+            continue;
+        }
+        readChunk(paths, first, count, consumer);
+    }
+}
+
+// 1. every open of the chunk in one submission, waiting for all of them
+// 2. a read linked to a close per opened file in a second one, the reads being handed to the consumer straight
+//    from the completion ring (no copy). Waiting for the whole batch rather than the first completion matters :
+//    procfs reads are mostly punted to the io-wq workers and would otherwise come back one enter at a time
+void IoUringFileReader::readChunk(const PathList& paths, const std::size_t first, const std::size_t count, const FileConsumer& consumer)
+{
+    Ring& ring = *_ring;
+    std::fill(_fds.begin(), _fds.begin() + static_cast<std::ptrdiff_t>(count), -1);
+    std::fill(_reported.begin(), _reported.begin() + static_cast<std::ptrdiff_t>(count), false);
+    for(std::size_t slot=0; slot<count; ++slot)
+    {
+        io_uring_sqe& sqe = ring.nextSqe();
+        sqe.opcode = IORING_OP_OPENAT;
+        sqe.fd = AT_FDCWD;
+        sqe.addr = reinterpret_cast<std::uint64_t>(paths[first + slot].c_str());
+        sqe.open_flags = O_RDONLY | O_CLOEXEC;
+        sqe.user_data = slot << 1u;
+    }
+
+    std::size_t opened{0u};
+    bool drained{true};
+    int error = submitAndWait(ring, static_cast<unsigned>(count), static_cast<unsigned>(count), _syscalls, drained,
+        [this, first, &consumer, &opened](const std::uint64_t userData, const int result)
+        {
+            const std::size_t slot = userData >> 1u;
+            _fds[slot] = result;
+            if(result < 0)
+            {
+                _reported[slot] = true;
+                consumer(first + slot, std::string_view(), -result);
+                return;
+            }
+            ++opened;
+        },
+        // an open taken back leaves its' file unopened, failed with the others
+        [](const std::uint64_t) {});
+    if(error != 0)
+    {
+        ERROR("io_uring_enter failed while opening " << count << " files : " << std::strerror(error));
+        // nothing was queued for the files opened
+        for(std::size_t slot=0; slot<count; ++slot)
+        {
+            if(_fds[slot] >= 0)
+            {
+                ::close(_fds[slot]);
+                ++_syscalls;
+                _fds[slot] = -1;
+            }
+        }
+        failChunk(first, count, error, drained, consumer);
+        return;
+    }
+
+    for(std::size_t slot=0; slot<count; ++slot)
+    {
+        if(_fds[slot] < 0)
+        {
+            continue;
+        }
+        io_uring_sqe& read = ring.nextSqe();
+        read.opcode = IORING_OP_READ;
+        read.fd = _fds[slot];
+        read.addr = reinterpret_cast<std::uint64_t>(_buffers.data() + slot * kMaxFileSize);
+        read.len = static_cast<std::uint32_t>(kMaxFileSize);
+        read.off = 0u;
+        // a hard link : a short read (the usual case, the buffer being bigger than the file) breaks a plain link
+        // and would cancel the close
+        read.flags = IOSQE_IO_HARDLINK;
+        read.user_data = slot << 1u;
+
+        io_uring_sqe& close = ring.nextSqe();
+        close.opcode = IORING_OP_CLOSE;
+        close.fd = _fds[slot];
+        close.user_data = (slot << 1u) | kCloseTag;
+    }
+
+    const unsigned pending = static_cast<unsigned>(2u * opened);
+    error = submitAndWait(ring, pending, pending, _syscalls, drained,
+        [this, first, &consumer](const std::uint64_t userData, const int result)
+        {
+            const std::size_t slot = userData >> 1u;
+            if((userData & kCloseTag) != 0u)
+            {
+                // the close never ran (ring torn down, ...), the descriptor is then closed by hand
+                if(result == -ECANCELED)
+                {
+                    ::close(_fds[slot]);
+                    ++_syscalls;
+                }
+                _fds[slot] = -1;
+                return;
+            }
+            _reported[slot] = true;
+            consumer(first + slot, result < 0 ? std::string_view() :
+                std::string_view(_buffers.data() + slot * kMaxFileSize, static_cast<std::size_t>(result)), result < 0 ? -result : 0);
+        },
+        [this](const std::uint64_t userData)
+        {
+            // a close that never reached the kernel (its' read may have, the read holds the file on its' own)
+            if((userData & kCloseTag) != 0u)
+            {
+                const std::size_t slot = userData >> 1u;
+                ::close(_fds[slot]);
+                ++_syscalls;
+                _fds[slot] = -1;
+            }
+        });
+    if(error != 0)
+    {
+        ERROR("io_uring_enter failed while reading files : " << std::strerror(error));
+        failChunk(first, count, error, drained, consumer);
+    }
+}
+
+void IoUringFileReader::failChunk(const std::size_t first, const std::size_t count, const int error, const bool drained, const FileConsumer& consumer)
+{
+    for(std::size_t slot=0; slot<count; ++slot)
+    {
+        if(!_reported[slot])
+        {
+            _reported[slot] = true;
+            consumer(first + slot, std::string_view(), error);
+        }
+    }
+    if(!drained)
+    {
+        // the closes still in flight are left to the kernel, closing their descriptors by hand could close a reused one
+        ERROR("io_uring left with requests in flight, /proc files will be read synchronously from now on");
+        _abandoned = true;
+        _syncBuffer.resize(kMaxFileSize);
+    }
+}
+
+std::unique_ptr<BatchFileReader> makeBatchFileReader(const IoBackend backend)
+{
+    if(backend == IoBackend::Sync)
+    {
+        return std::make_unique<SyncFileReader>();
+    }
+
+    std::unique_ptr<BatchFileReader> reader = IoUringFileReader::create();
+    if(reader == nullptr && backend == IoBackend::Auto)
+    {
+        return std::make_unique<SyncFileReader>();
+    }
+    return reader;
+}
+
+}
+}
\ No newline at end of file
@@ -0,0 +1,170 @@
+#include <EventLoop.hpp>
+#include <Exception.hpp>
+#include <LogTrace.hpp>
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <unistd.h>
+
+namespace utils
+{
+namespace
+{
+// the epoll data of a source, the fd is known from the Source itself
+inline std::uint64_t tag(const EventLoop::Source source)
+{
+    return static_cast<std::uint64_t>(source);
+}
+
+[[noreturn]] void fail(const char* what)
+{
+    throw SeverityException<SeriousException>(std::string(what) + " : " + std::strerror(errno));
+}
+}
+
+EventLoop::EventLoop()
+    : _epoll(::epoll_create1(EPOLL_CLOEXEC)), _wakeup(::eventfd(0u, EFD_NONBLOCK | EFD_CLOEXEC))
+{
+    if(!_epoll.valid() || !_wakeup.valid())
+    {
+        fail("Cannot create the event loop");
+    }
+    add(_wakeup.get(), Source::Wakeup);
+}
+
+EventLoop::~EventLoop()
+{
+    if(!_blockedSignals.empty())
+    {
+        sigset_t mask;
+        sigemptyset(&mask);
+        for(const int signal : _blockedSignals)
+        {
+            sigaddset(&mask, signal);
+        }
+        ::pthread_sigmask(SIG_UNBLOCK, &mask, nullptr);
+    }
+}
+
+void EventLoop::add(const int fd, const Source source)
+{
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = tag(source);
+    if(::epoll_ctl(_epoll.get(), EPOLL_CTL_ADD, fd, &event) != 0)
+    {
+        fail("Cannot watch a file descriptor of the event loop");
+    }
+}
+
+void EventLoop::watchInput(const int fd)
+{
+    _input = fd;
+    add(fd, Source::Input);
+}
+
+void EventLoop::unwatchInput()
+{
+    if(_input >= 0)
+    {
+        ::epoll_ctl(_epoll.get(), EPOLL_CTL_DEL, _input, nullptr);
+        _input = -1;
+    }
+}
+
+void EventLoop::watchSignals(std::initializer_list<int> signals)
+{
+    sigset_t mask;
+    sigemptyset(&mask);
+    for(const int signal : signals)
+    {
+        sigaddset(&mask, signal);
+        _blockedSignals.push_back(signal);
+    }
+    // blocked, otherwise the default disposition would act before the signalfd gets to read them
+    ::pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+
+    const bool created = !_signals.valid();
+    const int fd = ::signalfd(_signals.valid() ? _signals.get() : -1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if(fd < 0)
+    {
+        fail("Cannot create the signalfd");
+    }
+    if(created)
+    {
+        _signals.reset(fd);
+        add(_signals.get(), Source::Signal);
+    }
+}
+
+void EventLoop::watchFile(const int fd)
+{
+    add(fd, Source::File);
+}
+
+void EventLoop::unwatchFile(const int fd)
+{
+    ::epoll_ctl(_epoll.get(), EPOLL_CTL_DEL, fd, nullptr);
+}
+
+void EventLoop::wakeup()
+{
+    const std::uint64_t one{1u};
+    if(::write(_wakeup.get(), &one, sizeof(one)) != sizeof(one))
+    {
+        WARNING("Event loop wakeup lost : " << std::strerror(errno));
+    }
+}
+
+std::size_t EventLoop::wait(std::vector<Event>& events, const int timeoutMs)
+{
+    events.clear();
+    epoll_event ready[4];
+    int count = ::epoll_wait(_epoll.get(), ready, 4, timeoutMs);
+    while(count < 0 && errno == EINTR)
+    {
+        count = ::epoll_wait(_epoll.get(), ready, 4, timeoutMs);
+    }
+    if(count < 0)
+    {
+        fail("Event loop wait failed");
+    }
+
+    for(int index=0; index<count; ++index)
+    {
+        const Source source = static_cast<Source>(ready[index].data.u64);
+        switch(source)
+        {
+            case Source::Input :
+            case Source::File :
+                events.push_back(Event{source});
+                break;
+            case Source::Wakeup :
+            {
+                // an 8 bytes counter, reset by the read
+                std::uint64_t counter{0u};
+                if(::read(_wakeup.get(), &counter, sizeof(counter)) == sizeof(counter))
+                {
+                    events.push_back(Event{source, 0, counter});
+                }
+                break;
+            }
+            case Source::Signal :
+            {
+                signalfd_siginfo info;
+                while(::read(_signals.get(), &info, sizeof(info)) == sizeof(info))
+                {
+                    events.push_back(Event{source, static_cast<int>(info.ssi_signo)});
+                }
+                break;
+            }
+        }
+    }
+    return events.size();
+}
+}
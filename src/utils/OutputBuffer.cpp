@@ -0,0 +1,139 @@
+#include <OutputBuffer.hpp>
+#include <Exception.hpp>
+#include <LogTrace.hpp>
+
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <unistd.h>
+
+namespace utils
+{
+namespace
+{
+// biggest representation appendFixed can produce : sign + 309 integral digits of DBL_MAX + '.' + decimals
+static constexpr std::size_t kMaxFixedChars = 330u;
+static constexpr std::size_t kMaxIntegerChars = 24u;
+}
+
+OutputBuffer::OutputBuffer(const int fd, const std::size_t capacity)
+    : _buffer(capacity < kMaxFixedChars * 2 ? kMaxFixedChars * 2 : capacity), _fd(fd)
+{
+}
+
+OutputBuffer::~OutputBuffer()
+{
+    try
+    {
+        flush();
+    }
+    catch(const std::exception& e)
+    {
+        ERROR("Output buffer lost its' pending bytes on destruction : " << e.what());
+    }
+}
+
+char* OutputBuffer::reserveTail(const std::size_t bytes)
+{
+    if(_size + bytes <= _buffer.size())
+    {
+        return _buffer.data() + _size;
+    }
+
+    if(_fd >= 0)
+    {
+        flush();
+        if(bytes <= _buffer.size())
+        {
+            return _buffer.data();
+        }
+    }
+
+    // memory backed buffer (or a single gigantic append) : grow geometrically
+    std::size_t newCapacity = _buffer.size() * 2;
+    while(newCapacity < _size + bytes)
+    {
+        newCapacity *= 2;
+    }
+    _buffer.resize(newCapacity);
+    return _buffer.data() + _size;
+}
+
+void OutputBuffer::append(const char c)
+{
+    *reserveTail(1) = c;
+    ++_size;
+}
+
+void OutputBuffer::append(std::string_view text)
+{
+    std::memcpy(reserveTail(text.size()), text.data(), text.size());
+    _size += text.size();
+}
+
+void OutputBuffer::appendUint(const std::uint64_t value)
+{
+    char* tail = reserveTail(kMaxIntegerChars);
+    _size += std::to_chars(tail, tail + kMaxIntegerChars, value).ptr - tail;
+}
+
+void OutputBuffer::appendInt(const std::int64_t value)
+{
+    char* tail = reserveTail(kMaxIntegerChars);
+    _size += std::to_chars(tail, tail + kMaxIntegerChars, value).ptr - tail;
+}
+
+void OutputBuffer::appendUintPadded(const std::uint64_t value, const unsigned width)
+{
+    char digits[kMaxIntegerChars];
+    const std::size_t length = std::to_chars(digits, digits + kMaxIntegerChars, value).ptr - digits;
+    const std::size_t padding = width > length ? width - length : 0u;
+
+    char* tail = reserveTail(padding + length);
+    std::memset(tail, '0', padding);
+    std::memcpy(tail + padding, digits, length);
+    _size += padding + length;
+}
+
+void OutputBuffer::appendFixed(const double value, const int precision)
+{
+    char* tail = reserveTail(kMaxFixedChars);
+    const std::to_chars_result result = std::to_chars(tail, tail + kMaxFixedChars, value, std::chars_format::fixed, precision);
+    if(result.ec != std::errc())
+    {
+        throw SeverityException<ModerateException>("Value cannot be rendered in fixed notation with the requested precision");
+    }
+    _size += result.ptr - tail;
+}
+
+void OutputBuffer::flush()
+{
+    if(_fd < 0)
+    {
+        return;
+    }
+
+    std::size_t written{0};
+    while(written < _size)
+    {
+        const ssize_t chunk = ::write(_fd, _buffer.data() + written, _size - written);
+        if(chunk < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            _size = 0;
+            throw SeverityException<SeriousException>(std::string("Flushing the output buffer failed : ") + std::strerror(errno));
+        }
+        written += static_cast<std::size_t>(chunk);
+    }
+    _size = 0;
+}
+
+void OutputBuffer::clear()
+{
+    _size = 0;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,23 @@
+#include <PidTable.hpp>
+#include <ProcFile.hpp>
+
+namespace utils
+{
+namespace
+{
+// PID_MAX_LIMIT of a 64 bits kernel
+constexpr std::size_t kPidMaxLimit = 4194304u;
+}
+
+std::size_t readPidMax()
+{
+    char content[32];
+    unsigned long long pidMax{0u};
+    const ssize_t bytes = procfs::readFile("/proc/sys/kernel/pid_max", content, sizeof(content));
+    if(bytes <= 0 || !procfs::parseUnsigned(std::string_view(content, static_cast<std::size_t>(bytes)), pidMax) || pidMax == 0u)
+    {
+        return kPidMaxLimit;
+    }
+    return static_cast<std::size_t>(pidMax);
+}
+}
@@ -0,0 +1,67 @@
+#include <ProcFile.hpp>
+
+#include <cerrno>
+#include <charconv>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace utils
+{
+namespace procfs
+{
+
+ssize_t readFile(const char* path, char* buffer, const std::size_t capacity)
+{
+    const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if(fd < 0)
+    {
+        return -1;
+    }
+
+    // every file read here is a single record (seq_file single_open, sysfs attribute, sysctl) or a regular file of
+    // the test data : a read shorter than the buffer has reached the end, the read that would only see the end of
+    // file is spared. open/read/close, 3 syscalls
+    ssize_t bytes;
+    do
+    {
+        bytes = ::read(fd, buffer, capacity);
+    }
+    while(bytes < 0 && errno == EINTR);
+    // the errno of a failed read is what the caller reports, not the one of close
+    const int readError = errno;
+    ::close(fd);
+    errno = readError;
+    return bytes < 0 ? -1 : bytes;
+}
+
+bool parseUnsigned(std::string_view text, unsigned long long& value)
+{
+    std::size_t start{0u};
+    while(start < text.size() && (text[start] == ' ' || text[start] == '\t'))
+    {
+        ++start;
+    }
+    const std::from_chars_result result = std::from_chars(text.data() + start, text.data() + text.size(), value);
+    return result.ec == std::errc();
+}
+
+bool findKeyValue(std::string_view content, std::string_view key, unsigned long long& value)
+{
+    std::size_t position{0u};
+    while((position = content.find(key, position)) != std::string_view::npos)
+    {
+        const std::size_t end = position + key.size();
+        const bool startsLine = position == 0u || content[position - 1] == '\n';
+        const bool endsKey = end < content.size() && (content[end] == ' ' || content[end] == ':' || content[end] == '\t');
+        if(startsLine && endsKey)
+        {
+            const std::size_t valueStart = content[end] == ':' ? end + 1 : end;
+            return parseUnsigned(content.substr(valueStart), value);
+        }
+        position = end;
+    }
+    return false;
+}
+
+}
+}
\ No newline at end of file
@@ -0,0 +1,273 @@
+#include <Profiler.hpp>
+#include <LogTrace.hpp>
+#include <OutputBuffer.hpp>
+#include <UniqueFd.hpp>
+
+#include <cstdio>
+#include <fcntl.h>
+#include <limits>
+
+namespace utils
+{
+namespace profiling
+{
+namespace
+{
+static constexpr double kReportedQuantiles[] = {0.5, 0.9, 0.99, 0.999};
+static constexpr const char* kQuantileNames[] = {"p50_ns", "p90_ns", "p99_ns", "p999_ns"};
+
+void appendMicroseconds(OutputBuffer& out, const std::uint64_t nanoseconds)
+{
+    out.appendFixed(static_cast<double>(nanoseconds) / 1000.0, 1);
+}
+}
+
+const char* toString(const Stage stage)
+{
+    switch(stage)
+    {
+        case Stage::Scan : return "scan";
+        case Stage::DirectoryIteration : return "directory_iteration";
+        case Stage::StatRead : return "stat_read";
+        case Stage::StatParse : return "stat_parse";
+        case Stage::Calculate : return "calculate";
+        case Stage::Export : return "export";
+        case Stage::Render : return "render";
+        case Stage::Count : break;
+    }
+    return "unknown";
+}
+
+uint LatencyHistogram::bucketOf(const std::uint64_t value)
+{
+    if(value < kSubBuckets)
+    {
+        return static_cast<uint>(value);
+    }
+    const uint magnitude = 63u - static_cast<uint>(__builtin_clzll(value));
+    const uint shift = magnitude - kSubBucketBits;
+    const uint subBucket = static_cast<uint>(value >> shift) - kSubBuckets;
+    return ((shift + 1u) << kSubBucketBits) + subBucket;
+}
+
+std::uint64_t LatencyHistogram::bucketUpperBound(const uint bucket)
+{
+    if(bucket < kSubBuckets)
+    {
+        return bucket;
+    }
+    const uint shift = (bucket >> kSubBucketBits) - 1u;
+    const std::uint64_t top = kSubBuckets + (bucket & (kSubBuckets - 1u));
+    // the very last bucket ends at the top of the range
+    return shift + kSubBucketBits >= 63u && top == 2u * kSubBuckets - 1u ?
+        std::numeric_limits<std::uint64_t>::max() : ((top + 1u) << shift) - 1u;
+}
+
+// only the owning thread writes, the relaxed atomics are there so a concurrent aggregate reads whole values
+void LatencyHistogram::record(const std::uint64_t nanoseconds)
+{
+    _buckets[bucketOf(nanoseconds)].fetch_add(1u, std::memory_order_relaxed);
+    _count.fetch_add(1u, std::memory_order_relaxed);
+    _sum.fetch_add(nanoseconds, std::memory_order_relaxed);
+    if(nanoseconds < _min.load(std::memory_order_relaxed))
+    {
+        _min.store(nanoseconds, std::memory_order_relaxed);
+    }
+    if(nanoseconds > _max.load(std::memory_order_relaxed))
+    {
+        _max.store(nanoseconds, std::memory_order_relaxed);
+    }
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other)
+{
+    for(uint bucket=0; bucket<kBuckets; ++bucket)
+    {
+        _buckets[bucket].fetch_add(other._buckets[bucket].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    _count.fetch_add(other.count(), std::memory_order_relaxed);
+    _sum.fetch_add(other.sum(), std::memory_order_relaxed);
+    if(other.count() > 0u && other._min.load(std::memory_order_relaxed) < _min.load(std::memory_order_relaxed))
+    {
+        _min.store(other._min.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    if(other.max() > max())
+    {
+        _max.store(other.max(), std::memory_order_relaxed);
+    }
+}
+
+void LatencyHistogram::reset()
+{
+    for(std::atomic<std::uint64_t>& bucket : _buckets)
+    {
+        bucket.store(0u, std::memory_order_relaxed);
+    }
+    _count.store(0u, std::memory_order_relaxed);
+    _sum.store(0u, std::memory_order_relaxed);
+    _min.store(std::numeric_limits<std::uint64_t>::max(), std::memory_order_relaxed);
+    _max.store(0u, std::memory_order_relaxed);
+}
+
+std::uint64_t LatencyHistogram::percentile(const double quantile) const
+{
+    const std::uint64_t total = count();
+    if(total == 0u)
+    {
+        return 0u;
+    }
+
+    const double clamped = quantile < 0.0 ? 0.0 : (quantile > 1.0 ? 1.0 : quantile);
+    const std::uint64_t rank = std::max<std::uint64_t>(1u, static_cast<std::uint64_t>(clamped * static_cast<double>(total) + 0.5));
+    std::uint64_t seen{0u};
+    for(uint bucket=0; bucket<kBuckets; ++bucket)
+    {
+        seen += _buckets[bucket].load(std::memory_order_relaxed);
+        if(seen >= rank)
+        {
+            return std::min(bucketUpperBound(bucket), max());
+        }
+    }
+    return max();
+}
+
+Profiler& Profiler::instance()
+{
+    static Profiler profiler;
+    return profiler;
+}
+
+LatencyHistogram& Profiler::local(const Stage stage)
+{
+    thread_local ThreadProfile* threadProfile = nullptr;
+    if(threadProfile == nullptr)
+    {
+        std::lock_guard<std::mutex> lock(_threadsMutex);
+        _threads.push_back(std::make_unique<ThreadProfile>());
+        threadProfile = _threads.back().get();
+    }
+    return threadProfile->_stages[static_cast<std::size_t>(stage)];
+}
+
+void Profiler::aggregate(const Stage stage, LatencyHistogram& merged) const
+{
+    merged.reset();
+    std::lock_guard<std::mutex> lock(_threadsMutex);
+    for(const std::unique_ptr<ThreadProfile>& threadProfile : _threads)
+    {
+        merged.merge(threadProfile->_stages[static_cast<std::size_t>(stage)]);
+    }
+}
+
+// {"threads":2,"stages":{"scan":{"count":10,"sum_ns":...,"min_ns":...,"max_ns":...,"p50_ns":...,...,"per_thread":[10,0]},...}}
+std::string Profiler::toJson() const
+{
+    OutputBuffer out;
+    LatencyHistogram merged;
+    {
+        std::lock_guard<std::mutex> lock(_threadsMutex);
+        out.append("{\"threads\":");
+        out.appendUint(_threads.size());
+    }
+    out.append(",\"stages\":{");
+    for(std::size_t stage=0; stage<kStageCount; ++stage)
+    {
+        aggregate(static_cast<Stage>(stage), merged);
+        out.append(stage == 0u ? "\"" : ",\"");
+        out.append(toString(static_cast<Stage>(stage)));
+        out.append("\":{\"count\":");
+        out.appendUint(merged.count());
+        out.append(",\"sum_ns\":");
+        out.appendUint(merged.sum());
+        out.append(",\"min_ns\":");
+        out.appendUint(merged.min());
+        out.append(",\"max_ns\":");
+        out.appendUint(merged.max());
+        for(std::size_t quantile=0; quantile<std::size(kReportedQuantiles); ++quantile)
+        {
+            out.append(",\"");
+            out.append(kQuantileNames[quantile]);
+            out.append("\":");
+            out.appendUint(merged.percentile(kReportedQuantiles[quantile]));
+        }
+
+        out.append(",\"per_thread\":[");
+        std::lock_guard<std::mutex> lock(_threadsMutex);
+        for(std::size_t thread=0; thread<_threads.size(); ++thread)
+        {
+            if(thread > 0u)
+            {
+                out.append(',');
+            }
+            out.appendUint(_threads[thread]->_stages[stage].count());
+        }
+        out.append("]}");
+    }
+    out.append("}}\n");
+    return std::string(out.view());
+}
+
+// stage                     count     p50us     p99us     maxus
+std::string Profiler::renderOverlay() const
+{
+    OutputBuffer out;
+    LatencyHistogram merged;
+    out.append("stage                     count     p50us     p99us     maxus\n");
+    for(std::size_t stage=0; stage<kStageCount; ++stage)
+    {
+        aggregate(static_cast<Stage>(stage), merged);
+        const std::string_view name(toString(static_cast<Stage>(stage)));
+        out.append(name);
+        out.append(std::string_view("                         ", 26u - std::min<std::size_t>(name.size(), 25u)));
+        out.appendUint(merged.count());
+        out.append("  ");
+        appendMicroseconds(out, merged.percentile(0.5));
+        out.append("  ");
+        appendMicroseconds(out, merged.percentile(0.99));
+        out.append("  ");
+        appendMicroseconds(out, merged.max());
+        out.append('\n');
+    }
+    return std::string(out.view());
+}
+
+bool Profiler::dumpJson(const std::filesystem::path& path) const
+{
+#if !defined(SHARED_PROFILING)
+    WARNING("Profiling is compiled out (configure with -DENABLE_PROFILING=ON), the dump in " << path << " will be empty");
+#endif
+    const std::filesystem::path partial(path.string() + ".tmp");
+    {
+        UniqueFd file(::open(partial.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+        if(!file.valid())
+        {
+            ERROR("Profiling dump cannot be written in " << path);
+            return false;
+        }
+        OutputBuffer out(file.get());
+        out.append(toJson());
+        out.flush();
+    }
+    if(std::rename(partial.c_str(), path.c_str()) != 0)
+    {
+        ERROR("Profiling dump cannot be moved to " << path);
+        std::remove(partial.c_str());
+        return false;
+    }
+    return true;
+}
+
+void Profiler::reset()
+{
+    std::lock_guard<std::mutex> lock(_threadsMutex);
+    for(const std::unique_ptr<ThreadProfile>& threadProfile : _threads)
+    {
+        for(LatencyHistogram& histogram : threadProfile->_stages)
+        {
+            histogram.reset();
+        }
+    }
+}
+
+}
+}
\ No newline at end of file
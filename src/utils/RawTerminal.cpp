@@ -0,0 +1,49 @@
+#include <RawTerminal.hpp>
+#include <LogTrace.hpp>
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace utils
+{
+
+RawTerminal::RawTerminal(const int fd) : _fd(fd)
+{
+    _flags = ::fcntl(_fd, F_GETFL);
+    if(_flags >= 0)
+    {
+        ::fcntl(_fd, F_SETFL, _flags | O_NONBLOCK);
+    }
+
+    if(!::isatty(_fd) || ::tcgetattr(_fd, &_original) != 0)
+    {
+        return;
+    }
+    termios raw = _original;
+    raw.c_lflag &= ~static_cast<tcflag_t>(ICANON | ECHO | IEXTEN);
+    raw.c_iflag &= ~static_cast<tcflag_t>(IXON | ICRNL);
+    raw.c_cc[VMIN] = 0;
+    raw.c_cc[VTIME] = 0;
+    if(::tcsetattr(_fd, TCSAFLUSH, &raw) != 0)
+    {
+        WARNING("Terminal cannot be put in raw mode : " << std::strerror(errno) << ". Keys need Enter...");
+        return;
+    }
+    _raw = true;
+}
+
+RawTerminal::~RawTerminal()
+{
+    if(_raw)
+    {
+        ::tcsetattr(_fd, TCSAFLUSH, &_original);
+    }
+    if(_flags >= 0)
+    {
+        ::fcntl(_fd, F_SETFL, _flags);
+    }
+}
+
+}
@@ -0,0 +1,127 @@
+#include <StringTable.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <string>
+
+namespace utils
+{
+namespace
+{
+static constexpr std::size_t kMinSlots = 64u;
+
+bool hasControl(std::string_view text)
+{
+    return std::any_of(text.begin(), text.end(), [](const char c) { return static_cast<unsigned char>(c) < 0x20u || c == 0x7f; });
+}
+}
+
+StringTable::StringTable() : _views{std::string_view()}, _hashes{std::hash<std::string_view>{}(std::string_view())}, _slots(kMinSlots, 0u)
+{}
+
+StringTable::Id StringTable::intern(std::string_view text)
+{
+    if(text.empty())
+    {
+        return kEmpty;
+    }
+    // rare (a renamed thread, a hostile comm) : the copy only happens then
+    std::string sanitized;
+    if(hasControl(text))
+    {
+        sanitized.assign(text);
+        std::replace_if(sanitized.begin(), sanitized.end(), [](const char c) { return static_cast<unsigned char>(c) < 0x20u || c == 0x7f; }, '?');
+        text = sanitized;
+    }
+
+    const std::size_t hash = std::hash<std::string_view>{}(text);
+    std::size_t mask = _slots.size() - 1u;
+    std::size_t slot = hash & mask;
+    for(; _slots[slot] != 0u; slot = (slot + 1u) & mask)
+    {
+        const Id id = _slots[slot] - 1u;
+        if(_hashes[id] == hash && _views[id] == text)
+        {
+            return id;
+        }
+    }
+
+    // at most half full, the probes stay short
+    if(2u * (_views.size() + 1u) > _slots.size())
+    {
+        grow();
+        mask = _slots.size() - 1u;
+        for(slot = hash & mask; _slots[slot] != 0u; slot = (slot + 1u) & mask)
+        {}
+    }
+    const Id id = static_cast<Id>(_views.size());
+    _views.push_back(store(text));
+    _hashes.push_back(hash);
+    _slots[slot] = id + 1u;
+    return id;
+}
+
+bool StringTable::find(std::string_view text, Id& id) const
+{
+    if(text.empty())
+    {
+        id = kEmpty;
+        return true;
+    }
+    const std::size_t hash = std::hash<std::string_view>{}(text);
+    const std::size_t mask = _slots.size() - 1u;
+    for(std::size_t slot = hash & mask; _slots[slot] != 0u; slot = (slot + 1u) & mask)
+    {
+        const Id candidate = _slots[slot] - 1u;
+        if(_hashes[candidate] == hash && _views[candidate] == text)
+        {
+            id = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string_view StringTable::store(std::string_view text)
+{
+    char* at;
+    if(text.size() > kBlockBytes / 4u)
+    {
+        // a long command line gets a block of its' own, the current one keeps filling up
+        _blocks.push_back(std::make_unique<char[]>(text.size()));
+        at = _blocks.back().get();
+    }
+    else
+    {
+        if(_currentLeft < text.size())
+        {
+            _blocks.push_back(std::make_unique<char[]>(kBlockBytes));
+            _current = _blocks.back().get();
+            _currentLeft = kBlockBytes;
+        }
+        at = _current;
+        _current += text.size();
+        _currentLeft -= text.size();
+    }
+    std::memcpy(at, text.data(), text.size());
+    _bytes += text.size();
+    return std::string_view(at, text.size());
+}
+
+void StringTable::grow()
+{
+    _slots.assign(_slots.size() * 2u, 0u);
+    const std::size_t mask = _slots.size() - 1u;
+    // the empty string is never looked up through the index
+    for(Id id=1; id<_views.size(); ++id)
+    {
+        std::size_t slot = _hashes[id] & mask;
+        while(_slots[slot] != 0u)
+        {
+            slot = (slot + 1u) & mask;
+        }
+        _slots[slot] = id + 1u;
+    }
+}
+}
@@ -0,0 +1,41 @@
+#include <TickArena.hpp>
+#include <LogTrace.hpp>
+
+namespace utils
+{
+
+TickArena::TickArena(const std::size_t capacity) : _buffer(capacity)
+{
+    _arena.emplace(_buffer.data(), _buffer.size(), &_spill);
+}
+
+void TickArena::reset()
+{
+    if(_spill._bytes == 0u)
+    {
+        // back to the start of the buffer, no allocation involved
+        _arena->release();
+        return;
+    }
+
+    // what spilled is given back by the arena itself, then the buffer gets room for the whole last tick
+    const std::size_t capacity = _buffer.size() + 2u * _spill._bytes;
+    DEBUG("Tick arena spilled " << _spill._bytes << " bytes, growing it to " << capacity << " bytes");
+    _arena.reset();
+    _spill._bytes = 0u;
+    _buffer.assign(capacity, std::byte{0});
+    _arena.emplace(_buffer.data(), _buffer.size(), &_spill);
+}
+
+void* TickArena::SpillResource::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+    _bytes += bytes;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+}
+
+void TickArena::SpillResource::do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment)
+{
+    std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+}
+
+}
\ No newline at end of file
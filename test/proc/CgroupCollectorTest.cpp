@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+#include <CgroupCollector.hpp>
+
+#include <filesystem>
+#include <fstream>
+
+namespace proc
+{
+
+class CgroupCollectorTest : public ::testing::Test
+{
+public:
+    // the fake cgroupfs is copied aside, so the counters can move between two samples without touching the test data
+    void SetUp() override
+    {
+        _dataPath = std::filesystem::current_path().parent_path() / "test/data/CgroupCollector";
+        _scratchPath = std::filesystem::temp_directory_path() / ("CgroupCollectorTest." + std::to_string(::getpid()));
+        std::filesystem::remove_all(_scratchPath);
+        std::filesystem::copy(_dataPath, _scratchPath, std::filesystem::copy_options::recursive);
+    }
+
+    void TearDown() override
+    {
+        std::filesystem::remove_all(_scratchPath);
+    }
+
+    void rewrite(const std::filesystem::path& file, const std::string& content)
+    {
+        std::ofstream(file, std::ios::trunc) << content;
+    }
+
+    std::filesystem::path _dataPath;
+    std::filesystem::path _scratchPath;
+};
+
+TEST_F(CgroupCollectorTest, checkSample_everyCgroupWithCpuStat_sortedByPath_Ok)
+{
+    CgroupCollector collector(_scratchPath / "cgroup");
+    const std::vector<CgroupStats>& cgroups = collector.sample();
+
+    // system.slice has no cpu.stat, so it's no cgroup of ours
+    ASSERT_EQ(3u, cgroups.size());
+    ASSERT_EQ("/", cgroups[0]._path);
+    ASSERT_EQ("/kubepods", cgroups[1]._path);
+    ASSERT_EQ("/kubepods/pod1", cgroups[2]._path);
+
+    ASSERT_EQ(90000000u, cgroups[0]._usageUsec);
+    ASSERT_EQ(0u, cgroups[0]._memoryBytes);
+    ASSERT_EQ(536870912u, cgroups[1]._memoryBytes);
+    ASSERT_EQ(42u, cgroups[1]._pids);
+    ASSERT_EQ(104857600u, cgroups[2]._memoryBytes);
+    ASSERT_EQ(12u, cgroups[2]._pids);
+    ASSERT_EQ(0.0, cgroups[2]._cpu);
+}
+
+TEST_F(CgroupCollectorTest, checkSample_cpuFromUsageDelta_Ok)
+{
+    CgroupCollector collector(_scratchPath / "cgroup");
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    collector.sample(start);
+
+    // half a second of CPU in one second of wall time
+    rewrite(_scratchPath / "cgroup/kubepods/pod1/cpu.stat", "usage_usec 2500000\nuser_usec 1800000\nsystem_usec 700000\n");
+    const std::vector<CgroupStats>& cgroups = collector.sample(start + std::chrono::seconds(1));
+
+    ASSERT_EQ(3u, cgroups.size());
+    ASSERT_DOUBLE_EQ(50.0, cgroups[2]._cpu);
+    ASSERT_DOUBLE_EQ(0.0, cgroups[1]._cpu);
+}
+
+TEST_F(CgroupCollectorTest, checkMembers_procsOfOneCgroup_Ok)
+{
+    CgroupCollector collector(_scratchPath / "cgroup");
+    std::vector<uint> pids{1u};
+
+    ASSERT_TRUE(collector.members("/kubepods/pod1", pids));
+    ASSERT_EQ((std::vector<uint>{666u, 667u}), pids);
+    // no cgroup.procs in the fake root
+    ASSERT_FALSE(collector.members("/", pids));
+    ASSERT_TRUE(pids.empty());
+    ASSERT_FALSE(collector.members("/gone", pids));
+}
+
+TEST_F(CgroupCollectorTest, checkSample_removedCgroupSkipped_walkGoesOn_Ok)
+{
+    CgroupCollector collector(_scratchPath / "cgroup");
+    ASSERT_EQ(3u, collector.sample().size());
+
+    // a pod gone between two samples, its' CPU state with it
+    std::filesystem::remove_all(_scratchPath / "cgroup/kubepods/pod1");
+    const std::vector<CgroupStats>& cgroups = collector.sample();
+    ASSERT_EQ(2u, cgroups.size());
+    ASSERT_EQ("/kubepods", cgroups[1]._path);
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+#include <ChurnBench.hpp>
+#include <ChurnGenerator.hpp>
+#include <CliOptions.hpp>
+#include <Exception.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+
+namespace proc
+{
+namespace churn
+{
+
+class ChurnBenchTest : public ::testing::Test
+{
+public:
+    // the first child of `generator`, waiting for the storm to fork it
+    static const Child& firstChild(const Generator& generator)
+    {
+        const std::uint64_t deadlineNs = monotonicNs() + 2'000'000'000u;
+        while(generator.size() == 0u && monotonicNs() < deadlineNs)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return generator.at(0u);
+    }
+};
+
+TEST_F(ChurnBenchTest, checkGenerator_everyChildWrittenDownAndReaped_Ok)
+{
+    Generator generator(Config{500u, 1u, 10u});
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    generator.stop();
+
+    // 50 asked, a loaded runner forks fewer
+    ASSERT_GT(generator.size(), 10u);
+    ASSERT_EQ(0u, generator.getForkFailures());
+    for(std::size_t index=0; index<generator.size(); ++index)
+    {
+        const Child& child = generator.at(index);
+        ASSERT_GT(child._pid, 0);
+        ASSERT_NE(generator.getStormPid(), child._pid);
+        ASSERT_GT(child._reapedNs, child._forkedNs);
+    }
+    // stopping twice is harmless
+    generator.stop();
+}
+
+TEST_F(ChurnBenchTest, checkScan_youngChildWithItsThreads_Ok)
+{
+    // a single long-lived child, the rate only forks the next one in 10s
+    Generator generator(Config{1u, 3u, 5000u});
+    const Child& child = firstChild(generator);
+    ASSERT_GT(child._pid, 0);
+    // its' threads are cloned right after the fork
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    ProcessInfo collector;
+    const PidStats* stats = collector.scanProcDir().find(static_cast<uint>(child._pid));
+    ASSERT_NE(nullptr, stats);
+    ASSERT_EQ(4u, stats->_threads);
+    // just born : not dropped, and no wrap around of a slightly negative uptime
+    ASSERT_EQ(0u, stats->_timezone._hours);
+    ASSERT_EQ(0u, stats->_timezone._minutes);
+    ASSERT_LE(stats->_timezone._ms, 999u);
+}
+
+TEST_F(ChurnBenchTest, checkMeasure_noProcessMissedUnderChurn_Ok)
+{
+    const Config config{300u, 2u, 50u};
+    Generator generator(config);
+    ProcessInfo collector;
+    const Report report = measure(collector, generator, 20u, std::chrono::milliseconds(20));
+
+    ASSERT_EQ(20u, report._scans);
+    ASSERT_GT(report._spawned, 0u);
+    ASSERT_GT(report._expected, 0u);
+    ASSERT_EQ(0u, report._missed);
+    ASSERT_LE(report._p50Ms, report._p90Ms);
+    ASSERT_LE(report._p90Ms, report._p99Ms);
+    ASSERT_LE(report._p99Ms, report._maxMs);
+    ASSERT_GT(report._cpuMsPerScan, 0.0);
+    RecordProperty("p99_ms", std::to_string(report._p99Ms));
+    RecordProperty("cpu_percent", std::to_string(report._cpuPercent));
+    RecordProperty("vanished", std::to_string(report._vanished));
+    RecordProperty("forked_per_s", std::to_string(report._spawnedPerSecond));
+}
+
+TEST_F(ChurnBenchTest, checkAppendReport_oneRowPerFormat_Ok)
+{
+    Report report;
+    report._scans = 4u;
+    report._p50Ms = 1.0;
+    report._p90Ms = 2.0;
+    report._p99Ms = 3.0;
+    report._maxMs = 3.5;
+    report._expected = 200u;
+    report._missed = 1u;
+    report._vanished = 7u;
+
+    utils::OutputBuffer text;
+    appendReport(text, format::Kind::Text, Config{}, report);
+    ASSERT_NE(std::string::npos, text.view().find("Missed    : 1 of 200 processes there for a whole scan (0.500%)"));
+    ASSERT_NE(std::string::npos, text.view().find("latency p50 1.00 ms | p90 2.00 ms | p99 3.00 ms | max 3.50 ms"));
+
+    utils::OutputBuffer csv;
+    appendReport(csv, format::Kind::Csv, Config{}, report);
+    const std::string_view rows = csv.view();
+    ASSERT_EQ(2, std::count(rows.begin(), rows.end(), '\n'));
+    ASSERT_EQ(0u, rows.find("rate,threads,lifetime_ms,"));
+    ASSERT_NE(std::string::npos, rows.find("\n200,4,100,"));
+
+    utils::OutputBuffer json;
+    appendReport(json, format::Kind::JsonLines, Config{}, report);
+    ASSERT_EQ(0u, json.view().find("{\"rate\":200,\"threads\":4,"));
+    ASSERT_NE(std::string::npos, json.view().find(",\"missed\":1,\"missed_fraction\":0.005000,\"vanished\":7,"));
+    ASSERT_EQ("}\n", json.view().substr(json.view().size() - 2u));
+}
+
+TEST_F(ChurnBenchTest, checkChurnOptions_benchDefaults_Ok)
+{
+    const char* argv[] = {"out", "--churn-bench", "--churn-rate", "1000", "--churn-threads", "8", "--churn-lifetime", "20"};
+    const cli::Options options = cli::parseOptions(8, argv);
+    ASSERT_EQ(cli::Mode::ChurnBench, options._mode);
+    ASSERT_EQ(1000u, options._churn._processesPerSecond);
+    ASSERT_EQ(8u, options._churn._threadsPerProcess);
+    ASSERT_EQ(20u, options._churn._lifetimeMs);
+    ASSERT_EQ(50u, options._iterations);
+    ASSERT_DOUBLE_EQ(0.1, options._delaySeconds);
+    ASSERT_EQ(format::Kind::Text, options._format);
+
+    const char* given[] = {"out", "--churn-bench", "-n", "5", "-d", "0.5", "-f", "csv"};
+    const cli::Options explicitOptions = cli::parseOptions(8, given);
+    ASSERT_EQ(5u, explicitOptions._iterations);
+    ASSERT_DOUBLE_EQ(0.5, explicitOptions._delaySeconds);
+    ASSERT_EQ(format::Kind::Csv, explicitOptions._format);
+
+    const char* noRate[] = {"out", "--churn-bench", "--churn-rate", "0"};
+    ASSERT_THROW(cli::parseOptions(4, noRate), utils::SeverityException<utils::SeriousException>);
+}
+
+}
+}
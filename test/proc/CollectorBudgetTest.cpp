@@ -0,0 +1,122 @@
+#include "gtest/gtest.h"
+#include <CollectorBudget.hpp>
+
+#include <chrono>
+#include <sched.h>
+#include <thread>
+
+namespace proc
+{
+namespace budget
+{
+
+class CollectorBudgetTest : public ::testing::Test
+{};
+
+TEST_F(CollectorBudgetTest, checkWithinBudget_requestedIntervalKept_Ok)
+{
+    // 10ms a tick every second -> 1% of a core, below 2%
+    CollectorBudget collectorBudget(2.0, std::chrono::milliseconds(1000));
+    collectorBudget.record(std::chrono::milliseconds(10));
+    ASSERT_EQ(std::chrono::milliseconds(1000), collectorBudget.getInterval());
+    ASSERT_EQ(1u, collectorBudget.getStride());
+    ASSERT_FALSE(collectorBudget.isDegraded());
+    ASSERT_NEAR(1.0, collectorBudget.getCostPercent(), 1e-9);
+}
+
+TEST_F(CollectorBudgetTest, checkOverBudget_intervalWidened_Ok)
+{
+    // 50ms a tick needs 2.5s between ticks to stay at 2%
+    CollectorBudget collectorBudget(2.0, std::chrono::milliseconds(1000));
+    collectorBudget.record(std::chrono::milliseconds(50));
+    ASSERT_EQ(std::chrono::milliseconds(2500), collectorBudget.getInterval());
+    ASSERT_EQ(1u, collectorBudget.getStride());
+    ASSERT_TRUE(collectorBudget.isDegraded());
+    ASSERT_NEAR(2.0, collectorBudget.getCostPercent(), 1e-9);
+    ASSERT_EQ("| Refresh: 2.5s (throttled from 1.0s) - collector 2.0% of a core (budget 2.0%)", collectorBudget.describe());
+}
+
+TEST_F(CollectorBudgetTest, checkFarOverBudget_widestIntervalThenStride_Ok)
+{
+    // 400ms a tick needs 20s, past the widest 8s -> a third of the processes per tick every 6.7s
+    CollectorBudget collectorBudget(2.0, std::chrono::milliseconds(1000));
+    collectorBudget.record(std::chrono::milliseconds(400));
+    ASSERT_EQ(3u, collectorBudget.getStride());
+    ASSERT_LE(collectorBudget.getInterval(), std::chrono::milliseconds(1000 * CollectorBudget::kMaxWiden));
+    ASSERT_NEAR(2.0, collectorBudget.getCostPercent(), 0.01);
+    ASSERT_EQ("| Refresh: 6.7s (throttled from 1.0s, 1 in 3 processes per tick) - collector 2.0% of a core (budget 2.0%)",
+        collectorBudget.describe());
+
+    // a tick at stride 3 only reads a third of the processes, its' cost is extrapolated back to a full one
+    collectorBudget.record(std::chrono::microseconds(400'000 / 3));
+    ASSERT_EQ(3u, collectorBudget.getStride());
+}
+
+TEST_F(CollectorBudgetTest, checkCostDrops_backToRequested_Ok)
+{
+    CollectorBudget collectorBudget(2.0, std::chrono::milliseconds(1000));
+    collectorBudget.record(std::chrono::milliseconds(400));
+    ASSERT_TRUE(collectorBudget.isDegraded());
+    for(int tick=0; tick<20; ++tick)
+    {
+        collectorBudget.record(std::chrono::milliseconds(1));
+    }
+    ASSERT_FALSE(collectorBudget.isDegraded());
+    ASSERT_EQ(std::chrono::milliseconds(1000), collectorBudget.getInterval());
+    ASSERT_EQ(1u, collectorBudget.getStride());
+}
+
+TEST_F(CollectorBudgetTest, checkNoBudget_neverThrottled_Ok)
+{
+    CollectorBudget collectorBudget(0.0, std::chrono::milliseconds(1000));
+    collectorBudget.record(std::chrono::seconds(5));
+    ASSERT_FALSE(collectorBudget.isDegraded());
+    ASSERT_EQ("| Refresh: 1.0s - collector 500.0% of a core", collectorBudget.describe());
+}
+
+TEST_F(CollectorBudgetTest, checkThreadCpuTime_countsOwnWorkOnly_Ok)
+{
+    const std::chrono::microseconds start = threadCpuTime();
+    const std::chrono::steady_clock::time_point until = std::chrono::steady_clock::now() + std::chrono::milliseconds(30);
+    volatile unsigned long long spin{0u};
+    while(std::chrono::steady_clock::now() < until)
+    {
+        ++spin;
+    }
+    const std::chrono::microseconds busy = threadCpuTime() - start;
+    ASSERT_GT(busy, std::chrono::milliseconds(5));
+
+    // sleeping costs nothing
+    const std::chrono::microseconds beforeSleep = threadCpuTime();
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    ASSERT_LT(threadCpuTime() - beforeSleep, std::chrono::milliseconds(5));
+}
+
+TEST_F(CollectorBudgetTest, checkPriority_parsedAndIdleApplied_Ok)
+{
+    Priority priority{Priority::Normal};
+    ASSERT_TRUE(parsePriority("idle", priority));
+    ASSERT_EQ(Priority::Idle, priority);
+    ASSERT_TRUE(parsePriority("nice", priority));
+    ASSERT_EQ(Priority::Nice, priority);
+    ASSERT_FALSE(parsePriority("fifo", priority));
+
+    // on a thread of its' own, the test runner keeps its' priority
+    int policy{-1};
+    std::thread collector([&policy]()
+    {
+        if(applyPriority(Priority::Idle))
+        {
+            policy = ::sched_getscheduler(0);
+        }
+        else
+        {
+            policy = SCHED_IDLE; // refused by the sandbox, the WARNING was the point
+        }
+    });
+    collector.join();
+    ASSERT_EQ(SCHED_IDLE, policy);
+}
+
+}
+}
@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+#include <ExportWriter.hpp>
+#include <OutputBuffer.hpp>
+#include <SnapshotFormat.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+namespace proc
+{
+
+class ExportWriterTest : public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+        _directory = std::filesystem::temp_directory_path() / ("ExportWriterTest." + std::to_string(::getpid()));
+        std::filesystem::create_directories(_directory);
+        _exportPath = _directory / "ProcessesStatus.txt";
+    }
+    void TearDown() override
+    {
+        std::filesystem::remove_all(_directory);
+    }
+
+    // `rows` processes, pids 0 to rows - 1, `threads` telling the snapshots apart
+    static void fillSnapshot(PidTable_t& snapshot, const uint rows, const uint threads)
+    {
+        snapshot.beginTick();
+        for(uint pid=0; pid<rows; ++pid)
+        {
+            PidStats& stats = snapshot.upsert(pid);
+            stats._cpu = 0.25;
+            stats._memory = 0.5;
+            stats._threads = threads;
+            stats._timezone = PidStats::timezone{1u, 2u, 3u, 400u};
+        }
+        snapshot.sweep();
+    }
+
+    static std::string readFile(const std::filesystem::path& path)
+    {
+        std::ifstream file(path);
+        std::stringstream content;
+        content << file.rdbuf();
+        return content.str();
+    }
+
+    std::size_t filesInDirectory() const
+    {
+        return static_cast<std::size_t>(std::distance(std::filesystem::directory_iterator(_directory), std::filesystem::directory_iterator()));
+    }
+
+    std::filesystem::path _directory;
+    std::filesystem::path _exportPath;
+};
+
+TEST_F(ExportWriterTest, checkSubmit_publishesEveryRowWithoutTemporaryLeft_Ok)
+{
+    PidTable_t snapshot(32768u);
+    fillSnapshot(snapshot, 5000u, 7u);
+
+    ExportWriter writer(_exportPath);
+    writer.submit(snapshot);
+    writer.waitIdle();
+
+    utils::OutputBuffer expected;
+    for(const auto& [pidNum, stats] : snapshot)
+    {
+        format::appendRow(expected, format::Kind::Text, 0u, pidNum, stats);
+    }
+    ASSERT_EQ(std::string(expected.view()), readFile(_exportPath));
+    ASSERT_EQ(1u, writer.getPublished());
+    ASSERT_EQ(0u, writer.getFailed());
+    ASSERT_EQ(1u, filesInDirectory());
+}
+
+TEST_F(ExportWriterTest, checkSubmit_namesWrittenFromTheTable_Ok)
+{
+    PidTable_t snapshot(32768u);
+    fillSnapshot(snapshot, 3u, 1u);
+    utils::StringTable names;
+    snapshot.find(1u)->_name = names.intern("nginx");
+    snapshot.find(2u)->_name = names.intern("nginx");
+
+    ExportWriter writer(_exportPath);
+    writer.submit(snapshot, &names);
+    writer.waitIdle();
+
+    utils::OutputBuffer expected;
+    for(const auto& [pidNum, stats] : snapshot)
+    {
+        format::appendRow(expected, format::Kind::Text, 0u, pidNum, stats, names.view(stats._name));
+    }
+    const std::string content = readFile(_exportPath);
+    ASSERT_EQ(std::string(expected.view()), content);
+    ASSERT_NE(std::string::npos, content.find("threads: 1 time: 1:2:3.400 name: nginx\n"));
+}
+
+TEST_F(ExportWriterTest, checkSubmit_readerNeverSeesHalfAFile_Ok)
+{
+    constexpr uint kSnapshots = 200u;
+    std::atomic<bool> done{false};
+    std::atomic<uint> torn{0u};
+    std::atomic<uint> reads{0u};
+
+    // every snapshot k holds 1000 + 37k rows of `threads: k`, a whole file is recognised by its' own length
+    std::thread reader([&]{
+        while(!done.load())
+        {
+            const std::string content = readFile(_exportPath);
+            if(content.empty())
+            {
+                continue;
+            }
+            ++reads;
+            const std::size_t lines = static_cast<std::size_t>(std::count(content.begin(), content.end(), '\n'));
+            const std::size_t firstThreads = content.find("threads: ");
+            const std::size_t lastThreads = content.rfind("threads: ");
+            const uint first = static_cast<uint>(std::stoul(content.substr(firstThreads + 9u)));
+            const uint last = static_cast<uint>(std::stoul(content.substr(lastThreads + 9u)));
+            if(content.back() != '\n' || first != last || lines != 1000u + 37u * first)
+            {
+                ++torn;
+            }
+        }
+    });
+
+    ExportWriter writer(_exportPath);
+    PidTable_t snapshot(32768u);
+    for(uint k=0; k<kSnapshots; ++k)
+    {
+        fillSnapshot(snapshot, 1000u + 37u * k, k);
+        writer.submit(snapshot);
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    writer.waitIdle();
+    done.store(true);
+    reader.join();
+
+    RecordProperty("reads", static_cast<int>(reads.load()));
+    ASSERT_EQ(0u, torn.load());
+    ASSERT_EQ(kSnapshots, writer.getPublished() + writer.getCoalesced());
+    const std::string last = readFile(_exportPath);
+    ASSERT_EQ(1000u + 37u * (kSnapshots - 1u), static_cast<std::size_t>(std::count(last.begin(), last.end(), '\n')));
+    ASSERT_EQ(1u, filesInDirectory());
+}
+
+TEST_F(ExportWriterTest, checkSubmit_slowDiskCoalescesInsteadOfBlocking_Ok)
+{
+    constexpr uint kSnapshots = 50u;
+    PidTable_t snapshot(32768u);
+    ExportWriter writer(_exportPath, ExportWriter::Durability::Fsync);
+
+    double worstSubmitUs{0.0};
+    for(uint k=0; k<kSnapshots; ++k)
+    {
+        fillSnapshot(snapshot, 20000u, k);
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        writer.submit(snapshot);
+        worstSubmitUs = std::max(worstSubmitUs, std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    }
+    writer.waitIdle();
+
+    RecordProperty("worstSubmitOf20000Us", std::to_string(worstSubmitUs));
+    RecordProperty("published", static_cast<int>(writer.getPublished()));
+    // formatting and syncing 20000 rows takes far longer than copying them, the writer cannot keep up
+    ASSERT_GT(writer.getCoalesced(), 0u);
+    ASSERT_EQ(kSnapshots, writer.getPublished() + writer.getCoalesced());
+    ASSERT_NE(std::string::npos, readFile(_exportPath).find("threads: " + std::to_string(kSnapshots - 1u)));
+}
+
+TEST_F(ExportWriterTest, checkSubmit_missingDirectoryCountsAFailure_Ko)
+{
+    PidTable_t snapshot(32768u);
+    fillSnapshot(snapshot, 10u, 1u);
+
+    ExportWriter writer(_directory / "missing/ProcessesStatus.txt");
+    writer.submit(snapshot);
+    writer.waitIdle();
+
+    ASSERT_EQ(0u, writer.getPublished());
+    ASSERT_EQ(1u, writer.getFailed());
+    ASSERT_EQ(0u, filesInDirectory());
+}
+
+}
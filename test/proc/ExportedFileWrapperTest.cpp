@@ -1,6 +1,17 @@
 #include <filesystem>
 #include <gtest/gtest.h>
 #include <ExportedFileWrapper.hpp>
+#include <OutputBuffer.hpp>
+#include <SnapshotFormat.hpp>
+#include <UniqueFd.hpp>
+#include <EventLoop.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <set>
+#include <unistd.h>
 
 namespace proc
 {
@@ -8,6 +19,30 @@ namespace proc
 class ExportedFileWrapperTest : public ::testing::Test
 {
 public:
+    // the way ExportWriter publishes : a temporary file renamed over the export
+    static void publish(const std::filesystem::path& exportedFilePath, const std::string& content)
+    {
+        const std::filesystem::path temporary = exportedFilePath.string() + ".tmp";
+        {
+            std::ofstream file(temporary);
+            file << content;
+        }
+        std::filesystem::rename(temporary, exportedFilePath);
+    }
+
+    static std::set<uint> pagedPids(ExportedFileWrapper& wrapper)
+    {
+        std::set<uint> pids;
+        while(!wrapper.isIterPointingEnd())
+        {
+            for(const PidStatus_t::value_type& pidWithStats : wrapper.getPidsByStep(2u))
+            {
+                pids.insert(pidWithStats.first);
+            }
+        }
+        return pids;
+    }
+
     std::filesystem::path setTestingPath()
     {
         std::filesystem::path testPath = std::filesystem::current_path();
@@ -69,4 +104,232 @@ TEST_F(ExportedFileWrapperTest, checkRetrievalByStep8MoreThanShould_mapPopulated
     ASSERT_EQ(14270u, wrapper.getCurrentIter()->first);
 }
 
-}
\ No newline at end of file
+TEST_F(ExportedFileWrapperTest, checkLine_numbersLikeStod_Ok)
+{
+    uint pid{0u};
+    PidStats stats{};
+    ASSERT_EQ(nullptr, parseExportedLine("Pid: 15386 cpu: 4.58% memory: 1.55% threads: 11 time: 0:5:44.80\r", pid, stats));
+    ASSERT_EQ(15386u, pid);
+    ASSERT_DOUBLE_EQ(4.58, stats._cpu);
+    ASSERT_DOUBLE_EQ(1.55, stats._memory);
+    ASSERT_EQ(11u, stats._threads);
+    ASSERT_EQ(5u, stats._timezone._minutes);
+    ASSERT_EQ(44u, stats._timezone._seconds);
+    ASSERT_EQ(80u, stats._timezone._ms);
+
+    // what sticks to a number is ignored, the validator is the one judging the values
+    ASSERT_EQ(nullptr, parseExportedLine("Pid: 20952 cpu: -3213123.-1231232% memory: 0.5% threads: 1 time: 0:2:4.132", pid, stats));
+    ASSERT_DOUBLE_EQ(-3213123.0, stats._cpu);
+
+    ASSERT_NE(nullptr, parseExportedLine("Pid: 20952 cpu: 1% memory: 0.5% threads: 1", pid, stats));
+    ASSERT_NE(nullptr, parseExportedLine("Pid: x cpu: 1% memory: 0.5% threads: 1 time: 0:2:4.132", pid, stats));
+    ASSERT_NE(nullptr, parseExportedLine("Pid: 1 cpu: 1% memory: 0.5% threads: 1 time: 0:2", pid, stats));
+}
+
+TEST_F(ExportedFileWrapperTest, checkLine_optionalName_Ok)
+{
+    uint pid{0u};
+    PidStats stats{};
+    std::string_view name;
+    ASSERT_EQ(nullptr, parseExportedLine("Pid: 12 cpu: 1.00% memory: 0.50% threads: 1 time: 0:0:1.0 name: Web Content\r", pid, stats, &name));
+    ASSERT_EQ(12u, pid);
+    ASSERT_EQ("Web Content", name);
+
+    // older exports have none
+    name = "left over";
+    ASSERT_EQ(nullptr, parseExportedLine("Pid: 12 cpu: 1.00% memory: 0.50% threads: 1 time: 0:0:1.0", pid, stats, &name));
+    ASSERT_TRUE(name.empty());
+
+    ASSERT_NE(nullptr, parseExportedLine("Pid: 12 cpu: 1.00% memory: 0.50% threads: 1 time: 0:0:1.0 garbage", pid, stats, &name));
+}
+
+TEST_F(ExportedFileWrapperTest, checkLine_optionalUserAndSession_Ok)
+{
+    uint pid{0u};
+    PidStats stats{};
+    std::string_view name;
+    ASSERT_EQ(nullptr, parseExportedLine("Pid: 12 cpu: 1.00% memory: 0.50% threads: 1 time: 0:0:1.0 user: 1000 session: 7 name: bash", pid, stats, &name));
+    ASSERT_EQ(1000u, stats._uid);
+    ASSERT_EQ(7u, stats._session);
+    ASSERT_EQ("bash", name);
+
+    PidStats noName{};
+    ASSERT_EQ(nullptr, parseExportedLine("Pid: 12 cpu: 1.00% memory: 0.50% threads: 1 time: 0:0:1.0 user: 0 session: 3", pid, noName, &name));
+    ASSERT_EQ(3u, noName._session);
+    ASSERT_TRUE(name.empty());
+
+    ASSERT_NE(nullptr, parseExportedLine("Pid: 12 cpu: 1.00% memory: 0.50% threads: 1 time: 0:0:1.0 user: 1000 name: bash", pid, stats, &name));
+}
+
+TEST_F(ExportedFileWrapperTest, checkNames_internedOncePerName_Ok)
+{
+    const std::filesystem::path exportedFilePath = std::filesystem::temp_directory_path() / "ExportedFileWrapperTestNames.txt";
+    {
+        std::ofstream file(exportedFilePath);
+        file << "Pid: 1 cpu: 1.00% memory: 0.50% threads: 1 time: 0:0:1.0 name: php-fpm\n"
+                "Pid: 2 cpu: 1.00% memory: 0.50% threads: 1 time: 0:0:1.0 name: php-fpm\n"
+                "Pid: 3 cpu: 1.00% memory: 0.50% threads: 1 time: 0:0:1.0\n";
+    }
+    ExportedFileWrapper wrapper(exportedFilePath);
+    std::filesystem::remove(exportedFilePath);
+
+    ASSERT_EQ(3u, wrapper.getPids().size());
+    ASSERT_EQ(wrapper.getPids().at(1u)._name, wrapper.getPids().at(2u)._name);
+    ASSERT_EQ("php-fpm", wrapper.getNames().view(wrapper.getPids().at(1u)._name));
+    ASSERT_EQ(utils::StringTable::kEmpty, wrapper.getPids().at(3u)._name);
+    ASSERT_EQ(2u, wrapper.getNames().size());
+}
+
+TEST_F(ExportedFileWrapperTest, checkMalformedLines_reportedAndSkipped_Ok)
+{
+    const std::filesystem::path exportedFilePath = std::filesystem::temp_directory_path() / "ExportedFileWrapperTestMalformed.txt";
+    {
+        std::ofstream file(exportedFilePath);
+        file << "Pid: 1 cpu: 1.00% memory: 0.50% threads: 1 time: 0:0:1.0\n"
+                "Pid: 2 cpu: oops memory: 0.50% threads: 1 time: 0:0:1.0\n"
+                "\n"
+                "Pid: 3 cpu: 1.00% memory: 0.50% threads: 1 time: 0:0:1.0\n"
+                "garbage\n";
+    }
+    ExportedFileWrapper wrapper(exportedFilePath);
+    ASSERT_EQ(2u, wrapper.getPids().size());
+    ASSERT_EQ(2u, wrapper.getMalformedLines().size());
+    ASSERT_EQ(2u, wrapper.getMalformedLines()[0]._line);
+    ASSERT_EQ(5u, wrapper.getMalformedLines()[1]._line);
+    std::filesystem::remove(exportedFilePath);
+}
+
+TEST_F(ExportedFileWrapperTest, checkLargeExport_parallelChunksSameAsOne_Ok)
+{
+    // ~70 bytes a row, enough rows for several chunks
+    static constexpr uint kRows = 200'000u;
+    const std::filesystem::path exportedFilePath = std::filesystem::temp_directory_path() / "ExportedFileWrapperTestLarge.txt";
+    {
+        utils::UniqueFd file(::open(exportedFilePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+        utils::OutputBuffer out(file.get());
+        for(uint row=1; row<=kRows; ++row)
+        {
+            PidStats stats{};
+            stats._cpu = (row % 1000u) / 10.0;
+            stats._memory = (row % 300u) / 100.0;
+            stats._threads = row % 64u + 1u;
+            stats._timezone = PidStats::timezone{row % 24u, row % 60u, row % 59u, row % 1000u};
+            format::appendRow(out, format::Kind::Text, 0u, row, stats);
+            if(row % 50'000u == 0u)
+            {
+                out.append("Pid: broken\n");
+            }
+        }
+        out.flush();
+    }
+    const double megabytes = static_cast<double>(std::filesystem::file_size(exportedFilePath)) / (1u << 20);
+
+    ExportedFileWrapper single(exportedFilePath, 1u);
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    ExportedFileWrapper parallel(exportedFilePath, 4u);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    RecordProperty("loadMegabytesPerSecond", static_cast<int>(megabytes / seconds));
+
+    ASSERT_EQ(kRows, parallel.getPids().size());
+    ASSERT_EQ(single.getPids().size(), parallel.getPids().size());
+    ASSERT_EQ(4u, parallel.getMalformedLines().size());
+    for(std::size_t malformed=0; malformed<4u; ++malformed)
+    {
+        ASSERT_EQ(single.getMalformedLines()[malformed]._line, parallel.getMalformedLines()[malformed]._line);
+        ASSERT_EQ((malformed + 1u) * 50'001u, parallel.getMalformedLines()[malformed]._line);
+    }
+    const PidStats& stats = parallel.getPids().at(123'457u);
+    ASSERT_DOUBLE_EQ(45.7, stats._cpu);
+    ASSERT_DOUBLE_EQ(1.57, stats._memory);
+    ASSERT_EQ(2u, stats._threads);
+    ASSERT_EQ(457u, stats._timezone._ms);
+    std::filesystem::remove(exportedFilePath);
+}
+
+TEST_F(ExportedFileWrapperTest, checkFollow_publishedExportSwappedPassInProgressKept_Ok)
+{
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / ("ExportedFileWrapperFollow." + std::to_string(::getpid()));
+    std::filesystem::create_directories(directory);
+    const std::filesystem::path exportedFilePath = directory / "ProcessesStatus.txt";
+    publish(exportedFilePath, "Pid: 1 cpu: 1.00% memory: 0.50% threads: 1 time: 0:0:1.0 name: bash\n"
+                              "Pid: 2 cpu: 2.00% memory: 0.50% threads: 1 time: 0:0:1.0\n"
+                              "Pid: 3 cpu: 3.00% memory: 0.50% threads: 1 time: 0:0:1.0\n");
+    ExportedFileWrapper wrapper(exportedFilePath);
+    ASSERT_TRUE(wrapper.follow());
+    ASSERT_FALSE(wrapper.refresh());
+    utils::EventLoop loop;
+    loop.watchFile(wrapper.getFollowFd());
+    std::vector<utils::EventLoop::Event> events;
+    ASSERT_EQ(0u, loop.wait(events, 0));
+
+    // a pass started on the first snapshot
+    const std::size_t firstPage = wrapper.getPidsByStep(1u).size();
+    publish(exportedFilePath, "Pid: 4 cpu: 4.00% memory: 0.50% threads: 1 time: 0:0:1.0 name: bash\n"
+                              "Pid: 5 cpu: 5.00% memory: 0.50% threads: 1 time: 0:0:1.0 name: nginx\n");
+    ASSERT_EQ(1u, loop.wait(events, 1000));
+    ASSERT_EQ(utils::EventLoop::Source::File, events[0]._source);
+    ASSERT_TRUE(wrapper.refresh());
+    ASSERT_EQ(1u, wrapper.getGeneration());
+    ASSERT_EQ(0u, loop.wait(events, 0));
+
+    // the readers of the whole snapshot see the new one, the pass ends on the old one
+    ASSERT_EQ(2u, wrapper.getPids().size());
+    ASSERT_EQ("nginx", wrapper.getNames().view(wrapper.getPids().at(5u)._name));
+    ASSERT_EQ(wrapper.getPids().at(4u)._name, wrapper.accessNames().intern("bash"));
+    ASSERT_EQ(3u, firstPage + pagedPids(wrapper).size());
+    wrapper.resetIter();
+    ASSERT_EQ((std::set<uint>{4u, 5u}), pagedPids(wrapper));
+
+    // no longer following : a publication goes unnoticed until reload()
+    loop.unwatchFile(wrapper.getFollowFd());
+    wrapper.unfollow();
+    ASSERT_EQ(-1, wrapper.getFollowFd());
+    publish(exportedFilePath, "Pid: 6 cpu: 6.00% memory: 0.50% threads: 1 time: 0:0:1.0\n");
+    ASSERT_EQ(0u, loop.wait(events, 0));
+    ASSERT_FALSE(wrapper.refresh());
+    ASSERT_EQ(2u, wrapper.getPids().size());
+    ASSERT_TRUE(wrapper.reload());
+    ASSERT_EQ(1u, wrapper.getPids().size());
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST_F(ExportedFileWrapperTest, checkFollow_unchangedHalfWrittenOrUnrelatedIgnored_Ok)
+{
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / ("ExportedFileWrapperIgnored." + std::to_string(::getpid()));
+    std::filesystem::create_directories(directory);
+    const std::filesystem::path exportedFilePath = directory / "ProcessesStatus.txt";
+    const std::string content("Pid: 1 cpu: 1.00% memory: 0.50% threads: 1 time: 0:0:1.0\n");
+    publish(exportedFilePath, content);
+    ExportedFileWrapper wrapper(exportedFilePath);
+    ASSERT_TRUE(wrapper.follow());
+
+    // another file of the directory, then the same bytes published again
+    publish(directory / "other.txt", "Pid: 9 cpu: 1.00% memory: 0.50% threads: 1 time: 0:0:1.0\n");
+    ASSERT_FALSE(wrapper.refresh());
+    publish(exportedFilePath, content);
+    ASSERT_FALSE(wrapper.refresh());
+    ASSERT_EQ(0u, wrapper.getGeneration());
+
+    // written in place : nothing until it is closed
+    {
+        std::FILE* file = std::fopen(exportedFilePath.c_str(), "w");
+        ASSERT_NE(nullptr, file);
+        std::fputs("Pid: 7 cpu: 1.00% memory: 0.50% threads: 1 time: 0:0:1.0\n", file);
+        std::fflush(file);
+        ASSERT_FALSE(wrapper.refresh());
+        std::fputs("Pid: 8 cpu: 1.00% memory: 0.50% threads: 1 time: 0:0:1.0\n", file);
+        std::fclose(file);
+    }
+    ASSERT_TRUE(wrapper.refresh());
+    ASSERT_EQ(2u, wrapper.getPids().size());
+
+    // removed : the last snapshot stays
+    std::filesystem::remove(exportedFilePath);
+    ASSERT_FALSE(wrapper.refresh());
+    ASSERT_FALSE(wrapper.reload());
+    ASSERT_EQ(2u, wrapper.getPids().size());
+    std::filesystem::remove_all(directory);
+}
+
+}
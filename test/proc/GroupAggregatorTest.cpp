@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+#include <GroupAggregator.hpp>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace proc
+{
+namespace group
+{
+
+class GroupAggregatorTest : public ::testing::Test
+{
+public:
+    static PidStats makeStats(const utils::StringTable::Id name, const double cpu, const uint threads, const uint session = 1u)
+    {
+        PidStats stats{};
+        stats._cpu = cpu;
+        stats._memory = cpu / 2.0;
+        stats._threads = threads;
+        stats._name = name;
+        stats._uid = 1000u;
+        stats._session = session;
+        return stats;
+    }
+
+    // what one pass over `snapshot` finds, to compare with the groups kept up to date by deltas
+    static void expectSameGroups(const Aggregator& incremental, const PidStatus_t& snapshot, const GroupBy by)
+    {
+        Aggregator rebuilt;
+        rebuilt.rebuild(snapshot, by);
+        ASSERT_EQ(rebuilt.size(), incremental.size());
+        ASSERT_EQ(rebuilt.getProcessCount(), incremental.getProcessCount());
+        std::vector<const Group*> groups;
+        rebuilt.top(rebuilt.size(), Order::Count, groups);
+        for(const Group* group : groups)
+        {
+            const Group* kept = incremental.find(group->_key);
+            ASSERT_NE(nullptr, kept);
+            ASSERT_NEAR(group->_cpu, kept->_cpu, 1e-6);
+            ASSERT_NEAR(group->_memory, kept->_memory, 1e-6);
+            ASSERT_EQ(group->_threads, kept->_threads);
+            std::vector<uint> left = group->_members;
+            std::vector<uint> right = kept->_members;
+            std::sort(left.begin(), left.end());
+            std::sort(right.begin(), right.end());
+            ASSERT_EQ(left, right);
+        }
+    }
+};
+
+TEST_F(GroupAggregatorTest, checkRebuild_oneGroupPerKey_Ok)
+{
+    PidStatus_t snapshot;
+    snapshot[1u] = makeStats(7u, 10.0, 4u);
+    snapshot[2u] = makeStats(7u, 5.0, 2u);
+    snapshot[3u] = makeStats(8u, 1.0, 1u, 2u);
+
+    Aggregator aggregator;
+    aggregator.rebuild(snapshot, GroupBy::Name);
+    ASSERT_EQ(2u, aggregator.size());
+    const Group* nginx = aggregator.find(7u);
+    ASSERT_NE(nullptr, nginx);
+    ASSERT_DOUBLE_EQ(15.0, nginx->_cpu);
+    ASSERT_DOUBLE_EQ(7.5, nginx->_memory);
+    ASSERT_EQ(6u, nginx->_threads);
+    ASSERT_EQ(2u, nginx->_members.size());
+
+    aggregator.rebuild(snapshot, GroupBy::User);
+    ASSERT_EQ(1u, aggregator.size());
+    ASSERT_EQ(3u, aggregator.find(1000u)->_members.size());
+
+    aggregator.rebuild(snapshot, GroupBy::Session);
+    ASSERT_EQ(2u, aggregator.size());
+    ASSERT_EQ(1u, aggregator.find(2u)->_members.size());
+}
+
+TEST_F(GroupAggregatorTest, checkUpdate_deltaMovesTheGroup_keyChangeMovesTheProcess_Ok)
+{
+    Aggregator aggregator(GroupBy::Name);
+    aggregator.update(1u, makeStats(7u, 10.0, 4u));
+    aggregator.update(2u, makeStats(7u, 5.0, 2u));
+    aggregator.update(1u, makeStats(7u, 12.0, 5u));
+    ASSERT_DOUBLE_EQ(17.0, aggregator.find(7u)->_cpu);
+    ASSERT_EQ(7u, aggregator.find(7u)->_threads);
+
+    // an exec : 2 leaves the group of 7 for the one of 9
+    aggregator.update(2u, makeStats(9u, 3.0, 1u));
+    ASSERT_DOUBLE_EQ(12.0, aggregator.find(7u)->_cpu);
+    ASSERT_EQ(std::vector<uint>{1u}, aggregator.find(7u)->_members);
+    ASSERT_DOUBLE_EQ(3.0, aggregator.find(9u)->_cpu);
+
+    // the last member gone, so is its' group
+    aggregator.remove(1u);
+    aggregator.remove(42u);
+    ASSERT_EQ(nullptr, aggregator.find(7u));
+    ASSERT_EQ(1u, aggregator.size());
+    ASSERT_EQ(1u, aggregator.getProcessCount());
+}
+
+TEST_F(GroupAggregatorTest, checkTop_order_Ok)
+{
+    Aggregator aggregator(GroupBy::Name);
+    aggregator.update(1u, makeStats(7u, 1.0, 40u));
+    aggregator.update(2u, makeStats(7u, 1.0, 40u));
+    aggregator.update(3u, makeStats(7u, 1.0, 40u));
+    aggregator.update(4u, makeStats(8u, 50.0, 1u));
+    aggregator.update(5u, makeStats(9u, 0.0, 1u));
+
+    std::vector<const Group*> top;
+    aggregator.top(2u, Order::Cpu, top);
+    ASSERT_EQ(2u, top.size());
+    ASSERT_EQ(8u, top[0]->_key);
+    ASSERT_EQ(7u, top[1]->_key);
+
+    aggregator.top(10u, Order::Count, top);
+    ASSERT_EQ(3u, top.size());
+    ASSERT_EQ(7u, top[0]->_key);
+
+    aggregator.top(10u, Order::Threads, top);
+    ASSERT_EQ(3u, top.size());
+    ASSERT_EQ(7u, top[0]->_key);
+    ASSERT_EQ(8u, top[1]->_key);
+}
+
+TEST_F(GroupAggregatorTest, checkUpdates_sameGroupsAsARebuild_Ok)
+{
+    std::mt19937 random(42u);
+    PidStatus_t snapshot;
+    Aggregator aggregator(GroupBy::Name);
+    for(uint round=0; round<20000u; ++round)
+    {
+        const uint pid = random() % 500u + 1u;
+        if(random() % 4u == 0u)
+        {
+            snapshot.erase(pid);
+            aggregator.remove(pid);
+        }
+        else
+        {
+            const PidStats stats = makeStats(random() % 12u, static_cast<double>(random() % 1000u) / 10.0, random() % 64u);
+            snapshot[pid] = stats;
+            aggregator.update(pid, stats);
+        }
+    }
+    expectSameGroups(aggregator, snapshot, GroupBy::Name);
+}
+
+}
+}
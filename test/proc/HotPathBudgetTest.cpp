@@ -0,0 +1,188 @@
+#include <gtest/gtest.h>
+#include <Accounting.hpp>
+#include <ExportedFileWrapper.hpp>
+#include <OutputBuffer.hpp>
+#include <ProcessInfo.hpp>
+#include <SnapshotFormat.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+// Budgets of the collector hot path, measured with the accounting of the test binary (see Accounting.hpp).
+// A regression of the scan or of the load of an export fails here rather than in a profile weeks later
+namespace proc
+{
+
+class ProcessInfoBudgetAccessor : public ProcessInfo
+{
+public:
+    using ProcessInfo::ProcessInfo;
+    using ProcessInfo::getStatReader;
+    using ProcessInfo::getOldPath;
+    using ProcessInfo::getTickArena;
+    using ProcessInfo::getPidStatus;
+    using ProcessInfo::getLastScanSize;
+    using ProcessInfo::getCmdlineReads;
+};
+
+class HotPathBudgetTest : public ::testing::Test
+{
+public:
+    // uptime and meminfo (open/read/close each), opendir and closedir of the listing
+    static constexpr std::uint64_t kSyscallsPerTick = 8u;
+    static constexpr std::uint64_t kSyscallsPerPid = 3u;
+    // a steady tick draws from the arena and the pid table, both grown by the warm up
+    static constexpr std::uint64_t kAllocationsPerTick = 0u;
+    static constexpr uint kWarmUpTicks = 3u;
+    static constexpr uint kMeasuredTicks = 10u;
+
+    // the collector has already moved to /proc
+    static std::filesystem::path simulatedProc(ProcessInfoBudgetAccessor& collector)
+    {
+        return std::filesystem::path(collector.getOldPath()).parent_path() / "test/data/simulateProc/proc";
+    }
+
+    void writeExport(const std::filesystem::path& path, const uint rows)
+    {
+        utils::OutputBuffer content;
+        PidStats stats{};
+        stats._cpu = 1.5;
+        stats._memory = 0.25;
+        stats._threads = 4u;
+        stats._timezone = PidStats::timezone{0u, 1u, 2u, 300u};
+        for(uint pid=1; pid<=rows; ++pid)
+        {
+            format::appendRow(content, format::Kind::Text, 0u, pid, stats);
+        }
+        std::ofstream file(path);
+        file << content.view();
+    }
+};
+
+TEST_F(HotPathBudgetTest, checkScanProcDir_steadyTickOnSimulatedProc_withinBudget_Ok)
+{
+    ProcessInfoBudgetAccessor collector(utils::procfs::IoBackend::Sync);
+    std::filesystem::current_path(simulatedProc(collector));
+    for(uint tick=0; tick<kWarmUpTicks; ++tick)
+    {
+        collector.scanProcDir();
+    }
+
+    const utils::accounting::Phase phase;
+    for(uint tick=0; tick<kMeasuredTicks; ++tick)
+    {
+        ASSERT_EQ(1u, collector.scanProcDir().size());
+    }
+    const utils::accounting::Counts counts = phase.elapsed();
+
+    RecordProperty("allocationsPerTick", std::to_string(counts._allocations / kMeasuredTicks));
+    RecordProperty("syscallsPerTick", std::to_string(counts._syscalls / kMeasuredTicks));
+    ASSERT_LE(counts._allocations, kAllocationsPerTick * kMeasuredTicks);
+    ASSERT_LE(counts._syscalls, (kSyscallsPerTick + kSyscallsPerPid) * kMeasuredTicks);
+}
+
+TEST_F(HotPathBudgetTest, checkScanProcDir_steadyTickOnProc_withinBudget_Ok)
+{
+    ProcessInfoBudgetAccessor collector(utils::procfs::IoBackend::Sync);
+    for(uint tick=0; tick<kWarmUpTicks; ++tick)
+    {
+        collector.scanProcDir();
+    }
+
+    std::uint64_t pids{0u};
+    std::uint64_t syscalls{0u};
+    uint steadyTicks{0u};
+    const std::uint64_t readerSyscalls = collector.getStatReader().getSyscalls();
+    const std::uint64_t cmdlineReads = collector.getCmdlineReads();
+    for(uint tick=0; tick<kMeasuredTicks; ++tick)
+    {
+        const std::size_t arenaCapacity = collector.getTickArena().getCapacity();
+        const std::size_t tableCapacity = collector.getPidStatus().capacity();
+        const std::uint64_t tickCmdlineReads = collector.getCmdlineReads();
+        const utils::accounting::Phase phase;
+        collector.scanProcDir();
+        const utils::accounting::Counts counts = phase.elapsed();
+        const std::uint64_t newProcesses = collector.getCmdlineReads() - tickCmdlineReads;
+        pids += collector.getLastScanSize();
+        syscalls += counts._syscalls;
+        ASSERT_LE(counts._syscalls, kSyscallsPerTick + kSyscallsPerPid * (collector.getLastScanSize() + newProcesses)) << "tick " << tick;
+
+        // the system lives on meanwhile (other tests, the CI) : processes started may grow the arena or the table
+        // and have their names interned, one gone or started in the very millisecond is skipped through an exception.
+        // The allocations of such a tick are that growth or that exception, every other tick has to stay within the budget
+        const bool everyPidRead = collector.getPidStatus().size() == collector.getLastScanSize();
+        if(everyPidRead && newProcesses == 0u && collector.getTickArena().getCapacity() == arenaCapacity
+            && collector.getPidStatus().capacity() == tableCapacity)
+        {
+            ++steadyTicks;
+            ASSERT_LE(counts._allocations, kAllocationsPerTick) << "tick " << tick;
+        }
+    }
+
+    RecordProperty("pidsPerTick", std::to_string(pids / kMeasuredTicks));
+    RecordProperty("syscallsPerTick", std::to_string(syscalls / kMeasuredTicks));
+    RecordProperty("steadyTicks", static_cast<int>(steadyTicks));
+    // a zombie is skipped on every tick, a loaded machine may leave no steady tick : the simulated /proc above
+    // pins the allocations whatever the machine
+    ASSERT_GT(pids, 0u);
+    // the estimate of the reader and what libc was actually asked agree, but for the cmdline of the new processes
+    // (1 syscall when gone already, 3 otherwise)
+    const std::uint64_t expected = collector.getStatReader().getSyscalls() - readerSyscalls + kSyscallsPerTick * kMeasuredTicks;
+    const std::uint64_t newProcesses = collector.getCmdlineReads() - cmdlineReads;
+    ASSERT_GE(syscalls, expected + newProcesses);
+    ASSERT_LE(syscalls, expected + kSyscallsPerPid * newProcesses);
+}
+
+TEST_F(HotPathBudgetTest, checkScanProcDir_ioUringTickBatchesTheSyscalls_Ok)
+{
+    ProcessInfoBudgetAccessor collector(utils::procfs::IoBackend::Auto);
+    if(std::string(collector.getStatReader().name()) != "io_uring")
+    {
+        GTEST_SKIP() << "io_uring is not usable here";
+    }
+    for(uint tick=0; tick<kWarmUpTicks; ++tick)
+    {
+        collector.scanProcDir();
+    }
+
+    std::uint64_t pids{0u};
+    const utils::accounting::Phase phase;
+    for(uint tick=0; tick<kMeasuredTicks; ++tick)
+    {
+        pids += collector.scanProcDir().size();
+    }
+    const utils::accounting::Counts counts = phase.elapsed();
+
+    RecordProperty("syscallsPerTick", std::to_string(counts._syscalls / kMeasuredTicks));
+    // two io_uring_enter per batch of kQueueDepth files
+    const std::uint64_t batches = pids / utils::procfs::IoUringFileReader::kQueueDepth + kMeasuredTicks;
+    ASSERT_LE(counts._syscalls, kSyscallsPerTick * kMeasuredTicks + 2u * batches);
+}
+
+TEST_F(HotPathBudgetTest, checkExportedFileWrapper_loadCostsOneNodePerRowAndConstantSyscalls_Ok)
+{
+    constexpr uint kRows = 20000u;
+    const std::filesystem::path exportPath = std::filesystem::temp_directory_path() / ("HotPathBudgetTest." + std::to_string(::getpid()) + ".txt");
+    writeExport(exportPath, kRows);
+
+    utils::accounting::Counts counts;
+    {
+        const utils::accounting::Phase phase;
+        ExportedFileWrapper wrapper(exportPath, 1u);
+        counts = phase.elapsed();
+        ASSERT_EQ(kRows, wrapper.getPids().size());
+    }
+    std::filesystem::remove(exportPath);
+
+    RecordProperty("allocations", std::to_string(counts._allocations));
+    RecordProperty("bytes", std::to_string(counts._bytes));
+    RecordProperty("syscalls", std::to_string(counts._syscalls));
+    // open, fstat, mmap, munmap, close whatever the size of the export
+    ASSERT_LE(counts._syscalls, 5u);
+    // the node of every pid, the rest (buckets, decoded rows) grows geometrically
+    ASSERT_LE(counts._allocations, kRows + 64u);
+}
+
+}
@@ -0,0 +1,110 @@
+#include "gtest/gtest.h"
+#include <MetricHistory.hpp>
+
+#include <string>
+#include <vector>
+
+namespace proc
+{
+
+class MetricHistoryTest : public ::testing::Test
+{
+protected:
+    static PidStats stats(const double cpu, const double memory, const unsigned long long startTime)
+    {
+        PidStats pidStats{};
+        pidStats._cpu = cpu;
+        pidStats._memory = memory;
+        pidStats._startTime = startTime;
+        return pidStats;
+    }
+};
+
+TEST_F(MetricHistoryTest, checkWindowQuery_avgMaxP95_Ok)
+{
+    MetricHistory history(900u);
+    // 1..100 %, one sample per second
+    for(uint sample=1; sample<=100u; ++sample)
+    {
+        history.recordSystem(sample * 1000ll, static_cast<double>(sample), 50.0);
+    }
+
+    const WindowStats all = history.query(history.system(), Metric::Cpu, 100'000);
+    ASSERT_EQ(100u, all._samples);
+    ASSERT_DOUBLE_EQ(50.5, all._avg);
+    ASSERT_DOUBLE_EQ(100.0, all._max);
+    ASSERT_DOUBLE_EQ(95.0, all._p95);
+
+    // the last 10 seconds straddle a block
+    const WindowStats last = history.query(history.system(), Metric::Cpu, 10'000);
+    ASSERT_EQ(10u, last._samples);
+    ASSERT_DOUBLE_EQ(95.5, last._avg);
+    ASSERT_DOUBLE_EQ(100.0, last._max);
+
+    const WindowStats memory = history.query(history.system(), Metric::Memory, 100'000);
+    ASSERT_DOUBLE_EQ(50.0, memory._avg);
+    ASSERT_DOUBLE_EQ(50.0, memory._p95);
+}
+
+TEST_F(MetricHistoryTest, checkLongRun_fixedBudget_oldSamplesEvicted_Ok)
+{
+    MetricHistory history(128u);
+    history.recordSystem(1000, 0.0, 0.0);
+    const std::size_t budget = history.system().getBudgetBytes();
+    for(uint sample=2; sample<=10'000u; ++sample)
+    {
+        history.recordSystem(sample * 1000ll + static_cast<int>(sample % 7u), static_cast<double>(sample % 100u) + 0.25, 10.0);
+    }
+    ASSERT_EQ(budget, history.system().getBudgetBytes());
+    // the window and at most one more block
+    ASSERT_GE(history.system().size(), 128u);
+    ASSERT_LE(history.system().size(), 128u + MetricSeries::kSamplesPerBlock);
+
+    const WindowStats window = history.query(history.system(), Metric::Cpu, 128'000);
+    ASSERT_EQ(128u, window._samples);
+    ASSERT_DOUBLE_EQ(99.25, window._max);
+}
+
+TEST_F(MetricHistoryTest, checkPidReused_seriesStartsOver_Ok)
+{
+    MetricHistory history(900u);
+    PidStatus_t snapshot;
+    snapshot.emplace(666u, stats(10.0, 1.0, 100u));
+    history.record(1000, snapshot);
+    history.record(2000, snapshot);
+    ASSERT_EQ(2u, history.find(666u)->size());
+
+    snapshot[666u] = stats(20.0, 2.0, 500u);
+    history.record(3000, snapshot);
+    ASSERT_EQ(1u, history.find(666u)->size());
+    ASSERT_DOUBLE_EQ(20.0, history.query(*history.find(666u), Metric::Cpu, 10'000)._avg);
+}
+
+TEST_F(MetricHistoryTest, checkGoneProcess_droppedAfterWindow_Ok)
+{
+    MetricHistory history(3u);
+    PidStatus_t snapshot;
+    snapshot.emplace(666u, stats(10.0, 1.0, 100u));
+    history.record(1000, snapshot);
+    snapshot.clear();
+    history.record(2000, snapshot);
+    history.record(3000, snapshot);
+    ASSERT_NE(nullptr, history.find(666u));
+    history.record(4000, snapshot);
+    ASSERT_EQ(nullptr, history.find(666u));
+    ASSERT_EQ(0u, history.getTrackedCount());
+}
+
+TEST_F(MetricHistoryTest, checkSparkline_scaledAndPadded_Ok)
+{
+    MetricHistory history(900u);
+    history.recordSystem(1000, 0.0, 0.0);
+    history.recordSystem(2000, 50.0, 0.0);
+    history.recordSystem(3000, 100.0, 0.0);
+    ASSERT_EQ("  ▁▅█", renderSparkline(history.system(), Metric::Cpu, 5u));
+    ASSERT_EQ("▅█", renderSparkline(history.system(), Metric::Cpu, 2u));
+    // flat idle series stay at the bottom
+    ASSERT_EQ("▁▁▁", renderSparkline(history.system(), Metric::Memory, 3u));
+}
+
+}
@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+#include <Placement.hpp>
+
+#include <filesystem>
+#include <unistd.h>
+
+namespace proc
+{
+namespace placement
+{
+
+class PlacementTest : public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+        _dataPath = std::filesystem::current_path().parent_path() / "test/data/Placement";
+    }
+
+    std::filesystem::path _dataPath;
+};
+
+TEST_F(PlacementTest, checkCpuList_rangesAndSingles_Ok)
+{
+    std::vector<uint> cpus;
+    ASSERT_TRUE(parseCpuList("0-3,8,10-11\n", cpus));
+    ASSERT_EQ((std::vector<uint>{0u, 1u, 2u, 3u, 8u, 10u, 11u}), cpus);
+
+    std::vector<uint> wrong;
+    ASSERT_FALSE(parseCpuList("3-1", wrong));
+    ASSERT_FALSE(parseCpuList("0-", wrong));
+    ASSERT_FALSE(parseCpuList("a", wrong));
+}
+
+TEST_F(PlacementTest, checkNumaMaps_kbPerNodeWeightedByPageSize_Ok)
+{
+    const std::vector<unsigned long long> kbPerNode = parseNumaMaps(
+        "55cfdf1e2000 default heap anon=300 dirty=300 N0=100 N1=200 kernelpagesize_kB=4\n"
+        "7f1c2a000000 bind:1 anon=1 dirty=1 N1=1 kernelpagesize_kB=2048\n"
+        "7ffd5c1f0000 default\n"
+        "7ffd5c200000 default anon=1 N3=1 kernelpagesize_kB=4");
+    ASSERT_EQ((std::vector<unsigned long long>{400u, 2848u, 0u, 4u}), kbPerNode);
+}
+
+TEST_F(PlacementTest, checkTopology_cpuToNode_Ok)
+{
+    const NumaTopology topology(_dataPath / "node");
+    ASSERT_EQ(2u, topology.getNodeCount());
+    ASSERT_EQ(0, topology.nodeOfCpu(3));
+    ASSERT_EQ(1, topology.nodeOfCpu(4));
+    ASSERT_EQ(-1, topology.nodeOfCpu(8));
+    ASSERT_EQ(-1, topology.nodeOfCpu(-1));
+
+    // no node directory : one node holding every cpu
+    const NumaTopology flat(_dataPath / "missing");
+    ASSERT_EQ(1u, flat.getNodeCount());
+    ASSERT_EQ(0, flat.nodeOfCpu(63));
+}
+
+TEST_F(PlacementTest, checkSample_lastCpuOfTheRowAndRemoteRatio_Ok)
+{
+    PlacementSampler sampler(_dataPath / "proc", NumaTopology(_dataPath / "node"));
+    PidStats tmux;
+    tmux._processor = 5;
+    tmux._startTime = 9120u;
+    sampler.sample({{4242u, &tmux}}, 1000);
+
+    const Placement* placement = sampler.find(4242u);
+    ASSERT_NE(nullptr, placement);
+    ASSERT_EQ(5, placement->_lastCpu);
+    ASSERT_EQ(9120u, placement->_startTime);
+    // cpu 5 is on node 1, 408kB of the 3388kB are on node 0
+    ASSERT_NEAR(408.0 / 3388.0, placement->remoteRatio(sampler.getTopology()), 1e-9);
+    ASSERT_EQ(nullptr, sampler.find(99999u));
+
+    // not asked for anymore -> forgotten
+    sampler.sample({}, 2000);
+    ASSERT_EQ(nullptr, sampler.find(4242u));
+}
+
+TEST_F(PlacementTest, checkOccupancy_everyRowWithAProcessor_Ok)
+{
+    PidStatus_t rows;
+    rows[1u]._processor = 5;
+    rows[2u]._processor = 5;
+    rows[3u]._processor = 0;
+    // not scanned (a row of an export), or past the cpus counted
+    rows[4u]._processor = -1;
+    rows[5u]._processor = 8;
+
+    const std::vector<uint> perCpu = occupancy(rows, 8u);
+    ASSERT_EQ((std::vector<uint>{1u, 0u, 0u, 0u, 0u, 2u, 0u, 0u}), perCpu);
+    ASSERT_EQ("| Processes per cpu: 1....2..\n", renderOccupancy(perCpu));
+}
+
+TEST_F(PlacementTest, checkSample_numaMapsOnSlowTier_Ok)
+{
+    const std::filesystem::path scratch = std::filesystem::temp_directory_path() / ("PlacementTest." + std::to_string(::getpid()));
+    std::filesystem::remove_all(scratch);
+    std::filesystem::copy(_dataPath / "proc", scratch, std::filesystem::copy_options::recursive);
+
+    PlacementSampler sampler(scratch, NumaTopology(_dataPath / "node"));
+    PidStats tmux;
+    tmux._processor = 5;
+    tmux._startTime = 9120u;
+    sampler.sample({{4242u, &tmux}}, 1000);
+    ASSERT_FALSE(sampler.find(4242u)->_kbPerNode.empty());
+
+    // gone numa_maps is not noticed before the refresh is due
+    std::filesystem::remove(scratch / "4242" / "numa_maps");
+    sampler.sample({{4242u, &tmux}}, 1000 + PlacementSampler::kNumaRefreshMs - 1);
+    ASSERT_FALSE(sampler.find(4242u)->_kbPerNode.empty());
+    sampler.sample({{4242u, &tmux}}, 1000 + PlacementSampler::kNumaRefreshMs);
+    ASSERT_TRUE(sampler.find(4242u)->_kbPerNode.empty());
+    ASSERT_EQ(-1.0, sampler.find(4242u)->remoteRatio(sampler.getTopology()));
+    std::filesystem::remove_all(scratch);
+}
+
+TEST_F(PlacementTest, checkSample_ownProcess_affinityRead_Ok)
+{
+    PlacementSampler sampler;
+    const uint self = static_cast<uint>(::getpid());
+    PidStats stats;
+    stats._processor = 0;
+    sampler.sample({{self, &stats}}, 1000);
+    ASSERT_NE(nullptr, sampler.find(self));
+    ASSERT_EQ(0, sampler.find(self)->_lastCpu);
+    ASSERT_GE(sampler.find(self)->_allowedCpus, 1u);
+}
+
+}
+}
@@ -7,6 +7,7 @@
 #include <Exception.hpp>
 #include <string>
 #include <unordered_map>
+#include <unistd.h>
 
 namespace proc
 {
@@ -44,8 +45,11 @@ namespace proc
 class ProcessInfoAccessor : public ProcessInfo
 {
 public:
+    using ProcessInfo::ProcessInfo;
     using ProcessInfo::getPidNum;
     using ProcessInfo::fillStatMap;
+    using ProcessInfo::parseStatLine;
+    using ProcessInfo::getStatReader;
     using ProcessInfo::getGenericUptime;
     using ProcessInfo::calculateCpu;
     using ProcessInfo::refineDouble;
@@ -56,6 +60,7 @@ public:
     using ProcessInfo::getOldPath;
     using ProcessInfo::accessOldPath;
     using ProcessInfo::accessPidStatus;
+    using ProcessInfo::getCmdlineReads;
 };
 
 class ProcessInfoTest : public ::testing::Test
@@ -102,29 +107,145 @@ TEST_F(ProcessInfoTest, checkPidNum_return666_Ok)
 TEST_F(ProcessInfoTest, checkStatMap_filledUp_Ok)
 {
     std::filesystem::current_path(setTestingPath());
-    std::unordered_map<uint, std::string> statMap;
+    proc::StatFields statMap;
     
     ASSERT_NO_THROW(statMap = processInfoAccessor.fillStatMap(
         std::filesystem::path(std::filesystem::current_path() / "666" / "stat")));
     
-    ASSERT_EQ(5u, statMap.size());
-    ASSERT_EQ(1u, statMap.count(14u));
-    ASSERT_EQ(1u, statMap.count(15u));
-    ASSERT_EQ(1u, statMap.count(20u));
-    ASSERT_EQ(1u, statMap.count(22u));
-    ASSERT_EQ(1u, statMap.count(24u));
-
-    ASSERT_EQ("125", statMap.at(14u));
-    ASSERT_EQ("954", statMap.at(15u));
-    ASSERT_EQ("3", statMap.at(20u));
-    ASSERT_EQ("4685", statMap.at(22u));
-    ASSERT_EQ("1696", statMap.at(24u));
+    ASSERT_EQ(1966, statMap.at(6u));
+    ASSERT_EQ(125, statMap.at(14u));
+    ASSERT_EQ(954, statMap.at(15u));
+    ASSERT_EQ(3, statMap.at(20u));
+    ASSERT_EQ(4685, statMap.at(22u));
+    ASSERT_EQ(1696, statMap.at(24u));
+    ASSERT_EQ(1, statMap.at(39u));
+    // only the fields that matter are kept
+    ASSERT_THROW(statMap.at(23u), std::out_of_range);
+}
+
+TEST_F(ProcessInfoTest, checkStatLine_trailingNewLine_sameAsStatMap_Ok)
+{
+    std::filesystem::current_path(setTestingPath());
+    std::ifstream statFile(std::filesystem::current_path() / "666" / "stat");
+    const std::string content((std::istreambuf_iterator<char>(statFile)), std::istreambuf_iterator<char>());
+
+    const proc::StatFields statMap = processInfoAccessor.parseStatLine(content);
+    ASSERT_EQ(processInfoAccessor.fillStatMap(std::filesystem::current_path() / "666" / "stat"), statMap);
+    ASSERT_EQ(1696, statMap.at(24u));
+
+    ASSERT_THROW(processInfoAccessor.parseStatLine("666 (bash) S 1 2 3\n"), utils::SeverityException<utils::ModerateException>);
+    std::string notANumber(content);
+    notANumber.replace(notANumber.find(" 1696 "), 6u, " x696 ");
+    ASSERT_THROW(processInfoAccessor.parseStatLine(notANumber), utils::SeverityException<utils::ModerateException>);
+}
+
+TEST_F(ProcessInfoTest, checkStatLine_commWithBlanks_positionsKept_Ok)
+{
+    std::filesystem::current_path(setTestingPath());
+    std::ifstream statFile(std::filesystem::current_path() / "666" / "stat");
+    std::string content((std::istreambuf_iterator<char>(statFile)), std::istreambuf_iterator<char>());
+    content.replace(content.find("(gcr-ssh-agent)"), sizeof("(gcr-ssh-agent)") - 1u, "(Web Content) (x)");
+
+    const proc::StatFields statMap = processInfoAccessor.parseStatLine(content);
+    ASSERT_EQ(125, statMap.at(14u));
+    ASSERT_EQ(4685, statMap.at(22u));
+    ASSERT_EQ(1, statMap.at(39u));
+}
+
+TEST_F(ProcessInfoTest, checkScanProcDir_namesReadOncePerProcessAndAgainOnExec_Ok)
+{
+    // a copy of the simulated /proc, the stat of 666 is rewritten as an exec would
+    const std::filesystem::path procPath = std::filesystem::temp_directory_path() / ("ProcessInfoTestNames." + std::to_string(::getpid()));
+    std::filesystem::create_directories(procPath / "666");
+    std::filesystem::copy_file(setTestingPath() / "uptime", procPath / "uptime", std::filesystem::copy_options::overwrite_existing);
+    std::filesystem::copy_file(setTestingPath() / "meminfo", procPath / "meminfo", std::filesystem::copy_options::overwrite_existing);
+    std::ifstream statFile(setTestingPath() / "666" / "stat");
+    const std::string stat((std::istreambuf_iterator<char>(statFile)), std::istreambuf_iterator<char>());
+    std::ofstream(procPath / "666" / "stat") << stat;
+    std::ofstream(procPath / "666" / "cmdline") << std::string("/usr/libexec/gcr-ssh-agent\0--base-dir\0/run/user/1000/gcr\0", 57u);
+
+    ProcessInfoAccessor collector(utils::procfs::IoBackend::Sync);
+    std::filesystem::current_path(procPath);
+    collector.scanProcDir();
+    collector.scanProcDir();
+    const PidTable_t& scan = collector.scanProcDir();
+    ASSERT_EQ("gcr-ssh-agent", collector.getNames().view(scan.at(666u)._name));
+    ASSERT_EQ("/usr/libexec/gcr-ssh-agent --base-dir /run/user/1000/gcr", collector.getNames().view(scan.at(666u)._cmdline));
+    ASSERT_EQ(1u, collector.getCmdlineReads());
+    ASSERT_EQ(1966u, scan.at(666u)._session);
+    ASSERT_EQ(::geteuid(), scan.at(666u)._uid);
+
+    std::string execed = stat;
+    execed.replace(execed.find("gcr-ssh-agent"), sizeof("gcr-ssh-agent") - 1u, "sh");
+    std::ofstream(procPath / "666" / "stat") << execed;
+    std::ofstream(procPath / "666" / "cmdline") << std::string("sh\0-c\0true\0", 11u);
+    collector.scanProcDir();
+    ASSERT_EQ("sh", collector.getNames().view(scan.at(666u)._name));
+    ASSERT_EQ("sh -c true", collector.getNames().view(scan.at(666u)._cmdline));
+    ASSERT_EQ(2u, collector.getCmdlineReads());
+
+    std::filesystem::current_path(setTestingPath());
+    std::filesystem::remove_all(procPath);
+}
+
+TEST_F(ProcessInfoTest, checkScanProcDir_syncAndIoUringBackends_sameSnapshot_Ok)
+{
+    ProcessInfoAccessor syncCollector(utils::procfs::IoBackend::Sync);
+    ProcessInfoAccessor autoCollector(utils::procfs::IoBackend::Auto);
+    ASSERT_STREQ("sync", syncCollector.getStatReader().name());
+
+    std::filesystem::current_path(setTestingPath());
+    const PidTable_t syncSnapshot = syncCollector.scanProcDir();
+    const PidTable_t autoSnapshot = autoCollector.scanProcDir();
+
+    ASSERT_EQ(1u, syncSnapshot.size());
+    ASSERT_EQ(3u, syncSnapshot.at(666u)._threads);
+    ASSERT_EQ(4685u, syncSnapshot.at(666u)._startTime);
+    ASSERT_EQ(1, syncSnapshot.at(666u)._processor);
+    ASSERT_EQ(1u, autoSnapshot.size());
+    ASSERT_EQ(syncSnapshot.at(666u)._threads, autoSnapshot.at(666u)._threads);
+    ASSERT_EQ(syncSnapshot.at(666u)._startTime, autoSnapshot.at(666u)._startTime);
+    ASSERT_DOUBLE_EQ(syncSnapshot.at(666u)._memory, autoSnapshot.at(666u)._memory);
+}
+
+TEST_F(ProcessInfoTest, checkScanProcDir_sampleStride_unreadPidKeepsLastValues_Ok)
+{
+    ProcessInfoAccessor collector(utils::procfs::IoBackend::Sync);
+    collector.setSampleStride(2u);
+    std::filesystem::current_path(setTestingPath());
+
+    // 666 is even : read by the first round, kept by the second one
+    const PidTable_t firstRound = collector.scanProcDir();
+    const PidTable_t secondRound = collector.scanProcDir();
+    ASSERT_EQ(1u, firstRound.size());
+    ASSERT_EQ(1u, secondRound.size());
+    ASSERT_EQ(firstRound.at(666u)._startTime, secondRound.at(666u)._startTime);
+    ASSERT_EQ(3u, secondRound.at(666u)._threads);
+}
+
+TEST_F(ProcessInfoTest, checkScanPids_onlyAskedPidsRead_nothingSwept_Ok)
+{
+    ProcessInfoAccessor collector(utils::procfs::IoBackend::Sync);
+    std::filesystem::current_path(setTestingPath());
+    PidStats earlier{};
+    earlier._threads = 9u;
+    collector.accessPidStatus().upsert(42u) = earlier;
+
+    // 667 doesn't exist : skipped, 42 isn't asked for : left as it was
+    const PidTable_t& afterPass = collector.scanPids({666u, 667u});
+    ASSERT_EQ(2u, afterPass.size());
+    ASSERT_EQ(3u, afterPass.at(666u)._threads);
+    ASSERT_EQ(9u, afterPass.at(42u)._threads);
+    ASSERT_EQ(nullptr, afterPass.find(667u));
+
+    // the full scan that follows sweeps what /proc doesn't have
+    ASSERT_EQ(1u, collector.scanProcDir().size());
 }
 
 TEST_F(ProcessInfoTest, checkStatMap_noStatMap_throwModerate)
 {
     std::filesystem::current_path(setTestingPath());
-    std::unordered_map<uint, std::string> statMap;
+    proc::StatFields statMap;
     
     ASSERT_THROW(statMap = processInfoAccessor.fillStatMap(
         std::filesystem::path(std::filesystem::current_path() / "fs(dummy_folder_to_simulate)")), utils::SeverityException<utils::ModerateException>);
@@ -154,19 +275,13 @@ TEST_F(ProcessInfoTest, checkCalculateCpu_calculatedOk)
     std::filesystem::current_path(setTestingPath());
 
     // set up statMap and check outcome
-    const std::unordered_map<uint, std::string> statMap = processInfoAccessor.fillStatMap(
+    const proc::StatFields statMap = processInfoAccessor.fillStatMap(
         std::filesystem::path(std::filesystem::current_path() / "666" / "stat"));
-    ASSERT_EQ(5u, statMap.size());
-    ASSERT_EQ(1u, statMap.count(14u));
-    ASSERT_EQ(1u, statMap.count(15u));
-    ASSERT_EQ(1u, statMap.count(20u));
-    ASSERT_EQ(1u, statMap.count(22u));
-    ASSERT_EQ(1u, statMap.count(24u));
-    ASSERT_EQ("125", statMap.at(14u));
-    ASSERT_EQ("954", statMap.at(15u));
-    ASSERT_EQ("3", statMap.at(20u));
-    ASSERT_EQ("4685", statMap.at(22u));
-    ASSERT_EQ("1696", statMap.at(24u));
+    ASSERT_EQ(125, statMap.at(14u));
+    ASSERT_EQ(954, statMap.at(15u));
+    ASSERT_EQ(3, statMap.at(20u));
+    ASSERT_EQ(4685, statMap.at(22u));
+    ASSERT_EQ(1696, statMap.at(24u));
 
     // set up generic uptime
     std::filesystem::current_path(setTestingPath());
@@ -178,11 +293,29 @@ TEST_F(ProcessInfoTest, checkCalculateCpu_calculatedOk)
     ASSERT_EQ(0.19123474907306975, cpuTime);
 }
 
+TEST_F(ProcessInfoTest, checkCalculateCpu_startedInTheCurrentTick_oneTickOfLifeOk)
+{
+    const double clockTicks = static_cast<double>(sysconf(_SC_CLK_TCK));
+    proc::StatFields statMap;
+    // utime (14) of one tick, stime (15) of none, starttime (22) of 4685 ticks
+    statMap._values[1u] = 1;
+    statMap._values[4u] = 4685;
+
+    // no time since the start, then an uptime behind the starttime : a tick of CPU in a tick of life
+    ASSERT_DOUBLE_EQ(100.0, processInfoAccessor.calculateCpu(statMap, 4685.0 / clockTicks));
+    ASSERT_DOUBLE_EQ(100.0, processInfoAccessor.calculateCpu(statMap, 4684.0 / clockTicks));
+
+    statMap._values[1u] = 0;
+    ASSERT_DOUBLE_EQ(0.0, processInfoAccessor.calculateCpu(statMap, 4685.0 / clockTicks));
+}
+
 TEST_F(ProcessInfoTest, checkRefine_RefinedDoublesOk)
 {
     ASSERT_EQ("0.19%", processInfoAccessor.refineDouble(0.19123474907306975));
     ASSERT_EQ("12.54%", processInfoAccessor.refineDouble(12.5436667854642456));
-    ASSERT_EQ("0.0%", processInfoAccessor.refineDouble(0.0043));
+    ASSERT_EQ("0.00%", processInfoAccessor.refineDouble(0.0043));
+    ASSERT_EQ("0.05%", processInfoAccessor.refineDouble(0.05));
+    ASSERT_EQ("1.05%", processInfoAccessor.refineDouble(1.05));
 }
 
 TEST_F(ProcessInfoTest, checkMeminfo_parsedAndFetchedValueOk)
@@ -208,12 +341,10 @@ TEST_F(ProcessInfoTest, checkCalculateMemory_memoryCalculatedOk)
     std::filesystem::current_path(setTestingPath());
 
     // fill up statMap but check only vital entries
-    std::unordered_map<uint, std::string> statMap;
+    proc::StatFields statMap;
     ASSERT_NO_THROW(statMap = processInfoAccessor.fillStatMap(
         std::filesystem::path(std::filesystem::current_path() / "666" / "stat")));
-    ASSERT_EQ(5u, statMap.size());
-    ASSERT_EQ(1u, statMap.count(24u));
-    ASSERT_EQ("1696", statMap.at(24u));
+    ASSERT_EQ(1696, statMap.at(24u));
 
     // get the generic uptime
     std::filesystem::current_path(setTestingPath());
@@ -234,12 +365,10 @@ TEST_F(ProcessInfoTest, checkCalculateProcessUptime_calculatedOk)
     std::filesystem::current_path(setTestingPath());
 
     // fill up statMap but check only vital entries
-    std::unordered_map<uint, std::string> statMap;
+    proc::StatFields statMap;
     ASSERT_NO_THROW(statMap = processInfoAccessor.fillStatMap(
         std::filesystem::path(std::filesystem::current_path() / "666" / "stat")));
-    ASSERT_EQ(5u, statMap.size());
-    ASSERT_EQ(1u, statMap.count(22u));
-    ASSERT_EQ("4685", statMap.at(22u));
+    ASSERT_EQ(4685, statMap.at(22u));
 
     // set up generic uptime
     std::filesystem::current_path(setTestingPath());
@@ -259,7 +388,7 @@ TEST_F(ProcessInfoTest, checkExportInFile_exportingManyPidInfo_Ok)
 {
     std::filesystem::current_path(setTestingPath());
 
-    proc::PidStatus_t& pidStatus = processInfoAccessor.accessPidStatus();
+    proc::PidTable_t& pidStatus = processInfoAccessor.accessPidStatus();
     proc::PidStats stats;
     
     stats._cpu = 0.123456;
@@ -272,11 +401,12 @@ TEST_F(ProcessInfoTest, checkExportInFile_exportingManyPidInfo_Ok)
 
     for(int i=0; i<200; ++i)
     {
-        pidStatus[i] = stats;
+        pidStatus.upsert(i) = stats;
     }
 
     processInfoAccessor.accessOldPath() = std::filesystem::current_path();
     processInfoAccessor.exportInFile();
+    processInfoAccessor.waitForExport();
 
     ASSERT_EQ_FILES(
         std::filesystem::path(processInfoAccessor.accessOldPath().parent_path() / "export/ProcessesStatus.txt"),
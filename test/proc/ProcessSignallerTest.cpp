@@ -0,0 +1,167 @@
+#include <gtest/gtest.h>
+#include <ProcessSignaller.hpp>
+
+#include <csignal>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+namespace proc
+{
+
+class ProcessSignallerAccessor : public ProcessSignaller
+{
+public:
+    using ProcessSignaller::readStartTime;
+};
+
+class ProcessSignallerTest : public ::testing::Test
+{
+public:
+    void TearDown() override
+    {
+        for(const pid_t child : _children)
+        {
+            ::kill(child, SIGKILL);
+            ::waitpid(child, nullptr, 0);
+        }
+    }
+
+    std::vector<SignalTarget> spawnSleepingChildren(const uint count)
+    {
+        std::vector<SignalTarget> targets;
+        for(uint i=0; i<count; ++i)
+        {
+            const pid_t child = ::fork();
+            if(child == 0)
+            {
+                while(1)
+                {
+                    ::pause();
+                }
+            }
+            _children.push_back(child);
+            targets.push_back(SignalTarget{static_cast<uint>(child), accessor.readStartTime(child)});
+        }
+        return targets;
+    }
+
+    ProcessSignallerAccessor accessor;
+    std::vector<pid_t> _children;
+};
+
+TEST_F(ProcessSignallerTest, checkReadStartTime_fromFakeProc_Ok)
+{
+    const std::filesystem::path fakeProc(std::filesystem::current_path().parent_path() / "test/data/simulateProc/proc");
+    class FakeProcAccessor : public ProcessSignaller
+    {
+    public:
+        using ProcessSignaller::ProcessSignaller;
+        using ProcessSignaller::readStartTime;
+    } fakeAccessor(fakeProc);
+
+    ASSERT_EQ(4685u, fakeAccessor.readStartTime(666u));
+    ASSERT_EQ(0u, fakeAccessor.readStartTime(667u));
+}
+
+TEST_F(ProcessSignallerTest, checkTermManyChildren_allExitedWithLatency_Ok)
+{
+    const std::vector<SignalTarget> targets = spawnSleepingChildren(32u);
+    const std::vector<SignalReport> reports = accessor.deliver(targets, SIGTERM, std::chrono::milliseconds(5000));
+
+    ASSERT_EQ(targets.size(), reports.size());
+    for(std::size_t i=0; i<reports.size(); ++i)
+    {
+        EXPECT_EQ(targets[i]._pid, reports[i]._pid);
+        EXPECT_EQ(SignalOutcome::Exited, reports[i]._outcome);
+        EXPECT_LT(reports[i]._latency, std::chrono::milliseconds(5000));
+    }
+}
+
+TEST_F(ProcessSignallerTest, checkReusedPid_identityMismatch_nothingSent)
+{
+    std::vector<SignalTarget> targets = spawnSleepingChildren(1u);
+    ++targets.front()._startTime; // what a recycled pid looks like : same number, another process
+
+    const std::vector<SignalReport> reports = accessor.deliver(targets, SIGKILL, std::chrono::milliseconds(100));
+
+    ASSERT_EQ(SignalOutcome::IdentityMismatch, reports.front()._outcome);
+    int status{0};
+    ASSERT_EQ(0, ::waitpid(static_cast<pid_t>(targets.front()._pid), &status, WNOHANG)); // still running
+}
+
+TEST_F(ProcessSignallerTest, checkStopAndContinue_deliveredWithoutWaiting_Ok)
+{
+    const std::vector<SignalTarget> targets = spawnSleepingChildren(2u);
+
+    std::vector<SignalReport> reports = accessor.deliver(targets, SIGSTOP, std::chrono::milliseconds(5000));
+    for(const SignalReport& report : reports)
+    {
+        EXPECT_EQ(SignalOutcome::Delivered, report._outcome);
+    }
+    int status{0};
+    ASSERT_EQ(static_cast<pid_t>(targets.front()._pid), ::waitpid(static_cast<pid_t>(targets.front()._pid), &status, WUNTRACED));
+    ASSERT_TRUE(WIFSTOPPED(status));
+
+    reports = accessor.deliver(targets, SIGCONT, std::chrono::milliseconds(0));
+    for(const SignalReport& report : reports)
+    {
+        EXPECT_EQ(SignalOutcome::Delivered, report._outcome);
+    }
+}
+
+TEST_F(ProcessSignallerTest, checkReapedChild_alreadyGone_Ok)
+{
+    std::vector<SignalTarget> targets = spawnSleepingChildren(1u);
+    ::kill(static_cast<pid_t>(targets.front()._pid), SIGKILL);
+    ::waitpid(static_cast<pid_t>(targets.front()._pid), nullptr, 0);
+    _children.clear();
+
+    const std::vector<SignalReport> reports = accessor.deliver(targets, SIGTERM, std::chrono::milliseconds(100));
+    ASSERT_EQ(SignalOutcome::AlreadyGone, reports.front()._outcome);
+}
+
+TEST_F(ProcessSignallerTest, checkLowFdLimit_raisedForThePidfds_oneReportPerTargetInOrder_Ok)
+{
+    std::vector<SignalTarget> targets = spawnSleepingChildren(3u);
+    // the middle one gone before the signal
+    ::kill(static_cast<pid_t>(targets[1]._pid), SIGKILL);
+    ::waitpid(static_cast<pid_t>(targets[1]._pid), nullptr, 0);
+    _children.erase(_children.begin() + 1);
+    const std::vector<SignalTarget> more = spawnSleepingChildren(61u);
+    targets.insert(targets.end(), more.begin(), more.end());
+
+    struct rlimit original{};
+    ASSERT_EQ(0, ::getrlimit(RLIMIT_NOFILE, &original));
+    if(original.rlim_max != RLIM_INFINITY && original.rlim_max < 256u)
+    {
+        GTEST_SKIP() << "hard RLIMIT_NOFILE too low to raise the soft one";
+    }
+    struct rlimit low = original;
+    low.rlim_cur = 96u;
+    ASSERT_EQ(0, ::setrlimit(RLIMIT_NOFILE, &low));
+
+    const std::vector<SignalReport> reports = accessor.deliver(targets, SIGTERM, std::chrono::milliseconds(5000));
+    struct rlimit raised{};
+    ::getrlimit(RLIMIT_NOFILE, &raised);
+    ::setrlimit(RLIMIT_NOFILE, &original);
+
+    ASSERT_GE(raised.rlim_cur, targets.size());
+    ASSERT_EQ(targets.size(), reports.size());
+    for(std::size_t i=0; i<targets.size(); ++i)
+    {
+        EXPECT_EQ(targets[i]._pid, reports[i]._pid);
+        EXPECT_EQ(i == 1u ? SignalOutcome::AlreadyGone : SignalOutcome::Exited, reports[i]._outcome);
+    }
+}
+
+TEST_F(ProcessSignallerTest, checkParseSignal_namesAndNumbers_Ok)
+{
+    ASSERT_EQ(SIGTERM, parseSignal("TERM"));
+    ASSERT_EQ(SIGKILL, parseSignal("SIGKILL"));
+    ASSERT_EQ(SIGSTOP, parseSignal("19"));
+    ASSERT_EQ(-1, parseSignal("NOPE"));
+}
+
+}
\ No newline at end of file
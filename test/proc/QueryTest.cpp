@@ -0,0 +1,259 @@
+#include <gtest/gtest.h>
+#include <Query.hpp>
+#include <CliOptions.hpp>
+#include <Exception.hpp>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <unistd.h>
+
+namespace proc
+{
+namespace query
+{
+
+class QueryTest : public ::testing::Test
+{
+public:
+    using Rows = std::vector<std::pair<uint, PidStats>>;
+
+    static PidStats makeStats(const double cpu, const double memory, const uint threads, const uint uptimeSeconds,
+        const utils::StringTable::Id name = utils::StringTable::kEmpty)
+    {
+        PidStats stats{};
+        stats._cpu = cpu;
+        stats._memory = memory;
+        stats._threads = threads;
+        stats._timezone._hours = uptimeSeconds / 3600u;
+        stats._timezone._minutes = uptimeSeconds / 60u % 60u;
+        stats._timezone._seconds = uptimeSeconds % 60u;
+        stats._uid = 1000u;
+        stats._session = 7u;
+        stats._name = name;
+        return stats;
+    }
+
+    // the pids of `rows` kept by `filter`
+    static std::vector<uint> select(const Rows& rows, std::string_view filter, const utils::StringTable* names = nullptr)
+    {
+        Rows kept = rows;
+        retain(kept, compile(filter), names);
+        std::vector<uint> pids;
+        for(const std::pair<uint, PidStats>& row : kept)
+        {
+            pids.push_back(row.first);
+        }
+        return pids;
+    }
+};
+
+TEST_F(QueryTest, checkCompile_malformedFilters_Ko)
+{
+    for(const char* malformed : {"cpu >", "cpu 5", "load > 1", "cpu > 5 &&", "(cpu > 5", "cpu > 5)", "cpu >> 5",
+        "uptime < 10 days", "name > bash", "name == \"unterminated", "cpu > 5 & mem > 1", "!", "user == nobody-such-login-here"})
+    {
+        ASSERT_THROW(compile(malformed), utils::SeverityException<utils::SeriousException>) << malformed;
+    }
+    try
+    {
+        compile("cpu > 5 && mem >");
+        FAIL();
+    }
+    catch(const utils::SeverityException<utils::SeriousException>& e)
+    {
+        // where it went wrong is told
+        ASSERT_NE(std::string::npos, std::string(e.what()).find("at 17"));
+    }
+    ASSERT_TRUE(compile("").selectsAll());
+    ASSERT_TRUE(compile("   ").selectsAll());
+    ASSERT_FALSE(compile("cpu > 5").selectsAll());
+    ASSERT_EQ("cpu > 5", compile("cpu > 5").getText());
+}
+
+TEST_F(QueryTest, checkEvaluate_everyColumnAndComparison_Ok)
+{
+    Rows rows;
+    rows.emplace_back(1u, makeStats(0.5, 0.2, 1u, 30u));
+    rows.emplace_back(2u, makeStats(5.0, 1.5, 60u, 300u));
+    rows.emplace_back(3u, makeStats(12.0, 3.0, 8u, 7200u));
+    rows.back().second._uid = 0u;
+    rows.back().second._session = 3u;
+
+    ASSERT_EQ((std::vector<uint>{2u, 3u}), select(rows, "cpu >= 5"));
+    ASSERT_EQ((std::vector<uint>{3u}), select(rows, "cpu > 5%"));
+    ASSERT_EQ((std::vector<uint>{1u}), select(rows, "cpu < 5"));
+    ASSERT_EQ((std::vector<uint>{1u, 2u}), select(rows, "cpu <= 5"));
+    ASSERT_EQ((std::vector<uint>{2u}), select(rows, "cpu == 5"));
+    ASSERT_EQ((std::vector<uint>{1u, 3u}), select(rows, "cpu != 5"));
+    ASSERT_EQ((std::vector<uint>{2u, 3u}), select(rows, "mem > 1"));
+    ASSERT_EQ((std::vector<uint>{3u}), select(rows, "memory >= 3"));
+    ASSERT_EQ((std::vector<uint>{1u}), select(rows, "rss < 1"));
+    ASSERT_EQ((std::vector<uint>{2u}), select(rows, "threads > 50"));
+    ASSERT_EQ((std::vector<uint>{1u, 2u}), select(rows, "pid <= 2"));
+    ASSERT_EQ((std::vector<uint>{3u}), select(rows, "uid == 0"));
+    ASSERT_EQ((std::vector<uint>{3u}), select(rows, "user == root"));
+    ASSERT_EQ((std::vector<uint>{1u, 2u}), select(rows, "session != 3"));
+}
+
+TEST_F(QueryTest, checkEvaluate_uptimeUnits_Ok)
+{
+    Rows rows;
+    rows.emplace_back(1u, makeStats(0.0, 0.0, 1u, 30u));
+    rows.emplace_back(2u, makeStats(0.0, 0.0, 1u, 300u));
+    rows.emplace_back(3u, makeStats(0.0, 0.0, 1u, 7200u));
+
+    ASSERT_EQ((std::vector<uint>{1u, 2u}), select(rows, "uptime < 10m"));
+    ASSERT_EQ((std::vector<uint>{1u, 2u}), select(rows, "uptime < 10min"));
+    ASSERT_EQ((std::vector<uint>{1u}), select(rows, "uptime < 60"));
+    ASSERT_EQ((std::vector<uint>{1u}), select(rows, "uptime < 60s"));
+    ASSERT_EQ((std::vector<uint>{1u}), select(rows, "uptime < 30500ms"));
+    ASSERT_EQ((std::vector<uint>{3u}), select(rows, "uptime >= 2h"));
+}
+
+TEST_F(QueryTest, checkEvaluate_precedenceNotAndParentheses_Ok)
+{
+    Rows rows;
+    for(uint pid=1; pid<=8u; ++pid)
+    {
+        // the bits of the pid : cpu busy, memory heavy, many threads
+        rows.emplace_back(pid, makeStats((pid & 1u) ? 10.0 : 0.0, (pid & 2u) ? 10.0 : 0.0, (pid & 4u) ? 100u : 1u, 1u));
+    }
+    // && binds tighter : cpu || (mem && threads)
+    ASSERT_EQ((std::vector<uint>{1u, 3u, 5u, 6u, 7u}), select(rows, "cpu > 1 || mem > 1 && threads > 50"));
+    ASSERT_EQ((std::vector<uint>{3u, 5u, 6u, 7u}), select(rows, "(cpu > 1 || mem > 1) && threads > 50 || cpu > 1 && mem > 1"));
+    ASSERT_EQ((std::vector<uint>{2u, 4u, 6u, 8u}), select(rows, "!cpu > 1"));
+    ASSERT_EQ((std::vector<uint>{1u, 2u, 3u, 4u, 8u}), select(rows, "!(mem > 1 && threads > 50) && !(cpu > 1 && threads > 50 && mem < 1) || pid == 8"));
+    ASSERT_EQ((std::vector<uint>{1u, 3u, 5u, 7u}), select(rows, "!!(cpu > 1)"));
+}
+
+TEST_F(QueryTest, checkEvaluate_names_Ok)
+{
+    utils::StringTable names;
+    Rows rows;
+    rows.emplace_back(1u, makeStats(0.0, 0.0, 1u, 1u, names.intern("nginx")));
+    rows.emplace_back(2u, makeStats(0.0, 0.0, 1u, 1u, names.intern("Web Content")));
+    rows.emplace_back(3u, makeStats(0.0, 0.0, 1u, 1u));
+
+    ASSERT_EQ((std::vector<uint>{1u}), select(rows, "name == nginx", &names));
+    ASSERT_EQ((std::vector<uint>{2u}), select(rows, "name == \"Web Content\"", &names));
+    ASSERT_EQ((std::vector<uint>{2u, 3u}), select(rows, "name != nginx", &names));
+    // a name no process has : nothing equal, everything different
+    ASSERT_TRUE(select(rows, "name == sshd", &names).empty());
+    ASSERT_EQ((std::vector<uint>{1u, 2u, 3u}), select(rows, "name != sshd", &names));
+    // without a table every row has the empty name
+    ASSERT_TRUE(select(rows, "name == nginx").empty());
+}
+
+TEST_F(QueryTest, checkEvaluate_acrossBlocksTailMasked_Ok)
+{
+    // a couple of blocks, and a last word only partly used
+    const std::size_t rowCount = Predicate::kBlockRows * 2u + 77u;
+    Columns columns;
+    for(std::size_t row=0; row<rowCount; ++row)
+    {
+        columns.append(static_cast<uint>(row), makeStats(static_cast<double>(row % 3u), 0.0, 1u, 1u));
+    }
+    Bitmap selection;
+    compile("cpu == 1 || !(cpu < 5)").evaluate(columns, selection);
+    ASSERT_EQ((rowCount + 63u) / 64u, selection.size());
+    std::size_t selected{0u};
+    for(std::size_t row=0; row<rowCount; ++row)
+    {
+        ASSERT_EQ(row % 3u == 1u, isSelected(selection, row)) << row;
+        selected += isSelected(selection, row) ? 1u : 0u;
+    }
+    ASSERT_EQ(rowCount / 3u, selected);
+
+    // no bit past the last row, even when every row holds
+    compile("!(cpu > 100)").evaluate(columns, selection);
+    ASSERT_EQ((std::uint64_t{1u} << (rowCount % 64u)) - 1u, selection.back());
+    Predicate().evaluate(columns, selection);
+    ASSERT_EQ((std::uint64_t{1u} << (rowCount % 64u)) - 1u, selection.back());
+
+    columns.clear();
+    compile("cpu > 1").evaluate(columns, selection);
+    ASSERT_TRUE(selection.empty());
+}
+
+TEST_F(QueryTest, checkSelectOptions_filterCheckedUpFront_Ok)
+{
+    const char* argv[] = {"out", "--select", "capture.txt", "--where", "cpu > 5 && uptime < 10m"};
+    const cli::Options options = cli::parseOptions(5, argv);
+    ASSERT_EQ(cli::Mode::Select, options._mode);
+    ASSERT_EQ(std::filesystem::absolute("capture.txt"), options._selectFile);
+    ASSERT_EQ("cpu > 5 && uptime < 10m", options._where);
+    ASSERT_EQ(format::Kind::Text, options._format);
+
+    const char* typo[] = {"out", "-b", "--where", "cpu >> 5"};
+    ASSERT_THROW(cli::parseOptions(4, typo), utils::SeverityException<utils::SeriousException>);
+    const char* cgroups[] = {"out", "-b", "-g", "--where", "cpu > 5"};
+    ASSERT_THROW(cli::parseOptions(5, cgroups), utils::SeverityException<utils::SeriousException>);
+}
+
+TEST_F(QueryTest, checkRun_selectionOfAnExport_Ok)
+{
+    const std::string base = (std::filesystem::temp_directory_path() / ("QueryTest." + std::to_string(::getpid()))).string();
+    const std::string exportPath = base + ".txt";
+    const std::string outputPath = base + ".csv";
+    {
+        std::ofstream exportFile(exportPath);
+        exportFile << "Pid: 30 cpu: 9.00% memory: 2.00% threads: 3 time: 0:0:1.0 name: nginx\n"
+                   << "Pid: 31 cpu: 0.50% memory: 0.10% threads: 1 time: 0:0:2.0 name: nginx\n"
+                   << "Pid: 4 cpu: 12.00% memory: 0.10% threads: 1 time: 2:0:0.0 user: 1000 session: 4 name: Web Content\n";
+    }
+    const char* argv[] = {"out", "--select", exportPath.c_str(), "--where", "cpu > 5 && name == nginx || uptime > 1h",
+        "-f", "csv", "-o", outputPath.c_str()};
+    ASSERT_EQ(0, run(cli::parseOptions(9, argv)));
+
+    std::ifstream output(outputPath);
+    const std::string content((std::istreambuf_iterator<char>(output)), std::istreambuf_iterator<char>());
+    std::filesystem::remove(exportPath);
+    std::filesystem::remove(outputPath);
+    // the header and the two matching rows, in file order
+    ASSERT_EQ(3, std::count(content.begin(), content.end(), '\n'));
+    ASSERT_LT(content.find("30,"), content.find("Web Content"));
+    ASSERT_EQ(std::string::npos, content.find("31,"));
+}
+
+TEST_F(QueryTest, checkEvaluate_throughputOverAMillionRows_Ok)
+{
+    constexpr std::size_t kRows = 1'000'000u;
+    std::mt19937 random(42u);
+    Columns columns;
+    columns.reserve(kRows);
+    for(std::size_t row=0; row<kRows; ++row)
+    {
+        columns.append(static_cast<uint>(row), makeStats(static_cast<double>(random() % 10000u) / 100.0,
+            static_cast<double>(random() % 1000u) / 100.0, random() % 128u, random() % 3600u));
+    }
+    const Predicate predicate = compile("cpu > 5 && mem > 1 && threads > 50 && uptime < 10m");
+    Bitmap selection;
+    predicate.evaluate(columns, selection);
+
+    constexpr int kRounds = 10;
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(int round=0; round<kRounds; ++round)
+    {
+        predicate.evaluate(columns, selection);
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const double rowsPerSecond = static_cast<double>(kRows) * kRounds / seconds;
+
+    std::size_t selected{0u};
+    for(std::size_t row=0; row<kRows; ++row)
+    {
+        const bool holds = columns._cpu[row] > 5.0 && columns._memory[row] > 1.0 && columns._threads[row] > 50u && columns._uptime[row] < 600.0;
+        ASSERT_EQ(holds, isSelected(selection, row));
+        selected += holds ? 1u : 0u;
+    }
+    RecordProperty("rowsPerSecond", std::to_string(rowsPerSecond));
+    RecordProperty("selected", std::to_string(selected));
+    // the target is 50M rows/s on an optimized build, a sanitized or debug one gets some slack
+    ASSERT_GT(rowsPerSecond, 5e6);
+}
+
+}
+}
@@ -0,0 +1,274 @@
+#include "gtest/gtest.h"
+#include <RuleEngine.hpp>
+#include <Exception.hpp>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace proc
+{
+namespace rules
+{
+
+class RuleEngineTest : public ::testing::Test
+{
+protected:
+    static PidStats stats(const double cpu, const double memory, const unsigned long long startTime = 1u)
+    {
+        PidStats pidStats{};
+        pidStats._cpu = cpu;
+        pidStats._memory = memory;
+        pidStats._threads = 1u;
+        pidStats._startTime = startTime;
+        return pidStats;
+    }
+
+    static RuleEngine engineOf(const std::vector<std::string>& texts)
+    {
+        std::vector<Rule> compiled;
+        for(const std::string& text : texts)
+        {
+            compiled.push_back(compile(text));
+        }
+        return RuleEngine(std::move(compiled));
+    }
+};
+
+TEST_F(RuleEngineTest, checkCompile_wellFormedRules_Ok)
+{
+    const Rule cpu = compile("cpu > 80% for 30s");
+    ASSERT_EQ(Field::Cpu, cpu._field);
+    ASSERT_EQ(Kind::Above, cpu._kind);
+    ASSERT_DOUBLE_EQ(80.0, cpu._threshold);
+    ASSERT_EQ(30'000, cpu._holdMs);
+
+    const Rule rss = compile("rss rising for 5m");
+    ASSERT_EQ(Field::Memory, rss._field);
+    ASSERT_EQ(Kind::Rising, rss._kind);
+    ASSERT_EQ(300'000, rss._holdMs);
+
+    const Rule count = compile("count<=3");
+    ASSERT_EQ(Field::Count, count._field);
+    ASSERT_EQ(Kind::AtMost, count._kind);
+    ASSERT_EQ(0, count._holdMs);
+}
+
+TEST_F(RuleEngineTest, checkCompile_malformedRules_Throws)
+{
+    for(const char* text : {"disk > 3", "cpu 80", "cpu >", "threads > 5%", "cpu > 80 for", "cpu > 80 for 3 weeks", "cpu > 80 for 3s and more"})
+    {
+        ASSERT_THROW(compile(text), utils::SeverityException<utils::SeriousException>) << text;
+    }
+}
+
+TEST_F(RuleEngineTest, checkThresholdForDuration_firesOncePerStreak_Ok)
+{
+    RuleEngine engine = engineOf({"cpu > 80% for 2s", "cpu >= 50"});
+    PidStatus_t snapshot;
+    snapshot.emplace(666u, stats(90.0, 1.0));
+
+    // 50 holds right away, 80 only after 2 seconds
+    ASSERT_EQ(1u, engine.evaluate(0, snapshot).size());
+    ASSERT_TRUE(engine.evaluate(1000, snapshot).empty());
+    const std::vector<Alert> fired = engine.evaluate(2000, snapshot);
+    ASSERT_EQ(1u, fired.size());
+    ASSERT_EQ(0u, fired[0]._rule);
+    ASSERT_EQ(666u, fired[0]._pid);
+    ASSERT_EQ(0, fired[0]._sinceMs);
+    ASSERT_EQ(2u, engine.getFiringCount());
+    ASSERT_TRUE(engine.evaluate(3000, snapshot).empty());
+
+    // drops under 80 : that streak is over, the next one starts from scratch
+    snapshot[666u] = stats(60.0, 1.0);
+    ASSERT_TRUE(engine.evaluate(4000, snapshot).empty());
+    ASSERT_EQ(1u, engine.getFiringCount());
+    snapshot[666u] = stats(95.0, 1.0);
+    ASSERT_TRUE(engine.evaluate(5000, snapshot).empty());
+    ASSERT_TRUE(engine.evaluate(6000, snapshot).empty());
+    ASSERT_EQ(1u, engine.evaluate(7000, snapshot).size());
+}
+
+TEST_F(RuleEngineTest, checkBelowRules_strictAndNot_Ok)
+{
+    RuleEngine engine = engineOf({"memory < 10", "memory <= 10", "memory < 5"});
+    PidStatus_t snapshot;
+    snapshot.emplace(1u, stats(0.0, 10.0));
+    snapshot.emplace(2u, stats(0.0, 4.0));
+    const std::vector<Alert> fired = engine.evaluate(0, snapshot);
+    // pid 1 : only <= 10 ; pid 2 : all three
+    ASSERT_EQ(4u, fired.size());
+    std::size_t firedForOne{0u};
+    for(const Alert& alert : fired)
+    {
+        firedForOne += alert._pid == 1u ? 1u : 0u;
+        if(alert._pid == 1u)
+        {
+            ASSERT_EQ(1u, alert._rule);
+        }
+    }
+    ASSERT_EQ(1u, firedForOne);
+}
+
+TEST_F(RuleEngineTest, checkRising_resetOnDrop_Ok)
+{
+    RuleEngine engine = engineOf({"rss rising for 3s"});
+    PidStatus_t snapshot;
+    snapshot.emplace(7u, stats(0.0, 1.0));
+    ASSERT_TRUE(engine.evaluate(0, snapshot).empty());
+    snapshot[7u] = stats(0.0, 2.0);
+    ASSERT_TRUE(engine.evaluate(1000, snapshot).empty());
+    // flat is still not dropping
+    ASSERT_TRUE(engine.evaluate(2000, snapshot).empty());
+    snapshot[7u] = stats(0.0, 1.5);
+    ASSERT_TRUE(engine.evaluate(3000, snapshot).empty());
+    for(std::int64_t second=4; second<=5; ++second)
+    {
+        snapshot[7u] = stats(0.0, static_cast<double>(second));
+        ASSERT_TRUE(engine.evaluate(second * 1000, snapshot).empty());
+    }
+    // the streak restarted at the drop
+    const std::vector<Alert> fired = engine.evaluate(6000, snapshot);
+    ASSERT_EQ(1u, fired.size());
+    ASSERT_EQ(3000, fired[0]._sinceMs);
+}
+
+TEST_F(RuleEngineTest, checkPidReusedAndGone_streaksDropped_Ok)
+{
+    RuleEngine engine = engineOf({"cpu > 10 for 1s"});
+    PidStatus_t snapshot;
+    snapshot.emplace(9u, stats(50.0, 0.0, 100u));
+    engine.evaluate(0, snapshot);
+    ASSERT_EQ(1u, engine.evaluate(1000, snapshot).size());
+
+    // another process behind the same pid starts a streak of its' own
+    snapshot[9u] = stats(50.0, 0.0, 200u);
+    ASSERT_TRUE(engine.evaluate(2000, snapshot).empty());
+    ASSERT_EQ(0u, engine.getFiringCount());
+    ASSERT_EQ(1u, engine.evaluate(3000, snapshot).size());
+
+    snapshot.clear();
+    engine.evaluate(4000, snapshot);
+    ASSERT_EQ(0u, engine.getTrackedCount());
+    ASSERT_EQ(0u, engine.getFiringCount());
+}
+
+TEST_F(RuleEngineTest, checkProcessCount_systemWide_Ok)
+{
+    RuleEngine engine = engineOf({"count < 3 for 1s"});
+    PidStatus_t snapshot;
+    snapshot.emplace(1u, stats(0.0, 0.0));
+    ASSERT_TRUE(engine.evaluate(0, snapshot).empty());
+    const std::vector<Alert> fired = engine.evaluate(1000, snapshot);
+    ASSERT_EQ(1u, fired.size());
+    ASSERT_EQ(0u, fired[0]._pid);
+    ASSERT_EQ("system : count < 3 for 1s (value 1.00)", describe(engine.getRule(0u), fired[0]));
+    // system wide rules only, nothing tracked per process
+    ASSERT_EQ(0u, engine.getTrackedCount());
+}
+
+TEST_F(RuleEngineTest, checkProcessCountOfName_resolvedThroughTheNames_Ok)
+{
+    RuleEngine engine = engineOf({"count name=nginx < 2", "count name=\"php fpm\" >= 2", "count name=redis < 1", "count > 3"});
+    ASSERT_EQ("nginx", engine.getRule(0u)._name);
+    ASSERT_EQ("php fpm", engine.getRule(1u)._name);
+
+    utils::StringTable names;
+    PidStatus_t snapshot;
+    for(uint pid=1u; pid<=4u; ++pid)
+    {
+        snapshot.emplace(pid, stats(0.0, 0.0));
+        snapshot[pid]._name = names.intern(pid == 1u ? "nginx" : "php fpm");
+    }
+
+    // one nginx, three php fpm, no redis in the table at all, four processes
+    const std::vector<Alert> fired = engine.evaluate(0, snapshot, &names);
+    ASSERT_EQ(4u, fired.size());
+    ASSERT_EQ("system : count name=nginx < 2 (value 1.00)", describe(engine.getRule(fired[0]._rule), fired[0]));
+    ASSERT_EQ(3.0, fired[1]._value);
+    ASSERT_EQ(0.0, fired[2]._value);
+    ASSERT_EQ(4.0, fired[3]._value);
+
+    // without a table, no process has a name
+    RuleEngine unnamed = engineOf({"count name=nginx < 1"});
+    ASSERT_EQ(1u, unnamed.evaluate(0, snapshot).size());
+
+    ASSERT_THROW(compile("cpu name=nginx > 3"), utils::SeverityException<utils::SeriousException>);
+    ASSERT_THROW(compile("count name= < 3"), utils::SeverityException<utils::SeriousException>);
+    ASSERT_THROW(compile("count name=\"nginx < 3"), utils::SeverityException<utils::SeriousException>);
+}
+
+TEST_F(RuleEngineTest, checkLoadRules_lineOfTheError_Ok)
+{
+    const std::filesystem::path rulesFile = std::filesystem::temp_directory_path() / "RuleEngineTest.rules";
+    {
+        std::ofstream file(rulesFile);
+        file << "# hot processes\ncpu > 80% for 30s\n\nthreads >= 500 # forks\n";
+    }
+    const std::vector<Rule> loaded = loadRules(rulesFile);
+    ASSERT_EQ(2u, loaded.size());
+    ASSERT_EQ("threads >= 500", loaded[1]._text);
+
+    {
+        std::ofstream file(rulesFile);
+        file << "cpu > 80%\ncpu >> 80%\n";
+    }
+    try
+    {
+        loadRules(rulesFile);
+        FAIL() << "The malformed second line wasn't reported";
+    }
+    catch(const utils::SeverityException<utils::SeriousException>& e)
+    {
+        ASSERT_NE(std::string::npos, std::string(e.what()).find(":2 : "));
+    }
+    std::filesystem::remove(rulesFile);
+}
+
+TEST_F(RuleEngineTest, checkTwoHundredRules_twentyThousandProcesses_Ok)
+{
+    std::vector<std::string> texts;
+    for(uint rule=0; rule<50u; ++rule)
+    {
+        texts.push_back("cpu > " + std::to_string(rule * 2u) + " for " + std::to_string(rule) + "s");
+        texts.push_back("memory >= " + std::to_string(rule) + "% for 10s");
+        texts.push_back("threads >= " + std::to_string(rule * 10u) + " for 5s");
+        texts.push_back(rule % 2u == 0u ? "rss rising for " + std::to_string(rule + 1u) + "m" : "count > " + std::to_string(rule * 1000u));
+    }
+    RuleEngine engine = engineOf(texts);
+
+    // like a desktop : most processes idle, one in ten busy with a cpu jumping around
+    PidStatus_t snapshot;
+    for(uint pid=1; pid<=20'000u; ++pid)
+    {
+        PidStats pidStats = stats(0.0, (pid % 50u) / 10.0, pid);
+        pidStats._threads = 1u + pid % 8u;
+        snapshot.emplace(pid, pidStats);
+    }
+    engine.evaluate(0, snapshot);
+
+    static constexpr uint kTicks = 20u;
+    double totalMs{0.0};
+    for(uint tick=1; tick<=kTicks; ++tick)
+    {
+        for(PidStatus_t::value_type& pidWithStats : snapshot)
+        {
+            pidWithStats.second._cpu = pidWithStats.first % 10u == 0u ?
+                static_cast<double>((pidWithStats.first * 7u + tick * 13u) % 100u) : ((pidWithStats.first + tick) % 3u) * 0.1;
+        }
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        engine.evaluate(tick * 1000ll, snapshot);
+        totalMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    const double perTickMs = totalMs / kTicks;
+    RecordProperty("evaluateTickMicroseconds", static_cast<int>(perTickMs * 1000.0));
+    ASSERT_EQ(20'000u, engine.getTrackedCount());
+    ASSERT_GT(engine.getFiringCount(), 0u);
+    // the target is 5 ms on an optimized build, a sanitized or debug one gets some slack
+    ASSERT_LT(perTickMs, 50.0);
+}
+
+}
+}
@@ -0,0 +1,206 @@
+#include <gtest/gtest.h>
+#include <SnapshotDiff.hpp>
+#include <CliOptions.hpp>
+#include <ExportedFileWrapper.hpp>
+#include <Exception.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <unistd.h>
+
+namespace proc
+{
+namespace diff
+{
+
+class SnapshotDiffTest : public ::testing::Test
+{
+public:
+    static PidStats makeStats(const double cpu, const double memory, const uint threads)
+    {
+        PidStats stats{};
+        stats._cpu = cpu;
+        stats._memory = memory;
+        stats._threads = threads;
+        return stats;
+    }
+};
+
+TEST_F(SnapshotDiffTest, checkDiff_mergeJoinSortsEveryPid_Ok)
+{
+    const Rows_t before{{1u, makeStats(1.0, 1.0, 1u)}, {2u, makeStats(2.0, 1.0, 1u)}, {3u, makeStats(3.0, 1.0, 1u)}, {5u, makeStats(5.0, 1.0, 1u)}};
+    const Rows_t after{{2u, makeStats(6.5, 1.0, 1u)}, {3u, makeStats(3.0, 1.0, 1u)}, {4u, makeStats(4.0, 1.0, 1u)}, {5u, makeStats(5.0, 1.0, 8u)}};
+
+    const DiffResult result = diff(before, after, Metric::Cpu, 10u);
+    ASSERT_EQ(4u, result._beforeCount);
+    ASSERT_EQ(4u, result._afterCount);
+    // 5 changed its' threads only : changed, yet no cpu mover
+    ASSERT_EQ(2u, result._changed);
+    ASSERT_EQ(1u, result._unchanged);
+    ASSERT_EQ(1u, result._appeared);
+    ASSERT_EQ(1u, result._disappeared);
+    ASSERT_EQ(1u, result._movers.size());
+    ASSERT_EQ(2u, result._movers[0]._pid);
+    ASSERT_DOUBLE_EQ(4.5, result._movers[0]._score);
+    ASSERT_EQ(4u, result._appearedTop.at(0)._pid);
+    ASSERT_EQ(Change::Appeared, result._appearedTop.at(0)._change);
+    ASSERT_EQ(1u, result._disappearedTop.at(0)._pid);
+
+    const DiffResult byThreads = diff(before, after, Metric::Threads, 10u);
+    ASSERT_EQ(1u, byThreads._movers.size());
+    ASSERT_EQ(5u, byThreads._movers[0]._pid);
+}
+
+TEST_F(SnapshotDiffTest, checkDiff_topKHighestFirstTiesByPid_Ok)
+{
+    Rows_t before;
+    Rows_t after;
+    for(uint pid=1; pid<=100u; ++pid)
+    {
+        before.emplace_back(pid, makeStats(0.0, 0.0, 1u));
+        // pids 91 to 100 move the most, 50 and 60 tie
+        const double moved = pid > 90u ? static_cast<double>(pid) : pid == 50u || pid == 60u ? 70.0 : 1.0;
+        after.emplace_back(pid, makeStats(moved, 0.0, 1u));
+    }
+
+    const DiffResult result = diff(before, after, Metric::Cpu, 12u);
+    ASSERT_EQ(12u, result._movers.size());
+    for(std::size_t rank=0; rank<10u; ++rank)
+    {
+        ASSERT_EQ(100u - rank, result._movers[rank]._pid);
+    }
+    ASSERT_EQ(50u, result._movers[10]._pid);
+    ASSERT_EQ(60u, result._movers[11]._pid);
+
+    // 0 keeps every change, in pid order
+    ASSERT_EQ(100u, diff(before, after, Metric::Cpu, 0u)._movers.size());
+    ASSERT_EQ(1u, diff(before, after, Metric::Cpu, 0u)._movers.front()._pid);
+}
+
+TEST_F(SnapshotDiffTest, checkSortByPid_firstRowOfAPidKept_Ok)
+{
+    Rows_t rows{{9u, makeStats(1.0, 0.0, 1u)}, {3u, makeStats(2.0, 0.0, 1u)}, {9u, makeStats(3.0, 0.0, 1u)}, {1u, makeStats(4.0, 0.0, 1u)}};
+    sortByPid(rows);
+    ASSERT_EQ(3u, rows.size());
+    ASSERT_EQ(1u, rows[0].first);
+    ASSERT_EQ(3u, rows[1].first);
+    ASSERT_EQ(9u, rows[2].first);
+    ASSERT_DOUBLE_EQ(1.0, rows[2].second._cpu);
+}
+
+TEST_F(SnapshotDiffTest, checkStream_csvAndJsonLines_Ok)
+{
+    const Rows_t before{{1u, makeStats(1.0, 2.0, 3u)}, {2u, makeStats(1.0, 2.0, 3u)}};
+    const Rows_t after{{2u, makeStats(1.5, 2.0, 4u)}, {7u, makeStats(0.25, 0.5, 1u)}};
+    const DiffResult result = diff(before, after, Metric::Cpu, 10u);
+
+    utils::OutputBuffer csv;
+    appendStream(csv, format::Kind::Csv, result);
+    ASSERT_EQ(
+        "pid,change,cpu_before,cpu_after,memory_before,memory_after,threads_before,threads_after\n"
+        "2,changed,1.00,1.50,2.00,2.00,3,4\n"
+        "7,appeared,,0.25,,0.50,,1\n"
+        "1,disappeared,1.00,,2.00,,3,\n", std::string(csv.view()));
+
+    utils::OutputBuffer json;
+    appendStream(json, format::Kind::JsonLines, result);
+    const std::string jsonText(json.view());
+    ASSERT_EQ(0u, jsonText.find("{\"pid\":2,\"change\":\"changed\",\"cpu_before\":1.00,\"cpu_after\":1.50,\"memory_before\":2.00,"
+        "\"memory_after\":2.00,\"threads_before\":3,\"threads_after\":4}\n"));
+    ASSERT_NE(std::string::npos, jsonText.find("{\"pid\":7,\"change\":\"appeared\",\"cpu_before\":null,\"cpu_after\":0.25,"));
+}
+
+TEST_F(SnapshotDiffTest, checkTable_countsAndSignedChanges_Ok)
+{
+    const Rows_t before{{2u, makeStats(4.2, 1.0, 6u)}};
+    const Rows_t after{{2u, makeStats(9.1, 1.0, 4u)}};
+    utils::OutputBuffer out;
+    appendTable(out, diff(before, after, Metric::Cpu, 10u), Metric::Cpu, "before.txt", "after.txt");
+
+    const std::string table(out.view());
+    ASSERT_EQ(0u, table.find("Diff before.txt (1 processes) -> after.txt (1 processes)\nChanged 1 | Unchanged 0 | Appeared 0 | Disappeared 0\n"));
+    ASSERT_NE(std::string::npos, table.find("Top movers by CPU (%)\n"));
+    ASSERT_NE(std::string::npos, table.find("| 2       | 4.20 -> 9.10 (+4.90)         | 1.00 -> 1.00                 | 6 -> 4 (-2)          |\n"));
+}
+
+TEST_F(SnapshotDiffTest, checkReadExportedRows_fileOrderWithMalformed_Ok)
+{
+    const std::filesystem::path exportPath = std::filesystem::temp_directory_path() / ("SnapshotDiffTest." + std::to_string(::getpid()) + ".txt");
+    {
+        std::ofstream exportFile(exportPath);
+        exportFile << "Pid: 30 cpu: 1.00% memory: 2.00% threads: 3 time: 0:0:1.0\n"
+                   << "garbage\n"
+                   << "Pid: 4 cpu: 0.50% memory: 0.10% threads: 1 time: 0:0:2.0\n";
+    }
+    Rows_t rows;
+    std::vector<MalformedLine> malformed;
+    ASSERT_TRUE(readExportedRows(exportPath, rows, malformed));
+    std::filesystem::remove(exportPath);
+
+    ASSERT_EQ(2u, rows.size());
+    ASSERT_EQ(30u, rows[0].first);
+    ASSERT_EQ(4u, rows[1].first);
+    ASSERT_EQ(1u, malformed.size());
+    ASSERT_EQ(2u, malformed[0]._line);
+    ASSERT_FALSE(readExportedRows(exportPath, rows, malformed));
+}
+
+TEST_F(SnapshotDiffTest, checkDiffOptions_tableByDefault_Ok)
+{
+    const char* argv[] = {"out", "--diff", "before.txt", "after.txt", "--top", "5", "--by", "memory"};
+    const cli::Options options = cli::parseOptions(8, argv);
+    ASSERT_EQ(cli::Mode::Diff, options._mode);
+    ASSERT_EQ(std::filesystem::absolute("before.txt"), options._diffBefore);
+    ASSERT_EQ(std::filesystem::absolute("after.txt"), options._diffAfter);
+    ASSERT_EQ(5u, options._top);
+    ASSERT_EQ(Metric::Memory, options._diffMetric);
+    ASSERT_EQ(format::Kind::Text, options._format);
+
+    // no AFTER : a live scan
+    const char* live[] = {"out", "--diff", "before.txt", "-f", "jsonl"};
+    const cli::Options liveOptions = cli::parseOptions(5, live);
+    ASSERT_TRUE(liveOptions._diffAfter.empty());
+    ASSERT_EQ(format::Kind::JsonLines, liveOptions._format);
+
+    const char* wrong[] = {"out", "--diff", "before.txt", "--by", "io"};
+    ASSERT_THROW(cli::parseOptions(5, wrong), utils::SeverityException<utils::SeriousException>);
+}
+
+TEST_F(SnapshotDiffTest, checkDiff_twoMillionRowCapturesUnderASecond_Ok)
+{
+    constexpr uint kRows = 1'000'000u;
+    std::mt19937 random(42u);
+    Rows_t before;
+    Rows_t after;
+    before.reserve(kRows);
+    after.reserve(kRows);
+    for(uint pid=0; pid<kRows; ++pid)
+    {
+        before.emplace_back(pid, makeStats(static_cast<double>(random() % 10000u) / 100.0, 1.0, 4u));
+        // 1% gone, 1% new, the rest drifting
+        const uint afterPid = pid % 100u == 0u ? kRows + pid : pid;
+        after.emplace_back(afterPid, makeStats(static_cast<double>(random() % 10000u) / 100.0, 1.0, 4u));
+    }
+    // exports come in the order of the pid table, not sorted
+    std::shuffle(before.begin(), before.end(), random);
+    std::shuffle(after.begin(), after.end(), random);
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    sortByPid(before);
+    sortByPid(after);
+    const DiffResult result = diff(before, after, Metric::Cpu, 20u);
+    const double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    RecordProperty("sortAndDiffOf2x1MMs", std::to_string(elapsedMs));
+    ASSERT_EQ(kRows / 100u, result._appeared);
+    ASSERT_EQ(kRows / 100u, result._disappeared);
+    ASSERT_EQ(20u, result._movers.size());
+    ASSERT_LT(elapsedMs, 1000.0);
+}
+
+}
+}
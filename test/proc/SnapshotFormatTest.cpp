@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include <SnapshotFormat.hpp>
+#include <CliOptions.hpp>
+#include <Exception.hpp>
+
+namespace proc
+{
+
+class SnapshotFormatTest : public ::testing::Test
+{
+public:
+    PidStats makeStats()
+    {
+        PidStats stats;
+        stats._cpu = 0.05;
+        stats._memory = 1.3249;
+        stats._threads = 4;
+        stats._timezone._hours = 0;
+        stats._timezone._minutes = 20;
+        stats._timezone._seconds = 31;
+        stats._timezone._ms = 7;
+        return stats;
+    }
+};
+
+TEST_F(SnapshotFormatTest, checkTextRow_matchesExportFormat_Ok)
+{
+    utils::OutputBuffer out;
+    format::appendRow(out, format::Kind::Text, 0u, 1415u, makeStats());
+
+    ASSERT_EQ("Pid: 1415 cpu: 0.05% memory: 1.32% threads: 4 time: 0:20:31.7\n", out.view());
+}
+
+TEST_F(SnapshotFormatTest, checkTextRow_nameLast_Ok)
+{
+    utils::OutputBuffer out;
+    format::appendRow(out, format::Kind::Text, 0u, 1415u, makeStats(), "php-fpm");
+
+    ASSERT_EQ("Pid: 1415 cpu: 0.05% memory: 1.32% threads: 4 time: 0:20:31.7 name: php-fpm\n", out.view());
+}
+
+TEST_F(SnapshotFormatTest, checkTextRow_userAndSessionBeforeTheName_Ok)
+{
+    PidStats stats = makeStats();
+    stats._uid = 1000u;
+    stats._session = 1415u;
+    utils::OutputBuffer out;
+    format::appendRow(out, format::Kind::Text, 0u, 1415u, stats, "php-fpm");
+
+    ASSERT_EQ("Pid: 1415 cpu: 0.05% memory: 1.32% threads: 4 time: 0:20:31.7 user: 1000 session: 1415 name: php-fpm\n", out.view());
+}
+
+TEST_F(SnapshotFormatTest, checkCsvRowsWithHeader_Ok)
+{
+    utils::OutputBuffer out;
+    format::appendHeader(out, format::Kind::Csv);
+    format::appendRow(out, format::Kind::Csv, 1700000000000u, 1415u, makeStats());
+
+    ASSERT_EQ("ts,pid,cpu,memory,threads,uptime\n1700000000000,1415,0.05,1.32,4,1231.007\n", out.view());
+}
+
+TEST_F(SnapshotFormatTest, checkJsonLineRow_noHeader_Ok)
+{
+    utils::OutputBuffer out;
+    format::appendHeader(out, format::Kind::JsonLines);
+    format::appendRow(out, format::Kind::JsonLines, 1700000000000u, 1415u, makeStats());
+
+    ASSERT_EQ("{\"ts\":1700000000000,\"pid\":1415,\"cpu\":0.05,\"memory\":1.32,\"threads\":4,\"uptime\":1231.007}\n", out.view());
+}
+
+TEST_F(SnapshotFormatTest, checkBatchOptionsParsed_Ok)
+{
+    const char* argv[] = {"out", "-b", "-n", "10", "-d", "0.5", "-f", "jsonl", "-o", "snapshots.jsonl"};
+    const cli::Options options = cli::parseOptions(10, argv);
+
+    ASSERT_EQ(cli::Mode::Batch, options._mode);
+    ASSERT_EQ(10u, options._iterations);
+    ASSERT_EQ(0.5, options._delaySeconds);
+    ASSERT_EQ(format::Kind::JsonLines, options._format);
+    ASSERT_EQ(std::filesystem::path("snapshots.jsonl"), options._output);
+}
+
+TEST_F(SnapshotFormatTest, checkBatchOptions_unknownFormat_throwSerious)
+{
+    const char* argv[] = {"out", "-b", "-f", "xml"};
+    ASSERT_THROW(cli::parseOptions(4, argv), utils::SeverityException<utils::SeriousException>);
+}
+
+TEST_F(SnapshotFormatTest, checkIoBackendOption_Ok)
+{
+    const char* argv[] = {"out", "-b", "--io", "sync"};
+    ASSERT_EQ(utils::procfs::IoBackend::Sync, cli::parseOptions(4, argv)._ioBackend);
+    ASSERT_EQ(utils::procfs::IoBackend::Auto, cli::parseOptions(2, argv)._ioBackend);
+
+    const char* wrong[] = {"out", "--io", "aio"};
+    ASSERT_THROW(cli::parseOptions(3, wrong), utils::SeverityException<utils::SeriousException>);
+}
+
+TEST_F(SnapshotFormatTest, checkRulesOption_defaultAlertLog_Ok)
+{
+    const char* argv[] = {"out", "-b", "--rules", "hot.rules"};
+    const cli::Options options = cli::parseOptions(4, argv);
+    ASSERT_TRUE(options._rulesFile.is_absolute());
+    ASSERT_EQ("alerts.log", options._alertLog.filename());
+    ASSERT_TRUE(options._alertLog.is_absolute());
+    ASSERT_TRUE(cli::parseOptions(2, argv)._alertLog.empty());
+}
+
+TEST_F(SnapshotFormatTest, checkBudgetAndPriorityOptions_Ok)
+{
+    const char* argv[] = {"out", "-b", "--budget", "2", "--priority", "idle"};
+    const cli::Options options = cli::parseOptions(6, argv);
+    ASSERT_EQ(2.0, options._budgetPercent);
+    ASSERT_EQ(budget::Priority::Idle, options._priority);
+    ASSERT_EQ(0.0, cli::parseOptions(2, argv)._budgetPercent);
+    ASSERT_EQ(budget::Priority::Normal, cli::parseOptions(2, argv)._priority);
+
+    const char* wrong[] = {"out", "--priority", "realtime"};
+    ASSERT_THROW(cli::parseOptions(3, wrong), utils::SeverityException<utils::SeriousException>);
+    const char* overBudget[] = {"out", "--budget", "150"};
+    ASSERT_THROW(cli::parseOptions(3, overBudget), utils::SeverityException<utils::SeriousException>);
+}
+
+}
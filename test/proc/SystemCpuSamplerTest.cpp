@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+#include <SystemCpuSampler.hpp>
+
+#include <filesystem>
+
+namespace proc
+{
+
+class SystemCpuSamplerTest : public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+        _dataPath = std::filesystem::current_path().parent_path() / "test/data/SystemCpuSampler";
+        _statPath = std::filesystem::temp_directory_path() / ("SystemCpuSamplerTest." + std::to_string(::getpid()));
+    }
+
+    void TearDown() override
+    {
+        std::filesystem::remove(_statPath);
+    }
+
+    void publish(const char* sample)
+    {
+        std::filesystem::copy_file(_dataPath / sample, _statPath, std::filesystem::copy_options::overwrite_existing);
+    }
+
+    std::filesystem::path _dataPath;
+    std::filesystem::path _statPath;
+};
+
+TEST_F(SystemCpuSamplerTest, checkFirstSample_primesOnly_Ok)
+{
+    publish("stat0");
+    SystemCpuSampler sampler(_statPath);
+
+    ASSERT_TRUE(sampler.sample());
+    ASSERT_FALSE(sampler.hasUsage());
+    ASSERT_EQ(0.0, sampler.getTotal().busy());
+    ASSERT_LE(2u, sampler.getCores().size());
+}
+
+TEST_F(SystemCpuSamplerTest, checkDeltas_totalAndPerCore_Ok)
+{
+    publish("stat0");
+    SystemCpuSampler sampler(_statPath);
+    ASSERT_TRUE(sampler.sample());
+    publish("stat1");
+    ASSERT_TRUE(sampler.sample());
+    ASSERT_TRUE(sampler.hasUsage());
+
+    // total : 1100 jiffies elapsed -> user 600, system 200, idle 100, iowait 100, irq+softirq 100
+    const CpuUsage& total = sampler.getTotal();
+    EXPECT_DOUBLE_EQ(100.0 * 600 / 1100, total._user);
+    EXPECT_DOUBLE_EQ(100.0 * 200 / 1100, total._system);
+    EXPECT_DOUBLE_EQ(100.0 * 100 / 1100, total._idle);
+    EXPECT_DOUBLE_EQ(100.0 * 100 / 1100, total._iowait);
+    EXPECT_DOUBLE_EQ(100.0 * 100 / 1100, total._irq);
+    EXPECT_DOUBLE_EQ(0.0, total._steal);
+
+    // cpu0 : 800 jiffies elapsed, none of them idle
+    const CpuUsage& cpu0 = sampler.getCores()[0];
+    EXPECT_DOUBLE_EQ(100.0 * 500 / 800, cpu0._user);
+    EXPECT_DOUBLE_EQ(100.0 * 150 / 800, cpu0._system);
+    EXPECT_DOUBLE_EQ(0.0, cpu0._idle);
+
+    // cpu1 : 300 jiffies elapsed, a third of them idle
+    const CpuUsage& cpu1 = sampler.getCores()[1];
+    EXPECT_DOUBLE_EQ(100.0 * 100 / 300, cpu1._idle);
+    EXPECT_DOUBLE_EQ(100.0 * 150 / 300, cpu1.busy());
+}
+
+TEST_F(SystemCpuSamplerTest, checkOfflineCore_usageZeroed_primedAgainWhenBack_Ok)
+{
+    publish("stat0");
+    SystemCpuSampler sampler(_statPath);
+    ASSERT_TRUE(sampler.sample());
+    publish("stat1");
+    ASSERT_TRUE(sampler.sample());
+    ASSERT_DOUBLE_EQ(100.0 * 150 / 300, sampler.getCores()[1].busy());
+
+    publish("stat2_cpu1Offline");
+    ASSERT_TRUE(sampler.sample());
+    EXPECT_DOUBLE_EQ(0.0, sampler.getCores()[1].busy());
+    EXPECT_DOUBLE_EQ(0.0, sampler.getCores()[1]._idle);
+    EXPECT_DOUBLE_EQ(100.0 * 500 / 600, sampler.getCores()[0].busy());
+
+    // its' counters moved while it was away : nothing to compare them with
+    publish("stat3_cpu1Online");
+    ASSERT_TRUE(sampler.sample());
+    EXPECT_DOUBLE_EQ(0.0, sampler.getCores()[1].busy());
+    EXPECT_DOUBLE_EQ(0.0, sampler.getCores()[1]._idle);
+    EXPECT_DOUBLE_EQ(100.0 * 500 / 600, sampler.getCores()[0].busy());
+}
+
+TEST_F(SystemCpuSamplerTest, checkMissingFile_sampleFails)
+{
+    SystemCpuSampler sampler(_dataPath / "lol_this_is_wrong");
+    ASSERT_FALSE(sampler.sample());
+}
+
+TEST_F(SystemCpuSamplerTest, checkHeatmap_256CoresInFourRows_Ok)
+{
+    std::vector<CpuUsage> cores(256u);
+    cores[0]._user = 100.0;
+    cores[255]._system = 50.0;
+
+    const std::string heatmap = renderCpuHeatmap(cores, 64u);
+    ASSERT_EQ(4u * (5u + 1u + 64u + 2u), heatmap.size());
+    ASSERT_EQ("   0 |@", heatmap.substr(0, 7));
+    ASSERT_EQ(" 192 |", heatmap.substr(3u * 72u, 6));
+    ASSERT_EQ("+|\n", heatmap.substr(heatmap.size() - 3u));
+
+    // a row holds one core at least
+    ASSERT_EQ(renderCpuHeatmap(cores, 1u), renderCpuHeatmap(cores, 0u));
+}
+
+TEST_F(SystemCpuSamplerTest, checkBars_onePerCore_Ok)
+{
+    std::vector<CpuUsage> cores(2u);
+    cores[1]._user = 25.0;
+    cores[1]._irq = 25.0;
+
+    ASSERT_EQ("  0 [          ]   0.0%\n  1 [|||||     ]  50.0%\n", renderCpuBars(cores, 10u));
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+#include <SystemMemorySampler.hpp>
+
+#include <filesystem>
+
+namespace proc
+{
+
+class SystemMemorySamplerTest : public ::testing::Test
+{
+public:
+    std::filesystem::path setTestingPath()
+    {
+        return std::filesystem::current_path().parent_path() / "test/data/simulateProc/proc";
+    }
+};
+
+TEST_F(SystemMemorySamplerTest, checkMeminfo_defaultKeysSinglePass_Ok)
+{
+    SystemMemorySampler sampler(setTestingPath());
+    ASSERT_TRUE(sampler.sample());
+
+    unsigned long long kb{0u};
+    ASSERT_EQ(8131976u, sampler.getTotalKb());
+    ASSERT_TRUE(sampler.getKb("MemAvailable", kb));
+    ASSERT_EQ(5543780u, kb);
+    ASSERT_TRUE(sampler.getKb("Cached", kb));
+    ASSERT_EQ(1671052u, kb);
+    ASSERT_TRUE(sampler.getKb("SwapTotal", kb));
+    ASSERT_EQ(2097148u, kb);
+    ASSERT_TRUE(sampler.getKb("Dirty", kb));
+    ASSERT_EQ(224u, kb);
+    ASSERT_TRUE(sampler.getKb("Writeback", kb));
+    ASSERT_EQ(0u, kb);
+    // not configured at all
+    ASSERT_FALSE(sampler.getKb("Slab", kb));
+
+    ASSERT_EQ(8131976u - 5543780u, sampler.getUsedKb());
+    ASSERT_EQ("2.5/7.8 GB used (31.8%)", renderMemoryUsage(sampler));
+}
+
+TEST_F(SystemMemorySamplerTest, checkMeminfo_customKeys_totalAndAvailableKept_Ok)
+{
+    SystemMemorySampler sampler(setTestingPath(), {"Slab", "Shmem", "HugePages_Total"});
+    ASSERT_TRUE(sampler.sample());
+
+    unsigned long long kb{0u};
+    ASSERT_TRUE(sampler.getKb("Slab", kb));
+    ASSERT_EQ(203352u, kb);
+    ASSERT_TRUE(sampler.getKb("Shmem", kb));
+    ASSERT_EQ(109612u, kb);
+    ASSERT_TRUE(sampler.getKb("MemAvailable", kb));
+    // configured but not in this meminfo
+    ASSERT_FALSE(sampler.getKb("HugePages_Total", kb));
+    ASSERT_FALSE(sampler.getKb("Cached", kb));
+}
+
+TEST_F(SystemMemorySamplerTest, checkPressure_someAndFullAverages_ioUnavailable_Ok)
+{
+    SystemMemorySampler sampler(setTestingPath());
+    ASSERT_TRUE(sampler.sample());
+
+    const PressureStats& cpu = sampler.getPressure(PressureResource::Cpu);
+    ASSERT_TRUE(cpu._available);
+    ASSERT_DOUBLE_EQ(2.11, cpu._someAvg10);
+    ASSERT_DOUBLE_EQ(1.45, cpu._someAvg300);
+    ASSERT_EQ(13936543u, cpu._someTotalUs);
+
+    const PressureStats& memory = sampler.getPressure(PressureResource::Memory);
+    ASSERT_DOUBLE_EQ(12.5, memory._someAvg10);
+    ASSERT_DOUBLE_EQ(4.75, memory._fullAvg10);
+    ASSERT_EQ(1257123u, memory._fullTotalUs);
+
+    ASSERT_FALSE(sampler.getPressure(PressureResource::Io)._available);
+    ASSERT_EQ("cpu 2.11% | memory 12.50% | io n/a", renderPressure(sampler));
+}
+
+TEST_F(SystemMemorySamplerTest, checkMissingMeminfo_sampleFails)
+{
+    SystemMemorySampler sampler(setTestingPath() / "lol_this_is_wrong");
+    ASSERT_FALSE(sampler.sample());
+}
+
+}
\ No newline at end of file
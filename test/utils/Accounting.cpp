@@ -0,0 +1,230 @@
+#include <Accounting.hpp>
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdlib>
+#include <dirent.h>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace
+{
+std::atomic<std::uint64_t> allocations{0u};
+std::atomic<std::uint64_t> bytes{0u};
+std::atomic<std::uint64_t> frees{0u};
+std::atomic<std::uint64_t> syscalls{0u};
+
+void* allocate(const std::size_t size, const std::size_t alignment = 0u)
+{
+    allocations.fetch_add(1u, std::memory_order_relaxed);
+    bytes.fetch_add(size, std::memory_order_relaxed);
+    const std::size_t asked = size == 0u ? 1u : size;
+    // aligned_alloc wants a size multiple of the alignment
+    return alignment == 0u ? std::malloc(asked) : std::aligned_alloc(alignment, (asked + alignment - 1u) / alignment * alignment);
+}
+
+void* allocateOrThrow(const std::size_t size, const std::size_t alignment = 0u)
+{
+    void* memory = allocate(size, alignment);
+    if(memory == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void release(void* memory) noexcept
+{
+    if(memory != nullptr)
+    {
+        frees.fetch_add(1u, std::memory_order_relaxed);
+        std::free(memory);
+    }
+}
+
+void countSyscall()
+{
+    syscalls.fetch_add(1u, std::memory_order_relaxed);
+}
+
+// the libc definition a wrapper forwards to, looked up once ; `cache` is constant initialised, no guard (whose
+// contended path goes through syscall) is involved
+template<typename Function>
+Function next(std::atomic<void*>& cache, const char* name)
+{
+    void* function = cache.load(std::memory_order_relaxed);
+    if(function == nullptr)
+    {
+        function = ::dlsym(RTLD_NEXT, name);
+        cache.store(function, std::memory_order_relaxed);
+    }
+    return reinterpret_cast<Function>(function);
+}
+}
+
+namespace utils
+{
+namespace accounting
+{
+Counts now()
+{
+    Counts counts;
+    counts._allocations = allocations.load(std::memory_order_relaxed);
+    counts._bytes = bytes.load(std::memory_order_relaxed);
+    counts._frees = frees.load(std::memory_order_relaxed);
+    counts._syscalls = syscalls.load(std::memory_order_relaxed);
+    return counts;
+}
+
+Counts Phase::elapsed() const
+{
+    const Counts current = now();
+    Counts counts;
+    counts._allocations = current._allocations - _start._allocations;
+    counts._bytes = current._bytes - _start._bytes;
+    counts._frees = current._frees - _start._frees;
+    counts._syscalls = current._syscalls - _start._syscalls;
+    return counts;
+}
+}
+}
+
+void* operator new(std::size_t size) { return allocateOrThrow(size); }
+void* operator new[](std::size_t size) { return allocateOrThrow(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return allocateOrThrow(size, static_cast<std::size_t>(alignment)); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return allocateOrThrow(size, static_cast<std::size_t>(alignment)); }
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return allocate(size, static_cast<std::size_t>(alignment)); }
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return allocate(size, static_cast<std::size_t>(alignment)); }
+
+void operator delete(void* memory) noexcept { release(memory); }
+void operator delete[](void* memory) noexcept { release(memory); }
+void operator delete(void* memory, std::size_t) noexcept { release(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { release(memory); }
+void operator delete(void* memory, const std::nothrow_t&) noexcept { release(memory); }
+void operator delete[](void* memory, const std::nothrow_t&) noexcept { release(memory); }
+void operator delete(void* memory, std::align_val_t) noexcept { release(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { release(memory); }
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept { release(memory); }
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept { release(memory); }
+void operator delete(void* memory, std::align_val_t, const std::nothrow_t&) noexcept { release(memory); }
+void operator delete[](void* memory, std::align_val_t, const std::nothrow_t&) noexcept { release(memory); }
+
+extern "C"
+{
+int open(const char* path, int flags, ...)
+{
+    mode_t mode{0u};
+    if((flags & O_CREAT) != 0 || (flags & O_TMPFILE) == O_TMPFILE)
+    {
+        va_list arguments;
+        va_start(arguments, flags);
+        mode = va_arg(arguments, mode_t);
+        va_end(arguments);
+    }
+    countSyscall();
+    static std::atomic<void*> real{nullptr};
+    return next<int(*)(const char*, int, ...)>(real, "open")(path, flags, mode);
+}
+
+int openat(int directory, const char* path, int flags, ...)
+{
+    mode_t mode{0u};
+    if((flags & O_CREAT) != 0 || (flags & O_TMPFILE) == O_TMPFILE)
+    {
+        va_list arguments;
+        va_start(arguments, flags);
+        mode = va_arg(arguments, mode_t);
+        va_end(arguments);
+    }
+    countSyscall();
+    static std::atomic<void*> real{nullptr};
+    return next<int(*)(int, const char*, int, ...)>(real, "openat")(directory, path, flags, mode);
+}
+
+ssize_t read(int fd, void* buffer, size_t count)
+{
+    countSyscall();
+    static std::atomic<void*> real{nullptr};
+    return next<ssize_t(*)(int, void*, size_t)>(real, "read")(fd, buffer, count);
+}
+
+ssize_t write(int fd, const void* buffer, size_t count)
+{
+    countSyscall();
+    static std::atomic<void*> real{nullptr};
+    return next<ssize_t(*)(int, const void*, size_t)>(real, "write")(fd, buffer, count);
+}
+
+ssize_t writev(int fd, const struct iovec* iovecs, int count)
+{
+    countSyscall();
+    static std::atomic<void*> real{nullptr};
+    return next<ssize_t(*)(int, const struct iovec*, int)>(real, "writev")(fd, iovecs, count);
+}
+
+int close(int fd)
+{
+    countSyscall();
+    static std::atomic<void*> real{nullptr};
+    return next<int(*)(int)>(real, "close")(fd);
+}
+
+int fstat(int fd, struct stat* status) noexcept
+{
+    countSyscall();
+    static std::atomic<void*> real{nullptr};
+    return next<int(*)(int, struct stat*)>(real, "fstat")(fd, status);
+}
+
+void* mmap(void* address, size_t length, int protection, int flags, int fd, off_t offset) noexcept
+{
+    countSyscall();
+    static std::atomic<void*> real{nullptr};
+    return next<void*(*)(void*, size_t, int, int, int, off_t)>(real, "mmap")(address, length, protection, flags, fd, offset);
+}
+
+int munmap(void* address, size_t length) noexcept
+{
+    countSyscall();
+    static std::atomic<void*> real{nullptr};
+    return next<int(*)(void*, size_t)>(real, "munmap")(address, length);
+}
+
+// the openat of the directory, the getdents64 behind readdir are not seen (see Accounting.hpp)
+DIR* opendir(const char* path)
+{
+    countSyscall();
+    static std::atomic<void*> real{nullptr};
+    return next<DIR*(*)(const char*)>(real, "opendir")(path);
+}
+
+int closedir(DIR* directory)
+{
+    countSyscall();
+    static std::atomic<void*> real{nullptr};
+    return next<int(*)(DIR*)>(real, "closedir")(directory);
+}
+
+// the raw syscalls, io_uring_enter among them ; every argument register is passed on whatever the number takes
+long syscall(long number, ...) noexcept
+{
+    long arguments[6];
+    va_list list;
+    va_start(list, number);
+    for(long& argument : arguments)
+    {
+        argument = va_arg(list, long);
+    }
+    va_end(list);
+    countSyscall();
+    static std::atomic<void*> real{nullptr};
+    return next<long(*)(long, ...)>(real, "syscall")(number, arguments[0], arguments[1], arguments[2], arguments[3], arguments[4], arguments[5]);
+}
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+
+// Allocation and syscall accounting of the test binary, to pin the budgets of the collector hot path.
+// Accounting.cpp replaces the global operator new/delete and wraps the libc entry points the code does its' I/O
+// through (open, read, close, mmap, opendir, syscall, ...) : the executable comes first in the symbol lookup, so the
+// wrappers see every call made through the PLT, from our code as from libstdc++, the way an LD_PRELOAD library would.
+// Each wrapper counts one syscall and forwards to the next definition (dlsym RTLD_NEXT). What glibc does internally
+// stays out of reach : the getdents64 refilling the buffer of readdir (one per ~32KiB of entries) and the mmap of a
+// big malloc. The counters are process wide, a phase has to join the threads it starts before being read
+namespace utils
+{
+namespace accounting
+{
+struct Counts
+{
+    std::uint64_t _allocations{0u}; // operator new, every variant
+    std::uint64_t _bytes{0u};       // asked for by these allocations
+    std::uint64_t _frees{0u};
+    std::uint64_t _syscalls{0u};
+};
+
+Counts now();
+
+// what happened since it was built
+class Phase
+{
+public:
+    Phase() : _start(now()) {}
+    Counts elapsed() const;
+
+private:
+    Counts _start;
+};
+}
+}
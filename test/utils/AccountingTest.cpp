@@ -0,0 +1,43 @@
+#include <gtest/gtest.h>
+#include <Accounting.hpp>
+#include <ProcFile.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace utils
+{
+namespace accounting
+{
+
+TEST(AccountingTest, checkPhase_allocationsAndBytesCounted_Ok)
+{
+    const Phase phase;
+    {
+        const std::unique_ptr<int> single = std::make_unique<int>(7);
+        std::vector<char> bytes(1000u);
+        bytes.resize(3000u);
+    }
+    const Counts counts = phase.elapsed();
+
+    ASSERT_EQ(3u, counts._allocations);
+    ASSERT_EQ(sizeof(int) + 1000u + 3000u, counts._bytes);
+    ASSERT_EQ(3u, counts._frees);
+}
+
+TEST(AccountingTest, checkPhase_syscallsOfReadFileCounted_Ok)
+{
+    char content[256];
+    const Phase phase;
+    ASSERT_GT(procfs::readFile("/proc/self/stat", content, sizeof(content)), 0);
+    ASSERT_EQ(3u, phase.elapsed()._syscalls);
+
+    // only the open of a missing file
+    const Phase missing;
+    ASSERT_LT(procfs::readFile("/proc/self/missing", content, sizeof(content)), 0);
+    ASSERT_EQ(1u, missing.elapsed()._syscalls);
+}
+
+}
+}
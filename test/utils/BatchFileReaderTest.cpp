@@ -0,0 +1,158 @@
+#include "gtest/gtest.h"
+#include <BatchFileReader.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <linux/filter.h>
+#include <linux/seccomp.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+namespace utils
+{
+namespace procfs
+{
+
+class BatchFileReaderTest : public ::testing::Test
+{
+public:
+    // more files than the io_uring queue depth so that several chunks are needed, plus a missing one in the middle
+    static constexpr std::size_t kFiles = 600u;
+    static constexpr std::size_t kMissing = 300u;
+
+    void SetUp() override
+    {
+        _directory = std::filesystem::temp_directory_path() / ("BatchFileReaderTest." + std::to_string(::getpid()));
+        std::filesystem::create_directories(_directory);
+        for(std::size_t file=0; file<kFiles; ++file)
+        {
+            _paths.emplace_back((_directory / std::to_string(file)).string());
+            if(file != kMissing)
+            {
+                std::ofstream(_paths.back().c_str()) << file << " (comm) S 1 " << file * 3u << '\n';
+            }
+        }
+    }
+
+    void TearDown() override
+    {
+        std::filesystem::remove_all(_directory);
+    }
+
+    // every file handed over once with its' own content, the missing one as ENOENT
+    void checkReadAll(BatchFileReader& reader)
+    {
+        std::vector<uint> seen(kFiles, 0u);
+        reader.readAll(_paths, [this, &seen](const std::size_t index, std::string_view content, const int error)
+        {
+            ASSERT_LT(index, kFiles);
+            ++seen[index];
+            if(index == kMissing)
+            {
+                ASSERT_EQ(ENOENT, error);
+                ASSERT_TRUE(content.empty());
+                return;
+            }
+            ASSERT_EQ(0, error);
+            ASSERT_EQ(std::to_string(index) + " (comm) S 1 " + std::to_string(index * 3u) + "\n", content);
+        });
+        for(std::size_t file=0; file<kFiles; ++file)
+        {
+            ASSERT_EQ(1u, seen[file]) << "file " << file;
+        }
+    }
+
+    std::filesystem::path _directory;
+    PathList _paths;
+};
+
+TEST_F(BatchFileReaderTest, checkSyncReader_everyFileOnce_Ok)
+{
+    SyncFileReader reader;
+    checkReadAll(reader);
+    ASSERT_GE(reader.getSyscalls(), 3u * (kFiles - 1u));
+}
+
+TEST_F(BatchFileReaderTest, checkIoUringReader_everyFileOnce_fewSyscalls_Ok)
+{
+    std::unique_ptr<IoUringFileReader> reader = IoUringFileReader::create();
+    if(reader == nullptr)
+    {
+        GTEST_SKIP() << "io_uring is not usable here";
+    }
+    checkReadAll(*reader);
+    // a couple of io_uring_enter per chunk of 256 files instead of 3-4 syscalls per file
+    SyncFileReader syncReader;
+    checkReadAll(syncReader);
+    ASSERT_LT(reader->getSyscalls() * 10u, syncReader.getSyscalls());
+
+    // the ring is reusable, nothing left behind by the previous pass
+    checkReadAll(*reader);
+}
+
+// io_uring_enter refused whenever it would submit, from a seccomp filter of a forked child : the opens never
+// reach the kernel. Every file is still handed over once, with the errno, and no descriptor is left open
+TEST_F(BatchFileReaderTest, checkIoUringReader_enterFailure_everyFileReported_Ok)
+{
+    std::unique_ptr<IoUringFileReader> reader = IoUringFileReader::create();
+    if(reader == nullptr)
+    {
+        GTEST_SKIP() << "io_uring is not usable here";
+    }
+    const pid_t child = ::fork();
+    ASSERT_GE(child, 0);
+    if(child == 0)
+    {
+        const std::size_t fdsBefore = std::distance(std::filesystem::directory_iterator("/proc/self/fd"), std::filesystem::directory_iterator());
+        sock_filter filter[] = {
+            BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(seccomp_data, nr)),
+            BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, __NR_io_uring_enter, 0, 3),
+            BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(seccomp_data, args[1])),
+            BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 0, 1, 0),
+            BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ERRNO | EIO),
+            BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ALLOW),
+        };
+        sock_fprog program{static_cast<unsigned short>(sizeof(filter) / sizeof(filter[0])), filter};
+        if(::prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) != 0 || ::prctl(PR_SET_SECCOMP, SECCOMP_MODE_FILTER, &program) != 0)
+        {
+            ::_exit(2);
+        }
+
+        std::vector<uint> seen(kFiles, 0u);
+        bool failed{true};
+        reader->readAll(_paths, [&seen, &failed](const std::size_t index, std::string_view content, const int error)
+        {
+            ++seen[index];
+            failed &= error == EIO && content.empty();
+        });
+        const std::size_t fdsAfter = std::distance(std::filesystem::directory_iterator("/proc/self/fd"), std::filesystem::directory_iterator());
+        ::_exit(failed && std::count(seen.begin(), seen.end(), 1u) == static_cast<std::ptrdiff_t>(kFiles) && fdsAfter == fdsBefore ? 0 : 1);
+    }
+    int status{0};
+    ASSERT_EQ(child, ::waitpid(child, &status, 0));
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(0, WEXITSTATUS(status));
+}
+
+TEST_F(BatchFileReaderTest, checkBackendSelection_Ok)
+{
+    ASSERT_STREQ("sync", makeBatchFileReader(IoBackend::Sync)->name());
+    ASSERT_NE(nullptr, makeBatchFileReader(IoBackend::Auto));
+
+    IoBackend backend{IoBackend::Sync};
+    ASSERT_TRUE(parseIoBackend("uring", backend));
+    ASSERT_EQ(IoBackend::IoUring, backend);
+    ASSERT_TRUE(parseIoBackend("auto", backend));
+    ASSERT_EQ(IoBackend::Auto, backend);
+    ASSERT_FALSE(parseIoBackend("epoll", backend));
+}
+
+}
+}
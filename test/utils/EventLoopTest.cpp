@@ -0,0 +1,108 @@
+#include "gtest/gtest.h"
+#include <EventLoop.hpp>
+#include <RawTerminal.hpp>
+
+#include <chrono>
+#include <csignal>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace utils
+{
+
+class EventLoopTest : public ::testing::Test
+{};
+
+TEST_F(EventLoopTest, checkNothingReady_timesOut_Ok)
+{
+    EventLoop loop;
+    std::vector<EventLoop::Event> events;
+    ASSERT_EQ(0u, loop.wait(events, 10));
+}
+
+TEST_F(EventLoopTest, checkWakeupFromAnotherThread_delivered_Ok)
+{
+    EventLoop loop;
+    std::thread collector([&loop]() { loop.wakeup(); loop.wakeup(); });
+    collector.join();
+    std::vector<EventLoop::Event> events;
+    ASSERT_EQ(1u, loop.wait(events, 1000));
+    ASSERT_EQ(EventLoop::Source::Wakeup, events[0]._source);
+    ASSERT_EQ(2u, events[0]._count);
+    ASSERT_EQ(0u, loop.wait(events, 0));
+}
+
+TEST_F(EventLoopTest, checkSignal_readThroughSignalfd_Ok)
+{
+    EventLoop loop;
+    loop.watchSignals({SIGWINCH});
+    ASSERT_EQ(0, ::raise(SIGWINCH));
+    std::vector<EventLoop::Event> events;
+    ASSERT_EQ(1u, loop.wait(events, 1000));
+    ASSERT_EQ(EventLoop::Source::Signal, events[0]._source);
+    ASSERT_EQ(SIGWINCH, events[0]._signal);
+}
+
+TEST_F(EventLoopTest, checkInputReadable_thenUnwatched_Ok)
+{
+    int pipeFds[2];
+    ASSERT_EQ(0, ::pipe(pipeFds));
+    {
+        EventLoop loop;
+        loop.watchInput(pipeFds[0]);
+        std::vector<EventLoop::Event> events;
+        ASSERT_EQ(0u, loop.wait(events, 0));
+        ASSERT_EQ(1, ::write(pipeFds[1], "q", 1));
+        ASSERT_EQ(1u, loop.wait(events, 1000));
+        ASSERT_EQ(EventLoop::Source::Input, events[0]._source);
+
+        loop.unwatchInput();
+        ASSERT_EQ(0u, loop.wait(events, 0));
+    }
+    ::close(pipeFds[0]);
+    ::close(pipeFds[1]);
+}
+
+TEST_F(EventLoopTest, checkKeyToWakeLatency_belowFrame_Ok)
+{
+    int pipeFds[2];
+    ASSERT_EQ(0, ::pipe(pipeFds));
+    EventLoop loop;
+    loop.watchInput(pipeFds[0]);
+    std::vector<EventLoop::Event> events;
+    char key;
+    std::chrono::nanoseconds worst{0};
+    for(int press=0; press<100; ++press)
+    {
+        std::chrono::steady_clock::time_point pressed;
+        std::thread keyboard([&]() { pressed = std::chrono::steady_clock::now(); ASSERT_EQ(1, ::write(pipeFds[1], "s", 1)); });
+        ASSERT_EQ(1u, loop.wait(events, 1000));
+        const std::chrono::steady_clock::time_point woken = std::chrono::steady_clock::now();
+        keyboard.join();
+        ASSERT_EQ(EventLoop::Source::Input, events[0]._source);
+        ASSERT_EQ(1, ::read(pipeFds[0], &key, 1));
+        worst = std::max(worst, std::chrono::duration_cast<std::chrono::nanoseconds>(woken - pressed));
+    }
+    RecordProperty("worstKeyToWakeUs", static_cast<int>(worst.count() / 1000));
+    // a key is answered well within one frame, not at the next refresh
+    ASSERT_LT(worst, std::chrono::milliseconds(50));
+    ::close(pipeFds[0]);
+    ::close(pipeFds[1]);
+}
+
+TEST_F(EventLoopTest, checkRawTerminalOnPipe_nonBlockingOnly_Ok)
+{
+    int pipeFds[2];
+    ASSERT_EQ(0, ::pipe(pipeFds));
+    {
+        const RawTerminal terminal(pipeFds[0]);
+        ASSERT_FALSE(terminal.isRaw());
+        char key;
+        ASSERT_EQ(-1, ::read(pipeFds[0], &key, 1));
+    }
+    ::close(pipeFds[0]);
+    ::close(pipeFds[1]);
+}
+
+}
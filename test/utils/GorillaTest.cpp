@@ -0,0 +1,78 @@
+#include "gtest/gtest.h"
+#include <Gorilla.hpp>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace utils
+{
+namespace gorilla
+{
+
+class GorillaTest : public ::testing::Test
+{};
+
+TEST_F(GorillaTest, checkRandomValues_roundTrip_Ok)
+{
+    std::mt19937_64 generator(42u);
+    std::uniform_int_distribution<std::int64_t> distribution(-1'000'000'000'000ll, 1'000'000'000'000ll);
+    IntColumn<256u, 1u> column;
+    std::vector<std::int64_t> values;
+    for(uint value=0; value<200u; ++value)
+    {
+        values.push_back(value % 3u == 0u ? distribution(generator) : (values.empty() ? 0 : values.back()));
+        ASSERT_TRUE(column.append(values.back()));
+    }
+
+    IntColumn<256u, 1u>::Reader reader(column);
+    for(const std::int64_t value : values)
+    {
+        ASSERT_FALSE(reader.done());
+        ASSERT_EQ(value, reader.next());
+    }
+    ASSERT_TRUE(reader.done());
+}
+
+TEST_F(GorillaTest, checkJitteredTimestamps_fewBitsPerSample_Ok)
+{
+    std::mt19937 generator(7u);
+    std::uniform_int_distribution<int> jitter(-5, 5);
+    IntColumn<12u, 2u> column;
+    std::vector<std::int64_t> timestamps;
+    std::int64_t timestampMs = 1'700'000'000'000ll;
+    for(uint sample=0; sample<64u; ++sample)
+    {
+        timestampMs += 1000 + jitter(generator);
+        timestamps.push_back(timestampMs);
+        ASSERT_TRUE(column.append(timestampMs));
+    }
+    // the raw first timestamp, then at most 15 bits per sample
+    ASSERT_LE(column.bits(), 64u + 63u * 15u);
+
+    IntColumn<12u, 2u>::Reader reader(column);
+    for(const std::int64_t timestamp : timestamps)
+    {
+        ASSERT_EQ(timestamp, reader.next());
+    }
+}
+
+TEST_F(GorillaTest, checkFullColumn_appendRefused_Ok)
+{
+    IntColumn<2u, 1u> column;
+    ASSERT_TRUE(column.append(0));
+    ASSERT_TRUE(column.append(1 << 15));
+    // 64 + 24 bits used out of 128 : a steady value still fits, a jump doesn't
+    ASSERT_TRUE(column.fits(1 << 15));
+    ASSERT_FALSE(column.fits(1ll << 40));
+    ASSERT_FALSE(column.append(1ll << 40));
+    ASSERT_EQ(2u, column.count());
+    ASSERT_EQ(1 << 15, column.last());
+
+    column.clear();
+    ASSERT_EQ(0u, column.count());
+    ASSERT_TRUE(column.append(5));
+}
+
+}
+}
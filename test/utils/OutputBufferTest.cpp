@@ -0,0 +1,83 @@
+#include "gtest/gtest.h"
+#include <OutputBuffer.hpp>
+#include <UniqueFd.hpp>
+
+#include <string>
+#include <unistd.h>
+
+namespace utils
+{
+
+class OutputBufferTest : public ::testing::Test
+{};
+
+TEST_F(OutputBufferTest, checkNumbersRendered_Ok)
+{
+    OutputBuffer out;
+    out.appendUint(18446744073709551615ull);
+    out.append(' ');
+    out.appendInt(-42);
+    out.append(' ');
+    out.appendUintPadded(7u, 3u);
+    out.append(' ');
+    out.appendUintPadded(1234u, 3u);
+
+    ASSERT_EQ("18446744073709551615 -42 007 1234", out.view());
+}
+
+TEST_F(OutputBufferTest, checkFixedRoundedNotTruncated_Ok)
+{
+    OutputBuffer out;
+    out.appendFixed(0.05, 2);
+    out.append(' ');
+    out.appendFixed(0.29, 2);
+    out.append(' ');
+    out.appendFixed(12.5436667854642456, 2);
+    out.append(' ');
+    out.appendFixed(0.0043, 2);
+
+    ASSERT_EQ("0.05 0.29 12.54 0.00", out.view());
+}
+
+TEST_F(OutputBufferTest, checkMemoryBackedBufferGrows_Ok)
+{
+    OutputBuffer out(-1, 16u);
+    for(int i=0; i<10000; ++i)
+    {
+        out.append('x');
+    }
+    ASSERT_EQ(10000u, out.size());
+}
+
+TEST_F(OutputBufferTest, checkFdBackedBufferFlushesInLargeWrites_Ok)
+{
+    int pipeEnds[2];
+    ASSERT_EQ(0, ::pipe(pipeEnds));
+    UniqueFd readEnd(pipeEnds[0]);
+    UniqueFd writeEnd(pipeEnds[1]);
+
+    std::string expected;
+    {
+        OutputBuffer out(writeEnd.get(), 1024u);
+        for(uint i=0; i<1000; ++i)
+        {
+            out.appendUint(i);
+            out.append('\n');
+            expected += std::to_string(i) + "\n";
+            // never more than the capacity stays pending
+            ASSERT_LE(out.size(), 1024u);
+        }
+    }
+    writeEnd.reset();
+
+    std::string received;
+    char chunk[4096];
+    ssize_t bytes;
+    while((bytes = ::read(readEnd.get(), chunk, sizeof(chunk))) > 0)
+    {
+        received.append(chunk, bytes);
+    }
+    ASSERT_EQ(expected, received);
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,168 @@
+#include "gtest/gtest.h"
+#include <PidTable.hpp>
+
+#include <chrono>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace utils
+{
+
+class PidTableTest : public ::testing::Test
+{};
+
+TEST_F(PidTableTest, checkUpsert_updatedInPlace_Ok)
+{
+    PidTable<int> table(32768u);
+    table.beginTick();
+    table.upsert(42u) = 1;
+    table.upsert(42u) = 2;
+    ASSERT_EQ(1u, table.size());
+    ASSERT_EQ(2, table.at(42u));
+    ASSERT_EQ(nullptr, table.find(43u));
+    ASSERT_THROW(table.at(43u), std::out_of_range);
+}
+
+TEST_F(PidTableTest, checkSweep_unseenDropped_touchedKept_Ok)
+{
+    PidTable<int> table(32768u);
+    table.beginTick();
+    for(uint pid=1; pid<=10u; ++pid)
+    {
+        table.upsert(pid) = static_cast<int>(pid);
+    }
+    ASSERT_EQ(0u, table.sweep());
+
+    table.beginTick();
+    table.upsert(2u) = 20;
+    ASSERT_TRUE(table.touch(3u));
+    ASSERT_FALSE(table.touch(11u));
+    ASSERT_EQ(8u, table.sweep());
+    ASSERT_EQ(2u, table.size());
+    ASSERT_EQ(20, table.at(2u));
+    // touched : seen, its' value left as it was
+    ASSERT_EQ(3, table.at(3u));
+}
+
+TEST_F(PidTableTest, checkIteration_everyLiveEntryOnce_stableAcrossUpdates_Ok)
+{
+    PidTable<int> table(32768u);
+    table.beginTick();
+    for(uint pid=100; pid<600u; ++pid)
+    {
+        table.upsert(pid) = 0;
+    }
+    std::vector<uint> order;
+    for(const PidTable<int>::value_type& entry : table)
+    {
+        order.push_back(entry.first);
+    }
+    ASSERT_EQ(500u, order.size());
+
+    table.beginTick();
+    for(uint pid=100; pid<600u; ++pid)
+    {
+        table.upsert(pid) += 1;
+    }
+    table.sweep();
+    std::vector<uint> again;
+    for(const PidTable<int>::value_type& entry : table)
+    {
+        again.push_back(entry.first);
+        ASSERT_EQ(1, entry.second);
+    }
+    ASSERT_EQ(order, again);
+}
+
+TEST_F(PidTableTest, checkRandomChurn_sameAsUnorderedMap_Ok)
+{
+    // small pid space so that the probe runs collide, wrap around the end and get shifted back a lot
+    std::mt19937 random(7u);
+    PidTable<uint> table(512u);
+    std::unordered_map<uint, uint> reference;
+    for(uint tick=1; tick<=2000u; ++tick)
+    {
+        table.beginTick();
+        std::unordered_map<uint, uint> seen;
+        for(const std::pair<const uint, uint>& live : reference)
+        {
+            // most survive, a few die
+            if(random() % 10u != 0u)
+            {
+                if(random() % 2u == 0u)
+                {
+                    table.upsert(live.first) = tick;
+                    seen.emplace(live.first, tick);
+                }
+                else
+                {
+                    ASSERT_TRUE(table.touch(live.first));
+                    seen.emplace(live.first, live.second);
+                }
+            }
+        }
+        const uint births = random() % 40u;
+        for(uint birth=0; birth<births; ++birth)
+        {
+            const uint pid = random() % 512u;
+            table.upsert(pid) = tick;
+            seen[pid] = tick;
+        }
+        table.sweep();
+        reference.swap(seen);
+
+        ASSERT_EQ(reference.size(), table.size());
+        for(const std::pair<const uint, uint>& live : reference)
+        {
+            ASSERT_NE(nullptr, table.find(live.first));
+            ASSERT_EQ(live.second, *table.find(live.first));
+        }
+    }
+}
+
+TEST_F(PidTableTest, checkMillionsOfLifetimes_constantMemory_Ok)
+{
+    // ~1000 live processes, each living 10 ticks, pids handed out like the kernel does up to pid_max and wrapping
+    constexpr uint kPidMax = 4194304u;
+    PidTable<std::uint64_t> table(kPidMax, 1000u);
+    std::size_t capacity{0u};
+    std::vector<uint> live(1000u);
+    uint nextPid{300u};
+    for(uint& pid : live)
+    {
+        pid = nextPid++;
+    }
+    std::uint64_t lifetimes{0u};
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(uint tick=0; tick<20000u; ++tick)
+    {
+        table.beginTick();
+        for(std::size_t slot=tick % 10u; slot<live.size(); slot += 10u)
+        {
+            live[slot] = nextPid;
+            nextPid = nextPid + 1u >= kPidMax ? 300u : nextPid + 1u;
+            ++lifetimes;
+        }
+        for(const uint pid : live)
+        {
+            ++table.upsert(pid);
+        }
+        table.sweep();
+        ASSERT_EQ(live.size(), table.size());
+        // the births of a tick come before the sweep of its' deaths : one doubling for that, then no more
+        if(tick == 10u)
+        {
+            capacity = table.capacity();
+        }
+    }
+    const double tickUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / 20000.0;
+
+    RecordProperty("lifetimes", static_cast<int>(lifetimes));
+    RecordProperty("tickOf1000Us", std::to_string(tickUs));
+    ASSERT_GE(lifetimes, 2'000'000u);
+    ASSERT_EQ(capacity, table.capacity());
+    ASSERT_LE(table.capacity(), 4096u);
+}
+
+}
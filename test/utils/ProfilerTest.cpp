@@ -0,0 +1,133 @@
+#include "gtest/gtest.h"
+#include <Profiler.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+namespace utils
+{
+namespace profiling
+{
+
+class ProfilerTest : public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+        Profiler::instance().reset();
+    }
+};
+
+TEST_F(ProfilerTest, checkBuckets_exactBelowSixteen_boundedAbove_Ok)
+{
+    for(std::uint64_t value=0; value<LatencyHistogram::kSubBuckets; ++value)
+    {
+        ASSERT_EQ(value, LatencyHistogram::bucketOf(value));
+        ASSERT_EQ(value, LatencyHistogram::bucketUpperBound(LatencyHistogram::bucketOf(value)));
+    }
+
+    for(const std::uint64_t value : {16ull, 17ull, 1000ull, 123456789ull, 1ull << 40, ~0ull})
+    {
+        const uint bucket = LatencyHistogram::bucketOf(value);
+        ASSERT_LT(bucket, LatencyHistogram::kBuckets);
+        const std::uint64_t upper = LatencyHistogram::bucketUpperBound(bucket);
+        ASSERT_GE(upper, value);
+        // within one sixteenth of the value
+        ASSERT_LE(upper - value, value / LatencyHistogram::kSubBuckets);
+    }
+    ASSERT_EQ(LatencyHistogram::kBuckets - 1u, LatencyHistogram::bucketOf(~0ull));
+}
+
+TEST_F(ProfilerTest, checkPercentiles_uniformLatencies_Ok)
+{
+    LatencyHistogram histogram;
+    ASSERT_EQ(0u, histogram.percentile(0.5));
+    ASSERT_EQ(0u, histogram.min());
+
+    for(std::uint64_t value=1; value<=10000u; ++value)
+    {
+        histogram.record(value * 100u);
+    }
+
+    ASSERT_EQ(10000u, histogram.count());
+    ASSERT_EQ(100u, histogram.min());
+    ASSERT_EQ(1000000u, histogram.max());
+    ASSERT_EQ(100ull * 10000ull * 10001ull / 2ull, histogram.sum());
+    ASSERT_NEAR(500000.0, static_cast<double>(histogram.percentile(0.5)), 500000.0 / 16.0);
+    ASSERT_NEAR(990000.0, static_cast<double>(histogram.percentile(0.99)), 990000.0 / 16.0);
+    ASSERT_EQ(1000000u, histogram.percentile(1.0));
+}
+
+TEST_F(ProfilerTest, checkAggregate_perThreadHistogramsMerged_Ok)
+{
+    Profiler& profiler = Profiler::instance();
+    profiler.local(Stage::StatParse).record(1000u);
+    std::thread([&profiler]()
+    {
+        for(uint i=0; i<3u; ++i)
+        {
+            profiler.local(Stage::StatParse).record(5000u);
+        }
+        profiler.local(Stage::Export).record(42u);
+    }).join();
+
+    LatencyHistogram merged;
+    profiler.aggregate(Stage::StatParse, merged);
+    ASSERT_EQ(4u, merged.count());
+    ASSERT_EQ(1000u, merged.min());
+    ASSERT_EQ(5000u, merged.max());
+
+    profiler.aggregate(Stage::Export, merged);
+    ASSERT_EQ(1u, merged.count());
+    profiler.aggregate(Stage::Render, merged);
+    ASSERT_EQ(0u, merged.count());
+}
+
+TEST_F(ProfilerTest, checkScopedTimerAndJsonDump_Ok)
+{
+    {
+        ScopedTimer timer(Stage::Scan);
+    }
+
+    const std::string json = Profiler::instance().toJson();
+    ASSERT_EQ(0u, json.find("{\"threads\":"));
+    ASSERT_NE(std::string::npos, json.find("\"scan\":{\"count\":1,"));
+    ASSERT_NE(std::string::npos, json.find("\"directory_iteration\":{\"count\":0,"));
+    ASSERT_NE(std::string::npos, json.find("\"p999_ns\":"));
+    ASSERT_NE(std::string::npos, json.find("\"per_thread\":["));
+    ASSERT_EQ("}}\n", json.substr(json.size() - 3u));
+
+    const std::string overlay = Profiler::instance().renderOverlay();
+    ASSERT_EQ(0u, overlay.find("stage "));
+    ASSERT_NE(std::string::npos, overlay.find("\nscan                      1  "));
+}
+
+TEST_F(ProfilerTest, checkDumpJson_replacedWhileRunning_Ok)
+{
+    const std::filesystem::path path(std::filesystem::temp_directory_path() / ("ProfilerTest." + std::to_string(::getpid()) + ".json"));
+    const auto content = [&path]()
+    {
+        std::ifstream file(path);
+        return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    };
+
+    ASSERT_TRUE(Profiler::instance().dumpJson(path));
+    ASSERT_NE(std::string::npos, content().find("\"scan\":{\"count\":0,"));
+    {
+        ScopedTimer timer(Stage::Scan);
+    }
+    // a later dump replaces the file as a whole, nothing of the temporary one left behind
+    ASSERT_TRUE(Profiler::instance().dumpJson(path));
+    ASSERT_EQ(Profiler::instance().toJson(), content());
+    ASSERT_FALSE(std::filesystem::exists(path.string() + ".tmp"));
+    std::filesystem::remove(path);
+
+    ASSERT_FALSE(Profiler::instance().dumpJson("/nonexistent/profile.json"));
+}
+
+}
+}
\ No newline at end of file
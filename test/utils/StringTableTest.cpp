@@ -0,0 +1,85 @@
+#include "gtest/gtest.h"
+#include <StringTable.hpp>
+
+#include <string>
+#include <vector>
+
+namespace utils
+{
+
+class StringTableTest : public ::testing::Test
+{};
+
+TEST_F(StringTableTest, checkIntern_sameStringSameIdStoredOnce_Ok)
+{
+    StringTable table;
+    const StringTable::Id first = table.intern("php-fpm");
+    for(uint index=0; index<1000u; ++index)
+    {
+        ASSERT_EQ(first, table.intern(std::string("php-fpm")));
+    }
+    ASSERT_NE(StringTable::kEmpty, first);
+    ASSERT_EQ("php-fpm", table.view(first));
+    ASSERT_EQ(2u, table.size());
+    ASSERT_EQ(7u, table.bytes());
+}
+
+TEST_F(StringTableTest, checkIntern_viewsStableWhileGrowing_Ok)
+{
+    StringTable table;
+    const StringTable::Id bash = table.intern("bash");
+    const std::string_view bashView = table.view(bash);
+
+    std::vector<StringTable::Id> ids;
+    for(uint index=0; index<10000u; ++index)
+    {
+        ids.push_back(table.intern("worker-" + std::to_string(index)));
+    }
+    ASSERT_EQ(10002u, table.size());
+    for(uint index=0; index<10000u; ++index)
+    {
+        ASSERT_EQ("worker-" + std::to_string(index), table.view(ids[index]));
+        ASSERT_EQ(ids[index], table.intern("worker-" + std::to_string(index)));
+    }
+    // the characters never moved
+    ASSERT_EQ(bashView.data(), table.view(bash).data());
+    ASSERT_EQ(bash, table.intern("bash"));
+}
+
+TEST_F(StringTableTest, checkIntern_controlCharactersReplaced_Ok)
+{
+    StringTable table;
+    const StringTable::Id id = table.intern("evil\nname\x1b");
+    ASSERT_EQ("evil?name?", table.view(id));
+    ASSERT_EQ(id, table.intern("evil?name?"));
+}
+
+TEST_F(StringTableTest, checkFind_nothingStored_Ok)
+{
+    StringTable table;
+    const StringTable::Id bash = table.intern("bash");
+    StringTable::Id found{StringTable::kEmpty};
+    ASSERT_TRUE(table.find("bash", found));
+    ASSERT_EQ(bash, found);
+    ASSERT_FALSE(table.find("zsh", found));
+    ASSERT_TRUE(table.find("", found));
+    ASSERT_EQ(StringTable::kEmpty, found);
+    ASSERT_EQ(2u, table.size());
+}
+
+TEST_F(StringTableTest, checkIntern_longAndEmptyStrings_Ok)
+{
+    StringTable table;
+    ASSERT_EQ(StringTable::kEmpty, table.intern(""));
+    ASSERT_EQ("", table.view(StringTable::kEmpty));
+    ASSERT_EQ("", table.view(12345u));
+
+    const std::string longCommandLine(StringTable::kBlockBytes, 'x');
+    const StringTable::Id id = table.intern(longCommandLine);
+    ASSERT_EQ(longCommandLine, table.view(id));
+    ASSERT_EQ(id, table.intern(longCommandLine));
+    // the block being filled is still used by the short ones
+    ASSERT_EQ("java", table.view(table.intern("java")));
+}
+
+}
@@ -0,0 +1,58 @@
+#include "gtest/gtest.h"
+#include <TickArena.hpp>
+
+#include <string>
+#include <vector>
+
+namespace utils
+{
+
+class TickArenaTest : public ::testing::Test
+{};
+
+TEST_F(TickArenaTest, checkTickWithinBuffer_noSpill_Ok)
+{
+    TickArena arena(4096u);
+    {
+        const TickArena::Scope tick(arena);
+        std::pmr::vector<std::pmr::string> paths(arena.resource());
+        paths.reserve(16u);
+        for(uint pid=0; pid<16u; ++pid)
+        {
+            paths.emplace_back("4194304/stat is longer than the small string buffer");
+        }
+        ASSERT_EQ(0u, arena.getSpilledBytes());
+    }
+    ASSERT_EQ(4096u, arena.getCapacity());
+}
+
+TEST_F(TickArenaTest, checkTickSpilled_bufferGrownForNextTick_Ok)
+{
+    TickArena arena(1024u);
+    const auto fillTick = [&arena]()
+    {
+        std::pmr::vector<std::pmr::string> tokens(arena.resource());
+        for(uint token=0; token<200u; ++token)
+        {
+            tokens.emplace_back(40u, 'x');
+        }
+    };
+
+    fillTick();
+    ASSERT_GT(arena.getSpilledBytes(), 0u);
+    arena.reset();
+    ASSERT_GT(arena.getCapacity(), 1024u);
+    ASSERT_EQ(0u, arena.getSpilledBytes());
+
+    // the same tick fits now, and keeps fitting
+    for(uint tick=0; tick<3u; ++tick)
+    {
+        const std::size_t capacity = arena.getCapacity();
+        fillTick();
+        ASSERT_EQ(0u, arena.getSpilledBytes());
+        arena.reset();
+        ASSERT_EQ(capacity, arena.getCapacity());
+    }
+}
+
+}